@@ -0,0 +1,17 @@
+# das2: Improved DENG asset manager library
+# licence: Apache, see LICENCE file
+# file: GenerateModel.cmake - synthetic model generator program build configuration
+# author: Karl-Mihkel Ott
+
+set(GENERATE_MODEL_TARGET GenerateModel)
+set(GENERATE_MODEL_SOURCES
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/demos/GenerateModel.cpp)
+
+add_executable(${GENERATE_MODEL_TARGET}
+    ${GENERATE_MODEL_SOURCES})
+
+add_dependencies(${GENERATE_MODEL_TARGET}
+    ${DAS2_TARGET})
+
+target_link_libraries(${GENERATE_MODEL_TARGET}
+    PRIVATE ${DAS2_TARGET})
@@ -0,0 +1,36 @@
+# das2: Improved DENG asset manager library
+# licence: Apache, see LICENCE file
+# file: das2_bench.cmake - das2 benchmark suite CMake configuration file
+# author: Karl-Mihkel Ott
+
+set(DAS2_BENCH_TARGET das2_bench)
+set(DAS2_BENCH_HEADERS
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/bench/Benchmark.h)
+set(DAS2_BENCH_SOURCES
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/bench/BenchData.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/bench/Benchmark.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/bench/Main.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/bench/SerializationBench.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/bench/StringBench.cpp)
+
+if (DAS2_WAVEFRONT_OBJ)
+    list(APPEND DAS2_BENCH_SOURCES
+        ${CMAKE_CURRENT_SOURCE_DIR}/Sources/bench/ConverterBench.cpp
+        ${CMAKE_CURRENT_SOURCE_DIR}/Sources/bench/ObjBench.cpp)
+endif()
+
+add_executable(${DAS2_BENCH_TARGET}
+    ${DAS2_BENCH_HEADERS}
+    ${DAS2_BENCH_SOURCES})
+
+add_dependencies(${DAS2_BENCH_TARGET} ${DAS2_TARGET})
+target_link_libraries(${DAS2_BENCH_TARGET} PRIVATE ${DAS2_TARGET})
+
+if (DAS2_WAVEFRONT_OBJ)
+    target_compile_definitions(${DAS2_BENCH_TARGET} PRIVATE DAS2_BENCH_WAVEFRONT_OBJ)
+endif()
+
+# peak resident set size is queried with GetProcessMemoryInfo()
+if (WIN32)
+    target_link_libraries(${DAS2_BENCH_TARGET} PRIVATE psapi)
+endif()
@@ -4,8 +4,20 @@
 # author: Karl-Mihkel Ott
 
 set(DASTOOL_TARGET dastool)
-set(DASTOOL_HEADERS)
-set(DASTOOL_SOURCES)
+set(DASTOOL_HEADERS
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/dastool/Common.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/dastool/InspectCommand.h)
+set(DASTOOL_SOURCES
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/dastool/Common.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/dastool/InspectCommand.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/dastool/Main.cpp)
+
+if (DAS2_WAVEFRONT_OBJ)
+    list(APPEND DASTOOL_HEADERS
+        ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/dastool/BatchConverter.h)
+    list(APPEND DASTOOL_SOURCES
+        ${CMAKE_CURRENT_SOURCE_DIR}/Sources/dastool/BatchConverter.cpp)
+endif()
 
 add_executable(${DASTOOL_TARGET}
     ${DASTOOL_HEADERS}
@@ -13,3 +25,7 @@ add_executable(${DASTOOL_TARGET}
 
 add_dependencies(${DASTOOL_TARGET} ${DAS2_TARGET})
 target_link_libraries(${DASTOOL_TARGET} PRIVATE ${DAS2_TARGET})
+
+if (DAS2_WAVEFRONT_OBJ)
+    target_compile_definitions(${DASTOOL_TARGET} PRIVATE DASTOOL_WAVEFRONT_OBJ)
+endif()
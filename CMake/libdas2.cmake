@@ -5,13 +5,43 @@
 
 set(DAS2_TARGET das2)
 set(DAS2_HEADERS
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/AnimationCompression.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/AnimationSampler.h
     ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/Api.h
     ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/DasStructures.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/Inspector.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/Instancing.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/MemoryReport.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/MemoryResource.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/ModelGenerator.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/ModelPatcher.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/MorphBlending.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/SceneEvaluator.h
     ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/Serializer.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/Simd.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/SkeletonPalette.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/Skinning.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/Statistics.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/ThreadPool.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/Transform.h
     ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/Unserializer.h)
 set(DAS2_SOURCES
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/AnimationCompression.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/AnimationSampler.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/Sources/DasStructures.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/Inspector.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/Instancing.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/MemoryReport.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/MemoryResource.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/ModelGenerator.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/ModelPatcher.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/MorphBlending.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/SceneEvaluator.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/Sources/Serializer.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/SkeletonPalette.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/Skinning.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/Statistics.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/Sources/ThreadPool.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/Sources/Unserializer.cpp)
 
 # Third-party format converter support
@@ -20,10 +50,21 @@ if (DAS2_WAVEFRONT_OBJ)
 		${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/converters/obj/DasConverter.h
         ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/Exceptions.h
         ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/converters/obj/Data.h
-        ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/converters/obj/Unserializer.h)
+        ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/converters/obj/MaterialLibraryCache.h
+        ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/converters/obj/NormalGenerator.h
+        ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/converters/obj/StreamingConverter.h
+        ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/converters/obj/Tokenizer.h
+        ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/converters/obj/Triangulator.h
+        ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/converters/obj/Unserializer.h
+        ${CMAKE_CURRENT_SOURCE_DIR}/Include/das2/converters/obj/VertexWelder.h)
 	set (WAVEFRONT_OBJ_SOURCES
 		${CMAKE_CURRENT_SOURCE_DIR}/Sources/converters/obj/DasConverter.cpp
-        ${CMAKE_CURRENT_SOURCE_DIR}/Sources/converters/obj/Unserializer.cpp)
+        ${CMAKE_CURRENT_SOURCE_DIR}/Sources/converters/obj/MaterialLibraryCache.cpp
+        ${CMAKE_CURRENT_SOURCE_DIR}/Sources/converters/obj/NormalGenerator.cpp
+        ${CMAKE_CURRENT_SOURCE_DIR}/Sources/converters/obj/StreamingConverter.cpp
+        ${CMAKE_CURRENT_SOURCE_DIR}/Sources/converters/obj/Triangulator.cpp
+        ${CMAKE_CURRENT_SOURCE_DIR}/Sources/converters/obj/Unserializer.cpp
+        ${CMAKE_CURRENT_SOURCE_DIR}/Sources/converters/obj/VertexWelder.cpp)
 		
     list(APPEND DAS2_HEADERS ${WAVEFRONT_OBJ_HEADERS})
     list(APPEND DAS2_SOURCES ${WAVEFRONT_OBJ_SOURCES})
@@ -47,8 +88,17 @@ endif()
 
 add_dependencies(${DAS2_TARGET} cvar)
 
+if (DAS2_ENABLE_AVX2)
+    if (MSVC)
+        target_compile_options(${DAS2_TARGET} PRIVATE /arch:AVX2)
+    else()
+        target_compile_options(${DAS2_TARGET} PRIVATE -mavx2 -mfma)
+    endif()
+endif()
+
 find_package(Boost REQUIRED COMPONENTS iostreams)
 find_package(zstd CONFIG REQUIRED)
+find_package(Threads REQUIRED)
 message(STATUS "")
 
 if (WIN32 AND MSVC)
@@ -58,6 +108,7 @@ endif()
 
 target_link_libraries(${DAS2_TARGET}
     PUBLIC cvar
+    PUBLIC Threads::Threads
     PRIVATE Boost::boost 
     PRIVATE Boost::iostreams
     PRIVATE $<IF:$<TARGET_EXISTS:zstd::libzstd_shared>,zstd::libzstd_shared,zstd::libzstd_static>)
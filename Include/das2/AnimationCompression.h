@@ -0,0 +1,102 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: AnimationCompression.h - header of offline animation compressor and compact channel encoding
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <istream>
+#include <ostream>
+
+#include <das2/Api.h>
+#include <das2/DasStructures.h>
+
+#define DAS2_COMPRESSED_ANIMATION_MAGIC 0x31434164    // "dAC1"
+
+namespace das2 {
+
+    enum ChannelEncoding : char {
+        ChannelEncoding_Raw,                // uComponentCount floats per key
+        ChannelEncoding_SmallestThree,      // 48 bits per rotation: index of the largest component and three 15 bit components
+        ChannelEncoding_Quantized16         // uComponentCount unsigned 16 bit values per key, relative to per-component range
+    };
+
+
+    // Maximum absolute error per component that the compressor is allowed to introduce
+    struct AnimationCompressionSettings {
+        float fRotationError = 5e-4f;       // quaternion component error
+        float fTranslationError = 1e-4f;    // translation error in model units
+        float fScaleError = 1e-4f;
+        float fWeightError = 1e-3f;
+        bool bQuantize = true;              // quantize rotations and translations, otherwise only keyframes are reduced
+    };
+
+
+    class DAS2_API CompressedAnimationChannel {
+        public:
+            uint32_t uNodePropertyId = static_cast<uint32_t>(-1);
+            uint32_t uJointPropertyId = static_cast<uint32_t>(-1);
+            AnimationTarget bAnimationTarget = AnimationTarget_Unknown;
+            InterpolationType bInterpolationType = InterpolationType_Unknown;
+            ChannelEncoding bEncoding = ChannelEncoding_Raw;
+            uint32_t uComponentCount = 0;
+            std::vector<float> keyframes;
+            std::vector<float> rangeMin;            // ChannelEncoding_Quantized16 only, one value per component
+            std::vector<float> rangeExtent;         // ChannelEncoding_Quantized16 only, one value per component
+            std::vector<float> tangents;            // cubic spline channels only, same layout as AnimationChannel::tangents
+            std::vector<uint8_t> values;            // encoded keyframe values
+
+        public:
+            // size of a single encoded key in bytes
+            inline size_t GetKeySize() const {
+                switch (bEncoding) {
+                    case ChannelEncoding_SmallestThree:
+                        return 6;
+
+                    case ChannelEncoding_Quantized16:
+                        return uComponentCount * sizeof(uint16_t);
+
+                    default:
+                        return uComponentCount * sizeof(float);
+                }
+            }
+
+            // decodes uComponentCount floats of key _uKey into _pOut
+            void DecodeKey(uint32_t _uKey, float* _pOut) const;
+
+            // returns a pointer to raw float values if the channel is not quantized, nullptr otherwise
+            inline const float* GetRawValues() const {
+                return bEncoding == ChannelEncoding_Raw ? reinterpret_cast<const float*>(values.data()) : nullptr;
+            }
+
+            void Read(std::istream& _stream);
+            void Write(std::ostream& _stream) const;
+    };
+
+
+    class DAS2_API CompressedAnimation {
+        public:
+            BinString szName = nullptr;
+            std::vector<CompressedAnimationChannel> channels;
+
+        public:
+            void Read(std::istream& _stream);
+            void Write(std::ostream& _stream) const;
+
+            // total number of bytes used by keyframes and encoded values
+            size_t GetDataSize() const;
+    };
+
+
+    // Compresses a single animation channel
+    // Keys which can be reconstructed from their neighbours within the error bound are removed, linear rotation channels are encoded
+    // as smallest-three quaternions and linear translation channels as 16 bit values. Channels, whose quantized keys would exceed the
+    // error bound (e.g. translation ranges wider than 2 * 65535 * fTranslationError), keep raw floats. Cubic spline channels keep all keys
+    // in full precision.
+    DAS2_API CompressedAnimationChannel CompressAnimationChannel(const AnimationChannel& _channel, const AnimationCompressionSettings& _settings = {});
+
+    // Compresses all channels of animation _uAnimationIndex
+    DAS2_API CompressedAnimation CompressAnimation(const Model& _model, uint32_t _uAnimationIndex, const AnimationCompressionSettings& _settings = {});
+}
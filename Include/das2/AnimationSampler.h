@@ -0,0 +1,122 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: AnimationSampler.h - header of animation channel sampling engine
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <das2/Api.h>
+#include <das2/AnimationCompression.h>
+#include <das2/DasStructures.h>
+#include <das2/Transform.h>
+
+namespace das2 {
+
+    // Animated local properties of a model.
+    // Poses are initialized from the model and only the properties that are targeted by sampled channels are overwritten.
+    struct DAS2_API PoseBuffer {
+        std::vector<LocalPose> nodePoses;               // indexed by node id
+        std::vector<LocalPose> jointPoses;              // indexed by model skeleton joint id
+        std::vector<uint32_t> morphWeightOffsets;       // node id -> offset into morphWeights, -1 if the node has no morph weights
+        std::vector<uint32_t> morphWeightCounts;        // node id -> number of morph weights
+        std::vector<float> morphWeights;
+
+        PoseBuffer() = default;
+        explicit PoseBuffer(const Model& _model);
+
+        // restores all poses and morph weights to values stored in the model
+        void Reset(const Model& _model);
+    };
+
+
+    // Evaluates all channels of a single das2::Animation at the given time.
+    // Channel data is referenced directly from the model, thus the model must outlive the sampler.
+    // Each channel caches the keyframe that was used last, which makes sampling monotonically increasing time values
+    // O(1) amortized per channel. Samples that jump backwards or far ahead fall back to a binary search.
+    class DAS2_API AnimationSampler {
+        private:
+            struct _Track {
+                uint32_t uTargetId = static_cast<uint32_t>(-1);
+                bool bJointTarget = false;
+                AnimationTarget bAnimationTarget = AnimationTarget_Unknown;
+                InterpolationType bInterpolationType = InterpolationType_Unknown;
+                uint32_t uComponentCount = 0;
+                uint32_t uKeyframeCount = 0;
+                const float* pKeyframes = nullptr;
+                const float* pValues = nullptr;
+                const float* pTangents = nullptr;
+                const CompressedAnimationChannel* pCompressed = nullptr;   // set for channels, whose values are quantized
+                size_t uDecodedOffset = 0;              // offset into m_decodedKeys
+                uint32_t uDecodedKey = static_cast<uint32_t>(-1);
+                uint32_t uCursor = 0;
+            };
+
+            // current keyframe interval of a track
+            struct _Segment {
+                uint32_t uFirst;
+                uint32_t uSecond;
+                float fFactor;                          // normalized position between the two keyframes
+                float fDelta;                           // time between the two keyframes
+            };
+
+            std::vector<_Track> m_tracks;
+            float m_fStartTime = 0.f;
+            float m_fEndTime = 0.f;
+            bool m_bSlerp = false;
+
+            // scratch buffers, which are allocated once on construction
+            std::vector<float> m_decodedKeys;           // two decoded keys of each quantized track
+            std::vector<float> m_blendRows;             // lerp rows: a, b, t and out arrays
+            std::vector<float> m_hermiteRows;           // hermite rows: v0, m0, v1, m1, t and out arrays
+            std::vector<float> m_quaternionRows;        // quaternion lanes: q0[4], q1[4], w0, w1 and out[4] arrays
+            std::vector<uint32_t> m_blendTracks;
+            std::vector<uint32_t> m_hermiteTracks;
+            std::vector<uint32_t> m_quaternionTracks;
+            size_t m_uBlendRowCapacity = 0;
+            size_t m_uHermiteRowCapacity = 0;
+            size_t m_uQuaternionCapacity = 0;
+
+        private:
+            void _BindChannel(const AnimationChannel& _channel, _Track& _track);
+            void _BindChannel(const CompressedAnimationChannel& _channel, _Track& _track);
+            void _AddTrack(const Model& _model, uint32_t _uNodePropertyId, uint32_t _uJointPropertyId, size_t _uChannel, _Track& _track);
+            void _AllocateScratch();
+            void _DecodeSegment(_Track& _track, const _Segment& _segment, const float*& _pFirst, const float*& _pSecond);
+            _Segment _Seek(_Track& _track, float _fTime);
+            void _Store(const _Track& _track, const float* _pValues, PoseBuffer& _poses) const;
+
+        public:
+            // _bSlerp: use spherical linear interpolation for linear rotation channels, otherwise normalized lerp is used
+            AnimationSampler(const Model& _model, uint32_t _uAnimationIndex, bool _bSlerp = false);
+
+            // samples a compressed animation, which must outlive the sampler
+            // _model is used for validating channel targets
+            AnimationSampler(const Model& _model, const CompressedAnimation& _animation, bool _bSlerp = false);
+
+            // evaluates all channels at _fTime and writes the results into _poses
+            // _poses must be constructed from the same model
+            void Sample(float _fTime, PoseBuffer& _poses);
+
+            // forgets cached keyframe cursors
+            void ResetCursors();
+
+            inline float GetStartTime() const {
+                return m_fStartTime;
+            }
+
+            inline float GetEndTime() const {
+                return m_fEndTime;
+            }
+
+            inline float GetDuration() const {
+                return m_fEndTime - m_fStartTime;
+            }
+
+            inline size_t GetChannelCount() const {
+                return m_tracks.size();
+            }
+    };
+}
@@ -13,8 +13,8 @@
 #include <vector>
 #include <istream>
 #include <ostream>
-#include <variant>
 #include <utility>
+#include <memory_resource>
 
 #include <das2/Api.h>
 #include <cvar/SID.h>
@@ -27,68 +27,115 @@
 namespace das2 {
 
     class DAS2_API BinString {
+        public:
+            using allocator_type = std::pmr::polymorphic_allocator<char>;
+
         private:
             uint16_t m_uLength = 0;
             cvar::hash_t m_hshString = 0;
             char* m_pData = nullptr;
+            std::pmr::memory_resource* m_pResource = std::pmr::get_default_resource();
+
+        private:
+            inline void _Assign(const char* _pData, uint16_t _uLength) {
+                if (_uLength) {
+                    m_uLength = _uLength;
+                    m_pData = static_cast<char*>(m_pResource->allocate(m_uLength + 1, alignof(char)));
+                    std::memcpy(m_pData, _pData, m_uLength);
+                    m_pData[m_uLength] = 0;
+                }
+            }
+
+            inline void _Release() {
+                if (m_pData)
+                    m_pResource->deallocate(m_pData, m_uLength + 1, alignof(char));
+                m_pData = nullptr;
+                m_uLength = 0;
+            }
 
         public:
             BinString() = default;
             ~BinString() {
-                delete[] m_pData;
-                m_pData = nullptr;
-                m_uLength = 0;
+                _Release();
             }
 
-            BinString(const char* _szData) {
+            explicit BinString(const allocator_type& _alloc) :
+                m_pResource(_alloc.resource()) {}
+
+            BinString(const char* _szData, const allocator_type& _alloc = {}) :
+                m_pResource(_alloc.resource())
+            {
                 if (_szData != nullptr) {
-                    m_uLength = static_cast<uint16_t>(std::strlen(_szData));
-                    m_pData = new char[m_uLength+1]{};
-                    std::memcpy(m_pData, _szData, m_uLength);
-                    m_hshString = RUNTIME_CRC(m_pData);
+                    _Assign(_szData, static_cast<uint16_t>(std::strlen(_szData)));
+                    if (m_pData)
+                        m_hshString = RUNTIME_CRC(m_pData);
                 }
             }
 
-            BinString(const std::string& _str) {
-                if (_str.size()) {
-                    m_uLength = static_cast<uint16_t>(_str.size());
-                    m_pData = new char[m_uLength+1]{};
-                    std::memcpy(m_pData, _str.data(), _str.size());
+            BinString(const std::string& _str, const allocator_type& _alloc = {}) :
+                m_pResource(_alloc.resource())
+            {
+                _Assign(_str.data(), static_cast<uint16_t>(_str.size()));
+                if (m_pData)
                     m_hshString = RUNTIME_CRC(m_pData);
-                }
             }
 
             BinString(const BinString& _str) :
-                m_uLength(_str.m_uLength),
                 m_hshString(_str.m_hshString)
             {
-                if (m_uLength) {
-                    m_pData = new char[m_uLength+1]{};
-                    std::memcpy(m_pData, _str.m_pData, m_uLength);
-                }
+                _Assign(_str.m_pData, _str.m_uLength);
+            }
+
+            BinString(const BinString& _str, const allocator_type& _alloc) :
+                m_hshString(_str.m_hshString),
+                m_pResource(_alloc.resource())
+            {
+                _Assign(_str.m_pData, _str.m_uLength);
             }
 
             BinString(BinString&& _str) noexcept :
                 m_uLength(_str.m_uLength),
+                m_hshString(_str.m_hshString),
                 m_pData(_str.m_pData),
-                m_hshString(_str.m_hshString)
+                m_pResource(_str.m_pResource)
             {
                 _str.m_uLength = 0;
                 _str.m_pData = nullptr;
                 _str.m_hshString = 0;
             }
 
+            BinString(BinString&& _str, const allocator_type& _alloc) :
+                m_pResource(_alloc.resource())
+            {
+                *this = std::move(_str);
+            }
+
             BinString& operator=(const BinString& _other) {
-                delete[] m_pData;
-                m_pData = nullptr;
+                if (this == &_other)
+                    return *this;
 
+                _Release();
+                m_hshString = _other.m_hshString;
+                _Assign(_other.m_pData, _other.m_uLength);
+                return *this;
+            }
+
+            // memory resource is never propagated, data is copied when resources differ
+            BinString& operator=(BinString&& _other) {
+                if (this == &_other)
+                    return *this;
+
+                if (*m_pResource != *_other.m_pResource)
+                    return *this = static_cast<const BinString&>(_other);
+
+                _Release();
                 m_uLength = _other.m_uLength;
                 m_hshString = _other.m_hshString;
-                
-                if (m_uLength) {
-                    m_pData = new char[m_uLength+1]{};
-                    std::memcpy(m_pData, _other.m_pData, m_uLength);
-                }
+                m_pData = _other.m_pData;
+
+                _other.m_uLength = 0;
+                _other.m_pData = nullptr;
+                _other.m_hshString = 0;
                 return *this;
             }
 
@@ -112,6 +159,10 @@ namespace das2 {
                 return m_hshString;
             }
 
+            inline allocator_type get_allocator() const {
+                return allocator_type(m_pResource);
+            }
+
             void Read(std::istream& _stream);
             void Write(std::ostream& _stream) const;
     };
@@ -121,8 +172,8 @@ namespace das2 {
 namespace std {
     template<>
     struct hash<das2::BinString> {
-        bool operator()(const das2::BinString& _str) const {
-            return _str.Hash();
+        size_t operator()(const das2::BinString& _str) const {
+            return static_cast<size_t>(_str.Hash());
         }
     };
 }
@@ -172,6 +223,8 @@ namespace das2 {
             uint64_t m_uMagic = 0;
 
         public:
+            using allocator_type = std::pmr::polymorphic_allocator<char>;
+
             BinString szAuthorName = "";
             BinString szComment = "";
             uint32_t uVerticesCount = 0;
@@ -182,9 +235,13 @@ namespace das2 {
 
         public:
             Header() = default;
+            explicit Header(const allocator_type& _alloc);
             Header(const Header& _header) = default;
+            Header(const Header& _header, const allocator_type& _alloc);
             Header(Header&& _header) noexcept = default;
-            Header& operator=(Header&& _header) noexcept = default;
+            Header(Header&& _header, const allocator_type& _alloc);
+            Header& operator=(const Header& _header) = default;
+            Header& operator=(Header&& _header) = default;
 
             inline void Initialize() {
                 m_uMagic = DAS2_MAGIC;
@@ -200,16 +257,29 @@ namespace das2 {
 
 
     class DAS2_API Buffer {
+        public:
+            using allocator_type = std::pmr::polymorphic_allocator<char>;
+
         private:
             StructureIdentifier m_bStructure = StructureIdentifier_Unknown;
             uint32_t m_uLength = 0;
+            uint32_t m_uCapacity = 0;
             char* m_pData = nullptr;
+            std::pmr::memory_resource* m_pResource = std::pmr::get_default_resource();
+
+        private:
+            void _Reserve(uint32_t _uCapacity);
+            void _Release();
 
         public:
             Buffer() = default;
+            explicit Buffer(const allocator_type& _alloc);
             Buffer(const Buffer& _buffer);
+            Buffer(const Buffer& _buffer, const allocator_type& _alloc);
             Buffer(Buffer&& _buffer) noexcept;
-            Buffer& operator=(Buffer&& _buffer) noexcept;
+            Buffer(Buffer&& _buffer, const allocator_type& _alloc);
+            Buffer& operator=(const Buffer& _buffer);
+            Buffer& operator=(Buffer&& _buffer);
             ~Buffer();
 
             inline void Initialize() {
@@ -229,54 +299,63 @@ namespace das2 {
 
             template<typename T = char>
             T* Get(uint32_t _uOffset = 0) {
-                return static_cast<T*>(m_pData + _uOffset);
+                return reinterpret_cast<T*>(m_pData + _uOffset);
             }
             
             template <typename T = char>
             inline const T* Get(uint32_t _uOffset = 0) const {
-                return static_cast<const T*>(m_pData + _uOffset);
+                return reinterpret_cast<const T*>(m_pData + _uOffset);
             }
 
             template <typename InputIt>
             uint32_t PushRange(InputIt _first, InputIt _last) {
+                using T = typename std::remove_cv<typename std::remove_reference<decltype(*_first)>::type>::type;
                 std::size_t uDistance = std::distance(_first, _last);
                 
                 const uint32_t uOffset = m_uLength;
-                
-                m_uLength += static_cast<uint32_t>(uDistance * sizeof(typename std::remove_reference<decltype(*_first)>::type));
-                if (m_pData && m_uLength) {
-                    m_pData = static_cast<char*>(std::realloc(m_pData, m_uLength));
-                }
-                else {
-                    m_pData = static_cast<char*>(std::malloc(m_uLength));
-                }
-
-                if (!m_pData)
-                    throw std::bad_alloc();
+                _Reserve(m_uLength + static_cast<uint32_t>(uDistance * sizeof(T)));
+                m_uLength += static_cast<uint32_t>(uDistance * sizeof(T));
 
                 size_t i = 0;
                 for (auto it = _first; it != _last; it++, i++) {
-                    reinterpret_cast<typename std::remove_reference<decltype(*it)>::type*>(m_pData + uOffset)[i] = *it;
+                    std::memcpy(m_pData + uOffset + i * sizeof(T), &*it, sizeof(T));
                 }
 
                 return uOffset;
             }
 
+            // appends _uSize uninitialized bytes and returns their offset, which allows filling the buffer in place
+            inline uint32_t Extend(uint32_t _uSize) {
+                const uint32_t uOffset = m_uLength;
+                _Reserve(m_uLength + _uSize);
+                m_uLength += _uSize;
+                return uOffset;
+            }
+
+            // _uLength: number of elements of type T to push
             template <typename T>
             uint32_t PushRange(const T* _pData, size_t _uLength) {
                 const uint32_t uOffset = m_uLength;
-                m_uLength += static_cast<uint32_t>(_uLength);
-                m_pData = static_cast<char*>(std::realloc(m_pData, m_uLength));
-                if (!m_pData)
-                    throw std::bad_alloc();
+                _Reserve(m_uLength + static_cast<uint32_t>(_uLength * sizeof(T)));
+                m_uLength += static_cast<uint32_t>(_uLength * sizeof(T));
 
-                for (size_t i = 0; i < _uLength; i++)
-                    static_cast<T*>(m_pData + uOffset)[i] = _pData[i];
+                if (_uLength)
+                    std::memcpy(m_pData + uOffset, _pData, _uLength * sizeof(T));
+                return uOffset;
             }
 
             inline uint32_t Size() const {
                 return m_uLength;
             }
+
+            // number of allocated bytes, which can exceed Size() after PushRange() and Extend() calls
+            inline uint32_t Capacity() const {
+                return m_uCapacity;
+            }
+
+            inline allocator_type get_allocator() const {
+                return allocator_type(m_pResource);
+            }
     };
 
 
@@ -313,6 +392,8 @@ namespace das2 {
             StructureIdentifier m_bStructure = StructureIdentifier_Unknown;
         
         public:
+            using allocator_type = std::pmr::polymorphic_allocator<char>;
+
             uint32_t uIndexBufferOffset = 0;
             uint32_t uDrawCount = 0;
             uint32_t uPositionVertexBufferOffset = 0;
@@ -323,14 +404,18 @@ namespace das2 {
             std::array<uint32_t, 8> arrSkeletalJointWeightBufferOffsets;
             MaterialType bMaterialType = MaterialType_Unknown;
             uint32_t uMaterialId = static_cast<uint32_t>(-1);
-            std::vector<MorphTarget> morphTargets;
-            std::vector<Mesh> multipleLods;
+            std::pmr::vector<MorphTarget> morphTargets;
+            std::pmr::vector<Mesh> multipleLods;
 
         public:
             Mesh() = default;
+            explicit Mesh(const allocator_type& _alloc);
             Mesh(const Mesh& _mesh) = default;
+            Mesh(const Mesh& _mesh, const allocator_type& _alloc);
             Mesh(Mesh&& _mesh) noexcept = default;
-            Mesh& operator=(Mesh&& _mesh) noexcept = default;
+            Mesh(Mesh&& _mesh, const allocator_type& _alloc);
+            Mesh& operator=(const Mesh& _mesh) = default;
+            Mesh& operator=(Mesh&& _mesh) = default;
 
             inline void Initialize() {
                 m_bStructure = StructureIdentifier_Mesh;
@@ -350,14 +435,20 @@ namespace das2 {
             StructureIdentifier m_bStructure = StructureIdentifier_Unknown;
 
         public:
+            using allocator_type = std::pmr::polymorphic_allocator<char>;
+
             BinString szName = nullptr; 
-            std::vector<uint32_t> meshes;
+            std::pmr::vector<uint32_t> meshes;
 
         public:
             MeshGroup() = default;
+            explicit MeshGroup(const allocator_type& _alloc);
             MeshGroup(const MeshGroup& _meshGroup) = default;
+            MeshGroup(const MeshGroup& _meshGroup, const allocator_type& _alloc);
             MeshGroup(MeshGroup&& _meshGroup) noexcept = default;
-            MeshGroup& operator=(MeshGroup&& _meshGroup) noexcept = default;
+            MeshGroup(MeshGroup&& _meshGroup, const allocator_type& _alloc);
+            MeshGroup& operator=(const MeshGroup& _meshGroup) = default;
+            MeshGroup& operator=(MeshGroup&& _meshGroup) = default;
 
             inline void Initialize() {
                 m_bStructure = StructureIdentifier_MeshGroup;
@@ -377,8 +468,10 @@ namespace das2 {
             StructureIdentifier m_bStructure = StructureIdentifier_Unknown;
 
         public:
+            using allocator_type = std::pmr::polymorphic_allocator<char>;
+
             BinString szName = nullptr;
-            std::vector<uint32_t> children;
+            std::pmr::vector<uint32_t> children;
             uint32_t uMeshGroupId = static_cast<uint32_t>(-1);
             uint32_t uSkeletonId = static_cast<uint32_t>(-1);
             TRS::Matrix4<float> mCustomTransform;
@@ -388,9 +481,13 @@ namespace das2 {
 
         public:
             Node() = default;
+            explicit Node(const allocator_type& _alloc);
             Node(const Node& _node) = default;
+            Node(const Node& _node, const allocator_type& _alloc);
             Node(Node&& _node) noexcept = default;
-            Node& operator=(Node&& _node) noexcept = default;
+            Node(Node&& _node, const allocator_type& _alloc);
+            Node& operator=(const Node& _node) = default;
+            Node& operator=(Node&& _node) = default;
 
             inline void Initialize() {
                 m_bStructure = StructureIdentifier_Node;
@@ -410,14 +507,20 @@ namespace das2 {
             StructureIdentifier m_bStructure = StructureIdentifier_Unknown;
 
         public:
+            using allocator_type = std::pmr::polymorphic_allocator<char>;
+
             BinString szName = nullptr;
-            std::vector<uint32_t> rootNodes;
+            std::pmr::vector<uint32_t> rootNodes;
 
         public:
             Scene() = default;
+            explicit Scene(const allocator_type& _alloc);
             Scene(const Scene& _scene) = default;
+            Scene(const Scene& _scene, const allocator_type& _alloc);
             Scene(Scene&& _scene) noexcept = default;
-            Scene& operator=(Scene&& _scene) noexcept = default;
+            Scene(Scene&& _scene, const allocator_type& _alloc);
+            Scene& operator=(const Scene& _scene) = default;
+            Scene& operator=(Scene&& _scene) = default;
 
             inline void Initialize() {
                 m_bStructure = StructureIdentifier_Scene;
@@ -437,8 +540,10 @@ namespace das2 {
             StructureIdentifier m_bStructure = StructureIdentifier_Unknown;
 
         public:
+            using allocator_type = std::pmr::polymorphic_allocator<char>;
+
             BinString szName = nullptr;
-            std::vector<uint32_t> children;
+            std::pmr::vector<uint32_t> children;
             TRS::Matrix4<float> mInverseBindPos;
             TRS::Quaternion qRotation;
             TRS::Vector3<float> vTranslation;
@@ -446,9 +551,13 @@ namespace das2 {
 
         public:
             SkeletonJoint() = default;
+            explicit SkeletonJoint(const allocator_type& _alloc);
             SkeletonJoint(const SkeletonJoint& _skeletonJoint) = default;
+            SkeletonJoint(const SkeletonJoint& _skeletonJoint, const allocator_type& _alloc);
             SkeletonJoint(SkeletonJoint&& _skeletonJoint) noexcept = default;
-            SkeletonJoint& operator=(SkeletonJoint&& _skeleton) noexcept = default;
+            SkeletonJoint(SkeletonJoint&& _skeletonJoint, const allocator_type& _alloc);
+            SkeletonJoint& operator=(const SkeletonJoint& _skeleton) = default;
+            SkeletonJoint& operator=(SkeletonJoint&& _skeleton) = default;
     
             inline void Initialize() {
                 m_bStructure = StructureIdentifier_SkeletonJoint;
@@ -468,15 +577,21 @@ namespace das2 {
             StructureIdentifier m_bStructure = StructureIdentifier_Unknown;
 
         public:
+            using allocator_type = std::pmr::polymorphic_allocator<char>;
+
             BinString szName = nullptr;
             uint32_t uParent = static_cast<uint32_t>(-1);
-            std::vector<uint32_t> joints;
+            std::pmr::vector<uint32_t> joints;
 
         public:
             Skeleton() = default;
+            explicit Skeleton(const allocator_type& _alloc);
             Skeleton(const Skeleton& _skeleton) = default;
+            Skeleton(const Skeleton& _skeleton, const allocator_type& _alloc);
             Skeleton(Skeleton&& _skeleton) noexcept = default;
-            Skeleton& operator=(Skeleton&& _skeleton) noexcept = default;
+            Skeleton(Skeleton&& _skeleton, const allocator_type& _alloc);
+            Skeleton& operator=(const Skeleton& _skeleton) = default;
+            Skeleton& operator=(Skeleton&& _skeleton) = default;
 
             inline void Initialize() {
                 m_bStructure = StructureIdentifier_Skeleton;
@@ -496,14 +611,20 @@ namespace das2 {
             StructureIdentifier m_bStructure = StructureIdentifier_Unknown;
 
         public:
+            using allocator_type = std::pmr::polymorphic_allocator<char>;
+
             BinString szName = nullptr;
-            std::vector<uint32_t> animationChannels;
+            std::pmr::vector<uint32_t> animationChannels;
 
         public:
             Animation() = default;
-            Animation(const Animation& _animation);
+            explicit Animation(const allocator_type& _alloc);
+            Animation(const Animation& _animation) = default;
+            Animation(const Animation& _animation, const allocator_type& _alloc);
             Animation(Animation&& _animation) noexcept = default;
-            Animation& operator=(Animation&& _ani) noexcept = default;
+            Animation(Animation&& _animation, const allocator_type& _alloc);
+            Animation& operator=(const Animation& _ani) = default;
+            Animation& operator=(Animation&& _ani) = default;
 
             inline void Initialize() {
                 m_bStructure = StructureIdentifier_Animation;
@@ -521,23 +642,30 @@ namespace das2 {
     class DAS2_API AnimationChannel {
         private:
             StructureIdentifier m_bStructure = StructureIdentifier_Unknown;
-            using _Variant = std::variant<std::vector<float>, TRS::Vector3<float>, TRS::Quaternion, float>;
 
         public:
+            using allocator_type = std::pmr::polymorphic_allocator<char>;
+
             uint32_t uNodePropertyId = static_cast<uint32_t>(-1);
             uint32_t uJointPropertyId = static_cast<uint32_t>(-1);
             AnimationTarget bAnimationTarget = AnimationTarget_Unknown;
             InterpolationType bInterpolationType = InterpolationType_Unknown;
             uint32_t uWeightCount = 0;
-            std::vector<float> keyframes;
-            std::vector<std::array<_Variant, 2>> tangents;
-            std::vector<_Variant> targetValues;
+            std::pmr::vector<float> keyframes;
+            // keyframe-major packed values, each keyframe holds GetComponentCount() floats for the in tangent followed by the out tangent
+            std::pmr::vector<float> tangents;
+            // keyframe-major packed values, each keyframe holds GetComponentCount() floats
+            std::pmr::vector<float> targetValues;
 
         public:
             AnimationChannel() = default;
+            explicit AnimationChannel(const allocator_type& _alloc);
             AnimationChannel(const AnimationChannel& _animationChannel) = default;
+            AnimationChannel(const AnimationChannel& _animationChannel, const allocator_type& _alloc);
             AnimationChannel(AnimationChannel&& _animationChannel) noexcept = default;
-            AnimationChannel& operator=(AnimationChannel&& _cn) noexcept = default;
+            AnimationChannel(AnimationChannel&& _animationChannel, const allocator_type& _alloc);
+            AnimationChannel& operator=(const AnimationChannel& _cn) = default;
+            AnimationChannel& operator=(AnimationChannel&& _cn) = default;
 
             inline void Initialize() {
                 m_bStructure = StructureIdentifier_AnimationChannel;
@@ -547,6 +675,27 @@ namespace das2 {
                 return m_bStructure == StructureIdentifier_AnimationChannel;
             }
 
+            // number of floats that describe a single keyframe value
+            // weights: uWeightCount, translation: 3 (x, y, z), rotation: 4 (x, y, z, w), scale: 1
+            inline uint32_t GetComponentCount() const {
+                switch (bAnimationTarget) {
+                    case AnimationTarget_Weights:
+                        return uWeightCount;
+
+                    case AnimationTarget_Translation:
+                        return 3;
+
+                    case AnimationTarget_Rotation:
+                        return 4;
+
+                    case AnimationTarget_Scale:
+                        return 1;
+
+                    default:
+                        return 0;
+                }
+            }
+
             void Read(std::istream& _stream);
             void Write(std::ostream& _stream) const;
     };
@@ -557,6 +706,8 @@ namespace das2 {
             StructureIdentifier m_bStructure = StructureIdentifier_Unknown;
 
         public:
+            using allocator_type = std::pmr::polymorphic_allocator<char>;
+
             BinString szName = "";
             TRS::Vector4<float> vDiffuse = { 0.f, 0.f, 0.f, 1.f };
             TRS::Vector4<float> vSpecular = { 0.f, 0.f, 0.f, 1.f };
@@ -567,9 +718,13 @@ namespace das2 {
 
         public:
             MaterialPhong() = default;
+            explicit MaterialPhong(const allocator_type& _alloc);
             MaterialPhong(const MaterialPhong& _materialPhong) = default;
+            MaterialPhong(const MaterialPhong& _materialPhong, const allocator_type& _alloc);
             MaterialPhong(MaterialPhong&& _materialPhong) noexcept = default;
-            MaterialPhong& operator=(MaterialPhong&& _cn) noexcept = default;
+            MaterialPhong(MaterialPhong&& _materialPhong, const allocator_type& _alloc);
+            MaterialPhong& operator=(const MaterialPhong& _cn) = default;
+            MaterialPhong& operator=(MaterialPhong&& _cn) = default;
 
             inline void Initialize() {
                 m_bStructure = StructureIdentifier_MaterialPhong;
@@ -589,6 +744,8 @@ namespace das2 {
             StructureIdentifier m_bStructure = StructureIdentifier_Unknown;
 
         public:
+            using allocator_type = std::pmr::polymorphic_allocator<char>;
+
             BinString szName = "";
             TRS::Vector4<float> vAlbedoFactor = { 1.f, 1.f, 1.f, 1.f };
             TRS::Vector4<float> vEmissiveFactor = { 0.f, 0.f, 0.f, 1.f };
@@ -603,9 +760,13 @@ namespace das2 {
         
         public:
             MaterialPbr() = default;
+            explicit MaterialPbr(const allocator_type& _alloc);
             MaterialPbr(const MaterialPbr& _materialPbr) = default;
+            MaterialPbr(const MaterialPbr& _materialPbr, const allocator_type& _alloc);
             MaterialPbr(MaterialPbr&& _materialPbr) noexcept = default;
-            MaterialPbr& operator=(MaterialPbr&& _material) noexcept = default;
+            MaterialPbr(MaterialPbr&& _materialPbr, const allocator_type& _alloc);
+            MaterialPbr& operator=(const MaterialPbr& _material) = default;
+            MaterialPbr& operator=(MaterialPbr&& _material) = default;
 
             inline void Initialize() {
                 m_bStructure = StructureIdentifier_MaterialPbr;
@@ -620,22 +781,43 @@ namespace das2 {
     };
 
     struct Model {
+        using allocator_type = std::pmr::polymorphic_allocator<char>;
+
         Model() = default;
+        // all structures, strings and the buffer blob are allocated from _pResource
+        explicit Model(std::pmr::memory_resource* _pResource) :
+            header(allocator_type(_pResource)),
+            buffer(allocator_type(_pResource)),
+            meshes(_pResource),
+            meshGroups(_pResource),
+            nodes(_pResource),
+            scenes(_pResource),
+            skeletonJoints(_pResource),
+            skeletons(_pResource),
+            animations(_pResource),
+            animationChannels(_pResource),
+            phongMaterials(_pResource),
+            pbrMaterials(_pResource) {}
         Model(const Model& _model) = default;
         Model(Model&& _model) noexcept = default;
-        Model& operator=(Model&& _model) noexcept = default;
+        Model& operator=(const Model& _model) = default;
+        Model& operator=(Model&& _model) = default;
+
+        inline std::pmr::memory_resource* GetMemoryResource() const {
+            return meshes.get_allocator().resource();
+        }
 
         Header header;
         Buffer buffer;
-        std::vector<Mesh> meshes;
-        std::vector<MeshGroup> meshGroups;
-        std::vector<Node> nodes;
-        std::vector<Scene> scenes;
-        std::vector<SkeletonJoint> skeletonJoints;
-        std::vector<Skeleton> skeletons;
-        std::vector<Animation> animations;
-        std::vector<AnimationChannel> animationChannels;
-        std::vector<MaterialPhong> phongMaterials;
-        std::vector<MaterialPbr> pbrMaterials;
+        std::pmr::vector<Mesh> meshes;
+        std::pmr::vector<MeshGroup> meshGroups;
+        std::pmr::vector<Node> nodes;
+        std::pmr::vector<Scene> scenes;
+        std::pmr::vector<SkeletonJoint> skeletonJoints;
+        std::pmr::vector<Skeleton> skeletons;
+        std::pmr::vector<Animation> animations;
+        std::pmr::vector<AnimationChannel> animationChannels;
+        std::pmr::vector<MaterialPhong> phongMaterials;
+        std::pmr::vector<MaterialPbr> pbrMaterials;
     };
 }
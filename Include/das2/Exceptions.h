@@ -3,6 +3,8 @@
 // file: Exceptions.h - header file containing possible das2 exeptions
 // author: Karl-Mihkel Ott
 
+#pragma once
+
 #include <exception>
 #include <string>
 
@@ -48,4 +50,46 @@ namespace das2 {
             MagicValueException(const std::string& _sWhat = "Unknown exception") :
                 SerializerException(_sWhat) {}
     };
-}
\ No newline at end of file
+
+
+    class HierarchyException : public std::exception {
+        private:
+            std::string m_sWhatMessage;
+
+        public:
+            HierarchyException(const std::string& _sWhat = "Unknown exception") :
+                m_sWhatMessage(_sWhat) {}
+
+            const char* what() const noexcept override {
+                return m_sWhatMessage.c_str();
+            }
+    };
+
+
+    class AnimationException : public std::exception {
+        private:
+            std::string m_sWhatMessage;
+
+        public:
+            AnimationException(const std::string& _sWhat = "Unknown exception") :
+                m_sWhatMessage(_sWhat) {}
+
+            const char* what() const noexcept override {
+                return m_sWhatMessage.c_str();
+            }
+    };
+
+
+    class BufferRangeException : public std::exception {
+        private:
+            std::string m_sWhatMessage;
+
+        public:
+            BufferRangeException(const std::string& _sWhat = "Unknown exception") :
+                m_sWhatMessage(_sWhat) {}
+
+            const char* what() const noexcept override {
+                return m_sWhatMessage.c_str();
+            }
+    };
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory_resource>
 #include <ostream>
 #include <das2/Api.h>
 #include <das2/DasStructures.h>
@@ -12,7 +13,11 @@ namespace das2 {
             Model m_model;
 
         public:
-            IConverter(const BinString& _szAuthorName = "", const BinString& _szComment = "", uint8_t _bZlibLevel = 0) {
+            // _pResource: memory resource to allocate the converted model from
+            IConverter(const BinString& _szAuthorName = "", const BinString& _szComment = "", uint8_t _bZlibLevel = 0,
+                       std::pmr::memory_resource* _pResource = std::pmr::get_default_resource()) :
+                m_model(_pResource)
+            {
                 m_model.header.Initialize();
                 m_model.header.szAuthorName = _szAuthorName;
                 m_model.header.szComment = _szComment;
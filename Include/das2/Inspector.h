@@ -0,0 +1,39 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: Inspector.h - header of fast das2 file inspection without loading the buffer
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstdint>
+#include <istream>
+
+#include <das2/Api.h>
+#include <das2/DasStructures.h>
+#include <das2/Statistics.h>
+
+namespace das2 {
+
+    struct ModelSummary {
+        Header header;
+        uint64_t uFileSize = 0;             // bytes from the beginning of the model to the end of the stream, 0 if not seekable
+        uint64_t uUncompressedSize = 0;     // header and uncompressed structures, 0 if structures were not scanned
+        uint32_t uBufferSize = 0;
+        bool bStructuresScanned = false;    // false for compressed files, which were not decompressed
+
+        // counts and record sizes indexed by StructureIdentifier, only valid if bStructuresScanned is true
+        StructureStats arrStructures[DAS2_STATISTICS_STRUCTURE_COUNT];
+
+        inline double GetCompressionRatio() const {
+            return bStructuresScanned && uFileSize ? static_cast<double>(uUncompressedSize) / static_cast<double>(uFileSize) : 0.0;
+        }
+    };
+
+
+    // Reads the header and scans all structure records of a das2 file without reading the buffer blob.
+    // The buffer is skipped with a seek, thus inspecting an uncompressed file costs only as much as its structure records.
+    // Compressed files are summarized from their header alone, unless _bDecompress is set, in which case the stream is
+    // decompressed on the fly and the buffer is discarded instead of being copied.
+    // Throws MagicValueException or SerializerException on invalid or truncated files.
+    DAS2_API ModelSummary InspectModel(std::istream& _stream, bool _bDecompress = false);
+}
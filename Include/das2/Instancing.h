@@ -0,0 +1,45 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: Instancing.h - header of duplicate geometry detection and instancing pass
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstdint>
+
+#include <das2/Api.h>
+#include <das2/DasStructures.h>
+#include <das2/ThreadPool.h>
+
+namespace das2 {
+
+    // Tolerances of duplicate geometry detection
+    struct InstancingSettings {
+        float fPositionError = 1e-4f;       // maximum vertex distance relative to the bounding radius of the mesh
+        float fNormalError = 1e-3f;         // maximum distance between rotated unit normals
+        bool bUniformScale = false;         // detect uniformly scaled copies as well, otherwise only rigid transforms
+        bool bCompactBuffer = true;         // remove vertex data of replaced meshes from the buffer
+    };
+
+
+    struct InstancingResult {
+        uint32_t uInstancedNodes = 0;       // nodes, which now reference another mesh group through a transform
+        uint32_t uAddedNodes = 0;           // child nodes created for nodes whose own transform could not be changed
+        uint32_t uRemovedMeshGroups = 0;
+        uint32_t uRemovedMeshes = 0;
+        uint64_t uRemovedBytes = 0;         // bytes removed from the buffer
+    };
+
+
+    // Replaces mesh groups whose geometry is a rigid transformation of another mesh group with instances of the latter.
+    // Mesh groups are bucketed by a hash of their topology, texture coordinates, colors and materials, which do not change
+    // under rigid transformations. Within a bucket the transform is estimated from a reference frame spanned by two
+    // vertices of the first mesh and verified on every position and normal of every mesh and level of detail.
+    // Nodes referencing a duplicate get the transform folded into their translation, rotation and scale, unless they are
+    // animated or have children, in which case a child node with the transform references the remaining mesh group.
+    // Replaced mesh groups, meshes only they referenced and, with bCompactBuffer, their vertex data are removed and all
+    // indices and buffer offsets are remapped.
+    // Meshes with morph targets or skinning data and groups used by skinned nodes are left untouched.
+    // _pThreadPool: optional thread pool to hash meshes and compare buckets with, can be nullptr
+    DAS2_API InstancingResult InstanceDuplicateGeometry(Model& _model, const InstancingSettings& _settings = {}, ThreadPool* _pThreadPool = nullptr);
+}
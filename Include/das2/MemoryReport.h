@@ -0,0 +1,90 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: MemoryReport.h - header of in-memory footprint accounting for das2::Model
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <das2/Api.h>
+#include <das2/DasStructures.h>
+
+// rows of the report, StructureIdentifier values with the model itself and its header in the StructureIdentifier_Unknown row
+#define DAS2_MEMORY_REPORT_ROW_COUNT (StructureIdentifier_MaterialPbr + 1)
+
+namespace das2 {
+
+    enum MemoryCategory : uint8_t {
+        MemoryCategory_Geometry,        // used bytes of the buffer blob
+        MemoryCategory_Animation,       // keyframes, tangents and target values of animation channels
+        MemoryCategory_Strings,         // heap data of BinString objects, including the null terminator
+        MemoryCategory_Structures,      // structure objects and their index arrays (children, meshes, joints etc.)
+        MemoryCategory_Overhead,        // allocated but unused capacity of vectors and the buffer blob
+        MemoryCategory_Count
+    };
+
+
+    struct MemoryUsage {
+        uint64_t arrBytes[MemoryCategory_Count] = {};
+        uint64_t uCount = 0;            // number of structures
+
+        inline uint64_t GetTotal() const {
+            uint64_t uTotal = 0;
+            for (uint64_t uBytes : arrBytes)
+                uTotal += uBytes;
+            return uTotal;
+        }
+    };
+
+
+    struct MemorySuggestion {
+        std::string sDescription;
+        uint64_t uSavings = 0;          // estimated number of bytes that would be freed
+    };
+
+
+    // formats a byte count with binary units, e.g. "1.50 MiB"
+    DAS2_API std::string FormatBytes(uint64_t _uBytes);
+
+
+    // Accounts every byte a Model requests from its memory resource, broken down by structure type and category,
+    // and estimates the largest possible savings.
+    // Sizes are the requested sizes plus the Model object itself, allocator bookkeeping and alignment of the memory resource
+    // are not included.
+    class DAS2_API MemoryReport {
+        private:
+            MemoryUsage m_arrRows[DAS2_MEMORY_REPORT_ROW_COUNT];
+            MemoryUsage m_total;
+            std::vector<MemorySuggestion> m_suggestions;
+
+        private:
+            void _AccountModel(const Model& _model);
+            void _AccountMesh(const Mesh& _mesh);
+            void _SuggestUnusedCapacity(const Model& _model);
+            void _SuggestDuplicateStrings(const Model& _model);
+            void _SuggestConstantChannels(const Model& _model);
+
+        public:
+            explicit MemoryReport(const Model& _model);
+
+            inline const MemoryUsage& GetUsage(StructureIdentifier _bIdentifier) const {
+                return m_arrRows[_bIdentifier];
+            }
+
+            inline const MemoryUsage& GetTotal() const {
+                return m_total;
+            }
+
+            // sorted by estimated savings, largest first
+            inline const std::vector<MemorySuggestion>& GetSuggestions() const {
+                return m_suggestions;
+            }
+
+            // Writes a human readable table of all non-empty rows followed by the suggestions
+            void Print(std::ostream& _stream) const;
+    };
+}
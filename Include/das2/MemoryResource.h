@@ -0,0 +1,90 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: MemoryResource.h - header of memory resources that can be used to back das2::Model allocations
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <das2/Api.h>
+
+namespace das2 {
+
+    // Allocation callbacks for engines that manage memory by themselves
+    struct AllocatorHook {
+        void* (*pfnAllocate)(std::size_t _uSize, std::size_t _uAlignment, void* _pUserData) = nullptr;
+        void (*pfnDeallocate)(void* _pMemory, std::size_t _uSize, std::size_t _uAlignment, void* _pUserData) = nullptr;
+        void* pUserData = nullptr;
+    };
+
+
+    // std::pmr adapter for AllocatorHook, so that engine allocators can be passed anywhere das2 accepts
+    // a std::pmr::memory_resource (das2::Model, das2::Unserializer etc.)
+    class DAS2_API HookMemoryResource : public std::pmr::memory_resource {
+        private:
+            AllocatorHook m_hook;
+
+        protected:
+            void* do_allocate(std::size_t _uBytes, std::size_t _uAlignment) override;
+            void do_deallocate(void* _pMemory, std::size_t _uBytes, std::size_t _uAlignment) override;
+            bool do_is_equal(const std::pmr::memory_resource& _other) const noexcept override;
+
+        public:
+            HookMemoryResource(const AllocatorHook& _hook);
+    };
+
+
+    // Monotonic arena for loading a whole model into contiguous blocks of memory.
+    // Deallocations are no-ops, all memory is handed back to the upstream resource at once, when the
+    // arena is destroyed or Release() is called. Models allocated from the arena must not outlive it.
+    class DAS2_API ModelArena : public std::pmr::monotonic_buffer_resource {
+        public:
+            ModelArena(std::size_t _uInitialSize = 1 << 20, std::pmr::memory_resource* _pUpstream = std::pmr::get_default_resource()) :
+                std::pmr::monotonic_buffer_resource(_uInitialSize, _pUpstream) {}
+            ModelArena(const ModelArena&) = delete;
+            ModelArena& operator=(const ModelArena&) = delete;
+    };
+
+
+    // Forwards all requests to an upstream resource and counts them.
+    // Loads report the allocations of models backed by a counting resource in LoadStats.
+    class DAS2_API CountingMemoryResource : public std::pmr::memory_resource {
+        private:
+            std::pmr::memory_resource* m_pUpstream;
+            std::atomic<uint64_t> m_uAllocationCount{ 0 };
+            std::atomic<uint64_t> m_uAllocatedBytes{ 0 };
+            std::atomic<uint64_t> m_uDeallocationCount{ 0 };
+            std::atomic<uint64_t> m_uDeallocatedBytes{ 0 };
+
+        protected:
+            void* do_allocate(std::size_t _uBytes, std::size_t _uAlignment) override;
+            void do_deallocate(void* _pMemory, std::size_t _uBytes, std::size_t _uAlignment) override;
+            bool do_is_equal(const std::pmr::memory_resource& _other) const noexcept override;
+
+        public:
+            CountingMemoryResource(std::pmr::memory_resource* _pUpstream = std::pmr::get_default_resource()) :
+                m_pUpstream(_pUpstream) {}
+            CountingMemoryResource(const CountingMemoryResource&) = delete;
+            CountingMemoryResource& operator=(const CountingMemoryResource&) = delete;
+
+            inline uint64_t GetAllocationCount() const {
+                return m_uAllocationCount.load(std::memory_order_relaxed);
+            }
+
+            inline uint64_t GetAllocatedBytes() const {
+                return m_uAllocatedBytes.load(std::memory_order_relaxed);
+            }
+
+            inline uint64_t GetDeallocationCount() const {
+                return m_uDeallocationCount.load(std::memory_order_relaxed);
+            }
+
+            // bytes that are currently allocated
+            inline uint64_t GetLiveBytes() const {
+                return GetAllocatedBytes() - m_uDeallocatedBytes.load(std::memory_order_relaxed);
+            }
+    };
+}
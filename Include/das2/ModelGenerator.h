@@ -0,0 +1,110 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: ModelGenerator.h - header of deterministic synthetic model generator
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <ostream>
+#include <vector>
+
+#include <das2/Api.h>
+#include <das2/DasStructures.h>
+#include <das2/ThreadPool.h>
+
+namespace das2 {
+
+    struct ModelGeneratorSettings {
+        uint64_t uSeed = 1;
+
+        // geometry, every mesh is a height field grid with the same topology
+        uint32_t uMeshCount = 1;
+        uint32_t uVerticesPerMesh = 1024;   // rounded up to a square grid
+        uint32_t uUVSetCount = 1;           // at most 8
+        bool bNormals = true;
+        uint32_t uLodCount = 0;             // additional levels in Mesh::multipleLods, each halves the grid resolution
+        uint32_t uMorphTargetCount = 0;     // per mesh, with position and normal deltas
+
+        // hierarchy, node i owns mesh group i if i < uMeshCount, nodes beyond that are pure transforms
+        uint32_t uNodeCount = 0;            // raised to uMeshCount if smaller
+        uint32_t uNodeBranching = 4;        // children per node, 1 creates a single chain and 0 attaches all nodes to the root
+
+        // skinning, meshes are bound to skeletons in round robin order with one joint set of four influences per vertex
+        uint32_t uSkeletonCount = 0;
+        uint32_t uJointCount = 32;          // per skeleton
+        uint32_t uJointBranching = 2;       // same meaning as uNodeBranching
+
+        // animations rotate every joint, translate the first uAnimatedNodeCount nodes and animate their morph weights
+        uint32_t uAnimationCount = 0;
+        uint32_t uKeyframeCount = 32;
+        uint32_t uAnimatedNodeCount = 1;
+        float fAnimationDuration = 1.f;     // seconds
+
+        uint32_t uMaterialCount = 1;
+        uint8_t bZstdLevel = 0;
+    };
+
+
+    // Generates das2 models and Wavefront OBJ text of arbitrary size from a seed.
+    // The output only depends on the settings, not on the thread count or the chosen output path, thus
+    // Write() produces the same bytes as serializing the model returned by Generate().
+    // Mesh data is generated per mesh from a seed derived from uSeed and the mesh index, which allows
+    // Write() and WriteObj() to stream it without ever holding more than a bounded batch of meshes in memory.
+    class DAS2_API ModelGenerator {
+        private:
+            // byte offsets of vertex streams of one level of detail, relative to the beginning of the mesh block
+            struct _LodLayout {
+                uint32_t uSide = 2;
+                uint64_t uPositions = 0;
+                uint64_t uNormals = 0;
+                uint64_t arrUVs[8] = {};
+                uint64_t uIndices = 0;
+                uint64_t uJointIndices = 0;
+                uint64_t uJointWeights = 0;
+            };
+
+            struct _MorphLayout {
+                uint64_t uPositions = 0;
+                uint64_t uNormals = 0;
+            };
+
+            ModelGeneratorSettings m_settings;
+            ThreadPool* m_pThreadPool = nullptr;
+
+            std::vector<_LodLayout> m_lods;         // index 0 is the base mesh
+            std::vector<_MorphLayout> m_morphTargets;
+            uint64_t m_uMeshBlockSize = 0;
+
+        private:
+            void _CheckBufferSize() const;
+            void _BuildStructures(Model& _model) const;
+            void _LayoutMesh(Mesh& _mesh, const _LodLayout& _lod, uint64_t _uBase) const;
+            void _GenerateMeshBlock(uint32_t _uMesh, char* _pOut) const;
+            void _GenerateBlocks(uint32_t _uFirst, uint32_t _uCount, char* _pOut) const;
+
+        public:
+            // _pThreadPool: optional thread pool to generate meshes with, can be nullptr
+            ModelGenerator(const ModelGeneratorSettings& _settings, ThreadPool* _pThreadPool = nullptr);
+
+            // Throws BufferRangeException if the generated buffer does not fit into 32-bit das2 offsets.
+            Model Generate(std::pmr::memory_resource* _pResource = std::pmr::get_default_resource()) const;
+
+            // Streams a das2 file to _stream, memory use is bounded by the structures and one batch of mesh blocks.
+            // Throws BufferRangeException if the generated buffer does not fit into 32-bit das2 offsets.
+            void Write(std::ostream& _stream) const;
+
+            // Streams the base level geometry of all meshes as OBJ groups with quad faces, the output size is not limited.
+            // Meshes are placed next to each other, since OBJ has no node hierarchy.
+            void WriteObj(std::ostream& _stream) const;
+
+            inline uint64_t GetBufferSize() const {
+                return m_uMeshBlockSize * m_settings.uMeshCount;
+            }
+
+            inline const ModelGeneratorSettings& GetSettings() const {
+                return m_settings;
+            }
+    };
+}
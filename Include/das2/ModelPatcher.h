@@ -0,0 +1,92 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: ModelPatcher.h - header of in-place patching of uncompressed das2 files
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include <das2/Api.h>
+#include <das2/DasStructures.h>
+#include <das2/Statistics.h>
+
+namespace das2 {
+
+    enum PatchMode : uint8_t {
+        PatchMode_None,         // nothing changed
+        PatchMode_InPlace,      // changed records were overwritten at their offsets
+        PatchMode_Tail,         // all structure records after the buffer were rewritten
+        PatchMode_Rewrite       // the file was rewritten with the buffer copied byte by byte
+    };
+
+
+    struct PatchResult {
+        PatchMode eMode = PatchMode_None;
+        uint64_t uBytesWritten = 0;
+    };
+
+
+    // Edits the structures of an uncompressed das2 file without loading or reserializing its buffer.
+    // All structure records are loaded into GetModel(), whose buffer stays empty and is never written. On Commit() the
+    // records are serialized again and compared against the file:
+    //  - records whose size did not change are overwritten in place,
+    //  - otherwise, or if records were added or removed, all records after the buffer are rewritten and the file is
+    //    truncated to its new size,
+    //  - only a header, which changes its size, or a file with structures in front of the buffer needs a full rewrite,
+    //    in which the buffer is copied without being parsed.
+    // Records of each type keep their order, thus indices between structures stay valid.
+    // Whole-stream zstd compression has no independently encoded frames, compressed files are rejected and have to be
+    // loaded with Unserializer and written with Serializer instead.
+    // In-place and tail writes are not atomic, a full rewrite goes through a temporary file.
+    class DAS2_API ModelPatcher {
+        private:
+            struct _Record {
+                uint64_t uOffset = 0;
+                std::string bytes;      // serialized record as it is stored in the file
+            };
+
+            std::filesystem::path m_path;
+            std::fstream m_stream;
+            Model m_model;
+
+            std::string m_header;
+            uint64_t m_uBufferOffset = 0;
+            uint64_t m_uBufferRecordSize = 0;   // identifier, length and data, 0 if the file has no buffer
+            uint64_t m_uTailOffset = 0;         // first byte after the buffer or the header
+            bool m_bCanonical = true;           // header, buffer and then all other records
+            std::vector<_Record> m_arrRecords[DAS2_STATISTICS_STRUCTURE_COUNT];
+
+        private:
+            void _Open();
+            void _Load();
+            std::vector<std::string> _SerializeRecords(StructureIdentifier _bIdentifier) const;
+            void _Snapshot(const std::string& _header, std::vector<std::string>* _pRecords, uint64_t _uTailOffset);
+            uint64_t _WriteTail(std::ostream& _stream, std::vector<std::string>* _pRecords) const;
+            void _RewriteFile(const std::string& _header, std::vector<std::string>* _pRecords, PatchResult& _result);
+
+        public:
+            // Throws SerializerException if the file cannot be opened or is compressed and MagicValueException if it is
+            // not a das2 file
+            ModelPatcher(const std::filesystem::path& _path, std::pmr::memory_resource* _pResource = std::pmr::get_default_resource());
+            ModelPatcher(const ModelPatcher&) = delete;
+            ModelPatcher& operator=(const ModelPatcher&) = delete;
+
+            // structures of the file, the buffer is not loaded and changes to it are ignored
+            inline Model& GetModel() {
+                return m_model;
+            }
+
+            inline uint32_t GetBufferSize() const {
+                return m_uBufferRecordSize ? static_cast<uint32_t>(m_uBufferRecordSize - sizeof(StructureIdentifier) - sizeof(uint32_t)) : 0;
+            }
+
+            // writes all changes made to GetModel() since loading or the last commit
+            PatchResult Commit();
+    };
+}
@@ -0,0 +1,46 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: MorphBlending.h - header of morph target blending kernel
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <das2/Api.h>
+#include <das2/DasStructures.h>
+#include <das2/ThreadPool.h>
+
+namespace das2 {
+
+    // Blended vertex streams of a mesh, which can be reused between BlendMorphTargets() calls to avoid reallocations
+    struct MorphBlendBuffer {
+        std::vector<float> positions;       // 3 floats per vertex
+        std::vector<float> normals;         // 3 floats per vertex, normalized, empty if the mesh has no normals
+        std::vector<float> arrUVs[8];       // 2 floats per vertex for each blended UV set, empty if the mesh lacks the set
+
+        // active morph targets and their delta streams of the last call, kept here to avoid allocations
+        std::vector<uint32_t> activeTargets;
+        std::vector<const float*> deltaStreams;
+    };
+
+
+    // Describes which vertex streams of a mesh and its morph targets are blended.
+    // das2::Mesh does not store its vertex count, thus it must be given explicitly.
+    struct MorphBlendSettings {
+        size_t uVertexCount = 0;
+        bool bNormals = true;
+        uint32_t uUVSetCount = 0;
+        float fWeightEpsilon = 1e-5f;       // targets with smaller absolute weights are skipped
+    };
+
+
+    // Computes base + sum(weight[i] * delta[i]) for positions, normals and UV sets of _mesh.
+    // _pWeights: one weight per morph target of _mesh, _uWeightCount can be smaller than the number of morph targets
+    // _pThreadPool: optional thread pool to distribute vertex blocks across, can be nullptr
+    // Throws BufferRangeException if any of the streams does not fit into the model buffer.
+    DAS2_API void BlendMorphTargets(const Model& _model, const Mesh& _mesh, const float* _pWeights, size_t _uWeightCount,
+                                    const MorphBlendSettings& _settings, MorphBlendBuffer& _out, ThreadPool* _pThreadPool = nullptr);
+}
@@ -0,0 +1,82 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: SceneEvaluator.h - header of flattened scene graph world transformation evaluator
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <das2/Api.h>
+#include <das2/DasStructures.h>
+#include <das2/ThreadPool.h>
+#include <das2/Transform.h>
+
+namespace das2 {
+
+    // Scene graph evaluator, which flattens the node hierarchy of a scene into topological level-by-level order.
+    // Local transformation properties and computed world matrices are stored as structures of arrays, thus world
+    // transformations of each level can be evaluated with SIMD and in parallel, since nodes of one level only depend
+    // on the previous level.
+    //
+    // Local transformation of a node is computed as mCustomTransform * T * R * S.
+    class DAS2_API SceneEvaluator {
+        private:
+            ThreadPool* m_pThreadPool = nullptr;
+
+            std::vector<uint32_t> m_nodeIds;        // flattened index -> model node id
+            std::vector<uint32_t> m_parents;        // flattened index -> flattened parent index
+            std::vector<uint32_t> m_levelOffsets;   // level i spans [m_levelOffsets[i], m_levelOffsets[i+1])
+            std::vector<uint32_t> m_flatIndices;    // model node id -> flattened index
+
+            // local pose
+            std::vector<float> m_rotations[4];
+            std::vector<float> m_translations[3];
+            std::vector<float> m_scales;
+
+            // custom transforms and world matrices as 3x4 element arrays
+            std::vector<uint8_t> m_hasCustomTransform;
+            std::vector<float> m_customTransforms[12];
+            std::vector<float> m_worldTransforms[12];
+
+        private:
+            void _Flatten(const Model& _model, uint32_t _uSceneIndex);
+            void _EvaluateRange(size_t _uBegin, size_t _uEnd, bool _bRootLevel);
+
+        public:
+            // _pThreadPool: optional thread pool to evaluate large levels with, can be nullptr
+            SceneEvaluator(const Model& _model, uint32_t _uSceneIndex, ThreadPool* _pThreadPool = nullptr);
+
+            // Modify the local pose of the node by its model node id
+            void SetLocalPose(uint32_t _uNodeId, const LocalPose& _pose);
+            // _pPoses: array of local poses indexed by model node id, nodes that are not part of the scene are ignored
+            void SetLocalPoses(const LocalPose* _pPoses, size_t _uPoseCount);
+            LocalPose GetLocalPose(uint32_t _uNodeId) const;
+
+            // Recompute world transformations of all nodes in the scene
+            void Evaluate();
+
+            Matrix3x4 GetWorldTransform(uint32_t _uNodeId) const;
+            // _pOut: array of GetNodeCount() matrices, written in flattened order (see GetNodeOrder())
+            void CopyWorldTransforms(Matrix3x4* _pOut) const;
+
+            inline bool Contains(uint32_t _uNodeId) const {
+                return _uNodeId < m_flatIndices.size() && m_flatIndices[_uNodeId] != static_cast<uint32_t>(-1);
+            }
+
+            inline size_t GetNodeCount() const {
+                return m_nodeIds.size();
+            }
+
+            inline size_t GetLevelCount() const {
+                return m_levelOffsets.size() - 1;
+            }
+
+            // model node ids in flattened order, parents always precede their children
+            inline const std::vector<uint32_t>& GetNodeOrder() const {
+                return m_nodeIds;
+            }
+    };
+}
@@ -7,30 +7,48 @@
 
 #include <das2/Api.h>
 #include <das2/DasStructures.h>
+#include <das2/Statistics.h>
+#include <functional>
 #include <ostream>
 
 namespace das2 {
 
     class DAS2_API Serializer {
+        public:
+            // writes the data of the buffer record, its identifier and length are written by the serializer
+            using BufferWriter = std::function<void(std::ostream&)>;
+
         private:
             std::ostream& m_stream;
             const Model& m_model;
+            SaveStats* m_pStats = nullptr;
 
         private:
             template <typename T>
-            void _StreamUncompressedArray(const std::vector<T>& _vec, std::ostream& _stream) {
+            void _StreamUncompressedArray(const std::pmr::vector<T>& _vec, StructureIdentifier _bIdentifier, std::ostream& _stream) {
                 for (auto it = _vec.begin(); it != _vec.end(); it++) {
+                    StructureStatsScope scope(m_pStats, _bIdentifier, _stream);
                     it->Write(_stream);
                 }
             }
 
-            void _StreamUncompressed(std::ostream& _stream);
-            void _StreamCompressed();
+            void _StreamUncompressed(std::ostream& _stream, uint32_t _uBufferSize, const BufferWriter* _pfnWriteBuffer);
+            void _StreamCompressed(std::ostream& _stream);
+            void _StreamCompressed(std::ostream& _stream, uint32_t _uBufferSize, const BufferWriter& _fnWriteBuffer);
+            void _Serialize(uint32_t _uBufferSize, const BufferWriter* _pfnWriteBuffer);
 
         public:
-            Serializer(std::ostream& _stream, const Model& _model) :
+            // _pStats: optional statistics to accumulate into, can be nullptr
+            Serializer(std::ostream& _stream, const Model& _model, SaveStats* _pStats = nullptr) :
                 m_stream(_stream),
-                m_model(_model) {}
+                m_model(_model),
+                m_pStats(_pStats) {}
             void Serialize();
+
+            // Serializes the model with a buffer of _uBufferSize bytes, which _fnWriteBuffer writes instead of the model's own
+            // buffer. Lets writers, which generate or spill the buffer, emit it in pieces without holding it in memory.
+            // Compressed output is streamed through the compressor as well, thus buffer and structure statistics include
+            // the compression of the data they write.
+            void Serialize(uint32_t _uBufferSize, const BufferWriter& _fnWriteBuffer);
     };
 }
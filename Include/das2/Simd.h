@@ -0,0 +1,103 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: Simd.h - header of thin SIMD lane abstractions used by das2 evaluation kernels
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define DAS2_SSE2
+    #include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+    #define DAS2_AVX2
+    #include <immintrin.h>
+#endif
+
+namespace das2 {
+    namespace simd {
+
+        // Kernels are written once as templates over a lane type and instantiated for the widest
+        // available instruction set as well as for scalar tails.
+        struct Scalar {
+            using Type = float;
+            static constexpr size_t uWidth = 1;
+
+            static inline Type Load(const float* _pData) { return *_pData; }
+            static inline void Store(float* _pData, Type _v) { *_pData = _v; }
+            static inline Type Gather(const float* _pData, const uint32_t* _pIndices) { return _pData[_pIndices[0]]; }
+            static inline Type Set(float _f) { return _f; }
+            static inline Type Add(Type _a, Type _b) { return _a + _b; }
+            static inline Type Sub(Type _a, Type _b) { return _a - _b; }
+            static inline Type Mul(Type _a, Type _b) { return _a * _b; }
+            static inline Type Div(Type _a, Type _b) { return _a / _b; }
+            static inline Type Min(Type _a, Type _b) { return _a < _b ? _a : _b; }
+            static inline Type Max(Type _a, Type _b) { return _a > _b ? _a : _b; }
+            static inline Type Sqrt(Type _a) { return std::sqrt(_a); }
+            // _a * _b + _c
+            static inline Type MulAdd(Type _a, Type _b, Type _c) { return _a * _b + _c; }
+        };
+
+#ifdef DAS2_SSE2
+        struct Sse {
+            using Type = __m128;
+            static constexpr size_t uWidth = 4;
+
+            static inline Type Load(const float* _pData) { return _mm_loadu_ps(_pData); }
+            static inline void Store(float* _pData, Type _v) { _mm_storeu_ps(_pData, _v); }
+            static inline Type Gather(const float* _pData, const uint32_t* _pIndices) {
+                return _mm_setr_ps(_pData[_pIndices[0]], _pData[_pIndices[1]], _pData[_pIndices[2]], _pData[_pIndices[3]]);
+            }
+            static inline Type Set(float _f) { return _mm_set1_ps(_f); }
+            static inline Type Add(Type _a, Type _b) { return _mm_add_ps(_a, _b); }
+            static inline Type Sub(Type _a, Type _b) { return _mm_sub_ps(_a, _b); }
+            static inline Type Mul(Type _a, Type _b) { return _mm_mul_ps(_a, _b); }
+            static inline Type Div(Type _a, Type _b) { return _mm_div_ps(_a, _b); }
+            static inline Type Min(Type _a, Type _b) { return _mm_min_ps(_a, _b); }
+            static inline Type Max(Type _a, Type _b) { return _mm_max_ps(_a, _b); }
+            static inline Type Sqrt(Type _a) { return _mm_sqrt_ps(_a); }
+            static inline Type MulAdd(Type _a, Type _b, Type _c) { return _mm_add_ps(_mm_mul_ps(_a, _b), _c); }
+        };
+
+        using Wide = Sse;
+#else
+        using Wide = Scalar;
+#endif
+
+#ifdef DAS2_AVX2
+        struct Avx {
+            using Type = __m256;
+            static constexpr size_t uWidth = 8;
+
+            static inline Type Load(const float* _pData) { return _mm256_loadu_ps(_pData); }
+            static inline void Store(float* _pData, Type _v) { _mm256_storeu_ps(_pData, _v); }
+            static inline Type Gather(const float* _pData, const uint32_t* _pIndices) {
+                return _mm256_i32gather_ps(_pData, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_pIndices)), sizeof(float));
+            }
+            static inline Type Set(float _f) { return _mm256_set1_ps(_f); }
+            static inline Type Add(Type _a, Type _b) { return _mm256_add_ps(_a, _b); }
+            static inline Type Sub(Type _a, Type _b) { return _mm256_sub_ps(_a, _b); }
+            static inline Type Mul(Type _a, Type _b) { return _mm256_mul_ps(_a, _b); }
+            static inline Type Div(Type _a, Type _b) { return _mm256_div_ps(_a, _b); }
+            static inline Type Min(Type _a, Type _b) { return _mm256_min_ps(_a, _b); }
+            static inline Type Max(Type _a, Type _b) { return _mm256_max_ps(_a, _b); }
+            static inline Type Sqrt(Type _a) { return _mm256_sqrt_ps(_a); }
+#ifdef __FMA__
+            static inline Type MulAdd(Type _a, Type _b, Type _c) { return _mm256_fmadd_ps(_a, _b, _c); }
+#else
+            static inline Type MulAdd(Type _a, Type _b, Type _c) { return _mm256_add_ps(_mm256_mul_ps(_a, _b), _c); }
+#endif
+        };
+
+        // streaming kernels, which do not depend on a 4 element lane grouping, may use the widest lanes available
+        using Widest = Avx;
+#else
+        using Widest = Wide;
+#endif
+    }
+}
@@ -0,0 +1,66 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: SkeletonPalette.h - header of skinning matrix palette computation for skeletons
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <das2/Api.h>
+#include <das2/DasStructures.h>
+#include <das2/ThreadPool.h>
+#include <das2/Transform.h>
+
+namespace das2 {
+
+    // Precomputed, flattened joint hierarchy of a single das2::Skeleton.
+    // Joints are addressed by their index in Skeleton::joints ("skeleton-local" index), which is the same index
+    // that vertex joint index buffers use. Internally joints are evaluated in parent-before-child order.
+    class DAS2_API SkeletonLayout {
+        private:
+            std::vector<uint32_t> m_jointIds;           // skeleton-local index -> model skeleton joint id
+            std::vector<uint32_t> m_order;              // evaluation slot -> skeleton-local index
+            std::vector<uint32_t> m_parentSlots;        // evaluation slot -> parent evaluation slot
+            std::vector<Matrix3x4> m_inverseBindMatrices;  // skeleton-local index -> inverse bind matrix
+            std::vector<LocalPose> m_restPose;          // skeleton-local index -> local pose stored in the model
+
+        public:
+            SkeletonLayout(const Model& _model, uint32_t _uSkeletonIndex);
+
+            inline size_t GetJointCount() const {
+                return m_jointIds.size();
+            }
+
+            inline const std::vector<uint32_t>& GetJointIds() const {
+                return m_jointIds;
+            }
+
+            inline const std::vector<uint32_t>& GetEvaluationOrder() const {
+                return m_order;
+            }
+
+            inline const std::vector<uint32_t>& GetParentSlots() const {
+                return m_parentSlots;
+            }
+
+            inline const std::vector<Matrix3x4>& GetInverseBindMatrices() const {
+                return m_inverseBindMatrices;
+            }
+
+            // local poses of all joints as they are stored in the model, indexed by skeleton-local index
+            inline const std::vector<LocalPose>& GetRestPose() const {
+                return m_restPose;
+            }
+    };
+
+
+    // Computes joint matrix palettes (world * inverse bind) for many instances of the same skeleton.
+    // _pPoses: _uInstanceCount * GetJointCount() local joint poses, instance-major and indexed by skeleton-local index
+    // _pPalettes: output array of the same size and layout as _pPoses
+    // _pRootTransforms: optional per instance transformations applied to root joints, can be nullptr
+    // _pThreadPool: optional thread pool to distribute instances across, can be nullptr
+    DAS2_API void ComputeJointPalettes(const SkeletonLayout& _layout, const LocalPose* _pPoses, size_t _uInstanceCount, Matrix3x4* _pPalettes,
+                                       const Matrix3x4* _pRootTransforms = nullptr, ThreadPool* _pThreadPool = nullptr);
+}
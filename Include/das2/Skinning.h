@@ -0,0 +1,47 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: Skinning.h - header of CPU linear blend skinning kernel
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <das2/Api.h>
+#include <das2/DasStructures.h>
+#include <das2/ThreadPool.h>
+#include <das2/Transform.h>
+
+#define DAS2_MAX_JOINT_SETS 8
+#define DAS2_JOINTS_PER_SET 4
+
+namespace das2 {
+
+    // Vertex streams of a skinned mesh.
+    // Each joint set holds DAS2_JOINTS_PER_SET influences per vertex: u32 skeleton-local joint indices and f32 weights.
+    struct SkinnedMeshView {
+        const float* pPositions = nullptr;                          // 3 floats per vertex
+        const float* pNormals = nullptr;                            // 3 floats per vertex, can be nullptr
+        const uint32_t* arrJointIndices[DAS2_MAX_JOINT_SETS] = {};
+        const float* arrJointWeights[DAS2_MAX_JOINT_SETS] = {};
+        uint32_t uJointSetCount = 0;
+        size_t uVertexCount = 0;
+    };
+
+
+    // Creates a view of mesh vertex streams stored in the model buffer.
+    // das2::Mesh does not store its vertex count or the number of used joint sets, thus both must be given explicitly.
+    // Throws BufferRangeException if any of the streams does not fit into the buffer.
+    DAS2_API SkinnedMeshView MakeSkinnedMeshView(const Model& _model, const Mesh& _mesh, size_t _uVertexCount, uint32_t _uJointSetCount = 1,
+                                                 bool _bNormals = true);
+
+    // Applies linear blend skinning to all vertices of _view.
+    // _pPalette: joint matrices (world * inverse bind) indexed by skeleton-local joint index, see das2::ComputeJointPalettes()
+    // _pOutPositions: output array of _view.uVertexCount * 3 floats
+    // _pOutNormals: output array of _view.uVertexCount * 3 floats, ignored if the view has no normals, can be nullptr
+    // _pThreadPool: optional thread pool to distribute vertex chunks across, can be nullptr
+    // Throws BufferRangeException if a vertex references a joint outside of the palette.
+    DAS2_API void SkinVertices(const SkinnedMeshView& _view, const Matrix3x4* _pPalette, size_t _uJointCount, float* _pOutPositions,
+                               float* _pOutNormals = nullptr, ThreadPool* _pThreadPool = nullptr);
+}
@@ -0,0 +1,210 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: Statistics.h - header of optional load and save statistics instrumentation
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <das2/Api.h>
+#include <das2/DasStructures.h>
+
+#define DAS2_STATISTICS_STRUCTURE_COUNT (StructureIdentifier_MaterialPbr + 1)
+
+namespace das2 {
+
+    enum StatisticsPhase : uint8_t {
+        StatisticsPhase_Total,
+        StatisticsPhase_Header,
+        StatisticsPhase_Io,                 // time spent in the underlying stream buffer
+        StatisticsPhase_Compression,        // zstd compression or decompression, excluding I/O
+        StatisticsPhase_Structures,         // reading or writing of all structures except the buffer
+        StatisticsPhase_Buffer,             // reading or writing of the buffer blob
+        StatisticsPhase_Triangulation,      // converter phases are summed over all worker threads
+        StatisticsPhase_NormalGeneration,
+        StatisticsPhase_Welding,
+        StatisticsPhase_Layout,
+        StatisticsPhase_Materials,
+        StatisticsPhase_Count
+    };
+
+
+    struct PhaseStats {
+        double fSeconds = 0.0;
+        uint64_t uCount = 0;
+    };
+
+
+    struct StructureStats {
+        uint64_t uCount = 0;
+        uint64_t uBytes = 0;
+        double fSeconds = 0.0;
+    };
+
+
+    // Receives one named metric at a time, e.g. "das2.load.phase.io.seconds"
+    using MetricSink = std::function<void(const std::string& _sName, double _fValue)>;
+
+
+    // Statistics are collected only by operations, which receive a pointer to a statistics object.
+    // Without one every instrumentation point is a single null pointer check.
+    // Values accumulate over multiple operations until Reset() is called.
+    struct DAS2_API IoStats {
+        PhaseStats arrPhases[StatisticsPhase_Count];
+        StructureStats arrStructures[DAS2_STATISTICS_STRUCTURE_COUNT];    // indexed by StructureIdentifier
+        uint64_t uBytesIn = 0;
+        uint64_t uBytesOut = 0;
+
+        // called by the instrumented operation once it has finished, can be empty
+        MetricSink fnExportHook;
+
+        void Reset();
+
+        // Reports every collected value to _fnSink, metric names are prefixed with _szPrefix
+        void Export(const char* _szPrefix, const MetricSink& _fnSink) const;
+    };
+
+
+    // Collected by Unserializer and converters.
+    // uBytesIn: bytes read from the source stream, uBytesOut: uncompressed bytes that were parsed or produced.
+    // Allocations are counted only if the model is backed by a CountingMemoryResource, otherwise bAllocationsCounted stays
+    // false and the allocation metrics are not exported.
+    struct DAS2_API LoadStats : public IoStats {
+        uint64_t uAllocationCount = 0;
+        uint64_t uAllocatedBytes = 0;
+        bool bAllocationsCounted = false;
+
+        void Reset();
+        void Export(const MetricSink& _fnSink) const;
+
+        // invokes fnExportHook if it is set
+        inline void Publish() const {
+            if (fnExportHook)
+                Export(fnExportHook);
+        }
+    };
+
+
+    // Collected by Serializer.
+    // uBytesIn: uncompressed bytes that were serialized, uBytesOut: bytes written to the destination stream.
+    struct DAS2_API SaveStats : public IoStats {
+        void Export(const MetricSink& _fnSink) const;
+
+        inline void Publish() const {
+            if (fnExportHook)
+                Export(fnExportHook);
+        }
+    };
+
+
+    inline PhaseStats* GetPhaseStats(IoStats* _pStats, StatisticsPhase _ePhase) {
+        return _pStats ? &_pStats->arrPhases[_ePhase] : nullptr;
+    }
+
+
+    // Adds the lifetime of the timer to a phase, does nothing if the phase is nullptr
+    class StatsTimer {
+        private:
+            PhaseStats* m_pPhase;
+            std::chrono::steady_clock::time_point m_start;
+
+        public:
+            explicit StatsTimer(PhaseStats* _pPhase) :
+                m_pPhase(_pPhase)
+            {
+                if (m_pPhase)
+                    m_start = std::chrono::steady_clock::now();
+            }
+
+            StatsTimer(const StatsTimer&) = delete;
+            StatsTimer& operator=(const StatsTimer&) = delete;
+
+            ~StatsTimer() {
+                if (m_pPhase) {
+                    m_pPhase->fSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+                    m_pPhase->uCount++;
+                }
+            }
+    };
+
+
+    // Records count, size and time of reading or writing a single structure.
+    // The time is also added to the buffer or structures phase.
+    class DAS2_API StructureStatsScope {
+        private:
+            IoStats* m_pStats;
+            StructureIdentifier m_bIdentifier;
+            std::istream* m_pInput = nullptr;
+            std::ostream* m_pOutput = nullptr;
+            std::streamoff m_uStart = 0;
+            std::chrono::steady_clock::time_point m_start;
+
+        private:
+            void _Begin(std::istream& _stream);
+            void _Begin(std::ostream& _stream);
+            void _End();
+
+        public:
+            // the null checks are inline, thus scopes without statistics never call into the library
+            StructureStatsScope(IoStats* _pStats, StructureIdentifier _bIdentifier, std::istream& _stream) :
+                m_pStats(_pStats),
+                m_bIdentifier(_bIdentifier)
+            {
+                if (m_pStats)
+                    _Begin(_stream);
+            }
+
+            StructureStatsScope(IoStats* _pStats, StructureIdentifier _bIdentifier, std::ostream& _stream) :
+                m_pStats(_pStats),
+                m_bIdentifier(_bIdentifier)
+            {
+                if (m_pStats)
+                    _Begin(_stream);
+            }
+
+            StructureStatsScope(const StructureStatsScope&) = delete;
+            StructureStatsScope& operator=(const StructureStatsScope&) = delete;
+
+            ~StructureStatsScope() {
+                if (m_pStats)
+                    _End();
+            }
+    };
+
+
+    // Stream buffer, which forwards all reads or all writes to another stream buffer and adds the time spent in it
+    // to a phase. Used to separate I/O from decompression and parsing. Only relative seeks are supported, reads can seek
+    // if the target can and writes only support position queries.
+    class DAS2_API TimedStreamBuffer : public std::streambuf {
+        private:
+            std::streambuf* m_pTarget;
+            PhaseStats* m_pPhase;
+            uint64_t* m_pBytes;
+            std::vector<char> m_buffer;
+            uint64_t m_uPosition = 0;       // stream position of the beginning of the current get or put area
+
+        private:
+            bool _Flush();
+
+        protected:
+            int_type underflow() override;
+            std::streamsize xsgetn(char* _pData, std::streamsize _uCount) override;
+            int_type overflow(int_type _ch) override;
+            std::streamsize xsputn(const char* _pData, std::streamsize _uCount) override;
+            int sync() override;
+            pos_type seekoff(off_type _iOffset, std::ios_base::seekdir _eDir, std::ios_base::openmode _eMode) override;
+
+        public:
+            // _pBytes: counter of bytes transferred from or to _pTarget
+            TimedStreamBuffer(std::streambuf* _pTarget, PhaseStats* _pPhase, uint64_t* _pBytes, size_t _uBufferSize = 1 << 16);
+            ~TimedStreamBuffer();
+    };
+}
@@ -0,0 +1,51 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: ThreadPool.h - header of a simple worker thread pool used by parallel das2 algorithms
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+#include <das2/Api.h>
+
+namespace das2 {
+
+    class DAS2_API ThreadPool {
+        private:
+            std::vector<std::thread> m_workers;
+            std::deque<std::function<void()>> m_tasks;
+            std::mutex m_mutex;
+            std::condition_variable m_cvTask;
+            bool m_bStop = false;
+
+        private:
+            void _WorkerLoop();
+
+        public:
+            // _uThreadCount: number of worker threads, 0 means std::thread::hardware_concurrency()
+            ThreadPool(uint32_t _uThreadCount = 0);
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+            ~ThreadPool();
+
+            std::future<void> Submit(std::function<void()> _fnTask);
+
+            // Splits [_uBegin, _uEnd) into chunks of _uGrain elements and calls _fnBody(uChunkBegin, uChunkEnd) for each chunk.
+            // The calling thread participates in work and the call returns once all chunks are processed.
+            // The first exception thrown by _fnBody is rethrown in the calling thread.
+            void ParallelFor(size_t _uBegin, size_t _uEnd, size_t _uGrain, const std::function<void(size_t, size_t)>& _fnBody);
+
+            inline uint32_t GetThreadCount() const {
+                return static_cast<uint32_t>(m_workers.size());
+            }
+    };
+}
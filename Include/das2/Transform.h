@@ -0,0 +1,176 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: Transform.h - header of affine transformation helpers shared by scene and skeleton evaluators
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstring>
+#include <trs/Vector.h>
+#include <trs/Matrix.h>
+#include <trs/Quaternion.h>
+#include <das2/Simd.h>
+
+namespace das2 {
+
+    // Row-major 3x4 affine matrix, the implicit fourth row is [ 0, 0, 0, 1 ].
+    // Column vectors are used, so the translation is stored in the last column.
+    struct alignas(16) Matrix3x4 {
+        float m[3][4] = {
+            { 1.f, 0.f, 0.f, 0.f },
+            { 0.f, 1.f, 0.f, 0.f },
+            { 0.f, 0.f, 1.f, 0.f }
+        };
+    };
+
+
+    // Local transformation properties of a node or a skeleton joint
+    struct LocalPose {
+        TRS::Quaternion qRotation;
+        TRS::Vector3<float> vTranslation;
+        float fScale = 1.f;
+    };
+
+
+    // das2 stores matrices in row-major order, thus the first three rows form the affine part
+    inline Matrix3x4 ToMatrix3x4(const TRS::Matrix4<float>& _mat) {
+        float arrElements[16];
+        static_assert(sizeof(TRS::Matrix4<float>) == sizeof(arrElements), "TRS::Matrix4<float> must consist of 16 floats");
+        std::memcpy(arrElements, &_mat, sizeof(arrElements));
+
+        Matrix3x4 out;
+        std::memcpy(out.m, arrElements, sizeof(out.m));
+        return out;
+    }
+
+
+    inline TRS::Matrix4<float> ToMatrix4(const Matrix3x4& _mat) {
+        float arrElements[16] = {};
+        static_assert(sizeof(TRS::Matrix4<float>) == sizeof(arrElements), "TRS::Matrix4<float> must consist of 16 floats");
+        std::memcpy(arrElements, _mat.m, sizeof(_mat.m));
+        arrElements[15] = 1.f;
+
+        TRS::Matrix4<float> out;
+        std::memcpy(&out, arrElements, sizeof(arrElements));
+        return out;
+    }
+
+
+    // T * R * S
+    inline Matrix3x4 ComposeTransform(const TRS::Quaternion& _qRotation, const TRS::Vector3<float>& _vTranslation, float _fScale) {
+        const float x = _qRotation.x, y = _qRotation.y, z = _qRotation.z, w = _qRotation.w;
+        const float xx = x * x, yy = y * y, zz = z * z;
+        const float xy = x * y, xz = x * z, yz = y * z;
+        const float wx = w * x, wy = w * y, wz = w * z;
+
+        Matrix3x4 out;
+        out.m[0][0] = (1.f - 2.f * (yy + zz)) * _fScale;
+        out.m[0][1] = 2.f * (xy - wz) * _fScale;
+        out.m[0][2] = 2.f * (xz + wy) * _fScale;
+        out.m[0][3] = _vTranslation.first;
+        out.m[1][0] = 2.f * (xy + wz) * _fScale;
+        out.m[1][1] = (1.f - 2.f * (xx + zz)) * _fScale;
+        out.m[1][2] = 2.f * (yz - wx) * _fScale;
+        out.m[1][3] = _vTranslation.second;
+        out.m[2][0] = 2.f * (xz - wy) * _fScale;
+        out.m[2][1] = 2.f * (yz + wx) * _fScale;
+        out.m[2][2] = (1.f - 2.f * (xx + yy)) * _fScale;
+        out.m[2][3] = _vTranslation.third;
+        return out;
+    }
+
+
+    inline Matrix3x4 ComposeTransform(const LocalPose& _pose) {
+        return ComposeTransform(_pose.qRotation, _pose.vTranslation, _pose.fScale);
+    }
+
+
+    // _out = _lhs * _rhs, _out may alias either of the operands
+    inline void Multiply(const Matrix3x4& _lhs, const Matrix3x4& _rhs, Matrix3x4& _out) {
+#ifdef DAS2_SSE2
+        // each output row is a linear combination of the right hand side rows
+        const __m128 r0 = _mm_load_ps(_rhs.m[0]);
+        const __m128 r1 = _mm_load_ps(_rhs.m[1]);
+        const __m128 r2 = _mm_load_ps(_rhs.m[2]);
+        const __m128 r3 = _mm_set_ps(1.f, 0.f, 0.f, 0.f);
+
+        __m128 arrRows[3];
+        for (int i = 0; i < 3; i++) {
+            const __m128 l = _mm_load_ps(_lhs.m[i]);
+            __m128 row = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1));
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2));
+            arrRows[i] = _mm_add_ps(row, _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3));
+        }
+
+        _mm_store_ps(_out.m[0], arrRows[0]);
+        _mm_store_ps(_out.m[1], arrRows[1]);
+        _mm_store_ps(_out.m[2], arrRows[2]);
+#else
+        Matrix3x4 result;
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 4; j++) {
+                result.m[i][j] = _lhs.m[i][0] * _rhs.m[0][j] + _lhs.m[i][1] * _rhs.m[1][j] + _lhs.m[i][2] * _rhs.m[2][j];
+            }
+            result.m[i][3] += _lhs.m[i][3];
+        }
+        _out = result;
+#endif
+    }
+
+
+    inline Matrix3x4 operator*(const Matrix3x4& _lhs, const Matrix3x4& _rhs) {
+        Matrix3x4 out;
+        Multiply(_lhs, _rhs, out);
+        return out;
+    }
+
+
+    // Lane-wise variants of the helpers above, see das2/Simd.h. Matrices are passed as 12 lanes in row-major order.
+
+    // _out = _lhs * _rhs, _out may alias either of the operands
+    template <typename L>
+    inline void MultiplyLanes(const typename L::Type* _lhs, const typename L::Type* _rhs, typename L::Type* _out) {
+        using V = typename L::Type;
+        V result[12];
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 4; j++) {
+                V v = L::Mul(_lhs[i * 4], _rhs[j]);
+                v = L::MulAdd(_lhs[i * 4 + 1], _rhs[4 + j], v);
+                v = L::MulAdd(_lhs[i * 4 + 2], _rhs[8 + j], v);
+                result[i * 4 + j] = v;
+            }
+            result[i * 4 + 3] = L::Add(result[i * 4 + 3], _lhs[i * 4 + 3]);
+        }
+
+        for (int i = 0; i < 12; i++)
+            _out[i] = result[i];
+    }
+
+
+    // T * R * S, _pRotation: quaternion x, y, z, w lanes; _pTranslation: x, y, z lanes
+    template <typename L>
+    inline void ComposeTransformLanes(const typename L::Type* _pRotation, const typename L::Type* _pTranslation, typename L::Type _scale, typename L::Type* _out) {
+        using V = typename L::Type;
+        const V x = _pRotation[0], y = _pRotation[1], z = _pRotation[2], w = _pRotation[3];
+        const V one = L::Set(1.f);
+        const V two = L::Set(2.f);
+
+        const V xx = L::Mul(x, x), yy = L::Mul(y, y), zz = L::Mul(z, z);
+        const V xy = L::Mul(x, y), xz = L::Mul(x, z), yz = L::Mul(y, z);
+        const V wx = L::Mul(w, x), wy = L::Mul(w, y), wz = L::Mul(w, z);
+
+        _out[0] = L::Mul(L::Sub(one, L::Mul(two, L::Add(yy, zz))), _scale);
+        _out[1] = L::Mul(L::Mul(two, L::Sub(xy, wz)), _scale);
+        _out[2] = L::Mul(L::Mul(two, L::Add(xz, wy)), _scale);
+        _out[3] = _pTranslation[0];
+        _out[4] = L::Mul(L::Mul(two, L::Add(xy, wz)), _scale);
+        _out[5] = L::Mul(L::Sub(one, L::Mul(two, L::Add(xx, zz))), _scale);
+        _out[6] = L::Mul(L::Mul(two, L::Sub(yz, wx)), _scale);
+        _out[7] = _pTranslation[1];
+        _out[8] = L::Mul(L::Mul(two, L::Sub(xz, wy)), _scale);
+        _out[9] = L::Mul(L::Mul(two, L::Add(yz, wx)), _scale);
+        _out[10] = L::Mul(L::Sub(one, L::Mul(two, L::Add(xx, yy))), _scale);
+        _out[11] = _pTranslation[2];
+    }
+}
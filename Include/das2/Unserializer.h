@@ -6,22 +6,28 @@
 #pragma once
 
 #include <istream>
+#include <memory_resource>
 
 #include <das2/Api.h>
 #include <das2/DasStructures.h>
+#include <das2/Statistics.h>
 
 namespace das2 {
     class DAS2_API Unserializer {
         private:
             std::istream& m_stream;
             Model m_model;
+            LoadStats* m_pStats = nullptr;
 
         private:
-            void _ReadCompressed();
+            void _ReadCompressed(std::istream& _stream);
             void _ReadUncompressed(std::istream& _stream);
+            void _Unserialize();
 
         public:
-            Unserializer(std::istream& _stream);
+            // _pResource: memory resource that backs every allocation of the unserialized model
+            // _pStats: optional statistics to accumulate into, can be nullptr
+            Unserializer(std::istream& _stream, std::pmr::memory_resource* _pResource = std::pmr::get_default_resource(), LoadStats* _pStats = nullptr);
             void Unserialize();
             inline Model&& Get() {
                 return std::move(m_model);
@@ -0,0 +1,127 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: Benchmark.h - header of the das2 benchmark harness
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace das2 {
+    namespace bench {
+
+        struct BenchmarkSettings {
+            double fMinTime = 0.5;              // minimum measured wall time per benchmark in seconds
+            uint32_t uMinIterations = 1;
+            uint32_t uScale = 1;                // multiplier for input sizes
+            uint32_t uThreadCount = 0;          // worker threads of parallel benchmarks, 0 means hardware concurrency
+        };
+
+
+        struct BenchmarkResult {
+            std::string sName;
+            uint64_t uIterations = 0;
+            double fSeconds = 0.0;              // total measured wall time
+            uint64_t uBytes = 0;                // bytes processed per iteration, 0 if not applicable
+            uint64_t uItems = 0;                // items processed per iteration, 0 if not applicable
+            double fAllocations = 0.0;          // heap allocations per iteration
+            double fAllocatedBytes = 0.0;       // heap bytes allocated per iteration
+            uint64_t uPeakRss = 0;              // peak resident set size during the benchmark, since process start if it cannot be reset
+
+            inline double GetSecondsPerIteration() const {
+                return uIterations ? fSeconds / static_cast<double>(uIterations) : 0.0;
+            }
+
+            inline double GetMegabytesPerSecond() const {
+                return fSeconds > 0.0 ? static_cast<double>(uBytes) * static_cast<double>(uIterations) / fSeconds / 1e6 : 0.0;
+            }
+
+            inline double GetItemsPerSecond() const {
+                return fSeconds > 0.0 ? static_cast<double>(uItems) * static_cast<double>(uIterations) / fSeconds : 0.0;
+            }
+        };
+
+
+        // Passed to every benchmark function, which prepares its input untimed and then calls Measure() once.
+        class BenchmarkContext {
+            private:
+                const BenchmarkSettings& m_settings;
+                BenchmarkResult& m_result;
+
+            public:
+                BenchmarkContext(const BenchmarkSettings& _settings, BenchmarkResult& _result) :
+                    m_settings(_settings),
+                    m_result(_result) {}
+
+                inline const BenchmarkSettings& GetSettings() const {
+                    return m_settings;
+                }
+
+                // runs _fnBody once for warm up and then repeatedly until fMinTime and uMinIterations are reached
+                // _uBytes, _uItems: amount of data processed by a single call of _fnBody
+                void Measure(uint64_t _uBytes, uint64_t _uItems, const std::function<void()>& _fnBody);
+        };
+
+
+        using BenchmarkFunction = std::function<void(BenchmarkContext&)>;
+
+        class BenchmarkRegistry {
+            private:
+                std::vector<std::pair<std::string, BenchmarkFunction>> m_benchmarks;
+
+            public:
+                void Add(const std::string& _sName, BenchmarkFunction _fnBenchmark);
+
+                // runs every benchmark whose name contains _sFilter and prints progress into _log
+                std::vector<BenchmarkResult> Run(const BenchmarkSettings& _settings, const std::string& _sFilter, std::ostream& _log) const;
+
+                inline const std::vector<std::pair<std::string, BenchmarkFunction>>& GetBenchmarks() const {
+                    return m_benchmarks;
+                }
+        };
+
+
+        // process-wide counters of global operator new calls, the benchmark executable replaces the global allocation functions
+        // allocations made inside a shared das2 library are not counted on Windows, where each module has its own operators
+        uint64_t GetAllocationCount();
+        uint64_t GetAllocatedBytes();
+
+        // resets the peak resident set size to the current one, returns false if unsupported (everywhere but Linux)
+        bool ResetPeakRss();
+
+        // peak resident set size of the process in bytes since start or the last successful ResetPeakRss(), 0 if unsupported
+        uint64_t GetPeakRss();
+
+        void WriteTable(std::ostream& _stream, const std::vector<BenchmarkResult>& _results);
+        void WriteJson(std::ostream& _stream, const BenchmarkSettings& _settings, const std::vector<BenchmarkResult>& _results);
+
+
+        // read-only stream buffer over existing memory, avoids copying inputs into a std::stringstream per iteration
+        class MemoryStreamBuffer : public std::streambuf {
+            protected:
+                pos_type seekoff(off_type _iOffset, std::ios_base::seekdir _dir, std::ios_base::openmode _mode) override;
+                pos_type seekpos(pos_type _uPosition, std::ios_base::openmode _mode) override;
+
+            public:
+                MemoryStreamBuffer(const char* _pData, size_t _uSize);
+        };
+
+
+        // deterministic inputs shared by benchmarks
+        std::string GenerateObjText(size_t _uTargetSize, uint32_t _uGroupCount);
+
+        void RegisterSerializationBenchmarks(BenchmarkRegistry& _registry);
+        void RegisterStringBenchmarks(BenchmarkRegistry& _registry);
+#ifdef DAS2_BENCH_WAVEFRONT_OBJ
+        void RegisterObjBenchmarks(BenchmarkRegistry& _registry);
+        void RegisterConverterBenchmarks(BenchmarkRegistry& _registry);
+#endif
+    }
+}
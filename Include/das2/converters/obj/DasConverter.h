@@ -15,70 +15,59 @@
 #include <trs/Vector.h>
 
 #include <das2/converters/obj/Data.h>
+#include <das2/converters/obj/NormalGenerator.h>
+#include <das2/converters/obj/Triangulator.h>
+#include <das2/converters/obj/VertexWelder.h>
 #include <das2/DasStructures.h>
 #include <das2/IConverter.h>
 #include <das2/Serializer.h>
+#include <das2/Statistics.h>
+#include <das2/ThreadPool.h>
 
+#include <array>
 #include <cstdint>
-#include <unordered_set>
+#include <memory>
+#include <utility>
+#include <vector>
 
 
-namespace das2 {
-    namespace obj {
-        struct UnifiedVertex {
-            TRS::Vector3<float> positionVertex;
-            TRS::Vector2<float> textureVertex;
-            TRS::Vector3<float> normalVertex;
-
-            bool operator==(const UnifiedVertex& _vt) const {
-                return positionVertex == _vt.positionVertex && textureVertex == _vt.textureVertex && normalVertex == _vt.normalVertex;
-            }
-        };
-    }
-}
-
-namespace std {
-    template <>
-    struct hash<TRS::Vector3<float>> {
-        size_t operator()(const TRS::Vector3<float>& _vec) const {
-            size_t seed = 0;
-            std::hash<float> hasher;
-            seed ^= hasher(_vec.first) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-            seed ^= hasher(_vec.second) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-            seed ^= hasher(_vec.third) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-
-            return seed;
-        }
-    }; 
-}
-
 namespace das2 {
     namespace obj {
         
         class DAS2_API DasConverter : public IConverter {
             private:
                 Object m_obj;
-                std::unordered_map<TRS::Vector3<float>, uint32_t> m_mapNormals;
-                std::vector<std::array<TRS::Point3D<uint32_t>, 3>> m_triangulizedFaces;
-
-                std::unordered_map<TRS::Vector3<float>, uint32_t> m_reindexMap;
-                std::vector<TRS::Vector3<float>> m_reindexedVertexPositions;
-                std::vector<TRS::Vector2<float>> m_reindexedUVPositions;
-                std::vector<TRS::Vector3<float>> m_reindexedNormals;
-
-                std::vector<uint32_t> m_indices;
+                ThreadPool* m_pThreadPool = nullptr;
+                LoadStats* m_pStats = nullptr;
 
             private:
                 void _Convert();
+                void _BuildModel();
                 void _CreateModel();
-                void _TriangulizeFace(const std::vector<TRS::Point3D<uint32_t>>& _face);
-                void _SmoothenNormals(size_t _uTriangulizationOffset);
-                void _GenerateVertexNormals(const std::pair<size_t, size_t>& _draw);
-                void _OmitIndices(const std::pair<size_t, size_t>& _draw);
+                TRS::Vector3<float> _ComputeFaceNormal(const Triangle& _triangle) const;
+                void _WeldGroup(const std::vector<Triangle>& _triangles, const std::vector<TRS::Vector3<float>>& _generatedNormals, VertexWelder& _welder);
+                std::unique_ptr<VertexWelder> _ConvertGroup(const Group& _group, Triangulator& _triangulator, std::vector<Triangle>& _triangles,
+                                                             PhaseStats* _pPhases);
+                void _LayoutMeshes(const std::vector<std::unique_ptr<VertexWelder>>& _welders);
+                void _AssignMaterials();
 
             public:
-                DasConverter(const Object& _obj, const BinString& _szAuthorName = "", const BinString& _szComment = "", uint8_t _uZLibLevel = 0);
+                // _pThreadPool: optional thread pool to convert groups with, can be nullptr
+                // _pStats: optional statistics to accumulate conversion phases into, can be nullptr
+                // _pResource: memory resource of the converted model, allocations are counted if it is a CountingMemoryResource
+                DasConverter(const Object& _obj, const BinString& _szAuthorName = "", const BinString& _szComment = "", uint8_t _uZLibLevel = 0,
+                             ThreadPool* _pThreadPool = nullptr, LoadStats* _pStats = nullptr,
+                             std::pmr::memory_resource* _pResource = std::pmr::get_default_resource());
+                // takes ownership of _obj instead of copying it
+                DasConverter(Object&& _obj, const BinString& _szAuthorName = "", const BinString& _szComment = "", uint8_t _uZLibLevel = 0,
+                             ThreadPool* _pThreadPool = nullptr, LoadStats* _pStats = nullptr,
+                             std::pmr::memory_resource* _pResource = std::pmr::get_default_resource());
         };
 
+
+        // Appends _material as a MaterialPbr if it uses any PBR statement or as a MaterialPhong otherwise.
+        // Returns the material type and its index in the corresponding material array of _model.
+        DAS2_API std::pair<MaterialType, uint32_t> AppendMaterial(Model& _model, const BinString& _szName, const Material& _material);
+
     }
 }
\ No newline at end of file
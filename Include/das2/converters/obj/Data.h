@@ -65,14 +65,32 @@ namespace das2 {
         };
 
         // elements are referencing vertices
+        // faces are stored in compressed sparse row layout: corners of face i are corners[faceOffsets[i]] .. corners[faceOffsets[i + 1] - 1]
         struct Elements {
-            std::vector<std::vector<TRS::Point3D<uint32_t>>> faces;      // f
+            std::vector<TRS::Point3D<uint32_t>> corners;                // f
+            std::vector<uint32_t> faceOffsets = { 0 };                  // face count + 1 entries
+
+            inline size_t GetFaceCount() const {
+                return faceOffsets.size() - 1;
+            }
+
+            inline uint32_t GetCornerCount(size_t _uFace) const {
+                return faceOffsets[_uFace + 1] - faceOffsets[_uFace];
+            }
+
+            inline const TRS::Point3D<uint32_t>* GetFace(size_t _uFace) const {
+                return corners.data() + faceOffsets[_uFace];
+            }
+
+            inline bool Empty() const {
+                return faceOffsets.size() == 1;
+            }
         };
 
         struct Group {
             BinString szMaterialName = "";          // (structural)
             std::vector<BinString> groupNames;      // g
-            bool bSmoothing;                        // s
+            bool bSmoothing = false;                // s
             Elements elements;                      // (structural)
         };
 
@@ -100,10 +118,13 @@ namespace das2 {
             PBR_MetallicMapUri,     // map_Pm
             PBR_SheenMapUri,        // map_Ps
             PBR_EmissionMapUri,     // map_Ke
-            PBR_NormalMapUri        // norm
+            PBR_NormalMapUri,       // norm
+            NewMaterial             // newmtl
         };
 
         struct Material {
+            bool bPbr = false;          // true if any PBR statement was used
+
             /* Blinn/Phong shading model */
             TRS::Vector3<float> vKa;    // Blinn/Phong shading ambient color
             TRS::Vector3<float> vKd;    // Blinn/Phong shading diffuse color
@@ -117,14 +138,14 @@ namespace das2 {
             BinString szMapDUri = "";   // Transparency parameter map uri
 
             /* PBR shading model */
-            float fPr;                          // PBR roughness parameter
-            float fPm;                          // PBR metallic parameter
-            float fSheen;                       // PBR sheen parameter
-            float fPc;                          // PBR clearcoat thickness
-            float fPcr;                         // PBR clearcoat roughness
+            float fPr = 0.f;                    // PBR roughness parameter
+            float fPm = 0.f;                    // PBR metallic parameter
+            float fSheen = 0.f;                 // PBR sheen parameter
+            float fPc = 0.f;                    // PBR clearcoat thickness
+            float fPcr = 0.f;                   // PBR clearcoat roughness
             TRS::Vector3<float> vEmissive;      // PBR emissive component
-            float fAnisotropy;                  // PBR anisotropy parameter
-            float fAnisor;                      // PBR anisotropy rotation
+            float fAnisotropy = 0.f;            // PBR anisotropy parameter
+            float fAnisor = 0.f;                // PBR anisotropy rotation
 
             BinString szMapPrUri = "";          // PBR roughness map uri
             BinString szMapPmUri = "";          // PBR metallic map uri
@@ -134,10 +155,14 @@ namespace das2 {
         };
 
 
+        // materials of a .mtl file keyed by their newmtl names
+        using MaterialLibrary = std::unordered_map<BinString, Material>;
+
         struct Object {
             Vertices vertices;
             std::vector<Group> groups;
-            std::unordered_map<BinString, Material> materials;
+            std::vector<BinString> materialLibraries;       // mtllib, in order of appearance
+            MaterialLibrary materials;                      // filled by LoadMaterialLibraries()
         };
     }
 }
@@ -0,0 +1,59 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: MaterialLibraryCache.h - header of process-wide Wavefront MTL library cache
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <das2/Api.h>
+#include <das2/converters/obj/Data.h>
+
+namespace das2 {
+    namespace obj {
+
+        // Process-wide cache of parsed .mtl files keyed by their canonical path and modification time.
+        // Concurrent requests for the same library wait for a single parse, modified files are parsed again.
+        class DAS2_API MaterialLibraryCache {
+            private:
+                struct _Entry {
+                    std::filesystem::file_time_type modificationTime;
+                    std::shared_future<std::shared_ptr<const MaterialLibrary>> library;
+                    uint64_t uGeneration;
+                };
+
+                std::mutex m_mutex;
+                std::unordered_map<std::string, _Entry> m_entries;
+                uint64_t m_uGeneration = 0;
+
+            private:
+                MaterialLibraryCache() = default;
+
+            public:
+                MaterialLibraryCache(const MaterialLibraryCache&) = delete;
+                MaterialLibraryCache& operator=(const MaterialLibraryCache&) = delete;
+
+                static MaterialLibraryCache& GetInstance();
+
+                // returns the parsed library at _path
+                // throws std::filesystem::filesystem_error if the file does not exist and cvar::SyntaxErrorException on malformed input
+                std::shared_ptr<const MaterialLibrary> Load(const std::filesystem::path& _path);
+
+                void Clear();
+        };
+
+
+        // Loads all libraries of _obj.materialLibraries from _baseDirectory through the cache and merges their materials
+        // into _obj.materials, earlier libraries take precedence on name clashes.
+        // Returns the libraries which could not be found.
+        DAS2_API std::vector<std::string> LoadMaterialLibraries(Object& _obj, const std::filesystem::path& _baseDirectory);
+    }
+}
@@ -0,0 +1,36 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: NormalGenerator.h - header of smooth vertex normal generation for obj conversion
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <trs/Vector.h>
+#include <das2/Api.h>
+#include <das2/ThreadPool.h>
+#include <das2/converters/obj/Data.h>
+#include <das2/converters/obj/Triangulator.h>
+
+namespace das2 {
+    namespace obj {
+
+        struct NormalGeneratorSettings {
+            float fCreaseAngle = 3.14159265f;   // radians, faces meeting at a larger angle are not smoothed together
+            bool bAreaWeighted = true;          // weight face normals by triangle area
+            bool bAngleWeighted = true;         // weight face normals by the corner angle
+        };
+
+
+        // Generates one normal per triangle corner by accumulating weighted normals of all triangles sharing a position index.
+        // Corners are grouped by sorting (position, corner) keys, thus the cost does not depend on the size of the vertex pool.
+        // _outNormals: resized to _triangles.size() * 3, normal of corner j of triangle i is stored at i * 3 + j
+        // _pThreadPool: optional thread pool to distribute triangles and positions across, can be nullptr
+        // Throws ConvertionException if a triangle references a position out of range.
+        DAS2_API void GenerateNormals(const Vertices& _vertices, const std::vector<Triangle>& _triangles, const NormalGeneratorSettings& _settings,
+                                      std::vector<TRS::Vector3<float>>& _outNormals, ThreadPool* _pThreadPool = nullptr);
+    }
+}
@@ -0,0 +1,77 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: StreamingConverter.h - header of out-of-core Wavefront OBJ to das2 converter
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <das2/Api.h>
+#include <das2/DasStructures.h>
+#include <das2/ThreadPool.h>
+#include <das2/converters/obj/Data.h>
+
+namespace das2 {
+    namespace obj {
+
+        struct StreamingConverterSettings {
+            size_t uMemoryBudget = static_cast<size_t>(1) << 30;    // approximate upper bound of memory used for conversion in bytes
+            std::filesystem::path tempDirectory;                    // directory for intermediate files, system temporary directory if empty
+            std::filesystem::path materialDirectory;                // directory to resolve mtllib statements against, materials are not loaded if empty
+            BinString szAuthorName = "";
+            BinString szComment = "";
+            uint8_t bZstdLevel = 0;
+        };
+
+
+        // Out-of-core Wavefront OBJ to das2 converter for inputs which do not fit into memory.
+        // The input is parsed in blocks with StreamingUnserializer. Vertex attributes are spilled into temporary files as they
+        // are parsed, and faces are gathered into batches, which are converted with DasConverter as soon as their groups are
+        // complete or the batch reaches the memory budget. Converted vertex data is appended to another temporary file and
+        // copied into the output once all structures are known, thus only the small structure records stay in memory.
+        // Groups larger than a batch are split into several meshes of the same MeshGroup, generated smooth normals are then
+        // not averaged across the split.
+        class DAS2_API StreamingConverter {
+            private:
+                struct _State;
+
+                std::istream& m_input;
+                std::ostream& m_output;
+                StreamingConverterSettings m_settings;
+                ThreadPool* m_pThreadPool = nullptr;
+                std::unique_ptr<_State> m_pState;
+                std::vector<std::string> m_missingLibraries;
+
+            private:
+                void _SpillVertices(const Vertices& _vertices);
+                void _Enqueue(Group&& _group, bool _bContinues);
+                void _Flush();
+                void _AssignMaterials();
+                void _Write();
+
+            public:
+                // _pThreadPool: optional thread pool to parse blocks and convert groups with, can be nullptr
+                StreamingConverter(std::istream& _input, std::ostream& _output, const StreamingConverterSettings& _settings,
+                                   ThreadPool* _pThreadPool = nullptr);
+                ~StreamingConverter();
+
+                // converts the whole input and writes the das2 file into the output stream
+                // throws cvar::SyntaxErrorException on malformed input, ConvertionException on invalid references and
+                // std::filesystem::filesystem_error if temporary files cannot be written
+                void Convert();
+
+                // mtllib statements which could not be resolved in materialDirectory
+                inline const std::vector<std::string>& GetMissingMaterialLibraries() const {
+                    return m_missingLibraries;
+                }
+        };
+    }
+}
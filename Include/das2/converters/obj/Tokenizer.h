@@ -0,0 +1,198 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: Tokenizer.h - zero-copy tokenizer and keyword tables for Wavefront OBJ and MTL files
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+namespace das2 {
+    namespace obj {
+
+        // Keyword lookup table with a perfect hash, which is computed at compile time.
+        // Lookups hash the token once and compare it against a single slot, no allocations or probing are involved.
+        // T: keyword value type
+        // N: number of keywords
+        // S: number of slots, must be a power of two larger than N
+        template <typename T, size_t N, size_t S = 256>
+        class KeywordTable {
+            static_assert((S & (S - 1)) == 0 && S > N, "KeywordTable slot count must be a power of two larger than the keyword count");
+
+            public:
+                struct Entry {
+                    std::string_view sKeyword;
+                    T value;
+                };
+
+            private:
+                Entry m_arrSlots[S] = {};
+                uint32_t m_uSeed = 0;
+
+            private:
+                static constexpr uint32_t _Hash(std::string_view _sKey, uint32_t _uSeed) {
+                    // FNV-1a with the seed as its offset basis
+                    uint32_t uHash = _uSeed;
+                    for (size_t i = 0; i < _sKey.size(); i++) {
+                        uHash ^= static_cast<uint8_t>(_sKey[i]);
+                        uHash *= 16777619u;
+                    }
+                    return uHash ^ (uHash >> 15);
+                }
+
+                constexpr bool _TrySeed(const Entry (&_arrEntries)[N], uint32_t _uSeed) {
+                    for (size_t i = 0; i < S; i++)
+                        m_arrSlots[i] = Entry{};
+
+                    for (size_t i = 0; i < N; i++) {
+                        Entry& slot = m_arrSlots[_Hash(_arrEntries[i].sKeyword, _uSeed) & (S - 1)];
+                        if (!slot.sKeyword.empty())
+                            return false;
+                        slot = _arrEntries[i];
+                    }
+
+                    return true;
+                }
+
+            public:
+                constexpr KeywordTable(const Entry (&_arrEntries)[N]) {
+                    for (uint32_t uSeed = 2166136261u; ; uSeed++) {
+                        if (_TrySeed(_arrEntries, uSeed)) {
+                            m_uSeed = uSeed;
+                            break;
+                        }
+                    }
+                }
+
+                // returns nullptr if _sKey is not a keyword
+                constexpr const T* Find(std::string_view _sKey) const {
+                    const Entry& slot = m_arrSlots[_Hash(_sKey, m_uSeed) & (S - 1)];
+                    if (slot.sKeyword.empty() || slot.sKeyword != _sKey)
+                        return nullptr;
+                    return &slot.value;
+                }
+        };
+
+
+        // Line and whitespace separated token reader over an in-memory byte buffer.
+        // Tokens are returned as views into the buffer, thus the buffer must outlive them.
+        class Tokenizer {
+            private:
+                const char* m_pCursor = nullptr;
+                const char* m_pLineEnd = nullptr;
+                const char* m_pNextLine = nullptr;
+                const char* m_pEnd = nullptr;
+                uint32_t m_uLine = 0;
+
+            private:
+                static inline bool _IsSpace(char _c) {
+                    return _c == ' ' || _c == '\t' || _c == '\r';
+                }
+
+            public:
+                Tokenizer(const char* _pBegin, const char* _pEnd) :
+                    m_pNextLine(_pBegin),
+                    m_pEnd(_pEnd) {}
+
+                // advances to the next line, returns false if the buffer is exhausted
+                inline bool NextLine() {
+                    if (m_pNextLine >= m_pEnd)
+                        return false;
+
+                    m_pCursor = m_pNextLine;
+                    m_pLineEnd = static_cast<const char*>(std::memchr(m_pCursor, '\n', static_cast<size_t>(m_pEnd - m_pCursor)));
+                    if (!m_pLineEnd)
+                        m_pLineEnd = m_pEnd;
+
+                    m_pNextLine = m_pLineEnd + 1;
+                    m_uLine++;
+                    return true;
+                }
+
+                // returns the next token on the current line, empty if the line has no more tokens
+                inline std::string_view NextToken() {
+                    while (m_pCursor < m_pLineEnd && _IsSpace(*m_pCursor))
+                        m_pCursor++;
+
+                    const char* pBegin = m_pCursor;
+                    while (m_pCursor < m_pLineEnd && !_IsSpace(*m_pCursor))
+                        m_pCursor++;
+
+                    return std::string_view(pBegin, static_cast<size_t>(m_pCursor - pBegin));
+                }
+
+                // returns the rest of the current line with surrounding whitespace removed, used for names containing spaces
+                inline std::string_view Remainder() {
+                    while (m_pCursor < m_pLineEnd && _IsSpace(*m_pCursor))
+                        m_pCursor++;
+
+                    const char* pEnd = m_pLineEnd;
+                    while (pEnd > m_pCursor && _IsSpace(pEnd[-1]))
+                        pEnd--;
+
+                    std::string_view sRemainder(m_pCursor, static_cast<size_t>(pEnd - m_pCursor));
+                    m_pCursor = m_pLineEnd;
+                    return sRemainder;
+                }
+
+                inline bool IsLastLine() const {
+                    return m_pLineEnd == m_pEnd;
+                }
+
+                // 1-based number of the current line
+                inline uint32_t GetLine() const {
+                    return m_uLine;
+                }
+        };
+
+
+        // Parses the whole token as a float, returns false on malformed input
+        inline bool ParseFloat(std::string_view _sToken, float& _fValue) {
+            const char* pBegin = _sToken.data();
+            const char* pEnd = _sToken.data() + _sToken.size();
+            // from_chars does not accept an explicit plus sign
+            if (pBegin != pEnd && *pBegin == '+') {
+                pBegin++;
+                if (pBegin != pEnd && *pBegin == '-')
+                    return false;
+            }
+
+#if defined(__cpp_lib_to_chars) || (defined(_MSC_VER) && _MSC_VER >= 1924)
+            const std::from_chars_result result = std::from_chars(pBegin, pEnd, _fValue);
+            return result.ec == std::errc() && result.ptr == pEnd && pBegin != pEnd;
+#else
+            // standard libraries without floating point from_chars, strtof needs a terminated copy
+            char arrBuffer[64];
+            if (pBegin == pEnd || static_cast<size_t>(pEnd - pBegin) >= sizeof(arrBuffer))
+                return false;
+            std::memcpy(arrBuffer, pBegin, static_cast<size_t>(pEnd - pBegin));
+            arrBuffer[pEnd - pBegin] = '\0';
+
+            char* pParsed = nullptr;
+            _fValue = std::strtof(arrBuffer, &pParsed);
+            return pParsed == arrBuffer + (pEnd - pBegin);
+#endif
+        }
+
+
+        // Parses the whole token as an integer, returns false on malformed input or overflow
+        template <typename T>
+        inline bool ParseInt(std::string_view _sToken, T& _value) {
+            const char* pBegin = _sToken.data();
+            const char* pEnd = _sToken.data() + _sToken.size();
+            if (pBegin != pEnd && *pBegin == '+') {
+                pBegin++;
+                if (pBegin != pEnd && *pBegin == '-')
+                    return false;
+            }
+
+            const std::from_chars_result result = std::from_chars(pBegin, pEnd, _value);
+            return result.ec == std::errc() && result.ptr == pEnd && pBegin != pEnd;
+        }
+    }
+}
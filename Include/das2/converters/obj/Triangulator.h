@@ -0,0 +1,56 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: Triangulator.h - header of polygon triangulation for obj conversion
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <trs/Points.h>
+#include <das2/Api.h>
+#include <das2/ThreadPool.h>
+#include <das2/converters/obj/Data.h>
+
+namespace das2 {
+    namespace obj {
+
+        using Triangle = std::array<TRS::Point3D<uint32_t>, 3>;
+
+        // Splits obj polygons into triangles.
+        // Triangles and quads take a fast path, larger polygons are projected onto the plane of their Newell normal
+        // and triangulated with ear clipping, which handles concave polygons correctly.
+        // Scratch buffers are kept between calls, thus one instance should be reused per thread.
+        class DAS2_API Triangulator {
+            private:
+                std::vector<float> m_projected;     // 2 floats per polygon corner
+                std::vector<uint32_t> m_prev;
+                std::vector<uint32_t> m_next;
+                std::vector<uint8_t> m_reflex;
+
+            private:
+                void _ClipEars(const TRS::Point3D<uint32_t>* _pCorners, uint32_t _uCornerCount, std::vector<Triangle>& _out);
+                bool _IsEar(uint32_t _uCorner, uint32_t _uRemaining) const;
+                bool _IsReflex(uint32_t _uCorner) const;
+
+            public:
+                Triangulator() = default;
+
+                // appends triangles of a single polygon to _out
+                // throws ConvertionException if a corner references a position outside of _vertices
+                void Triangulate(const Vertices& _vertices, const TRS::Point3D<uint32_t>* _pCorners, uint32_t _uCornerCount,
+                                 std::vector<Triangle>& _out);
+
+                // appends triangles of all faces of _elements to _out
+                void Triangulate(const Vertices& _vertices, const Elements& _elements, std::vector<Triangle>& _out);
+        };
+
+
+        // Triangulates every group of _obj into _out, which is resized to the number of groups.
+        // _pThreadPool: optional thread pool to distribute groups across, can be nullptr
+        DAS2_API void TriangulateGroups(const Object& _obj, std::vector<std::vector<Triangle>>& _out, ThreadPool* _pThreadPool = nullptr);
+    }
+}
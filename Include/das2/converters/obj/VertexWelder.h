@@ -0,0 +1,82 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: VertexWelder.h - header of unified vertex deduplication for obj conversion
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <trs/Vector.h>
+#include <das2/Api.h>
+
+namespace das2 {
+    namespace obj {
+
+        struct UnifiedVertex {
+            TRS::Vector3<float> positionVertex;
+            TRS::Vector2<float> textureVertex;
+            TRS::Vector3<float> normalVertex;
+
+            bool operator==(const UnifiedVertex& _vt) const {
+                return positionVertex == _vt.positionVertex && textureVertex == _vt.textureVertex && normalVertex == _vt.normalVertex;
+            }
+        };
+
+
+        // Deduplicates unified vertices (position, uv and normal) into separate attribute streams and an index buffer.
+        // Lookups use an open addressing table with linear probing, which stores only output vertex indices.
+        // Vertices are compared bitwise with signed zeros folded together.
+        class DAS2_API VertexWelder {
+            private:
+                std::vector<uint32_t> m_table;
+                uint32_t m_uMask = 0;
+
+                std::vector<TRS::Vector3<float>> m_positions;
+                std::vector<TRS::Vector2<float>> m_uvs;
+                std::vector<TRS::Vector3<float>> m_normals;
+                std::vector<uint32_t> m_indices;
+                std::vector<uint64_t> m_hashes;             // hash of each unique vertex, used for rehashing and cheap rejection
+                bool m_bUVs = false;
+
+            private:
+                static uint64_t _Hash(const UnifiedVertex& _vertex);
+                bool _Equals(uint32_t _uIndex, const UnifiedVertex& _vertex) const;
+                void _Rehash(size_t _uCapacity);
+
+            public:
+                // _uCornerCount: expected number of Weld() calls, all outputs are preallocated for that many vertices
+                // _bUVs: if false, texture coordinates are ignored and no uv stream is produced
+                VertexWelder(size_t _uCornerCount, bool _bUVs);
+
+                // appends the index of _vertex to the index buffer, adding the vertex if it was not seen before
+                uint32_t Weld(const UnifiedVertex& _vertex);
+
+                inline const std::vector<TRS::Vector3<float>>& GetPositions() const {
+                    return m_positions;
+                }
+
+                inline const std::vector<TRS::Vector2<float>>& GetUVs() const {
+                    return m_uvs;
+                }
+
+                inline const std::vector<TRS::Vector3<float>>& GetNormals() const {
+                    return m_normals;
+                }
+
+                inline const std::vector<uint32_t>& GetIndices() const {
+                    return m_indices;
+                }
+
+                inline bool HasUVs() const {
+                    return m_bUVs;
+                }
+
+                inline size_t GetVertexCount() const {
+                    return m_positions.size();
+                }
+        };
+    }
+}
@@ -0,0 +1,99 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: BatchConverter.h - header of dastool parallel batch conversion of Wavefront OBJ files
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// files are converted in memory if their size times this factor fits into the memory limit, otherwise they are streamed
+#define DASTOOL_IN_MEMORY_FACTOR 6
+#define DASTOOL_OUTPUT_EXTENSION ".das"
+
+namespace das2 {
+    namespace dastool {
+
+        struct BatchConverterSettings {
+            std::filesystem::path outputDirectory;                  // outputs are written next to their inputs if empty
+            uint32_t uJobCount = 0;                                 // concurrently converted files, 0 uses hardware concurrency
+            size_t uMemoryLimit = static_cast<size_t>(1) << 30;     // approximate memory limit of a single conversion in bytes
+            uint8_t bZstdLevel = 0;
+            bool bIncremental = false;                              // skip files whose output is newer than the input
+            bool bInstancing = false;                               // replace duplicate geometry with instances, streamed files are not instanced
+            bool bVerbose = false;                                  // log every file instead of failures only
+        };
+
+
+        enum BatchStatus : uint8_t {
+            BatchStatus_Pending,
+            BatchStatus_Converted,
+            BatchStatus_Skipped,
+            BatchStatus_Failed
+        };
+
+
+        struct BatchEntry {
+            std::filesystem::path inputPath;
+            std::filesystem::path outputPath;
+            uint64_t uInputSize = 0;
+            uint64_t uOutputSize = 0;
+            double fSeconds = 0.0;
+            bool bStreamed = false;                                 // converted with StreamingConverter due to the memory limit
+            BatchStatus eStatus = BatchStatus_Pending;
+            std::string sMessage;                                   // error message of failed conversions
+            std::vector<std::string> missingLibraries;
+        };
+
+
+        // Converts many Wavefront OBJ files into das2 files on a bounded pool of workers.
+        // Every file is converted by a single worker, small files in memory with DasConverter and files, which would exceed
+        // the memory limit, out-of-core with StreamingConverter. Outputs are written into temporary files, which are renamed
+        // once the conversion succeeds, thus interrupted runs never leave truncated outputs behind.
+        // Failures do not stop the batch, they are collected and reported by PrintReport().
+        class BatchConverter {
+            private:
+                BatchConverterSettings m_settings;
+                std::vector<BatchEntry> m_entries;
+                double m_fSeconds = 0.0;
+
+            private:
+                void _AddFile(const std::filesystem::path& _file, const std::filesystem::path& _root);
+                void _AddMissing(const std::string& _sInput);
+                void _RejectOutputCollisions(std::ostream& _log);
+                void _Convert(BatchEntry& _entry) const;
+                void _Run(BatchEntry& _entry) const;
+
+            public:
+                BatchConverter(const BatchConverterSettings& _settings);
+
+                // _sInput: obj file, directory that is searched recursively for obj files or glob pattern
+                // Glob patterns support '*' and '?' within a path component and '**' for any number of directories.
+                // Inputs which match nothing are recorded as failures.
+                void AddInput(const std::string& _sInput);
+
+                // Converts all added files, progress and failures are logged to _log as they happen.
+                // Inputs, which map to the same output path (e.g. a.obj in two input directories), fail before any
+                // conversion starts instead of overwriting each other.
+                void Run(std::ostream& _log);
+
+                // Writes counts, throughput and all failures to _stream
+                void PrintReport(std::ostream& _stream) const;
+
+                inline const std::vector<BatchEntry>& GetEntries() const {
+                    return m_entries;
+                }
+
+                size_t GetFailureCount() const;
+        };
+
+
+        // dastool convert <input>... [options], returns the process exit code
+        int RunConvertCommand(int _argc, char* _argv[]);
+    }
+}
@@ -0,0 +1,30 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: Common.h - header of helpers shared by dastool commands
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace das2 {
+    namespace dastool {
+
+        struct InputFile {
+            std::filesystem::path path;
+            std::filesystem::path root;     // directory the input was given relative to, used to mirror the layout of outputs
+        };
+
+
+        // Appends all files matching _sInput to _files and returns false if there were none.
+        // _sInput: file, directory that is searched recursively for files ending with _szExtension (case insensitive) or glob
+        // pattern. Glob patterns support '*' and '?' within a path component and '**' for any number of directories.
+        bool ExpandInput(const std::string& _sInput, const char* _szExtension, std::vector<InputFile>& _files);
+
+        // parses a decimal command line value, returns false if _szValue is not entirely a number or exceeds _uMax
+        bool ParseUnsigned(const char* _szValue, uint64_t _uMax, uint64_t& _uValue);
+    }
+}
@@ -0,0 +1,17 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: InspectCommand.h - header of dastool das2 file inspection command
+// author: Karl-Mihkel Ott
+
+#pragma once
+
+#define DASTOOL_INSPECT_EXTENSION ".das"
+
+namespace das2 {
+    namespace dastool {
+
+        // dastool inspect <input>... [options], returns the process exit code
+        // Prints header fields, structure counts, sizes and compression ratios of das2 files without loading their buffers.
+        int RunInspectCommand(int _argc, char* _argv[]);
+    }
+}
@@ -0,0 +1,431 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: AnimationCompression.cpp - implementation of offline animation compressor and compact channel encoding
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <das2/Exceptions.h>
+#include <das2/AnimationCompression.h>
+
+#define SMALLEST_THREE_BITS 15
+#define SMALLEST_THREE_MAX ((1 << SMALLEST_THREE_BITS) - 1)
+#define QUANTIZED16_MAX 65535.f
+
+namespace das2 {
+
+    namespace {
+        const float g_fInvSqrt2 = 0.70710678f;
+
+        inline uint64_t _EncodeSmallestThree(const float* _pRotation) {
+            uint32_t uLargest = 0;
+            for (uint32_t i = 1; i < 4; i++) {
+                if (std::fabs(_pRotation[i]) > std::fabs(_pRotation[uLargest]))
+                    uLargest = i;
+            }
+
+            // q and -q describe the same rotation, thus the largest component is made positive and omitted
+            const float fSign = _pRotation[uLargest] < 0.f ? -1.f : 1.f;
+            uint64_t uBits = uLargest;
+            uint32_t uShift = 2;
+            for (uint32_t i = 0; i < 4; i++) {
+                if (i == uLargest)
+                    continue;
+
+                const float fNormalized = (_pRotation[i] * fSign * g_fInvSqrt2 + 0.5f);
+                const float fClamped = std::min(std::max(fNormalized, 0.f), 1.f);
+                uBits |= static_cast<uint64_t>(std::lround(fClamped * SMALLEST_THREE_MAX)) << uShift;
+                uShift += SMALLEST_THREE_BITS;
+            }
+
+            return uBits;
+        }
+
+
+        inline void _DecodeSmallestThree(uint64_t _uBits, float* _pOut) {
+            const uint32_t uLargest = static_cast<uint32_t>(_uBits & 0x3);
+            uint32_t uShift = 2;
+            float fSumSq = 0.f;
+            for (uint32_t i = 0; i < 4; i++) {
+                if (i == uLargest)
+                    continue;
+
+                const uint32_t uValue = static_cast<uint32_t>((_uBits >> uShift) & SMALLEST_THREE_MAX);
+                _pOut[i] = (static_cast<float>(uValue) / SMALLEST_THREE_MAX - 0.5f) * 2.f * g_fInvSqrt2;
+                fSumSq += _pOut[i] * _pOut[i];
+                uShift += SMALLEST_THREE_BITS;
+            }
+
+            _pOut[uLargest] = std::sqrt(std::max(1.f - fSumSq, 0.f));
+        }
+
+
+        inline float _ChannelError(AnimationTarget _bTarget, const AnimationCompressionSettings& _settings) {
+            switch (_bTarget) {
+                case AnimationTarget_Rotation:
+                    return _settings.fRotationError;
+
+                case AnimationTarget_Translation:
+                    return _settings.fTranslationError;
+
+                case AnimationTarget_Scale:
+                    return _settings.fScaleError;
+
+                default:
+                    return _settings.fWeightError;
+            }
+        }
+
+
+        // maximum component difference, rotations are compared up to their sign
+        inline float _Distance(const float* _pA, const float* _pB, uint32_t _uComponentCount, bool _bRotation) {
+            float fSign = 1.f;
+            if (_bRotation) {
+                const float fDot = _pA[0] * _pB[0] + _pA[1] * _pB[1] + _pA[2] * _pB[2] + _pA[3] * _pB[3];
+                fSign = fDot < 0.f ? -1.f : 1.f;
+            }
+
+            float fMax = 0.f;
+            for (uint32_t i = 0; i < _uComponentCount; i++)
+                fMax = std::max(fMax, std::fabs(_pA[i] - fSign * _pB[i]));
+            return fMax;
+        }
+
+
+        // same interpolation as das2::AnimationSampler uses for linear channels (nlerp for rotations)
+        inline void _Interpolate(const float* _pA, const float* _pB, float _fFactor, uint32_t _uComponentCount, bool _bRotation, float* _pOut) {
+            float fSign = 1.f;
+            if (_bRotation) {
+                const float fDot = _pA[0] * _pB[0] + _pA[1] * _pB[1] + _pA[2] * _pB[2] + _pA[3] * _pB[3];
+                fSign = fDot < 0.f ? -1.f : 1.f;
+            }
+
+            float fLengthSq = 0.f;
+            for (uint32_t i = 0; i < _uComponentCount; i++) {
+                _pOut[i] = (1.f - _fFactor) * _pA[i] + _fFactor * fSign * _pB[i];
+                fLengthSq += _pOut[i] * _pOut[i];
+            }
+
+            if (_bRotation && fLengthSq > 0.f) {
+                const float fInvLength = 1.f / std::sqrt(fLengthSq);
+                for (uint32_t i = 0; i < _uComponentCount; i++)
+                    _pOut[i] *= fInvLength;
+            }
+        }
+    }
+
+
+    void CompressedAnimationChannel::DecodeKey(uint32_t _uKey, float* _pOut) const {
+        const uint8_t* pKey = values.data() + _uKey * GetKeySize();
+
+        switch (bEncoding) {
+            case ChannelEncoding_SmallestThree:
+                {
+                    uint64_t uBits = 0;
+                    for (int i = 0; i < 6; i++)
+                        uBits |= static_cast<uint64_t>(pKey[i]) << (i * 8);
+                    _DecodeSmallestThree(uBits, _pOut);
+                }
+                break;
+
+            case ChannelEncoding_Quantized16:
+                for (uint32_t i = 0; i < uComponentCount; i++) {
+                    uint16_t uValue = 0;
+                    std::memcpy(&uValue, pKey + i * sizeof(uint16_t), sizeof(uint16_t));
+                    _pOut[i] = rangeMin[i] + rangeExtent[i] * (static_cast<float>(uValue) / QUANTIZED16_MAX);
+                }
+                break;
+
+            default:
+                std::memcpy(_pOut, pKey, uComponentCount * sizeof(float));
+                break;
+        }
+    }
+
+
+    void CompressedAnimationChannel::Read(std::istream& _stream) {
+        _stream.read(reinterpret_cast<char*>(&uNodePropertyId), sizeof(uint32_t));
+        _stream.read(reinterpret_cast<char*>(&uJointPropertyId), sizeof(uint32_t));
+        _stream.read(reinterpret_cast<char*>(&bAnimationTarget), sizeof(AnimationTarget));
+        _stream.read(reinterpret_cast<char*>(&bInterpolationType), sizeof(InterpolationType));
+        _stream.read(reinterpret_cast<char*>(&bEncoding), sizeof(ChannelEncoding));
+        _stream.read(reinterpret_cast<char*>(&uComponentCount), sizeof(uint32_t));
+
+        uint32_t uKeyframeCount = 0;
+        _stream.read(reinterpret_cast<char*>(&uKeyframeCount), sizeof(uint32_t));
+        keyframes.resize(uKeyframeCount);
+        _stream.read(reinterpret_cast<char*>(keyframes.data()), sizeof(float) * keyframes.size());
+
+        if (bEncoding == ChannelEncoding_Quantized16) {
+            rangeMin.resize(uComponentCount);
+            rangeExtent.resize(uComponentCount);
+            _stream.read(reinterpret_cast<char*>(rangeMin.data()), sizeof(float) * rangeMin.size());
+            _stream.read(reinterpret_cast<char*>(rangeExtent.data()), sizeof(float) * rangeExtent.size());
+        }
+
+        if (bInterpolationType == InterpolationType_CubicSpline) {
+            tangents.resize(static_cast<size_t>(uKeyframeCount) * uComponentCount * 2);
+            _stream.read(reinterpret_cast<char*>(tangents.data()), sizeof(float) * tangents.size());
+        }
+
+        values.resize(uKeyframeCount * GetKeySize());
+        _stream.read(reinterpret_cast<char*>(values.data()), values.size());
+    }
+
+
+    void CompressedAnimationChannel::Write(std::ostream& _stream) const {
+        _stream.write(reinterpret_cast<const char*>(&uNodePropertyId), sizeof(uint32_t));
+        _stream.write(reinterpret_cast<const char*>(&uJointPropertyId), sizeof(uint32_t));
+        _stream.write(reinterpret_cast<const char*>(&bAnimationTarget), sizeof(AnimationTarget));
+        _stream.write(reinterpret_cast<const char*>(&bInterpolationType), sizeof(InterpolationType));
+        _stream.write(reinterpret_cast<const char*>(&bEncoding), sizeof(ChannelEncoding));
+        _stream.write(reinterpret_cast<const char*>(&uComponentCount), sizeof(uint32_t));
+
+        const uint32_t uKeyframeCount = static_cast<uint32_t>(keyframes.size());
+        _stream.write(reinterpret_cast<const char*>(&uKeyframeCount), sizeof(uint32_t));
+        _stream.write(reinterpret_cast<const char*>(keyframes.data()), sizeof(float) * keyframes.size());
+
+        if (bEncoding == ChannelEncoding_Quantized16) {
+            _stream.write(reinterpret_cast<const char*>(rangeMin.data()), sizeof(float) * rangeMin.size());
+            _stream.write(reinterpret_cast<const char*>(rangeExtent.data()), sizeof(float) * rangeExtent.size());
+        }
+
+        if (bInterpolationType == InterpolationType_CubicSpline)
+            _stream.write(reinterpret_cast<const char*>(tangents.data()), sizeof(float) * tangents.size());
+        _stream.write(reinterpret_cast<const char*>(values.data()), values.size());
+    }
+
+
+    void CompressedAnimation::Read(std::istream& _stream) {
+        uint32_t uMagic = 0;
+        _stream.read(reinterpret_cast<char*>(&uMagic), sizeof(uint32_t));
+        if (uMagic != DAS2_COMPRESSED_ANIMATION_MAGIC) {
+            std::stringstream ss;
+            ss << "das2::CompressedAnimation: invalid magic number 0x" << std::setfill('0') << std::setw(8) << std::hex << uMagic;
+            throw MagicValueException(ss.str());
+        }
+
+        szName.Read(_stream);
+
+        uint32_t uChannelCount = 0;
+        _stream.read(reinterpret_cast<char*>(&uChannelCount), sizeof(uint32_t));
+        channels.resize(uChannelCount);
+        for (auto it = channels.begin(); it != channels.end(); it++)
+            it->Read(_stream);
+    }
+
+
+    void CompressedAnimation::Write(std::ostream& _stream) const {
+        const uint32_t uMagic = DAS2_COMPRESSED_ANIMATION_MAGIC;
+        _stream.write(reinterpret_cast<const char*>(&uMagic), sizeof(uint32_t));
+        szName.Write(_stream);
+
+        const uint32_t uChannelCount = static_cast<uint32_t>(channels.size());
+        _stream.write(reinterpret_cast<const char*>(&uChannelCount), sizeof(uint32_t));
+        for (auto it = channels.begin(); it != channels.end(); it++)
+            it->Write(_stream);
+    }
+
+
+    size_t CompressedAnimation::GetDataSize() const {
+        size_t uSize = 0;
+        for (auto it = channels.begin(); it != channels.end(); it++) {
+            uSize += (it->keyframes.size() + it->rangeMin.size() + it->rangeExtent.size() + it->tangents.size()) * sizeof(float);
+            uSize += it->values.size();
+        }
+        return uSize;
+    }
+
+
+    CompressedAnimationChannel CompressAnimationChannel(const AnimationChannel& _channel, const AnimationCompressionSettings& _settings) {
+        CompressedAnimationChannel compressed;
+        compressed.uNodePropertyId = _channel.uNodePropertyId;
+        compressed.uJointPropertyId = _channel.uJointPropertyId;
+        compressed.bAnimationTarget = _channel.bAnimationTarget;
+        compressed.bInterpolationType = _channel.bInterpolationType;
+        compressed.uComponentCount = _channel.GetComponentCount();
+
+        const uint32_t uComponents = compressed.uComponentCount;
+        const size_t uKeyframeCount = _channel.keyframes.size();
+        if (_channel.targetValues.size() != uKeyframeCount * uComponents)
+            throw AnimationException("das2::CompressAnimationChannel: animation channel value count does not match its keyframe count");
+
+        // cubic splines are kept intact, since their tangents depend on the exact keyframe spacing
+        if (_channel.bInterpolationType == InterpolationType_CubicSpline) {
+            compressed.keyframes.assign(_channel.keyframes.begin(), _channel.keyframes.end());
+            compressed.tangents.assign(_channel.tangents.begin(), _channel.tangents.end());
+            compressed.values.resize(_channel.targetValues.size() * sizeof(float));
+            std::memcpy(compressed.values.data(), _channel.targetValues.data(), compressed.values.size());
+            return compressed;
+        }
+
+        const bool bRotation = _channel.bAnimationTarget == AnimationTarget_Rotation;
+        if (_settings.bQuantize && bRotation)
+            compressed.bEncoding = ChannelEncoding_SmallestThree;
+        else if (_settings.bQuantize && _channel.bAnimationTarget == AnimationTarget_Translation)
+            compressed.bEncoding = ChannelEncoding_Quantized16;
+
+        const float fError = _ChannelError(_channel.bAnimationTarget, _settings);
+        if (compressed.bEncoding == ChannelEncoding_Quantized16) {
+            compressed.rangeMin.assign(uComponents, 0.f);
+            compressed.rangeExtent.assign(uComponents, 0.f);
+            for (uint32_t i = 0; i < uComponents && uKeyframeCount; i++) {
+                float fMin = _channel.targetValues[i], fMax = _channel.targetValues[i];
+                for (size_t j = 1; j < uKeyframeCount; j++) {
+                    fMin = std::min(fMin, _channel.targetValues[j * uComponents + i]);
+                    fMax = std::max(fMax, _channel.targetValues[j * uComponents + i]);
+                }
+                compressed.rangeMin[i] = fMin;
+                compressed.rangeExtent[i] = fMax - fMin;
+
+                // rounding error is half of a quantization step, wide ranges cannot meet the bound with 16 bits
+                if (compressed.rangeExtent[i] / (2.f * QUANTIZED16_MAX) > fError)
+                    compressed.bEncoding = ChannelEncoding_Raw;
+            }
+
+            if (compressed.bEncoding == ChannelEncoding_Raw) {
+                compressed.rangeMin.clear();
+                compressed.rangeExtent.clear();
+            }
+        }
+
+        // encode all keys first, so that key reduction accounts for the quantization error
+        std::vector<uint8_t> encoded;
+        std::vector<float> decoded(uKeyframeCount * uComponents);
+        auto fnEncode = [&]() {
+            const size_t uKeySize = compressed.GetKeySize();
+            encoded.resize(uKeyframeCount * uKeySize);
+            for (size_t i = 0; i < uKeyframeCount; i++) {
+                const float* pValue = _channel.targetValues.data() + i * uComponents;
+                uint8_t* pKey = encoded.data() + i * uKeySize;
+
+                switch (compressed.bEncoding) {
+                    case ChannelEncoding_SmallestThree:
+                        {
+                            const uint64_t uBits = _EncodeSmallestThree(pValue);
+                            for (int j = 0; j < 6; j++)
+                                pKey[j] = static_cast<uint8_t>(uBits >> (j * 8));
+                        }
+                        break;
+
+                    case ChannelEncoding_Quantized16:
+                        for (uint32_t j = 0; j < uComponents; j++) {
+                            const float fExtent = compressed.rangeExtent[j];
+                            const float fNormalized = fExtent > 0.f ? (pValue[j] - compressed.rangeMin[j]) / fExtent : 0.f;
+                            const uint16_t uValue = static_cast<uint16_t>(std::lround(std::min(std::max(fNormalized, 0.f), 1.f) * QUANTIZED16_MAX));
+                            std::memcpy(pKey + j * sizeof(uint16_t), &uValue, sizeof(uint16_t));
+                        }
+                        break;
+
+                    default:
+                        std::memcpy(pKey, pValue, uKeySize);
+                        break;
+                }
+            }
+
+            compressed.values = encoded;
+            for (size_t i = 0; i < uKeyframeCount; i++)
+                compressed.DecodeKey(static_cast<uint32_t>(i), decoded.data() + i * uComponents);
+        };
+
+        // quantized keys are decoded and measured, encodings exceeding the error bound fall back to raw floats
+        fnEncode();
+        if (compressed.bEncoding != ChannelEncoding_Raw) {
+            for (size_t i = 0; i < uKeyframeCount; i++) {
+                if (_Distance(decoded.data() + i * uComponents, _channel.targetValues.data() + i * uComponents, uComponents, bRotation) > fError) {
+                    compressed.bEncoding = ChannelEncoding_Raw;
+                    compressed.rangeMin.clear();
+                    compressed.rangeExtent.clear();
+                    fnEncode();
+                    break;
+                }
+            }
+        }
+        const size_t uKeySize = compressed.GetKeySize();
+
+        // greedily extend each segment for as long as all skipped keys are reproduced within the error bound
+        const bool bStep = _channel.bInterpolationType == InterpolationType_Step;
+        std::vector<float> interpolated(uComponents);
+
+        auto fnSegmentFits = [&](size_t _uFirst, size_t _uLast) {
+            const float fDelta = _channel.keyframes[_uLast] - _channel.keyframes[_uFirst];
+            for (size_t k = _uFirst + 1; k < _uLast; k++) {
+                const float* pExpected = _channel.targetValues.data() + k * uComponents;
+                const float* pFirst = decoded.data() + _uFirst * uComponents;
+                if (bStep || fDelta <= 0.f) {
+                    if (_Distance(pFirst, pExpected, uComponents, bRotation) > fError)
+                        return false;
+                    continue;
+                }
+
+                const float fFactor = (_channel.keyframes[k] - _channel.keyframes[_uFirst]) / fDelta;
+                _Interpolate(pFirst, decoded.data() + _uLast * uComponents, fFactor, uComponents, bRotation, interpolated.data());
+                if (_Distance(interpolated.data(), pExpected, uComponents, bRotation) > fError)
+                    return false;
+            }
+            return true;
+        };
+
+        std::vector<size_t> kept;
+        if (uKeyframeCount)
+            kept.push_back(0);
+
+        size_t uAnchor = 0;
+        for (size_t j = 2; j < uKeyframeCount; j++) {
+            if (!fnSegmentFits(uAnchor, j)) {
+                uAnchor = j - 1;
+                kept.push_back(uAnchor);
+            }
+        }
+        if (uKeyframeCount > 1)
+            kept.push_back(uKeyframeCount - 1);
+
+        // constant channels collapse into a single key
+        if (kept.size() == 2) {
+            bool bConstant = true;
+            for (size_t k = 1; k < uKeyframeCount && bConstant; k++)
+                bConstant = _Distance(decoded.data(), _channel.targetValues.data() + k * uComponents, uComponents, bRotation) <= fError;
+
+            if (bConstant)
+                kept.pop_back();
+        }
+
+        compressed.keyframes.resize(kept.size());
+        compressed.values.resize(kept.size() * uKeySize);
+        for (size_t i = 0; i < kept.size(); i++) {
+            compressed.keyframes[i] = _channel.keyframes[kept[i]];
+            std::memcpy(compressed.values.data() + i * uKeySize, encoded.data() + kept[i] * uKeySize, uKeySize);
+        }
+
+        return compressed;
+    }
+
+
+    CompressedAnimation CompressAnimation(const Model& _model, uint32_t _uAnimationIndex, const AnimationCompressionSettings& _settings) {
+        if (_uAnimationIndex >= _model.animations.size()) {
+            std::stringstream ss;
+            ss << "das2::CompressAnimation: invalid animation index " << _uAnimationIndex;
+            throw AnimationException(ss.str());
+        }
+
+        const Animation& animation = _model.animations[_uAnimationIndex];
+        CompressedAnimation compressed;
+        compressed.szName = animation.szName;
+        compressed.channels.reserve(animation.animationChannels.size());
+
+        for (auto it = animation.animationChannels.begin(); it != animation.animationChannels.end(); it++) {
+            if (*it >= _model.animationChannels.size()) {
+                std::stringstream ss;
+                ss << "das2::CompressAnimation: invalid animation channel id " << *it << " in animation " << _uAnimationIndex;
+                throw AnimationException(ss.str());
+            }
+
+            compressed.channels.push_back(CompressAnimationChannel(_model.animationChannels[*it], _settings));
+        }
+
+        return compressed;
+    }
+}
@@ -0,0 +1,519 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: AnimationSampler.cpp - implementation of animation channel sampling engine
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <das2/Exceptions.h>
+#include <das2/AnimationSampler.h>
+
+// number of keyframes the cursor is advanced linearly before falling back to binary search
+#define CURSOR_LINEAR_STEPS 4
+
+// below that angle slerp is numerically unstable and linear weights are used instead
+#define SLERP_EPSILON 1e-4f
+
+namespace das2 {
+
+    namespace {
+
+        // _pOut[i] = _pA[i] + (_pB[i] - _pA[i]) * _pT[i]
+        template <typename L>
+        inline void _LerpRows(const float* _pA, const float* _pB, const float* _pT, float* _pOut, size_t _uBegin, size_t _uEnd) {
+            for (size_t i = _uBegin; i + L::uWidth <= _uEnd; i += L::uWidth) {
+                const typename L::Type a = L::Load(_pA + i);
+                const typename L::Type b = L::Load(_pB + i);
+                L::Store(_pOut + i, L::MulAdd(L::Sub(b, a), L::Load(_pT + i), a));
+            }
+        }
+
+
+        // cubic hermite spline: (2t^3 - 3t^2 + 1)v0 + (t^3 - 2t^2 + t)m0 + (-2t^3 + 3t^2)v1 + (t^3 - t^2)m1
+        // tangents m0 and m1 are expected to be already scaled by keyframe delta time
+        template <typename L>
+        inline void _HermiteRows(const float* _pV0, const float* _pM0, const float* _pV1, const float* _pM1, const float* _pT, float* _pOut,
+                                 size_t _uBegin, size_t _uEnd)
+        {
+            using V = typename L::Type;
+            const V one = L::Set(1.f), two = L::Set(2.f), three = L::Set(3.f);
+
+            for (size_t i = _uBegin; i + L::uWidth <= _uEnd; i += L::uWidth) {
+                const V t = L::Load(_pT + i);
+                const V t2 = L::Mul(t, t);
+                const V t3 = L::Mul(t2, t);
+
+                const V h01 = L::Sub(L::Mul(three, t2), L::Mul(two, t3));
+                const V h00 = L::Sub(one, h01);
+                const V h11 = L::Sub(t3, t2);
+                const V h10 = L::Sub(L::Add(h11, t), t2);
+
+                V out = L::Mul(h00, L::Load(_pV0 + i));
+                out = L::MulAdd(h10, L::Load(_pM0 + i), out);
+                out = L::MulAdd(h01, L::Load(_pV1 + i), out);
+                out = L::MulAdd(h11, L::Load(_pM1 + i), out);
+                L::Store(_pOut + i, out);
+            }
+        }
+
+
+        // out = normalize(w0 * q0 + w1 * q1), quaternions are given as structure of arrays
+        template <typename L>
+        inline void _BlendQuaternions(float* const* _ppArrays, size_t _uBegin, size_t _uEnd) {
+            using V = typename L::Type;
+
+            for (size_t i = _uBegin; i + L::uWidth <= _uEnd; i += L::uWidth) {
+                const V w0 = L::Load(_ppArrays[8] + i);
+                const V w1 = L::Load(_ppArrays[9] + i);
+
+                V q[4];
+                V fLengthSq = L::Set(0.f);
+                for (int j = 0; j < 4; j++) {
+                    q[j] = L::MulAdd(w1, L::Load(_ppArrays[4 + j] + i), L::Mul(w0, L::Load(_ppArrays[j] + i)));
+                    fLengthSq = L::MulAdd(q[j], q[j], fLengthSq);
+                }
+
+                const V fInvLength = L::Div(L::Set(1.f), L::Sqrt(fLengthSq));
+                for (int j = 0; j < 4; j++)
+                    L::Store(_ppArrays[10 + j] + i, L::Mul(q[j], fInvLength));
+            }
+        }
+
+
+        inline size_t _VectorEnd(size_t _uCount) {
+            return _uCount - _uCount % simd::Wide::uWidth;
+        }
+    }
+
+
+    PoseBuffer::PoseBuffer(const Model& _model) {
+        Reset(_model);
+    }
+
+
+    void PoseBuffer::Reset(const Model& _model) {
+        nodePoses.resize(_model.nodes.size());
+        for (size_t i = 0; i < _model.nodes.size(); i++) {
+            const Node& node = _model.nodes[i];
+            nodePoses[i] = LocalPose{ node.qRotation, node.vTranslation, node.fScale };
+        }
+
+        jointPoses.resize(_model.skeletonJoints.size());
+        for (size_t i = 0; i < _model.skeletonJoints.size(); i++) {
+            const SkeletonJoint& joint = _model.skeletonJoints[i];
+            jointPoses[i] = LocalPose{ joint.qRotation, joint.vTranslation, joint.fScale };
+        }
+
+        // each node gets as many weights as its meshes have morph targets or its weight channels animate
+        morphWeightCounts.assign(_model.nodes.size(), 0);
+        for (size_t i = 0; i < _model.nodes.size(); i++) {
+            const uint32_t uMeshGroupId = _model.nodes[i].uMeshGroupId;
+            if (uMeshGroupId >= _model.meshGroups.size())
+                continue;
+
+            for (auto it = _model.meshGroups[uMeshGroupId].meshes.begin(); it != _model.meshGroups[uMeshGroupId].meshes.end(); it++) {
+                if (*it < _model.meshes.size())
+                    morphWeightCounts[i] = std::max(morphWeightCounts[i], static_cast<uint32_t>(_model.meshes[*it].morphTargets.size()));
+            }
+        }
+
+        for (auto it = _model.animationChannels.begin(); it != _model.animationChannels.end(); it++) {
+            if (it->bAnimationTarget == AnimationTarget_Weights && it->uNodePropertyId < _model.nodes.size())
+                morphWeightCounts[it->uNodePropertyId] = std::max(morphWeightCounts[it->uNodePropertyId], it->uWeightCount);
+        }
+
+        morphWeightOffsets.assign(_model.nodes.size(), static_cast<uint32_t>(-1));
+        uint32_t uWeightCount = 0;
+        for (size_t i = 0; i < morphWeightCounts.size(); i++) {
+            if (morphWeightCounts[i]) {
+                morphWeightOffsets[i] = uWeightCount;
+                uWeightCount += morphWeightCounts[i];
+            }
+        }
+        morphWeights.assign(uWeightCount, 0.f);
+    }
+
+
+    AnimationSampler::AnimationSampler(const Model& _model, uint32_t _uAnimationIndex, bool _bSlerp) :
+        m_bSlerp(_bSlerp)
+    {
+        if (_uAnimationIndex >= _model.animations.size()) {
+            std::stringstream ss;
+            ss << "das2::AnimationSampler: invalid animation index " << _uAnimationIndex;
+            throw AnimationException(ss.str());
+        }
+
+        const Animation& animation = _model.animations[_uAnimationIndex];
+        m_tracks.reserve(animation.animationChannels.size());
+
+        for (auto it = animation.animationChannels.begin(); it != animation.animationChannels.end(); it++) {
+            if (*it >= _model.animationChannels.size()) {
+                std::stringstream ss;
+                ss << "das2::AnimationSampler: invalid animation channel id " << *it << " in animation " << _uAnimationIndex;
+                throw AnimationException(ss.str());
+            }
+
+            const AnimationChannel& channel = _model.animationChannels[*it];
+            if (channel.keyframes.empty())
+                continue;
+
+            _Track track;
+            _BindChannel(channel, track);
+            _AddTrack(_model, channel.uNodePropertyId, channel.uJointPropertyId, *it, track);
+        }
+
+        _AllocateScratch();
+    }
+
+
+    AnimationSampler::AnimationSampler(const Model& _model, const CompressedAnimation& _animation, bool _bSlerp) :
+        m_bSlerp(_bSlerp)
+    {
+        m_tracks.reserve(_animation.channels.size());
+
+        for (size_t i = 0; i < _animation.channels.size(); i++) {
+            const CompressedAnimationChannel& channel = _animation.channels[i];
+            if (channel.keyframes.empty())
+                continue;
+
+            _Track track;
+            _BindChannel(channel, track);
+            _AddTrack(_model, channel.uNodePropertyId, channel.uJointPropertyId, i, track);
+        }
+
+        _AllocateScratch();
+    }
+
+
+    void AnimationSampler::_AddTrack(const Model& _model, uint32_t _uNodePropertyId, uint32_t _uJointPropertyId, size_t _uChannel, _Track& _track) {
+        _track.bJointTarget = _uNodePropertyId == static_cast<uint32_t>(-1);
+        _track.uTargetId = _track.bJointTarget ? _uJointPropertyId : _uNodePropertyId;
+
+        const size_t uTargetCount = _track.bJointTarget ? _model.skeletonJoints.size() : _model.nodes.size();
+        if (_track.uTargetId >= uTargetCount || (_track.bJointTarget && _track.bAnimationTarget == AnimationTarget_Weights)) {
+            std::stringstream ss;
+            ss << "das2::AnimationSampler: animation channel " << _uChannel << " has an invalid target";
+            throw AnimationException(ss.str());
+        }
+
+        if (m_tracks.empty()) {
+            m_fStartTime = _track.pKeyframes[0];
+            m_fEndTime = _track.pKeyframes[_track.uKeyframeCount - 1];
+        }
+        else {
+            m_fStartTime = std::min(m_fStartTime, _track.pKeyframes[0]);
+            m_fEndTime = std::max(m_fEndTime, _track.pKeyframes[_track.uKeyframeCount - 1]);
+        }
+
+        m_tracks.push_back(_track);
+    }
+
+
+    void AnimationSampler::_AllocateScratch() {
+        // allocate scratch buffers for the worst case, where every track is interpolated by the same kernel
+        size_t uDecodedSize = 0;
+        for (auto it = m_tracks.begin(); it != m_tracks.end(); it++) {
+            m_uBlendRowCapacity += it->uComponentCount;
+            m_uHermiteRowCapacity += it->uComponentCount;
+            if (it->bAnimationTarget == AnimationTarget_Rotation)
+                m_uQuaternionCapacity++;
+
+            // quantized tracks decode their current keyframe pair into a cache
+            if (!it->pValues) {
+                it->uDecodedOffset = uDecodedSize;
+                uDecodedSize += it->uComponentCount * 2;
+            }
+        }
+
+        m_decodedKeys.resize(uDecodedSize);
+        m_blendRows.resize(m_uBlendRowCapacity * 4);
+        m_hermiteRows.resize(m_uHermiteRowCapacity * 6);
+        m_quaternionRows.resize(m_uQuaternionCapacity * 14);
+        m_blendTracks.reserve(m_tracks.size());
+        m_hermiteTracks.reserve(m_tracks.size());
+        m_quaternionTracks.reserve(m_tracks.size());
+    }
+
+
+    void AnimationSampler::_BindChannel(const AnimationChannel& _channel, _Track& _track) {
+        _track.bAnimationTarget = _channel.bAnimationTarget;
+        _track.bInterpolationType = _channel.bInterpolationType;
+        _track.uComponentCount = _channel.GetComponentCount();
+        _track.uKeyframeCount = static_cast<uint32_t>(_channel.keyframes.size());
+        _track.pKeyframes = _channel.keyframes.data();
+        _track.pValues = _channel.targetValues.data();
+        _track.pTangents = _channel.tangents.data();
+
+        if (_channel.bAnimationTarget == AnimationTarget_Unknown || _channel.bAnimationTarget > AnimationTarget_Scale) {
+            std::stringstream ss;
+            ss << "das2::AnimationSampler: unknown animation target 0x" << std::hex << static_cast<int>(_channel.bAnimationTarget);
+            throw AnimationException(ss.str());
+        }
+
+        const size_t uValueCount = static_cast<size_t>(_track.uKeyframeCount) * _track.uComponentCount;
+        if (_channel.targetValues.size() != uValueCount ||
+            (_channel.bInterpolationType == InterpolationType_CubicSpline && _channel.tangents.size() != uValueCount * 2))
+        {
+            throw AnimationException("das2::AnimationSampler: animation channel value count does not match its keyframe count");
+        }
+    }
+
+
+    void AnimationSampler::_BindChannel(const CompressedAnimationChannel& _channel, _Track& _track) {
+        _track.bAnimationTarget = _channel.bAnimationTarget;
+        _track.bInterpolationType = _channel.bInterpolationType;
+        _track.uComponentCount = _channel.uComponentCount;
+        _track.uKeyframeCount = static_cast<uint32_t>(_channel.keyframes.size());
+        _track.pKeyframes = _channel.keyframes.data();
+        _track.pValues = _channel.GetRawValues();
+        _track.pTangents = _channel.tangents.data();
+        _track.pCompressed = &_channel;
+
+        if (_channel.bAnimationTarget == AnimationTarget_Unknown || _channel.bAnimationTarget > AnimationTarget_Scale) {
+            std::stringstream ss;
+            ss << "das2::AnimationSampler: unknown animation target 0x" << std::hex << static_cast<int>(_channel.bAnimationTarget);
+            throw AnimationException(ss.str());
+        }
+
+        const bool bComponentsValid = (_channel.bAnimationTarget == AnimationTarget_Weights) ||
+                                      (_channel.bAnimationTarget == AnimationTarget_Translation && _channel.uComponentCount == 3) ||
+                                      (_channel.bAnimationTarget == AnimationTarget_Rotation && _channel.uComponentCount == 4) ||
+                                      (_channel.bAnimationTarget == AnimationTarget_Scale && _channel.uComponentCount == 1);
+        const size_t uValueCount = static_cast<size_t>(_track.uKeyframeCount) * _track.uComponentCount;
+        if (!bComponentsValid || _channel.values.size() != _track.uKeyframeCount * _channel.GetKeySize() ||
+            (_channel.bEncoding == ChannelEncoding_Quantized16 && (_channel.rangeMin.size() != _track.uComponentCount ||
+                                                                    _channel.rangeExtent.size() != _track.uComponentCount)) ||
+            (_channel.bInterpolationType == InterpolationType_CubicSpline && (!_track.pValues || _channel.tangents.size() != uValueCount * 2)))
+        {
+            throw AnimationException("das2::AnimationSampler: compressed animation channel is malformed");
+        }
+    }
+
+
+    void AnimationSampler::_DecodeSegment(_Track& _track, const _Segment& _segment, const float*& _pFirst, const float*& _pSecond) {
+        const uint32_t uComponents = _track.uComponentCount;
+        float* pCache = m_decodedKeys.data() + _track.uDecodedOffset;
+        const uint32_t uNext = std::min(_segment.uFirst + 1, _track.uKeyframeCount - 1);
+
+        if (_track.uDecodedKey != _segment.uFirst) {
+            // sequential playback reuses the second key of the previous segment
+            if (_track.uDecodedKey != static_cast<uint32_t>(-1) && _track.uDecodedKey + 1 == _segment.uFirst)
+                std::copy(pCache + uComponents, pCache + uComponents * 2, pCache);
+            else
+                _track.pCompressed->DecodeKey(_segment.uFirst, pCache);
+
+            _track.pCompressed->DecodeKey(uNext, pCache + uComponents);
+            _track.uDecodedKey = _segment.uFirst;
+        }
+
+        _pFirst = pCache;
+        _pSecond = _segment.uSecond == _segment.uFirst ? pCache : pCache + uComponents;
+    }
+
+
+    AnimationSampler::_Segment AnimationSampler::_Seek(_Track& _track, float _fTime) {
+        const float* pKeyframes = _track.pKeyframes;
+        const uint32_t uLast = _track.uKeyframeCount - 1;
+
+        if (_fTime <= pKeyframes[0]) {
+            _track.uCursor = 0;
+            return _Segment{ 0, 0, 0.f, 0.f };
+        }
+        if (_fTime >= pKeyframes[uLast]) {
+            _track.uCursor = uLast;
+            return _Segment{ uLast, uLast, 0.f, 0.f };
+        }
+
+        // pKeyframes[uCursor] <= _fTime < pKeyframes[uCursor + 1] must hold after seeking
+        uint32_t uCursor = std::min(_track.uCursor, uLast - 1);
+        if (pKeyframes[uCursor] <= _fTime) {
+            int iSteps = 0;
+            while (pKeyframes[uCursor + 1] <= _fTime && iSteps < CURSOR_LINEAR_STEPS) {
+                uCursor++;
+                iSteps++;
+            }
+
+            if (pKeyframes[uCursor + 1] <= _fTime) {
+                const float* pUpper = std::upper_bound(pKeyframes + uCursor + 1, pKeyframes + uLast + 1, _fTime);
+                uCursor = static_cast<uint32_t>(pUpper - pKeyframes) - 1;
+            }
+        }
+        else {
+            const float* pUpper = std::upper_bound(pKeyframes, pKeyframes + uCursor + 1, _fTime);
+            uCursor = static_cast<uint32_t>(pUpper - pKeyframes) - 1;
+        }
+
+        _track.uCursor = uCursor;
+        const float fDelta = pKeyframes[uCursor + 1] - pKeyframes[uCursor];
+        return _Segment{ uCursor, uCursor + 1, (_fTime - pKeyframes[uCursor]) / fDelta, fDelta };
+    }
+
+
+    void AnimationSampler::_Store(const _Track& _track, const float* _pValues, PoseBuffer& _poses) const {
+        if (_track.bAnimationTarget == AnimationTarget_Weights) {
+            const uint32_t uOffset = _poses.morphWeightOffsets[_track.uTargetId];
+            if (uOffset == static_cast<uint32_t>(-1))
+                return;
+
+            const uint32_t uCount = std::min(_track.uComponentCount, _poses.morphWeightCounts[_track.uTargetId]);
+            std::copy(_pValues, _pValues + uCount, _poses.morphWeights.begin() + uOffset);
+            return;
+        }
+
+        LocalPose& pose = _track.bJointTarget ? _poses.jointPoses[_track.uTargetId] : _poses.nodePoses[_track.uTargetId];
+        switch (_track.bAnimationTarget) {
+            case AnimationTarget_Translation:
+                pose.vTranslation.first = _pValues[0];
+                pose.vTranslation.second = _pValues[1];
+                pose.vTranslation.third = _pValues[2];
+                break;
+
+            case AnimationTarget_Rotation:
+                pose.qRotation.x = _pValues[0];
+                pose.qRotation.y = _pValues[1];
+                pose.qRotation.z = _pValues[2];
+                pose.qRotation.w = _pValues[3];
+                break;
+
+            case AnimationTarget_Scale:
+                pose.fScale = _pValues[0];
+                break;
+
+            default:
+                break;
+        }
+    }
+
+
+    void AnimationSampler::Sample(float _fTime, PoseBuffer& _poses) {
+        m_blendTracks.clear();
+        m_hermiteTracks.clear();
+        m_quaternionTracks.clear();
+
+        float* arrBlend[4];
+        for (int i = 0; i < 4; i++)
+            arrBlend[i] = m_blendRows.data() + i * m_uBlendRowCapacity;
+        float* arrHermite[6];
+        for (int i = 0; i < 6; i++)
+            arrHermite[i] = m_hermiteRows.data() + i * m_uHermiteRowCapacity;
+        float* arrQuaternion[14];
+        for (int i = 0; i < 14; i++)
+            arrQuaternion[i] = m_quaternionRows.data() + i * m_uQuaternionCapacity;
+
+        // gather interpolation inputs of all tracks into rows, constant segments are written out immediately
+        size_t uBlendRows = 0, uHermiteRows = 0, uQuaternions = 0;
+        for (size_t i = 0; i < m_tracks.size(); i++) {
+            _Track& track = m_tracks[i];
+            const _Segment segment = _Seek(track, _fTime);
+
+            const uint32_t uComponents = track.uComponentCount;
+            const float* pFirst = nullptr;
+            const float* pSecond = nullptr;
+            if (track.pValues) {
+                pFirst = track.pValues + segment.uFirst * uComponents;
+                pSecond = track.pValues + segment.uSecond * uComponents;
+            }
+            else {
+                _DecodeSegment(track, segment, pFirst, pSecond);
+            }
+
+            if (segment.uFirst == segment.uSecond || track.bInterpolationType == InterpolationType_Step) {
+                _Store(track, pFirst, _poses);
+                continue;
+            }
+
+            if (track.bInterpolationType == InterpolationType_CubicSpline) {
+                // out tangent of the first keyframe and in tangent of the second keyframe
+                const float* pOutTangent = track.pTangents + (segment.uFirst * 2 + 1) * uComponents;
+                const float* pInTangent = track.pTangents + (segment.uSecond * 2) * uComponents;
+                for (uint32_t j = 0; j < uComponents; j++) {
+                    arrHermite[0][uHermiteRows] = pFirst[j];
+                    arrHermite[1][uHermiteRows] = pOutTangent[j] * segment.fDelta;
+                    arrHermite[2][uHermiteRows] = pSecond[j];
+                    arrHermite[3][uHermiteRows] = pInTangent[j] * segment.fDelta;
+                    arrHermite[4][uHermiteRows] = segment.fFactor;
+                    uHermiteRows++;
+                }
+                m_hermiteTracks.push_back(static_cast<uint32_t>(i));
+            }
+            else if (track.bAnimationTarget == AnimationTarget_Rotation) {
+                // take the shortest path
+                float fDot = pFirst[0] * pSecond[0] + pFirst[1] * pSecond[1] + pFirst[2] * pSecond[2] + pFirst[3] * pSecond[3];
+                const float fSign = fDot < 0.f ? -1.f : 1.f;
+                fDot *= fSign;
+
+                float fWeight0 = 1.f - segment.fFactor, fWeight1 = segment.fFactor;
+                if (m_bSlerp && fDot < 1.f - SLERP_EPSILON) {
+                    const float fTheta = std::acos(fDot);
+                    const float fInvSin = 1.f / std::sin(fTheta);
+                    fWeight0 = std::sin(fWeight0 * fTheta) * fInvSin;
+                    fWeight1 = std::sin(fWeight1 * fTheta) * fInvSin;
+                }
+
+                for (int j = 0; j < 4; j++) {
+                    arrQuaternion[j][uQuaternions] = pFirst[j];
+                    arrQuaternion[4 + j][uQuaternions] = pSecond[j];
+                }
+                arrQuaternion[8][uQuaternions] = fWeight0;
+                arrQuaternion[9][uQuaternions] = fWeight1 * fSign;
+                uQuaternions++;
+                m_quaternionTracks.push_back(static_cast<uint32_t>(i));
+            }
+            else {
+                for (uint32_t j = 0; j < uComponents; j++) {
+                    arrBlend[0][uBlendRows] = pFirst[j];
+                    arrBlend[1][uBlendRows] = pSecond[j];
+                    arrBlend[2][uBlendRows] = segment.fFactor;
+                    uBlendRows++;
+                }
+                m_blendTracks.push_back(static_cast<uint32_t>(i));
+            }
+        }
+
+        // evaluate all rows across channels
+        _LerpRows<simd::Wide>(arrBlend[0], arrBlend[1], arrBlend[2], arrBlend[3], 0, _VectorEnd(uBlendRows));
+        _LerpRows<simd::Scalar>(arrBlend[0], arrBlend[1], arrBlend[2], arrBlend[3], _VectorEnd(uBlendRows), uBlendRows);
+        _HermiteRows<simd::Wide>(arrHermite[0], arrHermite[1], arrHermite[2], arrHermite[3], arrHermite[4], arrHermite[5], 0, _VectorEnd(uHermiteRows));
+        _HermiteRows<simd::Scalar>(arrHermite[0], arrHermite[1], arrHermite[2], arrHermite[3], arrHermite[4], arrHermite[5],
+                                   _VectorEnd(uHermiteRows), uHermiteRows);
+        _BlendQuaternions<simd::Wide>(arrQuaternion, 0, _VectorEnd(uQuaternions));
+        _BlendQuaternions<simd::Scalar>(arrQuaternion, _VectorEnd(uQuaternions), uQuaternions);
+
+        // scatter results
+        size_t uRow = 0;
+        for (auto it = m_blendTracks.begin(); it != m_blendTracks.end(); it++) {
+            _Store(m_tracks[*it], arrBlend[3] + uRow, _poses);
+            uRow += m_tracks[*it].uComponentCount;
+        }
+
+        uRow = 0;
+        for (auto it = m_hermiteTracks.begin(); it != m_hermiteTracks.end(); it++) {
+            const _Track& track = m_tracks[*it];
+            float* pOut = arrHermite[5] + uRow;
+
+            // splines do not preserve unit length of quaternions
+            if (track.bAnimationTarget == AnimationTarget_Rotation) {
+                const float fLength = std::sqrt(pOut[0] * pOut[0] + pOut[1] * pOut[1] + pOut[2] * pOut[2] + pOut[3] * pOut[3]);
+                if (fLength > 0.f) {
+                    for (int j = 0; j < 4; j++)
+                        pOut[j] /= fLength;
+                }
+            }
+
+            _Store(track, pOut, _poses);
+            uRow += track.uComponentCount;
+        }
+
+        for (size_t i = 0; i < m_quaternionTracks.size(); i++) {
+            const float arrRotation[4] = { arrQuaternion[10][i], arrQuaternion[11][i], arrQuaternion[12][i], arrQuaternion[13][i] };
+            _Store(m_tracks[m_quaternionTracks[i]], arrRotation, _poses);
+        }
+    }
+
+
+    void AnimationSampler::ResetCursors() {
+        for (auto it = m_tracks.begin(); it != m_tracks.end(); it++)
+            it->uCursor = 0;
+    }
+}
@@ -4,40 +4,120 @@
 // author: Karl-Mihkel Ott
 
 #include <iomanip>
+#include <algorithm>
 #include <sstream>
 #include <das2/Exceptions.h>
 #include <das2/DasStructures.h>
 
 namespace das2 {
 
-    Buffer::Buffer(const Buffer& _buffer) {
-        m_bStructure = _buffer.m_bStructure;
-        if (_buffer.m_uLength) {
-            m_uLength = _buffer.m_uLength;
-            m_pData = new char[m_uLength];
-            std::memcpy(m_pData, _buffer.m_pData, m_uLength);
+    void BinString::Read(std::istream& _stream) {
+        _Release();
+        _stream.read(reinterpret_cast<char*>(&m_uLength), sizeof(uint16_t));
+        _stream.read(reinterpret_cast<char*>(&m_hshString), sizeof(cvar::hash_t));
+
+        if (m_uLength) {
+            m_pData = static_cast<char*>(m_pResource->allocate(m_uLength + 1, alignof(char)));
+            m_pData[m_uLength] = 0;
+            _stream.read(m_pData, m_uLength);
+        }
+    }
+    
+    void BinString::Write(std::ostream& _stream) const {
+        _stream.write(reinterpret_cast<const char*>(&m_uLength), sizeof(uint16_t));
+        _stream.write(reinterpret_cast<const char*>(&m_hshString), sizeof(cvar::hash_t));
+        if (m_pData && m_uLength) {
+            _stream.write(m_pData, m_uLength);
         }
     }
 
 
+    Header::Header(const allocator_type& _alloc) :
+        szAuthorName(_alloc),
+        szComment(_alloc) {}
+
+
+    Header::Header(const Header& _header, const allocator_type& _alloc) :
+        Header(_alloc)
+    {
+        *this = _header;
+    }
+
+
+    Header::Header(Header&& _header, const allocator_type& _alloc) :
+        Header(_alloc)
+    {
+        *this = std::move(_header);
+    }
+
+
+    Buffer::Buffer(const allocator_type& _alloc) :
+        m_pResource(_alloc.resource()) {}
+
+
+    Buffer::Buffer(const Buffer& _buffer) {
+        *this = _buffer;
+    }
+
+
+    Buffer::Buffer(const Buffer& _buffer, const allocator_type& _alloc) :
+        m_pResource(_alloc.resource())
+    {
+        *this = _buffer;
+    }
+
+
     Buffer::Buffer(Buffer&& _buffer) noexcept {
         m_bStructure = _buffer.m_bStructure;
         m_uLength = _buffer.m_uLength;
+        m_uCapacity = _buffer.m_uCapacity;
         m_pData = _buffer.m_pData;
+        m_pResource = _buffer.m_pResource;
 
         _buffer.m_uLength = 0;
+        _buffer.m_uCapacity = 0;
         _buffer.m_pData = nullptr;
     }
 
 
-    Buffer& Buffer::operator=(Buffer&& _buffer) noexcept {
-        delete[] m_pData;
+    Buffer::Buffer(Buffer&& _buffer, const allocator_type& _alloc) :
+        m_pResource(_alloc.resource())
+    {
+        *this = std::move(_buffer);
+    }
+
+
+    Buffer& Buffer::operator=(const Buffer& _buffer) {
+        if (this == &_buffer)
+            return *this;
 
         m_bStructure = _buffer.m_bStructure;
+        m_uLength = 0;
+        _Reserve(_buffer.m_uLength);
         m_uLength = _buffer.m_uLength;
+        if (m_uLength)
+            std::memcpy(m_pData, _buffer.m_pData, m_uLength);
+
+        return *this;
+    }
+
+
+    // memory resource is never propagated, the blob is copied when resources differ
+    Buffer& Buffer::operator=(Buffer&& _buffer) {
+        if (this == &_buffer)
+            return *this;
+
+        if (*m_pResource != *_buffer.m_pResource)
+            return *this = static_cast<const Buffer&>(_buffer);
+
+        _Release();
+        m_bStructure = _buffer.m_bStructure;
+        m_uLength = _buffer.m_uLength;
+        m_uCapacity = _buffer.m_uCapacity;
         m_pData = _buffer.m_pData;
 
         _buffer.m_uLength = 0;
+        _buffer.m_uCapacity = 0;
         _buffer.m_pData = nullptr;
 
         return *this;
@@ -45,29 +125,37 @@ namespace das2 {
 
 
     Buffer::~Buffer() {
+        _Release();
+    }
+
+
+    void Buffer::_Reserve(uint32_t _uCapacity) {
+        if (_uCapacity <= m_uCapacity)
+            return;
+
+        // grow geometrically to keep repeated PushRange() calls amortized
+        uint64_t uNewCapacity = std::max<uint64_t>(_uCapacity, static_cast<uint64_t>(m_uCapacity) + m_uCapacity / 2);
+        uNewCapacity = std::min<uint64_t>(uNewCapacity, UINT32_MAX);
+
+        char* pNewData = static_cast<char*>(m_pResource->allocate(static_cast<size_t>(uNewCapacity), alignof(std::max_align_t)));
         if (m_uLength)
-            free(m_pData);
+            std::memcpy(pNewData, m_pData, m_uLength);
+
+        if (m_pData)
+            m_pResource->deallocate(m_pData, m_uCapacity, alignof(std::max_align_t));
+
+        m_pData = pNewData;
+        m_uCapacity = static_cast<uint32_t>(uNewCapacity);
     }
 
 
-    void BinString::Read(std::istream& _stream) {
-        _stream.read(reinterpret_cast<char*>(&m_uLength), sizeof(uint16_t));
-        _stream.read(reinterpret_cast<char*>(&m_hshString), sizeof(cvar::hash_t));
+    void Buffer::_Release() {
+        if (m_pData)
+            m_pResource->deallocate(m_pData, m_uCapacity, alignof(std::max_align_t));
 
-        delete[] m_pData;
         m_pData = nullptr;
-        if (m_uLength) {
-            m_pData = new char[m_uLength + 1]{};
-            _stream.read(m_pData, m_uLength);
-        }
-    }
-    
-    void BinString::Write(std::ostream& _stream) const {
-        _stream.write(reinterpret_cast<const char*>(&m_uLength), sizeof(uint16_t));
-        _stream.write(reinterpret_cast<const char*>(&m_hshString), sizeof(cvar::hash_t));
-        if (m_pData && m_uLength) {
-            _stream.write(m_pData, m_uLength);
-        }
+        m_uLength = 0;
+        m_uCapacity = 0;
     }
 
 
@@ -108,13 +196,14 @@ namespace das2 {
             throw MagicValueException(ss.str());
         }
 
-        _stream.read(reinterpret_cast<char*>(&m_uLength), sizeof(uint32_t));
+        uint32_t uLength = 0;
+        _stream.read(reinterpret_cast<char*>(&uLength), sizeof(uint32_t));
 
-        delete[] m_pData;
-        m_pData = nullptr;
+        m_uLength = 0;
+        _Reserve(uLength);
+        m_uLength = uLength;
 
         if (m_uLength) {
-            m_pData = new char[m_uLength];
             _stream.read(m_pData, m_uLength);
         }
     }
@@ -151,6 +240,25 @@ namespace das2 {
     }
 
     
+    Mesh::Mesh(const allocator_type& _alloc) :
+        morphTargets(_alloc),
+        multipleLods(_alloc) {}
+
+
+    Mesh::Mesh(const Mesh& _mesh, const allocator_type& _alloc) :
+        Mesh(_alloc)
+    {
+        *this = _mesh;
+    }
+
+
+    Mesh::Mesh(Mesh&& _mesh, const allocator_type& _alloc) :
+        Mesh(_alloc)
+    {
+        *this = std::move(_mesh);
+    }
+
+
     void Mesh::Read(std::istream& _stream) {
         _stream.read(reinterpret_cast<char*>(&m_bStructure), sizeof(StructureIdentifier));
         if (!Verify()) {
@@ -164,7 +272,7 @@ namespace das2 {
         _stream.read(reinterpret_cast<char*>(&uPositionVertexBufferOffset), sizeof(uint32_t));
         _stream.read(reinterpret_cast<char*>(&uVertexNormalBufferOffset), sizeof(uint32_t));
         _stream.read(reinterpret_cast<char*>(arrUVBufferOffsets.data()), sizeof(std::array<uint32_t, 8>));
-        _stream.read(reinterpret_cast<char*>(&uIndexBufferOffset), sizeof(uint32_t));
+        _stream.read(reinterpret_cast<char*>(&uColorMultiplierOffset), sizeof(uint32_t));
         _stream.read(reinterpret_cast<char*>(arrSkeletalJointIndexBufferOffsets.data()), sizeof(std::array<uint32_t, 8>));
         _stream.read(reinterpret_cast<char*>(arrSkeletalJointWeightBufferOffsets.data()), sizeof(std::array<uint32_t, 8>));
         _stream.read(reinterpret_cast<char*>(&bMaterialType), sizeof(MaterialType));
@@ -219,6 +327,25 @@ namespace das2 {
     }
 
 
+    MeshGroup::MeshGroup(const allocator_type& _alloc) :
+        szName(_alloc),
+        meshes(_alloc) {}
+
+
+    MeshGroup::MeshGroup(const MeshGroup& _meshGroup, const allocator_type& _alloc) :
+        MeshGroup(_alloc)
+    {
+        *this = _meshGroup;
+    }
+
+
+    MeshGroup::MeshGroup(MeshGroup&& _meshGroup, const allocator_type& _alloc) :
+        MeshGroup(_alloc)
+    {
+        *this = std::move(_meshGroup);
+    }
+
+
     void MeshGroup::Read(std::istream& _stream) {
         _stream.read(reinterpret_cast<char*>(&m_bStructure), sizeof(StructureIdentifier));
         if (!Verify()) {
@@ -245,6 +372,25 @@ namespace das2 {
     }
 
 
+    Node::Node(const allocator_type& _alloc) :
+        szName(_alloc),
+        children(_alloc) {}
+
+
+    Node::Node(const Node& _node, const allocator_type& _alloc) :
+        Node(_alloc)
+    {
+        *this = _node;
+    }
+
+
+    Node::Node(Node&& _node, const allocator_type& _alloc) :
+        Node(_alloc)
+    {
+        *this = std::move(_node);
+    }
+
+
     void Node::Read(std::istream& _stream) {
         _stream.read(reinterpret_cast<char*>(&m_bStructure), sizeof(StructureIdentifier));
         if (!Verify()) {
@@ -284,6 +430,25 @@ namespace das2 {
     }
 
 
+    Scene::Scene(const allocator_type& _alloc) :
+        szName(_alloc),
+        rootNodes(_alloc) {}
+
+
+    Scene::Scene(const Scene& _scene, const allocator_type& _alloc) :
+        Scene(_alloc)
+    {
+        *this = _scene;
+    }
+
+
+    Scene::Scene(Scene&& _scene, const allocator_type& _alloc) :
+        Scene(_alloc)
+    {
+        *this = std::move(_scene);
+    }
+
+
     void Scene::Read(std::istream& _stream) {
         _stream.read(reinterpret_cast<char*>(&m_bStructure), sizeof(StructureIdentifier));
         if (!Verify()) {
@@ -310,6 +475,25 @@ namespace das2 {
     }
 
 
+    SkeletonJoint::SkeletonJoint(const allocator_type& _alloc) :
+        szName(_alloc),
+        children(_alloc) {}
+
+
+    SkeletonJoint::SkeletonJoint(const SkeletonJoint& _skeletonJoint, const allocator_type& _alloc) :
+        SkeletonJoint(_alloc)
+    {
+        *this = _skeletonJoint;
+    }
+
+
+    SkeletonJoint::SkeletonJoint(SkeletonJoint&& _skeletonJoint, const allocator_type& _alloc) :
+        SkeletonJoint(_alloc)
+    {
+        *this = std::move(_skeletonJoint);
+    }
+
+
     void SkeletonJoint::Read(std::istream& _stream) {
         _stream.read(reinterpret_cast<char*>(&m_bStructure), sizeof(StructureIdentifier));
         if (!Verify()) {
@@ -346,6 +530,25 @@ namespace das2 {
     }
 
 
+    Skeleton::Skeleton(const allocator_type& _alloc) :
+        szName(_alloc),
+        joints(_alloc) {}
+
+
+    Skeleton::Skeleton(const Skeleton& _skeleton, const allocator_type& _alloc) :
+        Skeleton(_alloc)
+    {
+        *this = _skeleton;
+    }
+
+
+    Skeleton::Skeleton(Skeleton&& _skeleton, const allocator_type& _alloc) :
+        Skeleton(_alloc)
+    {
+        *this = std::move(_skeleton);
+    }
+
+
     void Skeleton::Read(std::istream& _stream) {
         _stream.read(reinterpret_cast<char*>(&m_bStructure), sizeof(StructureIdentifier));
         if (!Verify()) {
@@ -374,6 +577,25 @@ namespace das2 {
     }
 
 
+    Animation::Animation(const allocator_type& _alloc) :
+        szName(_alloc),
+        animationChannels(_alloc) {}
+
+
+    Animation::Animation(const Animation& _animation, const allocator_type& _alloc) :
+        Animation(_alloc)
+    {
+        *this = _animation;
+    }
+
+
+    Animation::Animation(Animation&& _animation, const allocator_type& _alloc) :
+        Animation(_alloc)
+    {
+        *this = std::move(_animation);
+    }
+
+
     void Animation::Read(std::istream& _stream) {
         _stream.read(reinterpret_cast<char*>(&m_bStructure), sizeof(StructureIdentifier));
         if (!Verify()) {
@@ -400,6 +622,26 @@ namespace das2 {
     }
 
 
+    AnimationChannel::AnimationChannel(const allocator_type& _alloc) :
+        keyframes(_alloc),
+        tangents(_alloc),
+        targetValues(_alloc) {}
+
+
+    AnimationChannel::AnimationChannel(const AnimationChannel& _animationChannel, const allocator_type& _alloc) :
+        AnimationChannel(_alloc)
+    {
+        *this = _animationChannel;
+    }
+
+
+    AnimationChannel::AnimationChannel(AnimationChannel&& _animationChannel, const allocator_type& _alloc) :
+        AnimationChannel(_alloc)
+    {
+        *this = std::move(_animationChannel);
+    }
+
+
     void AnimationChannel::Read(std::istream& _stream) {
         _stream.read(reinterpret_cast<char*>(&m_bStructure), sizeof(StructureIdentifier));
         if (!Verify()) {
@@ -411,6 +653,7 @@ namespace das2 {
         _stream.read(reinterpret_cast<char*>(&uNodePropertyId), sizeof(uint32_t));
         _stream.read(reinterpret_cast<char*>(&uJointPropertyId), sizeof(uint32_t));
         _stream.read(reinterpret_cast<char*>(&bAnimationTarget), sizeof(AnimationTarget));
+        _stream.read(reinterpret_cast<char*>(&bInterpolationType), sizeof(InterpolationType));
         _stream.read(reinterpret_cast<char*>(&uWeightCount), sizeof(uint32_t));
 
         uint32_t uKeyframeCount = 0;
@@ -418,94 +661,18 @@ namespace das2 {
         keyframes.resize(uKeyframeCount);
         _stream.read(reinterpret_cast<char*>(keyframes.data()), sizeof(float) * keyframes.size());
 
-        // read tangents
+        // tangents and target values are stored in the same keyframe-major layout as they are kept in memory
+        const size_t uValueCount = static_cast<size_t>(uKeyframeCount) * GetComponentCount();
         if (bInterpolationType == InterpolationType_CubicSpline) {
-            tangents.resize(uKeyframeCount);
-            for (auto it = tangents.begin(); it != tangents.end(); it++) {
-                switch (bAnimationTarget) {
-                    case AnimationTarget_Rotation:
-                        {
-                            TRS::Quaternion q;
-                            _stream.read(reinterpret_cast<char*>(&q), sizeof(TRS::Quaternion));
-                            (*it)[0] = q;
-                            _stream.read(reinterpret_cast<char*>(&q), sizeof(TRS::Quaternion));
-                            (*it)[1] = q;
-                        }
-                        break;
-
-                    case AnimationTarget_Translation:
-                        {
-                            TRS::Vector3<float> v;
-                            _stream.read(reinterpret_cast<char*>(&v), sizeof(TRS::Vector3<float>));
-                            (*it)[0] = v;
-                            _stream.read(reinterpret_cast<char*>(&v), sizeof(TRS::Vector3<float>));
-                            (*it)[1] = v;
-                        }
-                        break;
-
-                    case AnimationTarget_Scale:
-                        {
-                            float fScale = 0.;
-                            _stream.read(reinterpret_cast<char*>(&fScale), sizeof(float));
-                            (*it)[0] = fScale;
-                            _stream.read(reinterpret_cast<char*>(&fScale), sizeof(float));
-                            (*it)[1] = fScale;
-                        }
-                        break;
-
-                    case AnimationTarget_Weights:
-                        {
-                            (*it)[0].emplace<std::vector<float>>();
-                            (*it)[1].emplace<std::vector<float>>();
-
-                            auto& a1 = std::get<std::vector<float>>((*it)[0]);
-                            auto& a2 = std::get<std::vector<float>>((*it)[1]);
-                            a1.resize(uWeightCount);
-                            a2.resize(uWeightCount);
-
-                            _stream.read(reinterpret_cast<char*>(a1.data()), a1.size() * sizeof(float));
-                            _stream.read(reinterpret_cast<char*>(a2.data()), a2.size() * sizeof(float));
-                        }
-                        break;
-
-                    default:
-                        break;
-                }
-            }
+            tangents.resize(uValueCount * 2);
+            _stream.read(reinterpret_cast<char*>(tangents.data()), sizeof(float) * tangents.size());
         }
-
-        // read target values
-        targetValues.resize(uKeyframeCount);
-        for (auto it = targetValues.begin(); it != targetValues.end(); it++) {
-            switch (bAnimationTarget) {
-                case AnimationTarget_Rotation:
-                    it->emplace<TRS::Quaternion>();
-                    _stream.read(reinterpret_cast<char*>(&std::get<TRS::Quaternion>(*it)), sizeof(TRS::Quaternion));
-                    break;
-
-                case AnimationTarget_Translation:
-                    it->emplace<TRS::Vector3<float>>();
-                    _stream.read(reinterpret_cast<char*>(&std::get<TRS::Vector3<float>>(*it)), sizeof(TRS::Vector3<float>));
-                    break;
-
-                case AnimationTarget_Scale:
-                    it->emplace<float>();
-                    _stream.read(reinterpret_cast<char*>(&std::get<float>(*it)), sizeof(float));
-                    break;
-
-                case AnimationTarget_Weights:
-                    {
-                        it->emplace<std::vector<float>>();
-                        auto& target = std::get<std::vector<float>>(*it);
-                        target.resize(uWeightCount);
-                        _stream.read(reinterpret_cast<char*>(target.data()), sizeof(float) * target.size());
-                    }
-                    break;
-
-                default:
-                    break;
-            }
+        else {
+            tangents.clear();
         }
+
+        targetValues.resize(uValueCount);
+        _stream.read(reinterpret_cast<char*>(targetValues.data()), sizeof(float) * targetValues.size());
     }
 
     void AnimationChannel::Write(std::ostream& _stream) const {
@@ -520,66 +687,30 @@ namespace das2 {
         _stream.write(reinterpret_cast<const char*>(&uKeyframeCount), sizeof(uint32_t));
         _stream.write(reinterpret_cast<const char*>(keyframes.data()), sizeof(float) * keyframes.size());
 
-        // write tangents
-        if (bInterpolationType == InterpolationType_CubicSpline) {
-            for (auto it = tangents.begin(); it != tangents.end(); it++) {
-                switch (bAnimationTarget) {
-                    case AnimationTarget_Rotation:
-                        _stream.write(reinterpret_cast<const char*>(&std::get<TRS::Quaternion>((*it)[0])), sizeof(TRS::Quaternion));
-                        _stream.write(reinterpret_cast<const char*>(&std::get<TRS::Quaternion>((*it)[1])), sizeof(TRS::Quaternion));
-                        break;
-
-                    case AnimationTarget_Translation:
-                        _stream.write(reinterpret_cast<const char*>(&std::get<TRS::Vector3<float>>((*it)[0])), sizeof(TRS::Vector3<float>));
-                        _stream.write(reinterpret_cast<const char*>(&std::get<TRS::Vector3<float>>((*it)[1])), sizeof(TRS::Vector3<float>));
-                        break;
-
-                    case AnimationTarget_Scale:
-                        _stream.write(reinterpret_cast<const char*>(&std::get<float>((*it)[0])), sizeof(float));
-                        _stream.write(reinterpret_cast<const char*>(&std::get<float>((*it)[1])), sizeof(float));
-                        break;
-
-                    case AnimationTarget_Weights:
-                        {
-                            auto& a1 = std::get<std::vector<float>>((*it)[0]);
-                            auto& a2 = std::get<std::vector<float>>((*it)[1]);
-                            _stream.write(reinterpret_cast<const char*>(a1.data()), a1.size() * sizeof(float));
-                            _stream.write(reinterpret_cast<const char*>(a2.data()), a2.size() * sizeof(float));
-                        }
-                        break;
-
-                    default:
-                        break;
-                }
-            }
-        }
+        if (bInterpolationType == InterpolationType_CubicSpline)
+            _stream.write(reinterpret_cast<const char*>(tangents.data()), sizeof(float) * tangents.size());
+        _stream.write(reinterpret_cast<const char*>(targetValues.data()), sizeof(float) * targetValues.size());
+    }
 
-        // write target values
-        for (auto it = targetValues.begin(); it != targetValues.end(); it++) {
-            switch (bAnimationTarget) {
-                case AnimationTarget_Rotation:
-                    _stream.write(reinterpret_cast<const char*>(&std::get<TRS::Quaternion>(*it)), sizeof(TRS::Quaternion));
-                    break;
-
-                case AnimationTarget_Translation:
-                    _stream.write(reinterpret_cast<const char*>(&std::get<TRS::Vector3<float>>(*it)), sizeof(TRS::Vector3<float>));
-                    break;
-
-                case AnimationTarget_Scale:
-                    _stream.write(reinterpret_cast<const char*>(&std::get<float>(*it)), sizeof(float));
-                    break;
-
-                case AnimationTarget_Weights:
-                    {
-                        auto& w = std::get<std::vector<float>>(*it);
-                        _stream.write(reinterpret_cast<const char*>(w.data()), sizeof(float) * w.size());
-                    }
-                    break;
-
-                default:
-                    break;
-            }
-        }
+
+    MaterialPhong::MaterialPhong(const allocator_type& _alloc) :
+        szName(_alloc),
+        szDiffuseMapUri(_alloc),
+        szSpecularMapUri(_alloc),
+        szEmissionMapUri(_alloc) {}
+
+
+    MaterialPhong::MaterialPhong(const MaterialPhong& _materialPhong, const allocator_type& _alloc) :
+        MaterialPhong(_alloc)
+    {
+        *this = _materialPhong;
+    }
+
+
+    MaterialPhong::MaterialPhong(MaterialPhong&& _materialPhong, const allocator_type& _alloc) :
+        MaterialPhong(_alloc)
+    {
+        *this = std::move(_materialPhong);
     }
 
 
@@ -614,6 +745,29 @@ namespace das2 {
     }
 
 
+    MaterialPbr::MaterialPbr(const allocator_type& _alloc) :
+        szName(_alloc),
+        szAlbedoMapUri(_alloc),
+        szEmissionMapUri(_alloc),
+        szRoughnessMapUri(_alloc),
+        szMetallicMapUri(_alloc),
+        szAmbientOcclusionMapUri(_alloc) {}
+
+
+    MaterialPbr::MaterialPbr(const MaterialPbr& _materialPbr, const allocator_type& _alloc) :
+        MaterialPbr(_alloc)
+    {
+        *this = _materialPbr;
+    }
+
+
+    MaterialPbr::MaterialPbr(MaterialPbr&& _materialPbr, const allocator_type& _alloc) :
+        MaterialPbr(_alloc)
+    {
+        *this = std::move(_materialPbr);
+    }
+
+
     void MaterialPbr::Read(std::istream& _stream) {
         _stream.read(reinterpret_cast<char*>(&m_bStructure), sizeof(StructureIdentifier));
         if (!Verify()) {
@@ -636,7 +790,7 @@ namespace das2 {
     }
 
     void MaterialPbr::Write(std::ostream& _stream) const {
-        _stream.write(reinterpret_cast<const char*>(m_bStructure), sizeof(StructureIdentifier));
+        _stream.write(reinterpret_cast<const char*>(&m_bStructure), sizeof(StructureIdentifier));
         szName.Write(_stream);
         _stream.write(reinterpret_cast<const char*>(&vAlbedoFactor), sizeof(TRS::Vector4<float>));
         _stream.write(reinterpret_cast<const char*>(&vEmissiveFactor), sizeof(TRS::Vector4<float>));
@@ -0,0 +1,150 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: Inspector.cpp - implementation of fast das2 file inspection without loading the buffer
+// author: Karl-Mihkel Ott
+
+#include <das2/Exceptions.h>
+#include <das2/Inspector.h>
+
+#include <boost/iostreams/filtering_streambuf.hpp>
+#include <boost/iostreams/filter/zstd.hpp>
+
+namespace das2 {
+
+    namespace {
+        template <typename T>
+        inline void _SkipStructure(std::istream& _stream) {
+            T structure;
+            structure.Read(_stream);
+        }
+
+
+        // _uEnd: end of the stream relative to _stream's beginning or 0 if it is not seekable,
+        // in which case the buffer blob is read and discarded
+        void _ScanStructures(std::istream& _stream, uint64_t _uEnd, ModelSummary& _summary) {
+            bool bBufferRead = false;
+            while (_stream.peek() != std::char_traits<char>::eof()) {
+                const StructureIdentifier bIdentifier = static_cast<StructureIdentifier>(_stream.peek());
+                const std::streamoff uStart = static_cast<std::streamoff>(_stream.tellg());
+
+                switch (bIdentifier) {
+                    case StructureIdentifier_Buffer: {
+                        if (bBufferRead)
+                            throw SerializerException("Multiple buffers detected in das2 buffer. The specification states that only one buffer is allowed.");
+                        bBufferRead = true;
+
+                        uint32_t uLength = 0;
+                        _stream.get();
+                        _stream.read(reinterpret_cast<char*>(&uLength), sizeof(uint32_t));
+                        if (_uEnd) {
+                            if (static_cast<uint64_t>(uStart) + sizeof(StructureIdentifier) + sizeof(uint32_t) + uLength > _uEnd)
+                                throw SerializerException("[das2::InspectModel] Buffer exceeds the end of the file");
+                            _stream.seekg(uLength, std::ios_base::cur);
+                        }
+                        else {
+                            _stream.ignore(uLength);
+                            if (static_cast<uint64_t>(_stream.gcount()) != uLength)
+                                throw SerializerException("[das2::InspectModel] Buffer exceeds the end of the file");
+                        }
+                        _summary.uBufferSize = uLength;
+                        break;
+                    }
+
+                    case StructureIdentifier_Mesh:
+                        _SkipStructure<Mesh>(_stream);
+                        break;
+
+                    case StructureIdentifier_MeshGroup:
+                        _SkipStructure<MeshGroup>(_stream);
+                        break;
+
+                    case StructureIdentifier_Node:
+                        _SkipStructure<Node>(_stream);
+                        break;
+
+                    case StructureIdentifier_Scene:
+                        _SkipStructure<Scene>(_stream);
+                        break;
+
+                    case StructureIdentifier_SkeletonJoint:
+                        _SkipStructure<SkeletonJoint>(_stream);
+                        break;
+
+                    case StructureIdentifier_Skeleton:
+                        _SkipStructure<Skeleton>(_stream);
+                        break;
+
+                    case StructureIdentifier_Animation:
+                        _SkipStructure<Animation>(_stream);
+                        break;
+
+                    case StructureIdentifier_AnimationChannel:
+                        _SkipStructure<AnimationChannel>(_stream);
+                        break;
+
+                    case StructureIdentifier_MaterialPhong:
+                        _SkipStructure<MaterialPhong>(_stream);
+                        break;
+
+                    case StructureIdentifier_MaterialPbr:
+                        _SkipStructure<MaterialPbr>(_stream);
+                        break;
+
+                    default:
+                        throw SerializerException("Invalid magic byte");
+                }
+
+                if (!_stream)
+                    throw SerializerException("[das2::InspectModel] Truncated structure record");
+
+                StructureStats& structure = _summary.arrStructures[bIdentifier];
+                structure.uCount++;
+                structure.uBytes += static_cast<uint64_t>(static_cast<std::streamoff>(_stream.tellg()) - uStart);
+            }
+        }
+    }
+
+
+    ModelSummary InspectModel(std::istream& _stream, bool _bDecompress) {
+        ModelSummary summary;
+
+        const std::streamoff iStart = static_cast<std::streamoff>(_stream.tellg());
+        if (iStart >= 0 && _stream.seekg(0, std::ios_base::end)) {
+            summary.uFileSize = static_cast<uint64_t>(static_cast<std::streamoff>(_stream.tellg()) - iStart);
+            _stream.seekg(iStart, std::ios_base::beg);
+        }
+        _stream.clear();
+
+        // reads go through a buffer, which tracks positions without asking the target, relative seeks skip the blob
+        TimedStreamBuffer buffer(_stream.rdbuf(), nullptr, nullptr);
+        std::istream stream(&buffer);
+
+        summary.header.Read(stream);
+        if (!stream)
+            throw SerializerException("[das2::InspectModel] Truncated header");
+
+        const uint64_t uHeaderSize = static_cast<uint64_t>(static_cast<std::streamoff>(stream.tellg()));
+        if (!summary.header.bZstdLevel) {
+            _ScanStructures(stream, summary.uFileSize, summary);
+            stream.clear();
+            summary.uUncompressedSize = static_cast<uint64_t>(static_cast<std::streamoff>(stream.tellg()));
+            summary.bStructuresScanned = true;
+        }
+        else if (_bDecompress) {
+            namespace bio = boost::iostreams;
+
+            bio::filtering_streambuf<bio::input> in;
+            in.push(bio::zstd_decompressor());
+            in.push(stream);
+
+            TimedStreamBuffer decompressedBuffer(&in, nullptr, nullptr);
+            std::istream decompressed(&decompressedBuffer);
+            _ScanStructures(decompressed, 0, summary);
+            decompressed.clear();
+            summary.uUncompressedSize = uHeaderSize + static_cast<uint64_t>(static_cast<std::streamoff>(decompressed.tellg()));
+            summary.bStructuresScanned = true;
+        }
+
+        return summary;
+    }
+}
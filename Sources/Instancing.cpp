@@ -0,0 +1,769 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: Instancing.cpp - implementation of duplicate geometry detection and instancing pass
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include <das2/Instancing.h>
+#include <das2/Transform.h>
+
+#define INSTANCING_MESH_GRAIN 16
+#define INSTANCING_MIN_FRAME_EXTENT 1e-3f   // second frame axis relative to the bounding radius, smaller means collinear
+#define INSTANCING_NONE static_cast<uint32_t>(-1)
+
+namespace das2 {
+
+    namespace {
+        // one level of detail of a mesh
+        struct _Level {
+            const Mesh* pMesh = nullptr;
+            uint32_t uVertexCount = 0;
+        };
+
+
+        struct _MeshInfo {
+            bool bEligible = false;
+            uint64_t uHash = 0;
+            std::vector<_Level> levels;
+            float arrCentroid[3] = {};
+            float fRadius = 0.f;
+            uint32_t arrFrame[2] = {};      // vertices spanning the reference frame around the centroid
+        };
+
+
+        // p' = fScale * R * p + t
+        struct _Transform {
+            float R[3][3] = { { 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, 0.f, 1.f } };
+            float t[3] = {};
+            float fScale = 1.f;
+        };
+
+
+        struct _Instance {
+            uint32_t uPrototype = INSTANCING_NONE;
+            _Transform transform;           // maps the prototype's geometry onto the replaced group
+        };
+
+
+        struct _Interval {
+            uint64_t uBegin;
+            uint64_t uEnd;
+        };
+
+
+        inline uint64_t _Mix(uint64_t _uHash, uint64_t _uValue) {
+            return (_uHash ^ _uValue) * 0x100000001b3ull;
+        }
+
+
+        uint64_t _HashBytes(uint64_t _uHash, const void* _pData, size_t _uSize) {
+            const char* pData = static_cast<const char*>(_pData);
+            size_t i = 0;
+            for (; i + sizeof(uint64_t) <= _uSize; i += sizeof(uint64_t)) {
+                uint64_t uWord;
+                std::memcpy(&uWord, pData + i, sizeof(uint64_t));
+                _uHash = _Mix(_uHash, uWord);
+            }
+            for (; i < _uSize; i++)
+                _uHash = _Mix(_uHash, static_cast<uint8_t>(pData[i]));
+            return _uHash;
+        }
+
+
+        // returns nullptr if the stream does not fit into the buffer
+        template <typename T>
+        inline const T* _GetStream(const Model& _model, uint32_t _uOffset, uint64_t _uCount) {
+            if (static_cast<uint64_t>(_uOffset) + _uCount * sizeof(T) > _model.buffer.Size())
+                return nullptr;
+            return _model.buffer.Get<T>(_uOffset);
+        }
+
+
+        // number of vertices referenced by the index stream, 0 if the mesh has no valid index stream
+        uint32_t _CountVertices(const Model& _model, const Mesh& _mesh) {
+            const uint32_t* pIndices = _GetStream<uint32_t>(_model, _mesh.uIndexBufferOffset, _mesh.uDrawCount);
+            if (!pIndices || !_mesh.uDrawCount)
+                return 0;
+
+            uint32_t uMax = 0;
+            for (uint32_t i = 0; i < _mesh.uDrawCount; i++)
+                uMax = std::max(uMax, pIndices[i]);
+            return uMax == UINT32_MAX ? 0 : uMax + 1;
+        }
+
+
+        // appends [offset, offset + size) of every vertex and index stream of _mesh, returns false if a stream cannot be measured
+        bool _AppendStreams(const Model& _model, const Mesh& _mesh, std::vector<_Interval>& _intervals) {
+            const uint32_t uVertexCount = _CountVertices(_model, _mesh);
+            if (!uVertexCount)
+                return false;
+
+            auto fnAppend = [&](uint32_t _uOffset, uint64_t _uSize) {
+                _intervals.push_back(_Interval{ _uOffset, std::min<uint64_t>(_uOffset + _uSize, _model.buffer.Size()) });
+            };
+
+            const uint64_t uVertices = uVertexCount;
+            fnAppend(_mesh.uIndexBufferOffset, static_cast<uint64_t>(_mesh.uDrawCount) * sizeof(uint32_t));
+            fnAppend(_mesh.uPositionVertexBufferOffset, uVertices * sizeof(TRS::Vector3<float>));
+            if (_mesh.uVertexNormalBufferOffset)
+                fnAppend(_mesh.uVertexNormalBufferOffset, uVertices * sizeof(TRS::Vector3<float>));
+            for (uint32_t uOffset : _mesh.arrUVBufferOffsets) {
+                if (uOffset)
+                    fnAppend(uOffset, uVertices * sizeof(TRS::Vector2<float>));
+            }
+            if (_mesh.uColorMultiplierOffset)
+                fnAppend(_mesh.uColorMultiplierOffset, uVertices * sizeof(TRS::Vector4<float>));
+            for (size_t i = 0; i < _mesh.arrSkeletalJointIndexBufferOffsets.size(); i++) {
+                if (_mesh.arrSkeletalJointIndexBufferOffsets[i])
+                    fnAppend(_mesh.arrSkeletalJointIndexBufferOffsets[i], uVertices * 4 * sizeof(uint32_t));
+                if (_mesh.arrSkeletalJointWeightBufferOffsets[i])
+                    fnAppend(_mesh.arrSkeletalJointWeightBufferOffsets[i], uVertices * 4 * sizeof(float));
+            }
+
+            for (const MorphTarget& target : _mesh.morphTargets) {
+                fnAppend(target.uIndexBufferOffset, static_cast<uint64_t>(_mesh.uDrawCount) * sizeof(uint32_t));
+                fnAppend(target.uPositionVertexBufferOffset, uVertices * sizeof(TRS::Vector3<float>));
+                if (target.uVertexNormalBufferOffset)
+                    fnAppend(target.uVertexNormalBufferOffset, uVertices * sizeof(TRS::Vector3<float>));
+                for (uint32_t uOffset : target.arrUVBufferOffsets) {
+                    if (uOffset)
+                        fnAppend(uOffset, uVertices * sizeof(TRS::Vector2<float>));
+                }
+                if (target.uColorMultiplierOffset)
+                    fnAppend(target.uColorMultiplierOffset, uVertices * sizeof(TRS::Vector4<float>));
+            }
+
+            for (const Mesh& lod : _mesh.multipleLods) {
+                if (!_AppendStreams(_model, lod, _intervals))
+                    return false;
+            }
+            return true;
+        }
+
+
+        void _MergeIntervals(std::vector<_Interval>& _intervals) {
+            std::sort(_intervals.begin(), _intervals.end(), [](const _Interval& _lhs, const _Interval& _rhs) { return _lhs.uBegin < _rhs.uBegin; });
+
+            size_t uCount = 0;
+            for (const _Interval& interval : _intervals) {
+                if (interval.uBegin >= interval.uEnd)
+                    continue;
+                if (uCount && interval.uBegin <= _intervals[uCount - 1].uEnd)
+                    _intervals[uCount - 1].uEnd = std::max(_intervals[uCount - 1].uEnd, interval.uEnd);
+                else _intervals[uCount++] = interval;
+            }
+            _intervals.resize(uCount);
+        }
+
+
+        // dropped buffer intervals in ascending order and the number of bytes dropped up to the end of each of them
+        struct _DroppedIntervals {
+            std::vector<_Interval> intervals;
+            std::vector<uint64_t> prefixSizes;
+        };
+
+
+        inline void _RemapOffset(uint32_t& _uOffset, const _DroppedIntervals& _dropped) {
+            const auto it = std::partition_point(_dropped.intervals.begin(), _dropped.intervals.end(),
+                                                 [&](const _Interval& _interval) { return _interval.uEnd <= _uOffset; });
+            if (it != _dropped.intervals.begin())
+                _uOffset -= static_cast<uint32_t>(_dropped.prefixSizes[static_cast<size_t>(it - _dropped.intervals.begin()) - 1]);
+        }
+
+
+        void _RemapMesh(Mesh& _mesh, const _DroppedIntervals& _dropped) {
+            _RemapOffset(_mesh.uIndexBufferOffset, _dropped);
+            _RemapOffset(_mesh.uPositionVertexBufferOffset, _dropped);
+            _RemapOffset(_mesh.uVertexNormalBufferOffset, _dropped);
+            for (uint32_t& uOffset : _mesh.arrUVBufferOffsets)
+                _RemapOffset(uOffset, _dropped);
+            _RemapOffset(_mesh.uColorMultiplierOffset, _dropped);
+            for (uint32_t& uOffset : _mesh.arrSkeletalJointIndexBufferOffsets)
+                _RemapOffset(uOffset, _dropped);
+            for (uint32_t& uOffset : _mesh.arrSkeletalJointWeightBufferOffsets)
+                _RemapOffset(uOffset, _dropped);
+
+            for (MorphTarget& target : _mesh.morphTargets) {
+                _RemapOffset(target.uIndexBufferOffset, _dropped);
+                _RemapOffset(target.uPositionVertexBufferOffset, _dropped);
+                _RemapOffset(target.uVertexNormalBufferOffset, _dropped);
+                for (uint32_t& uOffset : target.arrUVBufferOffsets)
+                    _RemapOffset(uOffset, _dropped);
+                _RemapOffset(target.uColorMultiplierOffset, _dropped);
+            }
+
+            for (Mesh& lod : _mesh.multipleLods)
+                _RemapMesh(lod, _dropped);
+        }
+
+
+        // hashes the rigid transformation invariant properties of a single level, returns false if the level is not instanceable
+        bool _AnalyzeLevel(const Model& _model, const Mesh& _mesh, _Level& _level, uint64_t& _uHash) {
+            for (size_t i = 0; i < _mesh.arrSkeletalJointIndexBufferOffsets.size(); i++) {
+                if (_mesh.arrSkeletalJointIndexBufferOffsets[i] || _mesh.arrSkeletalJointWeightBufferOffsets[i])
+                    return false;
+            }
+            if (!_mesh.morphTargets.empty())
+                return false;
+
+            _level.pMesh = &_mesh;
+            _level.uVertexCount = _CountVertices(_model, _mesh);
+            const uint64_t uVertices = _level.uVertexCount;
+            if (!uVertices || !_GetStream<float>(_model, _mesh.uPositionVertexBufferOffset, uVertices * 3))
+                return false;
+            if (_mesh.uVertexNormalBufferOffset && !_GetStream<float>(_model, _mesh.uVertexNormalBufferOffset, uVertices * 3))
+                return false;
+
+            _uHash = _Mix(_uHash, _mesh.uDrawCount);
+            _uHash = _Mix(_uHash, _level.uVertexCount);
+            _uHash = _Mix(_uHash, _mesh.uVertexNormalBufferOffset != 0);
+            _uHash = _HashBytes(_uHash, _model.buffer.Get<char>(_mesh.uIndexBufferOffset), static_cast<size_t>(_mesh.uDrawCount) * sizeof(uint32_t));
+
+            for (uint32_t uOffset : _mesh.arrUVBufferOffsets) {
+                _uHash = _Mix(_uHash, uOffset != 0);
+                if (!uOffset)
+                    continue;
+                if (!_GetStream<float>(_model, uOffset, uVertices * 2))
+                    return false;
+                _uHash = _HashBytes(_uHash, _model.buffer.Get<char>(uOffset), uVertices * sizeof(TRS::Vector2<float>));
+            }
+
+            _uHash = _Mix(_uHash, _mesh.uColorMultiplierOffset != 0);
+            if (_mesh.uColorMultiplierOffset) {
+                if (!_GetStream<float>(_model, _mesh.uColorMultiplierOffset, uVertices * 4))
+                    return false;
+                _uHash = _HashBytes(_uHash, _model.buffer.Get<char>(_mesh.uColorMultiplierOffset), uVertices * sizeof(TRS::Vector4<float>));
+            }
+
+            return true;
+        }
+
+
+        void _AnalyzeMesh(const Model& _model, const Mesh& _mesh, _MeshInfo& _info) {
+            uint64_t uHash = 0xcbf29ce484222325ull;
+            uHash = _Mix(uHash, _mesh.bMaterialType);
+            uHash = _Mix(uHash, _mesh.uMaterialId);
+            uHash = _Mix(uHash, _mesh.multipleLods.size());
+
+            _info.levels.resize(_mesh.multipleLods.size() + 1);
+            if (!_AnalyzeLevel(_model, _mesh, _info.levels[0], uHash))
+                return;
+            for (size_t i = 0; i < _mesh.multipleLods.size(); i++) {
+                if (!_AnalyzeLevel(_model, _mesh.multipleLods[i], _info.levels[i + 1], uHash))
+                    return;
+            }
+
+            // reference frame: the vertex farthest from the centroid and the one farthest from that axis
+            const float* pPositions = _model.buffer.Get<float>(_mesh.uPositionVertexBufferOffset);
+            const uint32_t uVertexCount = _info.levels[0].uVertexCount;
+            double arrSum[3] = {};
+            for (uint32_t i = 0; i < uVertexCount; i++) {
+                for (int j = 0; j < 3; j++)
+                    arrSum[j] += pPositions[i * 3 + j];
+            }
+            for (int j = 0; j < 3; j++)
+                _info.arrCentroid[j] = static_cast<float>(arrSum[j] / uVertexCount);
+
+            float fMaxSq = 0.f;
+            for (uint32_t i = 0; i < uVertexCount; i++) {
+                float fSq = 0.f;
+                for (int j = 0; j < 3; j++) {
+                    const float d = pPositions[i * 3 + j] - _info.arrCentroid[j];
+                    fSq += d * d;
+                }
+                if (fSq > fMaxSq) {
+                    fMaxSq = fSq;
+                    _info.arrFrame[0] = i;
+                }
+            }
+            _info.fRadius = std::sqrt(fMaxSq);
+            if (!(_info.fRadius > 0.f) || !std::isfinite(_info.fRadius))
+                return;
+
+            float e[3];
+            for (int j = 0; j < 3; j++)
+                e[j] = (pPositions[_info.arrFrame[0] * 3 + j] - _info.arrCentroid[j]) / _info.fRadius;
+
+            float fMaxCrossSq = 0.f;
+            for (uint32_t i = 0; i < uVertexCount; i++) {
+                const float dx = pPositions[i * 3] - _info.arrCentroid[0];
+                const float dy = pPositions[i * 3 + 1] - _info.arrCentroid[1];
+                const float dz = pPositions[i * 3 + 2] - _info.arrCentroid[2];
+                const float cx = e[1] * dz - e[2] * dy, cy = e[2] * dx - e[0] * dz, cz = e[0] * dy - e[1] * dx;
+                const float fSq = cx * cx + cy * cy + cz * cz;
+                if (fSq > fMaxCrossSq) {
+                    fMaxCrossSq = fSq;
+                    _info.arrFrame[1] = i;
+                }
+            }
+
+            // collinear geometry leaves the rotation around its axis undetermined
+            if (std::sqrt(fMaxCrossSq) < INSTANCING_MIN_FRAME_EXTENT * _info.fRadius)
+                return;
+
+            _info.uHash = uHash;
+            _info.bEligible = true;
+        }
+
+
+        // orthonormal frame with columns e1, e2 and e3, returns false if the frame vertices are degenerate
+        bool _BuildFrame(const float* _pPositions, const float* _pCentroid, const uint32_t* _pFrame, float _fRadius, float _frame[3][3]) {
+            float a[3], b[3];
+            for (int j = 0; j < 3; j++) {
+                a[j] = _pPositions[_pFrame[0] * 3 + j] - _pCentroid[j];
+                b[j] = _pPositions[_pFrame[1] * 3 + j] - _pCentroid[j];
+            }
+
+            const float fLength = std::sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+            if (!(fLength > 0.f))
+                return false;
+            for (int j = 0; j < 3; j++)
+                a[j] /= fLength;
+
+            const float fDot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+            for (int j = 0; j < 3; j++)
+                b[j] -= fDot * a[j];
+            const float fPerpendicular = std::sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2]);
+            if (fPerpendicular < INSTANCING_MIN_FRAME_EXTENT * _fRadius)
+                return false;
+            for (int j = 0; j < 3; j++)
+                b[j] /= fPerpendicular;
+
+            const float c[3] = { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+            for (int j = 0; j < 3; j++) {
+                _frame[j][0] = a[j];
+                _frame[j][1] = b[j];
+                _frame[j][2] = c[j];
+            }
+            return true;
+        }
+
+
+        // transform mapping the first mesh of _from onto the first mesh of _to, vertices correspond by their index
+        bool _EstimateTransform(const Model& _model, const _MeshInfo& _from, const _MeshInfo& _to, const InstancingSettings& _settings,
+                                _Transform& _transform) {
+            if (!_settings.bUniformScale && std::fabs(_to.fRadius - _from.fRadius) > _settings.fPositionError * _from.fRadius)
+                return false;
+
+            const float* pFrom = _model.buffer.Get<float>(_from.levels[0].pMesh->uPositionVertexBufferOffset);
+            const float* pTo = _model.buffer.Get<float>(_to.levels[0].pMesh->uPositionVertexBufferOffset);
+
+            float from[3][3], to[3][3];
+            if (!_BuildFrame(pFrom, _from.arrCentroid, _from.arrFrame, _from.fRadius, from) ||
+                !_BuildFrame(pTo, _to.arrCentroid, _from.arrFrame, _to.fRadius, to))
+                return false;
+
+            // the frame vertex of _from is its farthest vertex, thus its distance is the radius
+            float fDistanceSq = 0.f;
+            for (int j = 0; j < 3; j++) {
+                const float d = pTo[_from.arrFrame[0] * 3 + j] - _to.arrCentroid[j];
+                fDistanceSq += d * d;
+            }
+            _transform.fScale = std::sqrt(fDistanceSq) / _from.fRadius;
+            if (!_settings.bUniformScale) {
+                if (std::fabs(_transform.fScale - 1.f) > _settings.fPositionError)
+                    return false;
+                _transform.fScale = 1.f;
+            }
+
+            // R = to * from^T
+            for (int i = 0; i < 3; i++) {
+                for (int j = 0; j < 3; j++)
+                    _transform.R[i][j] = to[i][0] * from[j][0] + to[i][1] * from[j][1] + to[i][2] * from[j][2];
+            }
+
+            for (int i = 0; i < 3; i++) {
+                const float fRotated = _transform.R[i][0] * _from.arrCentroid[0] + _transform.R[i][1] * _from.arrCentroid[1] +
+                                       _transform.R[i][2] * _from.arrCentroid[2];
+                _transform.t[i] = _to.arrCentroid[i] - _transform.fScale * fRotated;
+            }
+            return true;
+        }
+
+
+        bool _VerifyLevel(const Model& _model, const _Level& _from, const _Level& _to, const _Transform& _transform, float _fPositionError,
+                          float _fNormalError) {
+            const Mesh& from = *_from.pMesh;
+            const Mesh& to = *_to.pMesh;
+            const uint64_t uVertices = _from.uVertexCount;
+            if (from.uDrawCount != to.uDrawCount || _from.uVertexCount != _to.uVertexCount ||
+                (from.uVertexNormalBufferOffset != 0) != (to.uVertexNormalBufferOffset != 0) ||
+                (from.uColorMultiplierOffset != 0) != (to.uColorMultiplierOffset != 0))
+                return false;
+
+            // attributes, which do not change under rigid transformations, have to match exactly
+            if (std::memcmp(_model.buffer.Get<char>(from.uIndexBufferOffset), _model.buffer.Get<char>(to.uIndexBufferOffset),
+                            static_cast<size_t>(from.uDrawCount) * sizeof(uint32_t)))
+                return false;
+            for (size_t i = 0; i < from.arrUVBufferOffsets.size(); i++) {
+                if ((from.arrUVBufferOffsets[i] != 0) != (to.arrUVBufferOffsets[i] != 0))
+                    return false;
+                if (from.arrUVBufferOffsets[i] && std::memcmp(_model.buffer.Get<char>(from.arrUVBufferOffsets[i]),
+                                                              _model.buffer.Get<char>(to.arrUVBufferOffsets[i]), uVertices * sizeof(TRS::Vector2<float>)))
+                    return false;
+            }
+            if (from.uColorMultiplierOffset && std::memcmp(_model.buffer.Get<char>(from.uColorMultiplierOffset),
+                                                           _model.buffer.Get<char>(to.uColorMultiplierOffset), uVertices * sizeof(TRS::Vector4<float>)))
+                return false;
+
+            const float* R = &_transform.R[0][0];
+            const float fErrorSq = _fPositionError * _fPositionError;
+            const float* pFrom = _model.buffer.Get<float>(from.uPositionVertexBufferOffset);
+            const float* pTo = _model.buffer.Get<float>(to.uPositionVertexBufferOffset);
+            for (uint64_t i = 0; i < uVertices; i++) {
+                const float* p = pFrom + i * 3;
+                const float* q = pTo + i * 3;
+                float fSq = 0.f;
+                for (int j = 0; j < 3; j++) {
+                    const float d = _transform.fScale * (R[j * 3] * p[0] + R[j * 3 + 1] * p[1] + R[j * 3 + 2] * p[2]) + _transform.t[j] - q[j];
+                    fSq += d * d;
+                }
+                if (!(fSq <= fErrorSq))
+                    return false;
+            }
+
+            if (!from.uVertexNormalBufferOffset)
+                return true;
+
+            const float fNormalErrorSq = _fNormalError * _fNormalError;
+            pFrom = _model.buffer.Get<float>(from.uVertexNormalBufferOffset);
+            pTo = _model.buffer.Get<float>(to.uVertexNormalBufferOffset);
+            for (uint64_t i = 0; i < uVertices; i++) {
+                const float* n = pFrom + i * 3;
+                const float* m = pTo + i * 3;
+                float fSq = 0.f;
+                for (int j = 0; j < 3; j++) {
+                    const float d = R[j * 3] * n[0] + R[j * 3 + 1] * n[1] + R[j * 3 + 2] * n[2] - m[j];
+                    fSq += d * d;
+                }
+                if (!(fSq <= fNormalErrorSq))
+                    return false;
+            }
+
+            return true;
+        }
+
+
+        bool _VerifyMesh(const Model& _model, const _MeshInfo& _from, const _MeshInfo& _to, const _Transform& _transform,
+                         const InstancingSettings& _settings) {
+            if (_from.levels.size() != _to.levels.size() || _from.levels[0].pMesh->bMaterialType != _to.levels[0].pMesh->bMaterialType ||
+                _from.levels[0].pMesh->uMaterialId != _to.levels[0].pMesh->uMaterialId)
+                return false;
+
+            const float fPositionError = _settings.fPositionError * _from.fRadius * _transform.fScale;
+            for (size_t i = 0; i < _from.levels.size(); i++) {
+                if (!_VerifyLevel(_model, _from.levels[i], _to.levels[i], _transform, fPositionError, _settings.fNormalError))
+                    return false;
+            }
+            return true;
+        }
+
+
+        TRS::Quaternion _ToQuaternion(const float _R[3][3]) {
+            TRS::Quaternion q;
+            const float fTrace = _R[0][0] + _R[1][1] + _R[2][2];
+            if (fTrace > 0.f) {
+                const float s = std::sqrt(fTrace + 1.f) * 2.f;
+                q.w = 0.25f * s;
+                q.x = (_R[2][1] - _R[1][2]) / s;
+                q.y = (_R[0][2] - _R[2][0]) / s;
+                q.z = (_R[1][0] - _R[0][1]) / s;
+            }
+            else if (_R[0][0] > _R[1][1] && _R[0][0] > _R[2][2]) {
+                const float s = std::sqrt(1.f + _R[0][0] - _R[1][1] - _R[2][2]) * 2.f;
+                q.w = (_R[2][1] - _R[1][2]) / s;
+                q.x = 0.25f * s;
+                q.y = (_R[0][1] + _R[1][0]) / s;
+                q.z = (_R[0][2] + _R[2][0]) / s;
+            }
+            else if (_R[1][1] > _R[2][2]) {
+                const float s = std::sqrt(1.f + _R[1][1] - _R[0][0] - _R[2][2]) * 2.f;
+                q.w = (_R[0][2] - _R[2][0]) / s;
+                q.x = (_R[0][1] + _R[1][0]) / s;
+                q.y = 0.25f * s;
+                q.z = (_R[1][2] + _R[2][1]) / s;
+            }
+            else {
+                const float s = std::sqrt(1.f + _R[2][2] - _R[0][0] - _R[1][1]) * 2.f;
+                q.w = (_R[1][0] - _R[0][1]) / s;
+                q.x = (_R[0][2] + _R[2][0]) / s;
+                q.y = (_R[1][2] + _R[2][1]) / s;
+                q.z = 0.25f * s;
+            }
+
+            const float fLength = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+            q.x /= fLength;
+            q.y /= fLength;
+            q.z /= fLength;
+            q.w /= fLength;
+            return q;
+        }
+
+
+        // _node's local transform becomes T * R * S * _transform
+        void _FoldTransform(Node& _node, const _Transform& _transform) {
+            const Matrix3x4 rotation = ComposeTransform(_node.qRotation, TRS::Vector3<float>(0.f, 0.f, 0.f), 1.f);
+            float arrTranslation[3];
+            for (int i = 0; i < 3; i++) {
+                arrTranslation[i] = rotation.m[i][0] * _transform.t[0] + rotation.m[i][1] * _transform.t[1] + rotation.m[i][2] * _transform.t[2];
+            }
+            _node.vTranslation = TRS::Vector3<float>(_node.vTranslation.first + _node.fScale * arrTranslation[0],
+                                                     _node.vTranslation.second + _node.fScale * arrTranslation[1],
+                                                     _node.vTranslation.third + _node.fScale * arrTranslation[2]);
+
+            const TRS::Quaternion a = _node.qRotation;
+            const TRS::Quaternion b = _ToQuaternion(_transform.R);
+            _node.qRotation.w = a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z;
+            _node.qRotation.x = a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y;
+            _node.qRotation.y = a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x;
+            _node.qRotation.z = a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w;
+            _node.fScale *= _transform.fScale;
+        }
+
+
+        void _CompactBuffer(Model& _model, const std::vector<uint8_t>& _removedMeshes, InstancingResult& _result) {
+            std::vector<_Interval> removed, kept;
+            for (size_t i = 0; i < _model.meshes.size(); i++) {
+                if (!_AppendStreams(_model, _model.meshes[i], _removedMeshes[i] ? removed : kept) && !_removedMeshes[i])
+                    return;     // streams of a remaining mesh cannot be measured, thus nothing can be dropped safely
+            }
+            _MergeIntervals(removed);
+            _MergeIntervals(kept);
+
+            // vertex data is only dropped if no remaining mesh uses any of it
+            _DroppedIntervals dropped;
+            size_t k = 0;
+            for (_Interval interval : removed) {
+                while (k < kept.size() && kept[k].uEnd <= interval.uBegin)
+                    k++;
+                for (size_t j = k; j < kept.size() && kept[j].uBegin < interval.uEnd; j++) {
+                    if (kept[j].uBegin > interval.uBegin)
+                        dropped.intervals.push_back(_Interval{ interval.uBegin, kept[j].uBegin });
+                    interval.uBegin = std::max(interval.uBegin, kept[j].uEnd);
+                }
+                if (interval.uBegin < interval.uEnd)
+                    dropped.intervals.push_back(interval);
+            }
+            if (dropped.intervals.empty())
+                return;
+
+            uint64_t uDroppedSize = 0;
+            dropped.prefixSizes.reserve(dropped.intervals.size());
+            for (const _Interval& interval : dropped.intervals) {
+                uDroppedSize += interval.uEnd - interval.uBegin;
+                dropped.prefixSizes.push_back(uDroppedSize);
+            }
+
+            Buffer buffer(_model.buffer.get_allocator());
+            buffer.Initialize();
+            char* pData = buffer.Get(buffer.Extend(static_cast<uint32_t>(_model.buffer.Size() - uDroppedSize)));
+            uint64_t uBegin = 0;
+            for (size_t i = 0; i <= dropped.intervals.size(); i++) {
+                const uint64_t uEnd = i < dropped.intervals.size() ? dropped.intervals[i].uBegin : _model.buffer.Size();
+                if (uEnd > uBegin) {
+                    std::memcpy(pData, _model.buffer.Get(static_cast<uint32_t>(uBegin)), static_cast<size_t>(uEnd - uBegin));
+                    pData += uEnd - uBegin;
+                }
+                if (i < dropped.intervals.size())
+                    uBegin = dropped.intervals[i].uEnd;
+            }
+            _model.buffer = std::move(buffer);
+
+            for (size_t i = 0; i < _model.meshes.size(); i++) {
+                if (!_removedMeshes[i])
+                    _RemapMesh(_model.meshes[i], dropped);
+            }
+            _result.uRemovedBytes = uDroppedSize;
+        }
+    }
+
+
+    InstancingResult InstanceDuplicateGeometry(Model& _model, const InstancingSettings& _settings, ThreadPool* _pThreadPool) {
+        InstancingResult result;
+
+        std::vector<_MeshInfo> meshInfos(_model.meshes.size());
+        auto fnAnalyze = [&](size_t _uBegin, size_t _uEnd) {
+            for (size_t i = _uBegin; i < _uEnd; i++)
+                _AnalyzeMesh(_model, _model.meshes[i], meshInfos[i]);
+        };
+        if (_pThreadPool && meshInfos.size() > INSTANCING_MESH_GRAIN)
+            _pThreadPool->ParallelFor(0, meshInfos.size(), INSTANCING_MESH_GRAIN, fnAnalyze);
+        else fnAnalyze(0, meshInfos.size());
+
+        // mesh groups are candidates if they are used, not skinned and all of their meshes are instanceable
+        std::vector<uint8_t> eligibleGroups(_model.meshGroups.size(), 0);
+        for (const Node& node : _model.nodes) {
+            if (node.uMeshGroupId < eligibleGroups.size())
+                eligibleGroups[node.uMeshGroupId] |= node.uSkeletonId == INSTANCING_NONE ? 1 : 2;
+        }
+
+        std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(_model.meshGroups.size()); i++) {
+            const MeshGroup& group = _model.meshGroups[i];
+            if (eligibleGroups[i] != 1 || group.meshes.empty())
+                continue;
+
+            uint64_t uHash = 0xcbf29ce484222325ull;
+            bool bEligible = true;
+            for (uint32_t uMesh : group.meshes) {
+                if (uMesh >= meshInfos.size() || !meshInfos[uMesh].bEligible) {
+                    bEligible = false;
+                    break;
+                }
+                uHash = _Mix(uHash, meshInfos[uMesh].uHash);
+            }
+            if (bEligible)
+                buckets[uHash].push_back(i);
+        }
+
+        std::vector<const std::vector<uint32_t>*> candidates;
+        for (const auto& bucket : buckets) {
+            if (bucket.second.size() > 1)
+                candidates.push_back(&bucket.second);
+        }
+
+        // every group of a bucket is matched against the prototypes found before it, buckets are independent
+        std::vector<_Instance> instances(_model.meshGroups.size());
+        auto fnMatch = [&](size_t _uBegin, size_t _uEnd) {
+            std::vector<uint32_t> prototypes;
+            for (size_t b = _uBegin; b < _uEnd; b++) {
+                prototypes.clear();
+                for (uint32_t uGroup : *candidates[b]) {
+                    const MeshGroup& group = _model.meshGroups[uGroup];
+                    for (uint32_t uPrototype : prototypes) {
+                        const MeshGroup& prototype = _model.meshGroups[uPrototype];
+                        if (prototype.meshes.size() != group.meshes.size())
+                            continue;
+
+                        _Transform transform;
+                        if (!_EstimateTransform(_model, meshInfos[prototype.meshes[0]], meshInfos[group.meshes[0]], _settings, transform))
+                            continue;
+
+                        bool bMatch = true;
+                        for (size_t i = 0; i < group.meshes.size() && bMatch; i++)
+                            bMatch = _VerifyMesh(_model, meshInfos[prototype.meshes[i]], meshInfos[group.meshes[i]], transform, _settings);
+
+                        if (bMatch) {
+                            instances[uGroup].uPrototype = uPrototype;
+                            instances[uGroup].transform = transform;
+                            break;
+                        }
+                    }
+
+                    if (instances[uGroup].uPrototype == INSTANCING_NONE)
+                        prototypes.push_back(uGroup);
+                }
+            }
+        };
+        if (_pThreadPool && candidates.size() > 1)
+            _pThreadPool->ParallelFor(0, candidates.size(), 1, fnMatch);
+        else fnMatch(0, candidates.size());
+
+        // animated transform properties are overwritten on playback, thus instance transforms of such nodes need own nodes
+        std::vector<uint8_t> animatedNodes(_model.nodes.size(), 0);
+        for (const AnimationChannel& channel : _model.animationChannels) {
+            if (channel.uNodePropertyId < animatedNodes.size() && channel.bAnimationTarget != AnimationTarget_Weights)
+                animatedNodes[channel.uNodePropertyId] = 1;
+        }
+
+        const size_t uNodeCount = _model.nodes.size();
+        for (size_t i = 0; i < uNodeCount; i++) {
+            if (_model.nodes[i].uMeshGroupId >= instances.size())
+                continue;
+
+            const _Instance& instance = instances[_model.nodes[i].uMeshGroupId];
+            if (instance.uPrototype == INSTANCING_NONE)
+                continue;
+
+            result.uInstancedNodes++;
+            if (_model.nodes[i].children.empty() && !animatedNodes[i]) {
+                _model.nodes[i].uMeshGroupId = instance.uPrototype;
+                _FoldTransform(_model.nodes[i], instance.transform);
+                continue;
+            }
+
+            _model.nodes.emplace_back();
+            Node& child = _model.nodes.back();
+            Node& node = _model.nodes[i];
+            child.Initialize();
+            child.szName = node.szName;
+            child.uMeshGroupId = instance.uPrototype;
+            child.mCustomTransform = ToMatrix4(Matrix3x4());
+            child.qRotation = _ToQuaternion(instance.transform.R);
+            child.vTranslation = TRS::Vector3<float>(instance.transform.t[0], instance.transform.t[1], instance.transform.t[2]);
+            child.fScale = instance.transform.fScale;
+
+            node.uMeshGroupId = INSTANCING_NONE;
+            node.children.push_back(static_cast<uint32_t>(_model.nodes.size() - 1));
+            result.uAddedNodes++;
+        }
+
+        // replaced mesh groups are no longer referenced, meshes are removed once no remaining group uses them
+        std::vector<uint32_t> groupIds(_model.meshGroups.size(), INSTANCING_NONE);
+        std::vector<uint8_t> usedMeshes(_model.meshes.size(), 0);
+        std::vector<uint8_t> replacedMeshes(_model.meshes.size(), 0);
+        uint32_t uGroupCount = 0;
+        for (size_t i = 0; i < _model.meshGroups.size(); i++) {
+            const bool bReplaced = instances[i].uPrototype != INSTANCING_NONE;
+            for (uint32_t uMesh : _model.meshGroups[i].meshes) {
+                if (uMesh < _model.meshes.size())
+                    (bReplaced ? replacedMeshes : usedMeshes)[uMesh] = 1;
+            }
+
+            if (!bReplaced) {
+                if (uGroupCount != i)
+                    _model.meshGroups[uGroupCount] = std::move(_model.meshGroups[i]);
+                groupIds[i] = uGroupCount++;
+            }
+        }
+        result.uRemovedMeshGroups = static_cast<uint32_t>(_model.meshGroups.size() - uGroupCount);
+        if (!result.uRemovedMeshGroups)
+            return result;
+        _model.meshGroups.erase(_model.meshGroups.begin() + uGroupCount, _model.meshGroups.end());
+
+        for (Node& node : _model.nodes) {
+            if (node.uMeshGroupId < groupIds.size())
+                node.uMeshGroupId = groupIds[node.uMeshGroupId];
+        }
+
+        std::vector<uint8_t> removedMeshes(_model.meshes.size(), 0);
+        uint64_t uRemovedVertices = 0;
+        for (size_t i = 0; i < _model.meshes.size(); i++) {
+            removedMeshes[i] = replacedMeshes[i] && !usedMeshes[i];
+            if (removedMeshes[i]) {
+                uRemovedVertices += meshInfos[i].levels[0].uVertexCount;
+                result.uRemovedMeshes++;
+            }
+        }
+
+        if (_settings.bCompactBuffer)
+            _CompactBuffer(_model, removedMeshes, result);
+
+        std::vector<uint32_t> meshIds(_model.meshes.size(), INSTANCING_NONE);
+        uint32_t uMeshCount = 0;
+        for (size_t i = 0; i < _model.meshes.size(); i++) {
+            if (removedMeshes[i])
+                continue;
+            if (uMeshCount != i)
+                _model.meshes[uMeshCount] = std::move(_model.meshes[i]);
+            meshIds[i] = uMeshCount++;
+        }
+        _model.meshes.erase(_model.meshes.begin() + uMeshCount, _model.meshes.end());
+
+        for (MeshGroup& group : _model.meshGroups) {
+            for (uint32_t& uMesh : group.meshes) {
+                if (uMesh < meshIds.size())
+                    uMesh = meshIds[uMesh];
+            }
+        }
+
+        _model.header.uMeshCount = static_cast<uint32_t>(_model.meshes.size());
+        _model.header.uVerticesCount -= static_cast<uint32_t>(std::min<uint64_t>(uRemovedVertices, _model.header.uVerticesCount));
+        return result;
+    }
+}
@@ -0,0 +1,335 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: MemoryReport.cpp - implementation of in-memory footprint accounting for das2::Model
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <cstdio>
+#include <string_view>
+#include <unordered_map>
+
+#include <das2/MemoryReport.h>
+
+namespace das2 {
+
+    namespace {
+        const char* g_arrRowNames[DAS2_MEMORY_REPORT_ROW_COUNT] = {
+            "Model", "Buffer", "Mesh", "MorphTarget", "MeshGroup", "Node", "Scene",
+            "SkeletonJoint", "Skeleton", "Animation", "AnimationChannel", "MaterialPhong", "MaterialPbr"
+        };
+
+        const char* g_arrCategoryNames[MemoryCategory_Count] = {
+            "geometry", "animation", "strings", "structures", "overhead"
+        };
+
+
+        inline uint64_t _StringBytes(const BinString& _str) {
+            return _str.CString() ? static_cast<uint64_t>(_str.Length()) + 1 : 0;
+        }
+
+
+        // used elements are accounted to _eCategory and unused capacity to overhead
+        template <typename T>
+        inline void _AccountVector(MemoryUsage& _usage, const std::pmr::vector<T>& _vec, MemoryCategory _eCategory) {
+            _usage.arrBytes[_eCategory] += _vec.size() * sizeof(T);
+            _usage.arrBytes[MemoryCategory_Overhead] += (_vec.capacity() - _vec.size()) * sizeof(T);
+        }
+
+
+        // calls _fn for every string of the model
+        template <typename Fn>
+        void _ForEachString(const Model& _model, Fn _fn) {
+            _fn(_model.header.szAuthorName);
+            _fn(_model.header.szComment);
+            for (const MeshGroup& group : _model.meshGroups)
+                _fn(group.szName);
+            for (const Node& node : _model.nodes)
+                _fn(node.szName);
+            for (const Scene& scene : _model.scenes)
+                _fn(scene.szName);
+            for (const SkeletonJoint& joint : _model.skeletonJoints)
+                _fn(joint.szName);
+            for (const Skeleton& skeleton : _model.skeletons)
+                _fn(skeleton.szName);
+            for (const Animation& animation : _model.animations)
+                _fn(animation.szName);
+            for (const MaterialPhong& material : _model.phongMaterials) {
+                _fn(material.szName);
+                _fn(material.szDiffuseMapUri);
+                _fn(material.szSpecularMapUri);
+                _fn(material.szEmissionMapUri);
+            }
+            for (const MaterialPbr& material : _model.pbrMaterials) {
+                _fn(material.szName);
+                _fn(material.szAlbedoMapUri);
+                _fn(material.szEmissionMapUri);
+                _fn(material.szRoughnessMapUri);
+                _fn(material.szMetallicMapUri);
+                _fn(material.szAmbientOcclusionMapUri);
+            }
+        }
+    }
+
+
+    std::string FormatBytes(uint64_t _uBytes) {
+        const char* arrUnits[] = { "B", "KiB", "MiB", "GiB", "TiB" };
+        double fValue = static_cast<double>(_uBytes);
+        size_t uUnit = 0;
+        while (fValue >= 1024.0 && uUnit + 1 < sizeof(arrUnits) / sizeof(arrUnits[0])) {
+            fValue /= 1024.0;
+            uUnit++;
+        }
+
+        char szBuffer[32] = {};
+        if (uUnit)
+            std::snprintf(szBuffer, sizeof(szBuffer), "%.2f %s", fValue, arrUnits[uUnit]);
+        else std::snprintf(szBuffer, sizeof(szBuffer), "%llu B", static_cast<unsigned long long>(_uBytes));
+        return szBuffer;
+    }
+
+
+    MemoryReport::MemoryReport(const Model& _model) {
+        _AccountModel(_model);
+
+        for (const MemoryUsage& row : m_arrRows) {
+            for (size_t i = 0; i < MemoryCategory_Count; i++)
+                m_total.arrBytes[i] += row.arrBytes[i];
+            m_total.uCount += row.uCount;
+        }
+
+        _SuggestUnusedCapacity(_model);
+        _SuggestDuplicateStrings(_model);
+        _SuggestConstantChannels(_model);
+
+        std::stable_sort(m_suggestions.begin(), m_suggestions.end(), [](const MemorySuggestion& _a, const MemorySuggestion& _b) {
+            return _a.uSavings > _b.uSavings;
+        });
+    }
+
+
+    void MemoryReport::_AccountMesh(const Mesh& _mesh) {
+        MemoryUsage& meshRow = m_arrRows[StructureIdentifier_Mesh];
+        meshRow.uCount++;
+
+        MemoryUsage& morphRow = m_arrRows[StructureIdentifier_MorphTarget];
+        morphRow.uCount += _mesh.morphTargets.size();
+        _AccountVector(morphRow, _mesh.morphTargets, MemoryCategory_Structures);
+
+        // levels of detail are meshes as well and are allocated by their parent
+        _AccountVector(meshRow, _mesh.multipleLods, MemoryCategory_Structures);
+        for (const Mesh& lod : _mesh.multipleLods)
+            _AccountMesh(lod);
+    }
+
+
+    void MemoryReport::_AccountModel(const Model& _model) {
+        MemoryUsage& modelRow = m_arrRows[StructureIdentifier_Unknown];
+        modelRow.uCount = 1;
+        modelRow.arrBytes[MemoryCategory_Structures] += sizeof(Model);
+        modelRow.arrBytes[MemoryCategory_Strings] += _StringBytes(_model.header.szAuthorName) + _StringBytes(_model.header.szComment);
+
+        MemoryUsage& bufferRow = m_arrRows[StructureIdentifier_Buffer];
+        bufferRow.uCount = 1;
+        bufferRow.arrBytes[MemoryCategory_Geometry] += _model.buffer.Size();
+        bufferRow.arrBytes[MemoryCategory_Overhead] += _model.buffer.Capacity() - _model.buffer.Size();
+
+        _AccountVector(m_arrRows[StructureIdentifier_Mesh], _model.meshes, MemoryCategory_Structures);
+        for (const Mesh& mesh : _model.meshes)
+            _AccountMesh(mesh);
+
+        MemoryUsage& groupRow = m_arrRows[StructureIdentifier_MeshGroup];
+        groupRow.uCount += _model.meshGroups.size();
+        _AccountVector(groupRow, _model.meshGroups, MemoryCategory_Structures);
+        for (const MeshGroup& group : _model.meshGroups) {
+            groupRow.arrBytes[MemoryCategory_Strings] += _StringBytes(group.szName);
+            _AccountVector(groupRow, group.meshes, MemoryCategory_Structures);
+        }
+
+        MemoryUsage& nodeRow = m_arrRows[StructureIdentifier_Node];
+        nodeRow.uCount += _model.nodes.size();
+        _AccountVector(nodeRow, _model.nodes, MemoryCategory_Structures);
+        for (const Node& node : _model.nodes) {
+            nodeRow.arrBytes[MemoryCategory_Strings] += _StringBytes(node.szName);
+            _AccountVector(nodeRow, node.children, MemoryCategory_Structures);
+        }
+
+        MemoryUsage& sceneRow = m_arrRows[StructureIdentifier_Scene];
+        sceneRow.uCount += _model.scenes.size();
+        _AccountVector(sceneRow, _model.scenes, MemoryCategory_Structures);
+        for (const Scene& scene : _model.scenes) {
+            sceneRow.arrBytes[MemoryCategory_Strings] += _StringBytes(scene.szName);
+            _AccountVector(sceneRow, scene.rootNodes, MemoryCategory_Structures);
+        }
+
+        MemoryUsage& jointRow = m_arrRows[StructureIdentifier_SkeletonJoint];
+        jointRow.uCount += _model.skeletonJoints.size();
+        _AccountVector(jointRow, _model.skeletonJoints, MemoryCategory_Structures);
+        for (const SkeletonJoint& joint : _model.skeletonJoints) {
+            jointRow.arrBytes[MemoryCategory_Strings] += _StringBytes(joint.szName);
+            _AccountVector(jointRow, joint.children, MemoryCategory_Structures);
+        }
+
+        MemoryUsage& skeletonRow = m_arrRows[StructureIdentifier_Skeleton];
+        skeletonRow.uCount += _model.skeletons.size();
+        _AccountVector(skeletonRow, _model.skeletons, MemoryCategory_Structures);
+        for (const Skeleton& skeleton : _model.skeletons) {
+            skeletonRow.arrBytes[MemoryCategory_Strings] += _StringBytes(skeleton.szName);
+            _AccountVector(skeletonRow, skeleton.joints, MemoryCategory_Structures);
+        }
+
+        MemoryUsage& animationRow = m_arrRows[StructureIdentifier_Animation];
+        animationRow.uCount += _model.animations.size();
+        _AccountVector(animationRow, _model.animations, MemoryCategory_Structures);
+        for (const Animation& animation : _model.animations) {
+            animationRow.arrBytes[MemoryCategory_Strings] += _StringBytes(animation.szName);
+            _AccountVector(animationRow, animation.animationChannels, MemoryCategory_Structures);
+        }
+
+        MemoryUsage& channelRow = m_arrRows[StructureIdentifier_AnimationChannel];
+        channelRow.uCount += _model.animationChannels.size();
+        _AccountVector(channelRow, _model.animationChannels, MemoryCategory_Structures);
+        for (const AnimationChannel& channel : _model.animationChannels) {
+            _AccountVector(channelRow, channel.keyframes, MemoryCategory_Animation);
+            _AccountVector(channelRow, channel.tangents, MemoryCategory_Animation);
+            _AccountVector(channelRow, channel.targetValues, MemoryCategory_Animation);
+        }
+
+        MemoryUsage& phongRow = m_arrRows[StructureIdentifier_MaterialPhong];
+        phongRow.uCount += _model.phongMaterials.size();
+        _AccountVector(phongRow, _model.phongMaterials, MemoryCategory_Structures);
+        for (const MaterialPhong& material : _model.phongMaterials) {
+            phongRow.arrBytes[MemoryCategory_Strings] += _StringBytes(material.szName) + _StringBytes(material.szDiffuseMapUri) +
+                                                        _StringBytes(material.szSpecularMapUri) + _StringBytes(material.szEmissionMapUri);
+        }
+
+        MemoryUsage& pbrRow = m_arrRows[StructureIdentifier_MaterialPbr];
+        pbrRow.uCount += _model.pbrMaterials.size();
+        _AccountVector(pbrRow, _model.pbrMaterials, MemoryCategory_Structures);
+        for (const MaterialPbr& material : _model.pbrMaterials) {
+            pbrRow.arrBytes[MemoryCategory_Strings] += _StringBytes(material.szName) + _StringBytes(material.szAlbedoMapUri) +
+                                                      _StringBytes(material.szEmissionMapUri) + _StringBytes(material.szRoughnessMapUri) +
+                                                      _StringBytes(material.szMetallicMapUri) + _StringBytes(material.szAmbientOcclusionMapUri);
+        }
+    }
+
+
+    void MemoryReport::_SuggestUnusedCapacity(const Model& _model) {
+        const uint64_t uBufferSlack = _model.buffer.Capacity() - _model.buffer.Size();
+        if (uBufferSlack) {
+            m_suggestions.push_back({
+                "Buffer has " + FormatBytes(uBufferSlack) + " of unused capacity, copy it into an exactly sized buffer",
+                uBufferSlack
+            });
+        }
+
+        for (size_t i = 0; i < DAS2_MEMORY_REPORT_ROW_COUNT; i++) {
+            if (i == StructureIdentifier_Buffer || !m_arrRows[i].arrBytes[MemoryCategory_Overhead])
+                continue;
+
+            const uint64_t uSlack = m_arrRows[i].arrBytes[MemoryCategory_Overhead];
+            m_suggestions.push_back({
+                std::string(g_arrRowNames[i]) + " vectors have " + FormatBytes(uSlack) + " of unused capacity, call shrink_to_fit() after loading",
+                uSlack
+            });
+        }
+    }
+
+
+    void MemoryReport::_SuggestDuplicateStrings(const Model& _model) {
+        std::unordered_map<std::string_view, uint32_t> occurrences;
+        _ForEachString(_model, [&](const BinString& _str) {
+            if (_str.CString())
+                occurrences[std::string_view(_str.CString(), _str.Length())]++;
+        });
+
+        uint64_t uSavings = 0;
+        uint64_t uDuplicated = 0;
+        std::string_view mostRepeated;
+        uint32_t uMostRepeatedCount = 0;
+        for (const auto& [sView, uCount] : occurrences) {
+            if (uCount < 2)
+                continue;
+
+            uSavings += static_cast<uint64_t>(uCount - 1) * (sView.size() + 1);
+            uDuplicated++;
+            if (uCount > uMostRepeatedCount || (uCount == uMostRepeatedCount && sView < mostRepeated)) {
+                mostRepeated = sView;
+                uMostRepeatedCount = uCount;
+            }
+        }
+
+        if (!uSavings)
+            return;
+
+        m_suggestions.push_back({
+            "Strings stored more than once: " + std::to_string(uDuplicated) + " (most repeated: \"" + std::string(mostRepeated) + "\" x" +
+                std::to_string(uMostRepeatedCount) + "), sharing them would save " + FormatBytes(uSavings),
+            uSavings
+        });
+    }
+
+
+    void MemoryReport::_SuggestConstantChannels(const Model& _model) {
+        // channels, which hold the same value at every keyframe, can be reduced to a single keyframe
+        uint64_t uSavings = 0;
+        uint64_t uConstantCount = 0;
+        for (const AnimationChannel& channel : _model.animationChannels) {
+            const size_t uComponents = channel.GetComponentCount();
+            const size_t uKeyframes = channel.keyframes.size();
+            if (uKeyframes < 2 || !uComponents || channel.targetValues.size() != uKeyframes * uComponents)
+                continue;
+
+            bool bConstant = true;
+            for (size_t i = uComponents; i < channel.targetValues.size() && bConstant; i++)
+                bConstant = channel.targetValues[i] == channel.targetValues[i % uComponents];
+            if (!bConstant)
+                continue;
+
+            uConstantCount++;
+            uSavings += (uKeyframes - 1) * sizeof(float) * (1 + uComponents);
+            if (channel.tangents.size() == uKeyframes * uComponents * 2)
+                uSavings += (uKeyframes - 1) * sizeof(float) * uComponents * 2;
+        }
+
+        if (!uSavings)
+            return;
+
+        m_suggestions.push_back({
+            "Animation channels with a constant value: " + std::to_string(uConstantCount) + ", keeping one keyframe each would save " +
+                FormatBytes(uSavings),
+            uSavings
+        });
+    }
+
+
+    void MemoryReport::Print(std::ostream& _stream) const {
+        char szLine[256] = {};
+        std::snprintf(szLine, sizeof(szLine), "%-18s %10s %12s %12s %12s %12s %12s %12s\n", "structure", "count",
+                      g_arrCategoryNames[0], g_arrCategoryNames[1], g_arrCategoryNames[2], g_arrCategoryNames[3], g_arrCategoryNames[4], "total");
+        _stream << szLine;
+
+        auto fnPrintRow = [&](const char* _szName, const MemoryUsage& _usage) {
+            std::snprintf(szLine, sizeof(szLine), "%-18s %10llu", _szName, static_cast<unsigned long long>(_usage.uCount));
+            _stream << szLine;
+            for (uint64_t uBytes : _usage.arrBytes) {
+                std::snprintf(szLine, sizeof(szLine), " %12s", FormatBytes(uBytes).c_str());
+                _stream << szLine;
+            }
+            std::snprintf(szLine, sizeof(szLine), " %12s\n", FormatBytes(_usage.GetTotal()).c_str());
+            _stream << szLine;
+        };
+
+        for (size_t i = 0; i < DAS2_MEMORY_REPORT_ROW_COUNT; i++) {
+            if (m_arrRows[i].GetTotal())
+                fnPrintRow(g_arrRowNames[i], m_arrRows[i]);
+        }
+        fnPrintRow("total", m_total);
+
+        if (m_suggestions.empty())
+            return;
+
+        _stream << "\nSuggestions:\n";
+        for (const MemorySuggestion& suggestion : m_suggestions)
+            _stream << "  - " << suggestion.sDescription << '\n';
+    }
+}
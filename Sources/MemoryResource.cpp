@@ -0,0 +1,56 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: MemoryResource.cpp - implementation of memory resources that can be used to back das2::Model allocations
+// author: Karl-Mihkel Ott
+
+#include <new>
+#include <das2/MemoryResource.h>
+
+namespace das2 {
+
+    HookMemoryResource::HookMemoryResource(const AllocatorHook& _hook) :
+        m_hook(_hook) {}
+
+
+    void* HookMemoryResource::do_allocate(std::size_t _uBytes, std::size_t _uAlignment) {
+        void* pMemory = m_hook.pfnAllocate ? m_hook.pfnAllocate(_uBytes, _uAlignment, m_hook.pUserData) : nullptr;
+        if (!pMemory)
+            throw std::bad_alloc();
+
+        return pMemory;
+    }
+
+
+    void HookMemoryResource::do_deallocate(void* _pMemory, std::size_t _uBytes, std::size_t _uAlignment) {
+        if (m_hook.pfnDeallocate)
+            m_hook.pfnDeallocate(_pMemory, _uBytes, _uAlignment, m_hook.pUserData);
+    }
+
+
+    bool HookMemoryResource::do_is_equal(const std::pmr::memory_resource& _other) const noexcept {
+        const HookMemoryResource* pOther = dynamic_cast<const HookMemoryResource*>(&_other);
+        return pOther && pOther->m_hook.pfnAllocate == m_hook.pfnAllocate &&
+               pOther->m_hook.pfnDeallocate == m_hook.pfnDeallocate &&
+               pOther->m_hook.pUserData == m_hook.pUserData;
+    }
+
+
+    void* CountingMemoryResource::do_allocate(std::size_t _uBytes, std::size_t _uAlignment) {
+        void* pMemory = m_pUpstream->allocate(_uBytes, _uAlignment);
+        m_uAllocationCount.fetch_add(1, std::memory_order_relaxed);
+        m_uAllocatedBytes.fetch_add(_uBytes, std::memory_order_relaxed);
+        return pMemory;
+    }
+
+
+    void CountingMemoryResource::do_deallocate(void* _pMemory, std::size_t _uBytes, std::size_t _uAlignment) {
+        m_pUpstream->deallocate(_pMemory, _uBytes, _uAlignment);
+        m_uDeallocationCount.fetch_add(1, std::memory_order_relaxed);
+        m_uDeallocatedBytes.fetch_add(_uBytes, std::memory_order_relaxed);
+    }
+
+
+    bool CountingMemoryResource::do_is_equal(const std::pmr::memory_resource& _other) const noexcept {
+        return this == &_other;
+    }
+}
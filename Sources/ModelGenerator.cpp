@@ -0,0 +1,603 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: ModelGenerator.cpp - implementation of deterministic synthetic model generator
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include <das2/Exceptions.h>
+#include <das2/ModelGenerator.h>
+#include <das2/Serializer.h>
+#include <das2/Transform.h>
+
+#define GENERATOR_BATCH_SIZE (32 << 20)
+#define GENERATOR_MESH_EXTENT 16.f
+#define GENERATOR_JOINT_LENGTH 1.f
+#define GENERATOR_TWO_PI 6.28318531f
+
+namespace das2 {
+
+    namespace {
+        // independent random sequences of the generator, each one is seeded per element from the settings seed
+        enum _Stream : uint64_t {
+            _Stream_Mesh = 1,
+            _Stream_Node,
+            _Stream_Animation,
+            _Stream_Material,
+            _Stream_JointWeights
+        };
+
+
+        // splitmix64, unlike std distributions its output is identical on every platform
+        class _Random {
+            private:
+                uint64_t m_uState;
+
+            public:
+                explicit _Random(uint64_t _uState) :
+                    m_uState(_uState) {}
+
+                inline uint64_t Next() {
+                    uint64_t z = (m_uState += 0x9e3779b97f4a7c15ull);
+                    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+                    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+                    return z ^ (z >> 31);
+                }
+
+                // uniform float in [_fMin, _fMax)
+                inline float NextFloat(float _fMin = 0.f, float _fMax = 1.f) {
+                    const float f = static_cast<float>(Next() >> 40) / static_cast<float>(1ull << 24);
+                    return _fMin + f * (_fMax - _fMin);
+                }
+        };
+
+
+        inline uint64_t _DeriveSeed(uint64_t _uSeed, _Stream _eStream, uint64_t _uIndex) {
+            return _Random(_uSeed ^ (static_cast<uint64_t>(_eStream) << 56) ^ (_uIndex * 0xd1342543de82ef95ull)).Next();
+        }
+
+
+        inline uint32_t _GetParent(uint32_t _uIndex, uint32_t _uBranching) {
+            return _uBranching ? (_uIndex - 1) / _uBranching : 0;
+        }
+
+
+        // height field of a single mesh, all levels of detail sample the same surface
+        struct _Surface {
+            float fAmplitude = 1.f;
+            float arrFrequencies[2] = {};
+            float arrPhases[2] = {};
+
+            explicit _Surface(_Random& _random) :
+                fAmplitude(_random.NextFloat(0.5f, 2.f))
+            {
+                for (int i = 0; i < 2; i++) {
+                    arrFrequencies[i] = GENERATOR_TWO_PI * _random.NextFloat(0.5f, 3.f);
+                    arrPhases[i] = _random.NextFloat(0.f, GENERATOR_TWO_PI);
+                }
+            }
+
+            inline void Sample(float _fU, float _fV, float* _pPosition, float* _pNormal) const {
+                const float fSinU = std::sin(arrFrequencies[0] * _fU + arrPhases[0]);
+                const float fCosU = std::cos(arrFrequencies[0] * _fU + arrPhases[0]);
+                const float fSinV = std::sin(arrFrequencies[1] * _fV + arrPhases[1]);
+                const float fCosV = std::cos(arrFrequencies[1] * _fV + arrPhases[1]);
+
+                _pPosition[0] = _fU * GENERATOR_MESH_EXTENT;
+                _pPosition[1] = fAmplitude * fSinU * fCosV;
+                _pPosition[2] = _fV * GENERATOR_MESH_EXTENT;
+
+                if (_pNormal) {
+                    const float fDx = fAmplitude * arrFrequencies[0] * fCosU * fCosV / GENERATOR_MESH_EXTENT;
+                    const float fDz = -fAmplitude * arrFrequencies[1] * fSinU * fSinV / GENERATOR_MESH_EXTENT;
+                    const float fInvLength = 1.f / std::sqrt(fDx * fDx + 1.f + fDz * fDz);
+                    _pNormal[0] = -fDx * fInvLength;
+                    _pNormal[1] = fInvLength;
+                    _pNormal[2] = -fDz * fInvLength;
+                }
+            }
+        };
+
+
+        void _AppendFormatted(std::string& _sOut, const char* _szFormat, ...) {
+            char szLine[128];
+            va_list args;
+            va_start(args, _szFormat);
+            const int iLength = std::vsnprintf(szLine, sizeof(szLine), _szFormat, args);
+            va_end(args);
+            _sOut.append(szLine, static_cast<size_t>(std::min<int>(iLength, sizeof(szLine) - 1)));
+        }
+    }
+
+
+    ModelGenerator::ModelGenerator(const ModelGeneratorSettings& _settings, ThreadPool* _pThreadPool) :
+        m_settings(_settings),
+        m_pThreadPool(_pThreadPool)
+    {
+        m_settings.uUVSetCount = std::min<uint32_t>(m_settings.uUVSetCount, 8);
+        m_settings.uNodeCount = std::max(m_settings.uNodeCount, m_settings.uMeshCount);
+        if (!m_settings.uJointCount)
+            m_settings.uSkeletonCount = 0;
+
+        uint32_t uSide = 2;
+        while (static_cast<uint64_t>(uSide) * uSide < m_settings.uVerticesPerMesh)
+            uSide++;
+
+        // every stream consists of 4 byte elements, thus all offsets stay aligned
+        uint64_t uSize = 0;
+        for (uint32_t i = 0; i <= m_settings.uLodCount; i++) {
+            const uint64_t uVertexCount = static_cast<uint64_t>(uSide) * uSide;
+            _LodLayout lod;
+            lod.uSide = uSide;
+            lod.uPositions = uSize;
+            uSize += uVertexCount * 3 * sizeof(float);
+            if (m_settings.bNormals) {
+                lod.uNormals = uSize;
+                uSize += uVertexCount * 3 * sizeof(float);
+            }
+            for (uint32_t j = 0; j < m_settings.uUVSetCount; j++) {
+                lod.arrUVs[j] = uSize;
+                uSize += uVertexCount * 2 * sizeof(float);
+            }
+            lod.uIndices = uSize;
+            uSize += static_cast<uint64_t>(uSide - 1) * (uSide - 1) * 6 * sizeof(uint32_t);
+            if (m_settings.uSkeletonCount) {
+                lod.uJointIndices = uSize;
+                uSize += uVertexCount * 4 * sizeof(uint32_t);
+                lod.uJointWeights = uSize;
+                uSize += uVertexCount * 4 * sizeof(float);
+            }
+            m_lods.push_back(lod);
+
+            if (uSide == 2)
+                break;
+            uSide = std::max<uint32_t>((uSide - 1) / 2 + 1, 2);
+        }
+
+        const uint64_t uBaseVertexCount = static_cast<uint64_t>(m_lods.front().uSide) * m_lods.front().uSide;
+        for (uint32_t i = 0; i < m_settings.uMorphTargetCount; i++) {
+            _MorphLayout morph;
+            morph.uPositions = uSize;
+            uSize += uBaseVertexCount * 3 * sizeof(float);
+            if (m_settings.bNormals) {
+                morph.uNormals = uSize;
+                uSize += uBaseVertexCount * 3 * sizeof(float);
+            }
+            m_morphTargets.push_back(morph);
+        }
+
+        m_uMeshBlockSize = uSize;
+    }
+
+
+    void ModelGenerator::_CheckBufferSize() const {
+        if (GetBufferSize() > static_cast<uint64_t>(UINT32_MAX)) {
+            std::stringstream ss;
+            ss << "das2::ModelGenerator: generated buffer of " << GetBufferSize() << " bytes exceeds 32-bit buffer offsets";
+            throw BufferRangeException(ss.str());
+        }
+    }
+
+
+    void ModelGenerator::_LayoutMesh(Mesh& _mesh, const _LodLayout& _lod, uint64_t _uBase) const {
+        _mesh.Initialize();
+        _mesh.arrUVBufferOffsets.fill(0);
+        _mesh.arrSkeletalJointIndexBufferOffsets.fill(0);
+        _mesh.arrSkeletalJointWeightBufferOffsets.fill(0);
+
+        _mesh.uPositionVertexBufferOffset = static_cast<uint32_t>(_uBase + _lod.uPositions);
+        _mesh.uVertexNormalBufferOffset = m_settings.bNormals ? static_cast<uint32_t>(_uBase + _lod.uNormals) : 0;
+        for (uint32_t i = 0; i < m_settings.uUVSetCount; i++)
+            _mesh.arrUVBufferOffsets[i] = static_cast<uint32_t>(_uBase + _lod.arrUVs[i]);
+        _mesh.uIndexBufferOffset = static_cast<uint32_t>(_uBase + _lod.uIndices);
+        _mesh.uDrawCount = (_lod.uSide - 1) * (_lod.uSide - 1) * 6;
+
+        if (m_settings.uSkeletonCount) {
+            _mesh.arrSkeletalJointIndexBufferOffsets[0] = static_cast<uint32_t>(_uBase + _lod.uJointIndices);
+            _mesh.arrSkeletalJointWeightBufferOffsets[0] = static_cast<uint32_t>(_uBase + _lod.uJointWeights);
+        }
+    }
+
+
+    void ModelGenerator::_BuildStructures(Model& _model) const {
+        const uint32_t uMeshCount = m_settings.uMeshCount;
+        const uint32_t uNodeCount = m_settings.uNodeCount;
+        const uint32_t uJointCount = m_settings.uJointCount;
+
+        _model.header.Initialize();
+        _model.header.uMeshCount = uMeshCount;
+        _model.header.uAnimationCount = m_settings.uAnimationCount;
+        _model.header.uVerticesCount = static_cast<uint32_t>(std::min<uint64_t>(
+            static_cast<uint64_t>(m_lods.front().uSide) * m_lods.front().uSide * uMeshCount, UINT32_MAX));
+        _model.header.bZstdLevel = m_settings.bZstdLevel;
+        _model.buffer.Initialize();
+
+        for (uint32_t i = 0; i < m_settings.uMaterialCount; i++) {
+            _Random random(_DeriveSeed(m_settings.uSeed, _Stream_Material, i));
+            _model.phongMaterials.emplace_back();
+            MaterialPhong& material = _model.phongMaterials.back();
+            material.Initialize();
+            material.szName = "material_" + std::to_string(i);
+            material.vDiffuse = TRS::Vector4<float>(random.NextFloat(), random.NextFloat(), random.NextFloat(), 1.f);
+        }
+
+        // meshes, one mesh group per mesh
+        _model.meshes.reserve(uMeshCount);
+        _model.meshGroups.reserve(uMeshCount);
+        for (uint32_t i = 0; i < uMeshCount; i++) {
+            const uint64_t uBase = m_uMeshBlockSize * i;
+            _model.meshes.emplace_back();
+            Mesh& mesh = _model.meshes.back();
+            _LayoutMesh(mesh, m_lods.front(), uBase);
+
+            for (auto it = m_morphTargets.begin(); it != m_morphTargets.end(); it++) {
+                mesh.morphTargets.emplace_back();
+                MorphTarget& target = mesh.morphTargets.back();
+                target.Initialize();
+                target.arrUVBufferOffsets.fill(0);
+                target.uIndexBufferOffset = mesh.uIndexBufferOffset;
+                target.uPositionVertexBufferOffset = static_cast<uint32_t>(uBase + it->uPositions);
+                target.uVertexNormalBufferOffset = m_settings.bNormals ? static_cast<uint32_t>(uBase + it->uNormals) : 0;
+            }
+
+            for (size_t j = 1; j < m_lods.size(); j++) {
+                mesh.multipleLods.emplace_back();
+                _LayoutMesh(mesh.multipleLods.back(), m_lods[j], uBase);
+            }
+
+            if (m_settings.uMaterialCount) {
+                mesh.bMaterialType = MaterialType_Phong;
+                mesh.uMaterialId = i % m_settings.uMaterialCount;
+            }
+
+            _model.meshGroups.emplace_back();
+            MeshGroup& meshGroup = _model.meshGroups.back();
+            meshGroup.Initialize();
+            meshGroup.szName = "mesh_" + std::to_string(i);
+            meshGroup.meshes.push_back(i);
+        }
+
+        // node hierarchy, parents always precede their children
+        _model.nodes.reserve(uNodeCount);
+        for (uint32_t i = 0; i < uNodeCount; i++) {
+            _Random random(_DeriveSeed(m_settings.uSeed, _Stream_Node, i));
+            _model.nodes.emplace_back();
+            Node& node = _model.nodes.back();
+            node.Initialize();
+            node.szName = "node_" + std::to_string(i);
+            node.qRotation.x = node.qRotation.y = node.qRotation.z = 0.f;
+            node.qRotation.w = 1.f;
+            node.vTranslation = TRS::Vector3<float>(0.f, 0.f, 0.f);
+            if (i) {
+                node.vTranslation = TRS::Vector3<float>(random.NextFloat(-GENERATOR_MESH_EXTENT, GENERATOR_MESH_EXTENT), 0.f,
+                                                        random.NextFloat(-GENERATOR_MESH_EXTENT, GENERATOR_MESH_EXTENT));
+                _model.nodes[_GetParent(i, m_settings.uNodeBranching)].children.push_back(i);
+            }
+
+            if (i < uMeshCount) {
+                node.uMeshGroupId = i;
+                if (m_settings.uSkeletonCount)
+                    node.uSkeletonId = i % m_settings.uSkeletonCount;
+            }
+        }
+
+        _model.scenes.emplace_back();
+        _model.scenes.back().Initialize();
+        _model.scenes.back().szName = "scene";
+        if (uNodeCount)
+            _model.scenes.back().rootNodes.push_back(0);
+
+        // skeletons are chains or trees of unit length bones along +y in their rest pose
+        std::vector<TRS::Vector3<float>> worldTranslations(uJointCount);
+        for (uint32_t i = 0; i < m_settings.uSkeletonCount; i++) {
+            const uint32_t uFirst = static_cast<uint32_t>(_model.skeletonJoints.size());
+            _model.skeletons.emplace_back();
+            Skeleton& skeleton = _model.skeletons.back();
+            skeleton.Initialize();
+            skeleton.szName = "skeleton_" + std::to_string(i);
+
+            for (uint32_t j = 0; j < uJointCount; j++) {
+                _model.skeletonJoints.emplace_back();
+                SkeletonJoint& joint = _model.skeletonJoints.back();
+                joint.Initialize();
+                joint.szName = "skeleton_" + std::to_string(i) + "_joint_" + std::to_string(j);
+                joint.qRotation.x = joint.qRotation.y = joint.qRotation.z = 0.f;
+                joint.qRotation.w = 1.f;
+                joint.vTranslation = TRS::Vector3<float>(0.f, 0.f, 0.f);
+
+                worldTranslations[j] = TRS::Vector3<float>(0.f, 0.f, 0.f);
+                if (j) {
+                    const uint32_t uParent = _GetParent(j, m_settings.uJointBranching);
+                    joint.vTranslation = TRS::Vector3<float>(0.f, GENERATOR_JOINT_LENGTH, 0.f);
+                    worldTranslations[j] = worldTranslations[uParent] + joint.vTranslation;
+                    _model.skeletonJoints[uFirst + uParent].children.push_back(uFirst + j);
+                }
+
+                Matrix3x4 inverseBind;
+                inverseBind.m[0][3] = -worldTranslations[j][0];
+                inverseBind.m[1][3] = -worldTranslations[j][1];
+                inverseBind.m[2][3] = -worldTranslations[j][2];
+                joint.mInverseBindPos = ToMatrix4(inverseBind);
+                skeleton.joints.push_back(uFirst + j);
+            }
+        }
+
+        // animations with linear keyframes spread evenly over the duration
+        const uint32_t uKeyframeCount = m_settings.uKeyframeCount;
+        const uint32_t uAnimatedNodeCount = std::min(m_settings.uAnimatedNodeCount, uNodeCount);
+        for (uint32_t i = 0; i < m_settings.uAnimationCount; i++) {
+            _Random random(_DeriveSeed(m_settings.uSeed, _Stream_Animation, i));
+            _model.animations.emplace_back();
+            Animation& animation = _model.animations.back();
+            animation.Initialize();
+            animation.szName = "animation_" + std::to_string(i);
+
+            auto fnAddChannel = [&](uint32_t _uNodeId, uint32_t _uJointId, AnimationTarget _bTarget, uint32_t _uWeightCount) -> AnimationChannel& {
+                animation.animationChannels.push_back(static_cast<uint32_t>(_model.animationChannels.size()));
+                _model.animationChannels.emplace_back();
+                AnimationChannel& channel = _model.animationChannels.back();
+                channel.Initialize();
+                channel.uNodePropertyId = _uNodeId;
+                channel.uJointPropertyId = _uJointId;
+                channel.bAnimationTarget = _bTarget;
+                channel.bInterpolationType = InterpolationType_Linear;
+                channel.uWeightCount = _uWeightCount;
+                for (uint32_t k = 0; k < uKeyframeCount; k++)
+                    channel.keyframes.push_back(uKeyframeCount > 1 ? m_settings.fAnimationDuration * k / (uKeyframeCount - 1) : 0.f);
+                channel.targetValues.reserve(static_cast<size_t>(uKeyframeCount) * channel.GetComponentCount());
+                return channel;
+            };
+
+            for (uint32_t j = 0; j < static_cast<uint32_t>(_model.skeletonJoints.size()); j++) {
+                AnimationChannel& channel = fnAddChannel(static_cast<uint32_t>(-1), j, AnimationTarget_Rotation, 0);
+                for (uint32_t k = 0; k < uKeyframeCount; k++) {
+                    const float fHalfAngle = random.NextFloat(-0.25f, 0.25f);
+                    const float arrValues[4] = { std::sin(fHalfAngle), 0.f, 0.f, std::cos(fHalfAngle) };
+                    channel.targetValues.insert(channel.targetValues.end(), arrValues, arrValues + 4);
+                }
+            }
+
+            for (uint32_t j = 0; j < uAnimatedNodeCount; j++) {
+                AnimationChannel& translation = fnAddChannel(j, static_cast<uint32_t>(-1), AnimationTarget_Translation, 0);
+                for (uint32_t k = 0; k < uKeyframeCount * 3; k++)
+                    translation.targetValues.push_back(random.NextFloat(-1.f, 1.f));
+
+                if (j < uMeshCount && m_settings.uMorphTargetCount) {
+                    AnimationChannel& weights = fnAddChannel(j, static_cast<uint32_t>(-1), AnimationTarget_Weights, m_settings.uMorphTargetCount);
+                    for (uint32_t k = 0; k < uKeyframeCount * m_settings.uMorphTargetCount; k++)
+                        weights.targetValues.push_back(random.NextFloat());
+                }
+            }
+        }
+    }
+
+
+    void ModelGenerator::_GenerateMeshBlock(uint32_t _uMesh, char* _pOut) const {
+        _Random random(_DeriveSeed(m_settings.uSeed, _Stream_Mesh, _uMesh));
+        const _Surface surface(random);
+
+        for (size_t i = 0; i < m_lods.size(); i++) {
+            const _LodLayout& lod = m_lods[i];
+            const uint32_t uSide = lod.uSide;
+            const float fStep = 1.f / static_cast<float>(uSide - 1);
+
+            float* pPositions = reinterpret_cast<float*>(_pOut + lod.uPositions);
+            float* pNormals = m_settings.bNormals ? reinterpret_cast<float*>(_pOut + lod.uNormals) : nullptr;
+            for (uint32_t y = 0; y < uSide; y++) {
+                for (uint32_t x = 0; x < uSide; x++) {
+                    const size_t uVertex = static_cast<size_t>(y) * uSide + x;
+                    const float fU = x * fStep, fV = y * fStep;
+                    surface.Sample(fU, fV, pPositions + uVertex * 3, pNormals ? pNormals + uVertex * 3 : nullptr);
+
+                    for (uint32_t j = 0; j < m_settings.uUVSetCount; j++) {
+                        float* pUV = reinterpret_cast<float*>(_pOut + lod.arrUVs[j]) + uVertex * 2;
+                        pUV[0] = fU * static_cast<float>(j + 1);
+                        pUV[1] = fV * static_cast<float>(j + 1);
+                    }
+                }
+            }
+
+            // two counter-clockwise triangles per grid cell, seen from +y
+            uint32_t* pIndices = reinterpret_cast<uint32_t*>(_pOut + lod.uIndices);
+            for (uint32_t y = 0; y + 1 < uSide; y++) {
+                for (uint32_t x = 0; x + 1 < uSide; x++) {
+                    const uint32_t uCorner = y * uSide + x;
+                    const uint32_t arrTriangles[6] = { uCorner, uCorner + uSide + 1, uCorner + 1, uCorner, uCorner + uSide, uCorner + uSide + 1 };
+                    std::copy(arrTriangles, arrTriangles + 6, pIndices);
+                    pIndices += 6;
+                }
+            }
+
+            // the dominant joint follows the x axis of the grid, the remaining three influences are random
+            if (m_settings.uSkeletonCount) {
+                _Random weightRandom(_DeriveSeed(m_settings.uSeed, _Stream_JointWeights, static_cast<uint64_t>(_uMesh) * m_lods.size() + i));
+                const uint32_t uJointCount = m_settings.uJointCount;
+                uint32_t* pJoints = reinterpret_cast<uint32_t*>(_pOut + lod.uJointIndices);
+                float* pWeights = reinterpret_cast<float*>(_pOut + lod.uJointWeights);
+
+                for (uint32_t y = 0; y < uSide; y++) {
+                    for (uint32_t x = 0; x < uSide; x++) {
+                        pJoints[0] = std::min(static_cast<uint32_t>(static_cast<uint64_t>(x) * uJointCount / uSide), uJointCount - 1);
+                        pJoints[1] = (pJoints[0] + 1) % uJointCount;
+                        pJoints[2] = static_cast<uint32_t>(weightRandom.Next() % uJointCount);
+                        pJoints[3] = static_cast<uint32_t>(weightRandom.Next() % uJointCount);
+
+                        pWeights[0] = 1.f + weightRandom.NextFloat();
+                        pWeights[1] = weightRandom.NextFloat();
+                        pWeights[2] = weightRandom.NextFloat(0.f, 0.25f);
+                        pWeights[3] = weightRandom.NextFloat(0.f, 0.25f);
+                        const float fInvSum = 1.f / (pWeights[0] + pWeights[1] + pWeights[2] + pWeights[3]);
+                        for (int k = 0; k < 4; k++)
+                            pWeights[k] *= fInvSum;
+
+                        pJoints += 4;
+                        pWeights += 4;
+                    }
+                }
+            }
+        }
+
+        // morph targets are smooth bumps, deltas only exist for the base level
+        const uint32_t uSide = m_lods.front().uSide;
+        const float fStep = 1.f / static_cast<float>(uSide - 1);
+        for (auto it = m_morphTargets.begin(); it != m_morphTargets.end(); it++) {
+            const float fAmplitude = random.NextFloat(-1.f, 1.f);
+            const float fFrequency = GENERATOR_TWO_PI * random.NextFloat(0.5f, 2.f);
+            float* pPositions = reinterpret_cast<float*>(_pOut + it->uPositions);
+            float* pNormals = m_settings.bNormals ? reinterpret_cast<float*>(_pOut + it->uNormals) : nullptr;
+
+            for (uint32_t y = 0; y < uSide; y++) {
+                for (uint32_t x = 0; x < uSide; x++) {
+                    const size_t uVertex = static_cast<size_t>(y) * uSide + x;
+                    const float fWave = std::sin(fFrequency * x * fStep) * std::sin(0.5f * GENERATOR_TWO_PI * y * fStep);
+                    pPositions[uVertex * 3] = 0.f;
+                    pPositions[uVertex * 3 + 1] = fAmplitude * fWave;
+                    pPositions[uVertex * 3 + 2] = 0.f;
+
+                    if (pNormals) {
+                        pNormals[uVertex * 3] = -0.1f * fAmplitude * fWave;
+                        pNormals[uVertex * 3 + 1] = 0.f;
+                        pNormals[uVertex * 3 + 2] = 0.f;
+                    }
+                }
+            }
+        }
+    }
+
+
+    void ModelGenerator::_GenerateBlocks(uint32_t _uFirst, uint32_t _uCount, char* _pOut) const {
+        auto fnGenerate = [this, _uFirst, _pOut](size_t _uBegin, size_t _uEnd) {
+            for (size_t i = _uBegin; i < _uEnd; i++)
+                _GenerateMeshBlock(_uFirst + static_cast<uint32_t>(i), _pOut + m_uMeshBlockSize * i);
+        };
+
+        if (m_pThreadPool)
+            m_pThreadPool->ParallelFor(0, _uCount, 1, fnGenerate);
+        else fnGenerate(0, _uCount);
+    }
+
+
+    Model ModelGenerator::Generate(std::pmr::memory_resource* _pResource) const {
+        _CheckBufferSize();
+        Model model(_pResource);
+        _BuildStructures(model);
+
+        model.buffer.Extend(static_cast<uint32_t>(GetBufferSize()));
+        _GenerateBlocks(0, m_settings.uMeshCount, model.buffer.Get());
+        return model;
+    }
+
+
+    void ModelGenerator::Write(std::ostream& _stream) const {
+        _CheckBufferSize();
+        Model model;
+        _BuildStructures(model);
+
+        // the buffer is generated batch by batch instead of being held in model.buffer
+        Serializer serializer(_stream, model);
+        serializer.Serialize(static_cast<uint32_t>(GetBufferSize()), [this](std::ostream& _out) {
+            if (!m_settings.uMeshCount)
+                return;
+
+            const uint32_t uBatchCount = static_cast<uint32_t>(std::clamp<uint64_t>(GENERATOR_BATCH_SIZE / std::max<uint64_t>(m_uMeshBlockSize, 1), 1,
+                                                                                    m_settings.uMeshCount));
+            std::vector<char> batch(m_uMeshBlockSize * uBatchCount);
+            for (uint32_t i = 0; i < m_settings.uMeshCount; i += uBatchCount) {
+                const uint32_t uCount = std::min(uBatchCount, m_settings.uMeshCount - i);
+                _GenerateBlocks(i, uCount, batch.data());
+                _out.write(batch.data(), static_cast<std::streamsize>(m_uMeshBlockSize * uCount));
+            }
+        });
+        _stream.flush();
+    }
+
+
+    void ModelGenerator::WriteObj(std::ostream& _stream) const {
+        const uint32_t uMeshCount = m_settings.uMeshCount;
+        const _LodLayout& lod = m_lods.front();
+        const uint32_t uSide = lod.uSide;
+        const uint64_t uVertexCount = static_cast<uint64_t>(uSide) * uSide;
+        const bool bUVs = m_settings.uUVSetCount > 0;
+
+        uint32_t uColumns = 1;
+        while (static_cast<uint64_t>(uColumns) * uColumns < uMeshCount)
+            uColumns++;
+
+        _stream << "# das2::ModelGenerator seed " << m_settings.uSeed << '\n';
+        if (!uMeshCount) {
+            _stream.flush();
+            return;
+        }
+
+        // obj text is a few times larger than the binary streams, thus batches are smaller than for das2 output
+        const uint32_t uBatchCount = static_cast<uint32_t>(std::clamp<uint64_t>(GENERATOR_BATCH_SIZE / 4 / std::max<uint64_t>(m_uMeshBlockSize, 1), 1,
+                                                                                uMeshCount));
+        std::vector<char> blocks(m_uMeshBlockSize * uBatchCount);
+        std::vector<std::string> texts(uBatchCount);
+
+        // all meshes have the same vertex count, thus global obj indices of every mesh are known up front
+        auto fnFormat = [&](uint32_t _uFirst, size_t _uBegin, size_t _uEnd) {
+            for (size_t i = _uBegin; i < _uEnd; i++) {
+                const uint32_t uMesh = _uFirst + static_cast<uint32_t>(i);
+                const char* pBlock = blocks.data() + m_uMeshBlockSize * i;
+                const float* pPositions = reinterpret_cast<const float*>(pBlock + lod.uPositions);
+                const float* pNormals = reinterpret_cast<const float*>(pBlock + lod.uNormals);
+                const float* pUVs = reinterpret_cast<const float*>(pBlock + lod.arrUVs[0]);
+                const float fOffsetX = static_cast<float>(uMesh % uColumns) * GENERATOR_MESH_EXTENT * 1.25f;
+                const float fOffsetZ = static_cast<float>(uMesh / uColumns) * GENERATOR_MESH_EXTENT * 1.25f;
+
+                std::string& sText = texts[i];
+                sText.clear();
+                _AppendFormatted(sText, "g mesh_%u\n", uMesh);
+                if (m_settings.uMaterialCount)
+                    _AppendFormatted(sText, "usemtl material_%u\n", uMesh % m_settings.uMaterialCount);
+
+                for (uint64_t j = 0; j < uVertexCount; j++) {
+                    _AppendFormatted(sText, "v %.6f %.6f %.6f\n", pPositions[j * 3] + fOffsetX, pPositions[j * 3 + 1], pPositions[j * 3 + 2] + fOffsetZ);
+                    if (bUVs)
+                        _AppendFormatted(sText, "vt %.6f %.6f\n", pUVs[j * 2], pUVs[j * 2 + 1]);
+                    if (m_settings.bNormals)
+                        _AppendFormatted(sText, "vn %.6f %.6f %.6f\n", pNormals[j * 3], pNormals[j * 3 + 1], pNormals[j * 3 + 2]);
+                }
+
+                const unsigned long long uBase = static_cast<unsigned long long>(uVertexCount) * uMesh + 1;
+                for (uint32_t y = 0; y + 1 < uSide; y++) {
+                    for (uint32_t x = 0; x + 1 < uSide; x++) {
+                        const unsigned long long uCorner = uBase + static_cast<unsigned long long>(y) * uSide + x;
+                        const unsigned long long arrCorners[4] = { uCorner, uCorner + uSide, uCorner + uSide + 1, uCorner + 1 };
+
+                        sText += 'f';
+                        for (int k = 0; k < 4; k++) {
+                            if (bUVs && m_settings.bNormals)
+                                _AppendFormatted(sText, " %llu/%llu/%llu", arrCorners[k], arrCorners[k], arrCorners[k]);
+                            else if (bUVs)
+                                _AppendFormatted(sText, " %llu/%llu", arrCorners[k], arrCorners[k]);
+                            else if (m_settings.bNormals)
+                                _AppendFormatted(sText, " %llu//%llu", arrCorners[k], arrCorners[k]);
+                            else _AppendFormatted(sText, " %llu", arrCorners[k]);
+                        }
+                        sText += '\n';
+                    }
+                }
+            }
+        };
+
+        for (uint32_t i = 0; i < uMeshCount; i += uBatchCount) {
+            const uint32_t uCount = std::min(uBatchCount, uMeshCount - i);
+            _GenerateBlocks(i, uCount, blocks.data());
+            if (m_pThreadPool)
+                m_pThreadPool->ParallelFor(0, uCount, 1, [&fnFormat, i](size_t _uBegin, size_t _uEnd) { fnFormat(i, _uBegin, _uEnd); });
+            else fnFormat(i, 0, uCount);
+
+            for (uint32_t j = 0; j < uCount; j++)
+                _stream.write(texts[j].data(), static_cast<std::streamsize>(texts[j].size()));
+        }
+
+        _stream.flush();
+    }
+}
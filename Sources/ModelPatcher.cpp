@@ -0,0 +1,391 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: ModelPatcher.cpp - implementation of in-place patching of uncompressed das2 files
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <sstream>
+
+#include <das2/Exceptions.h>
+#include <das2/ModelPatcher.h>
+
+#define DAS2_PATCHER_COPY_CHUNK_SIZE (1 << 20)
+
+namespace das2 {
+
+    namespace {
+        // same order as Serializer writes them
+        const StructureIdentifier g_arrRecordOrder[] = {
+            StructureIdentifier_Mesh,
+            StructureIdentifier_MeshGroup,
+            StructureIdentifier_Node,
+            StructureIdentifier_Scene,
+            StructureIdentifier_SkeletonJoint,
+            StructureIdentifier_Skeleton,
+            StructureIdentifier_Animation,
+            StructureIdentifier_AnimationChannel,
+            StructureIdentifier_MaterialPhong,
+            StructureIdentifier_MaterialPbr
+        };
+
+
+        template <typename T>
+        void _SerializeArray(const std::pmr::vector<T>& _vec, std::vector<std::string>& _records) {
+            _records.reserve(_vec.size());
+            for (const T& structure : _vec) {
+                std::ostringstream stream;
+                structure.Write(stream);
+                _records.push_back(stream.str());
+            }
+        }
+
+
+        template <typename T>
+        inline void _ReadStructure(std::istream& _stream, std::pmr::vector<T>& _vec) {
+            _vec.emplace_back();
+            _vec.back().Read(_stream);
+        }
+    }
+
+
+    ModelPatcher::ModelPatcher(const std::filesystem::path& _path, std::pmr::memory_resource* _pResource) :
+        m_path(_path),
+        m_model(_pResource)
+    {
+        _Open();
+        _Load();
+    }
+
+
+    void ModelPatcher::_Open() {
+        m_stream.open(m_path, std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+        if (!m_stream)
+            throw SerializerException("[das2::ModelPatcher] Cannot open file '" + m_path.string() + "' for reading and writing");
+    }
+
+
+    void ModelPatcher::_Load() {
+        const uint64_t uFileSize = std::filesystem::file_size(m_path);
+
+        // positions are tracked by the buffer, thus the blob is skipped with a single relative seek
+        TimedStreamBuffer buffer(m_stream.rdbuf(), nullptr, nullptr);
+        std::istream stream(&buffer);
+
+        m_model.header.Read(stream);
+        if (!stream)
+            throw SerializerException("[das2::ModelPatcher] Truncated header");
+        if (m_model.header.bZstdLevel)
+            throw SerializerException("[das2::ModelPatcher] Compressed file '" + m_path.string() + "' cannot be patched, load and serialize it instead");
+
+        {
+            std::ostringstream header;
+            m_model.header.Write(header);
+            m_header = header.str();
+        }
+        m_uTailOffset = static_cast<uint64_t>(static_cast<std::streamoff>(stream.tellg()));
+
+        std::vector<uint64_t> arrSizes[DAS2_STATISTICS_STRUCTURE_COUNT];
+        while (stream.peek() != std::char_traits<char>::eof()) {
+            const StructureIdentifier bIdentifier = static_cast<StructureIdentifier>(stream.peek());
+            const uint64_t uStart = static_cast<uint64_t>(static_cast<std::streamoff>(stream.tellg()));
+
+            switch (bIdentifier) {
+                case StructureIdentifier_Buffer: {
+                    if (m_uBufferRecordSize)
+                        throw SerializerException("Multiple buffers detected in das2 buffer. The specification states that only one buffer is allowed.");
+
+                    uint32_t uLength = 0;
+                    stream.get();
+                    stream.read(reinterpret_cast<char*>(&uLength), sizeof(uint32_t));
+                    m_uBufferOffset = uStart;
+                    m_uBufferRecordSize = sizeof(StructureIdentifier) + sizeof(uint32_t) + static_cast<uint64_t>(uLength);
+                    if (!stream || uStart + m_uBufferRecordSize > uFileSize)
+                        throw SerializerException("[das2::ModelPatcher] Buffer exceeds the end of the file");
+                    stream.seekg(uLength, std::ios_base::cur);
+
+                    // any structure in front of the buffer cannot be moved without moving the blob
+                    for (const std::vector<_Record>& records : m_arrRecords) {
+                        if (!records.empty())
+                            m_bCanonical = false;
+                    }
+                    m_uTailOffset = uStart + m_uBufferRecordSize;
+                    continue;
+                }
+
+                case StructureIdentifier_Mesh:
+                    _ReadStructure(stream, m_model.meshes);
+                    break;
+
+                case StructureIdentifier_MeshGroup:
+                    _ReadStructure(stream, m_model.meshGroups);
+                    break;
+
+                case StructureIdentifier_Node:
+                    _ReadStructure(stream, m_model.nodes);
+                    break;
+
+                case StructureIdentifier_Scene:
+                    _ReadStructure(stream, m_model.scenes);
+                    break;
+
+                case StructureIdentifier_SkeletonJoint:
+                    _ReadStructure(stream, m_model.skeletonJoints);
+                    break;
+
+                case StructureIdentifier_Skeleton:
+                    _ReadStructure(stream, m_model.skeletons);
+                    break;
+
+                case StructureIdentifier_Animation:
+                    _ReadStructure(stream, m_model.animations);
+                    break;
+
+                case StructureIdentifier_AnimationChannel:
+                    _ReadStructure(stream, m_model.animationChannels);
+                    break;
+
+                case StructureIdentifier_MaterialPhong:
+                    _ReadStructure(stream, m_model.phongMaterials);
+                    break;
+
+                case StructureIdentifier_MaterialPbr:
+                    _ReadStructure(stream, m_model.pbrMaterials);
+                    break;
+
+                default:
+                    throw SerializerException("Invalid magic byte");
+            }
+
+            if (!stream)
+                throw SerializerException("[das2::ModelPatcher] Truncated structure record");
+
+            _Record record;
+            record.uOffset = uStart;
+            m_arrRecords[bIdentifier].push_back(std::move(record));
+            arrSizes[bIdentifier].push_back(static_cast<uint64_t>(static_cast<std::streamoff>(stream.tellg())) - uStart);
+        }
+
+        // records are compared by their serialized bytes, which have to match the file for in-place writes
+        for (StructureIdentifier bIdentifier : g_arrRecordOrder) {
+            std::vector<_Record>& records = m_arrRecords[bIdentifier];
+            std::vector<std::string> serialized = _SerializeRecords(bIdentifier);
+            for (size_t i = 0; i < records.size(); i++) {
+                if (arrSizes[bIdentifier][i] != serialized[i].size())
+                    m_bCanonical = false;
+                records[i].bytes = std::move(serialized[i]);
+            }
+        }
+
+        m_stream.clear();
+    }
+
+
+    std::vector<std::string> ModelPatcher::_SerializeRecords(StructureIdentifier _bIdentifier) const {
+        std::vector<std::string> records;
+        switch (_bIdentifier) {
+            case StructureIdentifier_Mesh:
+                _SerializeArray(m_model.meshes, records);
+                break;
+
+            case StructureIdentifier_MeshGroup:
+                _SerializeArray(m_model.meshGroups, records);
+                break;
+
+            case StructureIdentifier_Node:
+                _SerializeArray(m_model.nodes, records);
+                break;
+
+            case StructureIdentifier_Scene:
+                _SerializeArray(m_model.scenes, records);
+                break;
+
+            case StructureIdentifier_SkeletonJoint:
+                _SerializeArray(m_model.skeletonJoints, records);
+                break;
+
+            case StructureIdentifier_Skeleton:
+                _SerializeArray(m_model.skeletons, records);
+                break;
+
+            case StructureIdentifier_Animation:
+                _SerializeArray(m_model.animations, records);
+                break;
+
+            case StructureIdentifier_AnimationChannel:
+                _SerializeArray(m_model.animationChannels, records);
+                break;
+
+            case StructureIdentifier_MaterialPhong:
+                _SerializeArray(m_model.phongMaterials, records);
+                break;
+
+            case StructureIdentifier_MaterialPbr:
+                _SerializeArray(m_model.pbrMaterials, records);
+                break;
+
+            default:
+                break;
+        }
+
+        return records;
+    }
+
+
+    void ModelPatcher::_Snapshot(const std::string& _header, std::vector<std::string>* _pRecords, uint64_t _uTailOffset) {
+        m_header = _header;
+        m_uTailOffset = _uTailOffset;
+
+        uint64_t uOffset = _uTailOffset;
+        for (StructureIdentifier bIdentifier : g_arrRecordOrder) {
+            std::vector<_Record>& records = m_arrRecords[bIdentifier];
+            records.resize(_pRecords[bIdentifier].size());
+            for (size_t i = 0; i < records.size(); i++) {
+                records[i].uOffset = uOffset;
+                records[i].bytes = std::move(_pRecords[bIdentifier][i]);
+                uOffset += records[i].bytes.size();
+            }
+        }
+        m_bCanonical = true;
+    }
+
+
+    uint64_t ModelPatcher::_WriteTail(std::ostream& _stream, std::vector<std::string>* _pRecords) const {
+        uint64_t uBytes = 0;
+        for (StructureIdentifier bIdentifier : g_arrRecordOrder) {
+            for (const std::string& record : _pRecords[bIdentifier]) {
+                _stream.write(record.data(), static_cast<std::streamsize>(record.size()));
+                uBytes += record.size();
+            }
+        }
+
+        return uBytes;
+    }
+
+
+    void ModelPatcher::_RewriteFile(const std::string& _header, std::vector<std::string>* _pRecords, PatchResult& _result) {
+        std::filesystem::path tmp = m_path;
+        tmp += ".patch";
+
+        {
+            std::ofstream out(tmp, std::ios_base::binary | std::ios_base::trunc);
+            if (!out)
+                throw SerializerException("[das2::ModelPatcher] Cannot open file '" + tmp.string() + "' for writing");
+
+            out.write(_header.data(), static_cast<std::streamsize>(_header.size()));
+
+            // the buffer record is copied as is, its contents are never parsed
+            if (m_uBufferRecordSize) {
+                std::vector<char> chunk(DAS2_PATCHER_COPY_CHUNK_SIZE);
+                m_stream.seekg(static_cast<std::streamoff>(m_uBufferOffset), std::ios_base::beg);
+                uint64_t uRemaining = m_uBufferRecordSize;
+                while (uRemaining) {
+                    const std::streamsize uChunk = static_cast<std::streamsize>(std::min<uint64_t>(uRemaining, chunk.size()));
+                    if (!m_stream.read(chunk.data(), uChunk))
+                        throw SerializerException("[das2::ModelPatcher] Cannot read buffer from '" + m_path.string() + "'");
+                    out.write(chunk.data(), uChunk);
+                    uRemaining -= static_cast<uint64_t>(uChunk);
+                }
+            }
+
+            _result.uBytesWritten = _header.size() + m_uBufferRecordSize + _WriteTail(out, _pRecords);
+            if (!out.flush())
+                throw SerializerException("[das2::ModelPatcher] Cannot write file '" + tmp.string() + "'");
+        }
+
+        m_stream.close();
+        std::filesystem::rename(tmp, m_path);
+        _Open();
+
+        m_uBufferOffset = _header.size();
+        _Snapshot(_header, _pRecords, m_uBufferOffset + m_uBufferRecordSize);
+        _result.eMode = PatchMode_Rewrite;
+    }
+
+
+    PatchResult ModelPatcher::Commit() {
+        PatchResult result;
+
+        std::string header;
+        {
+            std::ostringstream stream;
+            m_model.header.Write(stream);
+            header = stream.str();
+        }
+
+        if (m_model.header.bZstdLevel)
+            throw SerializerException("[das2::ModelPatcher] Patched files cannot be compressed, load and serialize the model instead");
+
+        std::vector<std::string> arrRecords[DAS2_STATISTICS_STRUCTURE_COUNT];
+        bool bSameLayout = header.size() == m_header.size();
+        bool bChanged = header != m_header;
+        for (StructureIdentifier bIdentifier : g_arrRecordOrder) {
+            arrRecords[bIdentifier] = _SerializeRecords(bIdentifier);
+
+            const std::vector<_Record>& records = m_arrRecords[bIdentifier];
+            const std::vector<std::string>& serialized = arrRecords[bIdentifier];
+            if (records.size() != serialized.size()) {
+                bSameLayout = false;
+                bChanged = true;
+                continue;
+            }
+
+            for (size_t i = 0; i < records.size(); i++) {
+                if (records[i].bytes.size() != serialized[i].size())
+                    bSameLayout = false;
+                if (records[i].bytes != serialized[i])
+                    bChanged = true;
+            }
+        }
+
+        if (!bChanged)
+            return result;
+
+        // the header sits in front of the buffer, a different size moves the blob
+        if (header.size() != m_header.size() || !m_bCanonical) {
+            _RewriteFile(header, arrRecords, result);
+            return result;
+        }
+
+        if (header != m_header) {
+            m_stream.seekp(0, std::ios_base::beg);
+            m_stream.write(header.data(), static_cast<std::streamsize>(header.size()));
+            result.uBytesWritten += header.size();
+        }
+
+        if (bSameLayout) {
+            for (StructureIdentifier bIdentifier : g_arrRecordOrder) {
+                std::vector<_Record>& records = m_arrRecords[bIdentifier];
+                for (size_t i = 0; i < records.size(); i++) {
+                    const std::string& serialized = arrRecords[bIdentifier][i];
+                    if (records[i].bytes == serialized)
+                        continue;
+
+                    m_stream.seekp(static_cast<std::streamoff>(records[i].uOffset), std::ios_base::beg);
+                    m_stream.write(serialized.data(), static_cast<std::streamsize>(serialized.size()));
+                    result.uBytesWritten += serialized.size();
+                    records[i].bytes = serialized;
+                }
+            }
+
+            if (!m_stream.flush())
+                throw SerializerException("[das2::ModelPatcher] Cannot write file '" + m_path.string() + "'");
+            m_header = std::move(header);
+            result.eMode = PatchMode_InPlace;
+            return result;
+        }
+
+        // structures follow the buffer, thus the tail is rewritten and the blob stays untouched
+        m_stream.seekp(static_cast<std::streamoff>(m_uTailOffset), std::ios_base::beg);
+        const uint64_t uTailSize = _WriteTail(m_stream, arrRecords);
+        if (!m_stream.flush())
+            throw SerializerException("[das2::ModelPatcher] Cannot write file '" + m_path.string() + "'");
+        result.uBytesWritten += uTailSize;
+
+        if (std::filesystem::file_size(m_path) > m_uTailOffset + uTailSize)
+            std::filesystem::resize_file(m_path, m_uTailOffset + uTailSize);
+
+        _Snapshot(header, arrRecords, m_uTailOffset);
+        result.eMode = PatchMode_Tail;
+        return result;
+    }
+}
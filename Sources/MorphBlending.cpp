@@ -0,0 +1,158 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: MorphBlending.cpp - implementation of morph target blending kernel
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <das2/Exceptions.h>
+#include <das2/MorphBlending.h>
+#include <das2/Simd.h>
+
+// number of floats blended at once, all targets are applied to a block while it is in cache
+// must be divisible by both 2 and 3 so that blocks contain whole vertices
+#define MORPH_BLOCK_SIZE 3072
+
+namespace das2 {
+
+    namespace {
+        template <typename L>
+        inline void _Accumulate(float* _pOut, const float* _pDelta, float _fWeight, size_t _uBegin, size_t _uEnd) {
+            const typename L::Type weight = L::Set(_fWeight);
+            for (size_t i = _uBegin; i + L::uWidth <= _uEnd; i += L::uWidth)
+                L::Store(_pOut + i, L::MulAdd(weight, L::Load(_pDelta + i), L::Load(_pOut + i)));
+        }
+
+
+        inline void _AccumulateRange(float* _pOut, const float* _pDelta, float _fWeight, size_t _uBegin, size_t _uEnd) {
+            const size_t uVectorEnd = _uBegin + (_uEnd - _uBegin) / simd::Widest::uWidth * simd::Widest::uWidth;
+            _Accumulate<simd::Widest>(_pOut, _pDelta, _fWeight, _uBegin, uVectorEnd);
+            _Accumulate<simd::Scalar>(_pOut, _pDelta, _fWeight, uVectorEnd, _uEnd);
+        }
+
+
+        inline const float* _GetStream(const Model& _model, uint32_t _uOffset, size_t _uFloatCount, const char* _szName) {
+            if (static_cast<size_t>(_uOffset) + _uFloatCount * sizeof(float) > _model.buffer.Size()) {
+                std::stringstream ss;
+                ss << "das2::BlendMorphTargets: " << _szName << " stream at offset " << _uOffset << " exceeds the buffer size";
+                throw BufferRangeException(ss.str());
+            }
+
+            return _model.buffer.Get<float>(_uOffset);
+        }
+    }
+
+
+    void BlendMorphTargets(const Model& _model, const Mesh& _mesh, const float* _pWeights, size_t _uWeightCount,
+                           const MorphBlendSettings& _settings, MorphBlendBuffer& _out, ThreadPool* _pThreadPool)
+    {
+        const size_t uVertexCount = _settings.uVertexCount;
+        const uint32_t uUVSetCount = std::min<uint32_t>(_settings.uUVSetCount, 8);
+
+        // collect targets, which contribute to the result
+        _out.activeTargets.clear();
+        const size_t uTargetCount = std::min(_uWeightCount, _mesh.morphTargets.size());
+        for (size_t i = 0; i < uTargetCount; i++) {
+            if (std::fabs(_pWeights[i]) > _settings.fWeightEpsilon)
+                _out.activeTargets.push_back(static_cast<uint32_t>(i));
+        }
+
+        // resolve all streams before blending, so that range errors are reported up front
+        std::vector<const float*>& deltas = _out.deltaStreams;
+        deltas.clear();
+
+        struct _Stream {
+            const float* pBase;
+            float* pOut;
+            size_t uFloatCount;
+            size_t uFirstDelta;
+            bool bNormalize;
+        };
+        _Stream arrStreams[10];
+        uint32_t uStreamCount = 0;
+
+        // offset 0 marks an absent stream everywhere but for positions, which always exist; absent mesh streams leave their
+        // output empty and targets without the stream contribute no delta (nullptr)
+        auto fnAddStream = [&](std::vector<float>& _dst, uint32_t _uBaseOffset, size_t _uComponents, const char* _szName,
+                               bool _bOptional, bool _bNormalize, auto _fnTargetOffset) {
+            if (_bOptional && !_uBaseOffset) {
+                _dst.clear();
+                return;
+            }
+
+            const size_t uFloatCount = uVertexCount * _uComponents;
+            _dst.resize(uFloatCount);
+
+            _Stream& stream = arrStreams[uStreamCount++];
+            stream.pBase = _GetStream(_model, _uBaseOffset, uFloatCount, _szName);
+            stream.pOut = _dst.data();
+            stream.uFloatCount = uFloatCount;
+            stream.uFirstDelta = deltas.size();
+            stream.bNormalize = _bNormalize;
+
+            for (auto it = _out.activeTargets.begin(); it != _out.activeTargets.end(); it++) {
+                const uint32_t uOffset = _fnTargetOffset(_mesh.morphTargets[*it]);
+                deltas.push_back(_bOptional && !uOffset ? nullptr : _GetStream(_model, uOffset, uFloatCount, _szName));
+            }
+        };
+
+        fnAddStream(_out.positions, _mesh.uPositionVertexBufferOffset, 3, "position", false, false, [](const MorphTarget& _target) {
+            return _target.uPositionVertexBufferOffset;
+        });
+
+        if (_settings.bNormals) {
+            fnAddStream(_out.normals, _mesh.uVertexNormalBufferOffset, 3, "vertex normal", true, true, [](const MorphTarget& _target) {
+                return _target.uVertexNormalBufferOffset;
+            });
+        }
+
+        for (uint32_t i = 0; i < uUVSetCount; i++) {
+            fnAddStream(_out.arrUVs[i], _mesh.arrUVBufferOffsets[i], 2, "UV", true, false, [i](const MorphTarget& _target) {
+                return _target.arrUVBufferOffsets[i];
+            });
+        }
+
+        const size_t uActiveCount = _out.activeTargets.size();
+        auto fnBlendBlocks = [&](size_t _uFirstBlock, size_t _uLastBlock) {
+            for (uint32_t s = 0; s < uStreamCount; s++) {
+                const _Stream& stream = arrStreams[s];
+                const size_t uBegin = std::min(_uFirstBlock * MORPH_BLOCK_SIZE, stream.uFloatCount);
+                const size_t uEnd = std::min(_uLastBlock * MORPH_BLOCK_SIZE, stream.uFloatCount);
+                if (uBegin == uEnd)
+                    continue;
+
+                for (size_t uBlock = uBegin; uBlock < uEnd; uBlock += MORPH_BLOCK_SIZE) {
+                    const size_t uBlockEnd = std::min(uBlock + MORPH_BLOCK_SIZE, uEnd);
+                    std::memcpy(stream.pOut + uBlock, stream.pBase + uBlock, (uBlockEnd - uBlock) * sizeof(float));
+
+                    for (size_t t = 0; t < uActiveCount; t++) {
+                        const float* pDelta = deltas[stream.uFirstDelta + t];
+                        if (pDelta)
+                            _AccumulateRange(stream.pOut, pDelta, _pWeights[_out.activeTargets[t]], uBlock, uBlockEnd);
+                    }
+
+                    if (stream.bNormalize && uActiveCount) {
+                        for (size_t i = uBlock; i < uBlockEnd; i += 3) {
+                            float* pNormal = stream.pOut + i;
+                            const float fLength = std::sqrt(pNormal[0] * pNormal[0] + pNormal[1] * pNormal[1] + pNormal[2] * pNormal[2]);
+                            if (fLength > 0.f) {
+                                pNormal[0] /= fLength;
+                                pNormal[1] /= fLength;
+                                pNormal[2] /= fLength;
+                            }
+                        }
+                    }
+                }
+            }
+        };
+
+        // all streams have at most 3 floats per vertex, thus positions determine the number of blocks
+        const size_t uBlockCount = (uVertexCount * 3 + MORPH_BLOCK_SIZE - 1) / MORPH_BLOCK_SIZE;
+        if (_pThreadPool && uBlockCount > 1)
+            _pThreadPool->ParallelFor(0, uBlockCount, 1, fnBlendBlocks);
+        else
+            fnBlendBlocks(0, uBlockCount);
+    }
+}
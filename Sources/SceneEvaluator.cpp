@@ -0,0 +1,248 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: SceneEvaluator.cpp - implementation of flattened scene graph world transformation evaluator
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <das2/Exceptions.h>
+#include <das2/SceneEvaluator.h>
+
+// levels smaller than that are evaluated on the calling thread
+#define PARALLEL_LEVEL_THRESHOLD 4096
+#define PARALLEL_GRAIN 1024
+
+namespace das2 {
+
+    namespace {
+        struct _SoAPointers {
+            const float* arrRotations[4];
+            const float* arrTranslations[3];
+            const float* pScales;
+            const uint8_t* pHasCustomTransform;
+            const float* arrCustomTransforms[12];
+            const uint32_t* pParents;
+            float* arrWorldTransforms[12];
+        };
+
+
+        template <typename L>
+        inline void _EvaluateLanes(const _SoAPointers& _soa, size_t _uIndex, bool _bRootLevel) {
+            using V = typename L::Type;
+
+            V rotation[4], translation[3];
+            for (int i = 0; i < 4; i++)
+                rotation[i] = L::Load(_soa.arrRotations[i] + _uIndex);
+            for (int i = 0; i < 3; i++)
+                translation[i] = L::Load(_soa.arrTranslations[i] + _uIndex);
+
+            V local[12];
+            ComposeTransformLanes<L>(rotation, translation, L::Load(_soa.pScales + _uIndex), local);
+
+            // custom transforms are rare, skip the multiplication if no lane has one
+            uint8_t bHasCustom = 0;
+            for (size_t i = 0; i < L::uWidth; i++)
+                bHasCustom |= _soa.pHasCustomTransform[_uIndex + i];
+
+            if (bHasCustom) {
+                V custom[12];
+                for (int i = 0; i < 12; i++)
+                    custom[i] = L::Load(_soa.arrCustomTransforms[i] + _uIndex);
+                MultiplyLanes<L>(custom, local, local);
+            }
+
+            if (!_bRootLevel) {
+                V parent[12];
+                const uint32_t* pParents = _soa.pParents + _uIndex;
+                for (int i = 0; i < 12; i++)
+                    parent[i] = L::Gather(_soa.arrWorldTransforms[i], pParents);
+                MultiplyLanes<L>(parent, local, local);
+            }
+
+            for (int i = 0; i < 12; i++)
+                L::Store(_soa.arrWorldTransforms[i] + _uIndex, local[i]);
+        }
+    }
+
+
+    SceneEvaluator::SceneEvaluator(const Model& _model, uint32_t _uSceneIndex, ThreadPool* _pThreadPool) :
+        m_pThreadPool(_pThreadPool)
+    {
+        _Flatten(_model, _uSceneIndex);
+    }
+
+
+    void SceneEvaluator::_Flatten(const Model& _model, uint32_t _uSceneIndex) {
+        if (_uSceneIndex >= _model.scenes.size()) {
+            std::stringstream ss;
+            ss << "das2::SceneEvaluator: invalid scene index " << _uSceneIndex;
+            throw HierarchyException(ss.str());
+        }
+
+        const Scene& scene = _model.scenes[_uSceneIndex];
+        m_flatIndices.assign(_model.nodes.size(), static_cast<uint32_t>(-1));
+
+        auto fnVisit = [&](uint32_t _uNodeId, uint32_t _uParent) {
+            if (_uNodeId >= _model.nodes.size()) {
+                std::stringstream ss;
+                ss << "das2::SceneEvaluator: invalid node id " << _uNodeId;
+                throw HierarchyException(ss.str());
+            }
+
+            if (m_flatIndices[_uNodeId] != static_cast<uint32_t>(-1)) {
+                std::stringstream ss;
+                ss << "das2::SceneEvaluator: node " << _uNodeId << " is referenced multiple times in scene " << _uSceneIndex;
+                throw HierarchyException(ss.str());
+            }
+
+            m_flatIndices[_uNodeId] = static_cast<uint32_t>(m_nodeIds.size());
+            m_nodeIds.push_back(_uNodeId);
+            m_parents.push_back(_uParent);
+        };
+
+        // breadth first traversal yields the level-by-level order
+        m_levelOffsets.push_back(0);
+        for (auto it = scene.rootNodes.begin(); it != scene.rootNodes.end(); it++)
+            fnVisit(*it, static_cast<uint32_t>(-1));
+
+        size_t uLevelBegin = 0;
+        while (uLevelBegin < m_nodeIds.size()) {
+            const size_t uLevelEnd = m_nodeIds.size();
+            m_levelOffsets.push_back(static_cast<uint32_t>(uLevelEnd));
+
+            for (size_t i = uLevelBegin; i < uLevelEnd; i++) {
+                const Node& node = _model.nodes[m_nodeIds[i]];
+                for (auto it = node.children.begin(); it != node.children.end(); it++)
+                    fnVisit(*it, static_cast<uint32_t>(i));
+            }
+            uLevelBegin = uLevelEnd;
+        }
+
+        // allocate structure of arrays and fill in local poses
+        const size_t uCount = m_nodeIds.size();
+        for (int i = 0; i < 4; i++)
+            m_rotations[i].resize(uCount);
+        for (int i = 0; i < 3; i++)
+            m_translations[i].resize(uCount);
+        m_scales.resize(uCount);
+        m_hasCustomTransform.resize(uCount);
+        for (int i = 0; i < 12; i++) {
+            m_customTransforms[i].resize(uCount);
+            m_worldTransforms[i].resize(uCount);
+        }
+
+        const Matrix3x4 identity;
+        for (size_t i = 0; i < uCount; i++) {
+            const Node& node = _model.nodes[m_nodeIds[i]];
+            SetLocalPose(m_nodeIds[i], LocalPose{ node.qRotation, node.vTranslation, node.fScale });
+
+            const Matrix3x4 custom = ToMatrix3x4(node.mCustomTransform);
+            m_hasCustomTransform[i] = std::memcmp(custom.m, identity.m, sizeof(identity.m)) != 0;
+            for (int j = 0; j < 12; j++)
+                m_customTransforms[j][i] = custom.m[j / 4][j % 4];
+        }
+    }
+
+
+    void SceneEvaluator::_EvaluateRange(size_t _uBegin, size_t _uEnd, bool _bRootLevel) {
+        _SoAPointers soa;
+        for (int i = 0; i < 4; i++)
+            soa.arrRotations[i] = m_rotations[i].data();
+        for (int i = 0; i < 3; i++)
+            soa.arrTranslations[i] = m_translations[i].data();
+        soa.pScales = m_scales.data();
+        soa.pHasCustomTransform = m_hasCustomTransform.data();
+        for (int i = 0; i < 12; i++) {
+            soa.arrCustomTransforms[i] = m_customTransforms[i].data();
+            soa.arrWorldTransforms[i] = m_worldTransforms[i].data();
+        }
+        soa.pParents = m_parents.data();
+
+        size_t i = _uBegin;
+        for (; i + simd::Wide::uWidth <= _uEnd; i += simd::Wide::uWidth)
+            _EvaluateLanes<simd::Wide>(soa, i, _bRootLevel);
+        for (; i < _uEnd; i++)
+            _EvaluateLanes<simd::Scalar>(soa, i, _bRootLevel);
+    }
+
+
+    void SceneEvaluator::SetLocalPose(uint32_t _uNodeId, const LocalPose& _pose) {
+        if (!Contains(_uNodeId))
+            return;
+
+        const uint32_t uIndex = m_flatIndices[_uNodeId];
+        m_rotations[0][uIndex] = _pose.qRotation.x;
+        m_rotations[1][uIndex] = _pose.qRotation.y;
+        m_rotations[2][uIndex] = _pose.qRotation.z;
+        m_rotations[3][uIndex] = _pose.qRotation.w;
+        m_translations[0][uIndex] = _pose.vTranslation.first;
+        m_translations[1][uIndex] = _pose.vTranslation.second;
+        m_translations[2][uIndex] = _pose.vTranslation.third;
+        m_scales[uIndex] = _pose.fScale;
+    }
+
+
+    void SceneEvaluator::SetLocalPoses(const LocalPose* _pPoses, size_t _uPoseCount) {
+        const size_t uCount = std::min(_uPoseCount, m_flatIndices.size());
+        for (size_t i = 0; i < uCount; i++)
+            SetLocalPose(static_cast<uint32_t>(i), _pPoses[i]);
+    }
+
+
+    LocalPose SceneEvaluator::GetLocalPose(uint32_t _uNodeId) const {
+        LocalPose pose;
+        if (!Contains(_uNodeId))
+            return pose;
+
+        const uint32_t uIndex = m_flatIndices[_uNodeId];
+        pose.qRotation.x = m_rotations[0][uIndex];
+        pose.qRotation.y = m_rotations[1][uIndex];
+        pose.qRotation.z = m_rotations[2][uIndex];
+        pose.qRotation.w = m_rotations[3][uIndex];
+        pose.vTranslation.first = m_translations[0][uIndex];
+        pose.vTranslation.second = m_translations[1][uIndex];
+        pose.vTranslation.third = m_translations[2][uIndex];
+        pose.fScale = m_scales[uIndex];
+        return pose;
+    }
+
+
+    void SceneEvaluator::Evaluate() {
+        for (size_t uLevel = 0; uLevel + 1 < m_levelOffsets.size(); uLevel++) {
+            const size_t uBegin = m_levelOffsets[uLevel];
+            const size_t uEnd = m_levelOffsets[uLevel + 1];
+            const bool bRootLevel = uLevel == 0;
+
+            // nodes within one level are independent of each other
+            if (m_pThreadPool && uEnd - uBegin >= PARALLEL_LEVEL_THRESHOLD) {
+                m_pThreadPool->ParallelFor(uBegin, uEnd, PARALLEL_GRAIN, [&](size_t _uFirst, size_t _uLast) {
+                    _EvaluateRange(_uFirst, _uLast, bRootLevel);
+                });
+            }
+            else {
+                _EvaluateRange(uBegin, uEnd, bRootLevel);
+            }
+        }
+    }
+
+
+    Matrix3x4 SceneEvaluator::GetWorldTransform(uint32_t _uNodeId) const {
+        Matrix3x4 out;
+        if (!Contains(_uNodeId))
+            return out;
+
+        const uint32_t uIndex = m_flatIndices[_uNodeId];
+        for (int i = 0; i < 12; i++)
+            out.m[i / 4][i % 4] = m_worldTransforms[i][uIndex];
+        return out;
+    }
+
+
+    void SceneEvaluator::CopyWorldTransforms(Matrix3x4* _pOut) const {
+        for (size_t uIndex = 0; uIndex < m_nodeIds.size(); uIndex++) {
+            for (int i = 0; i < 12; i++)
+                _pOut[uIndex].m[i / 4][i % 4] = m_worldTransforms[i][uIndex];
+        }
+    }
+}
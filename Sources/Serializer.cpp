@@ -7,51 +7,161 @@
 #include <sstream>
 #include <iostream>
 
+#include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filtering_streambuf.hpp>
 #include <boost/iostreams/copy.hpp>
 #include <boost/iostreams/filter/zstd.hpp>
 
 namespace das2 {
 
-    void Serializer::_StreamUncompressed(std::ostream& _stream) {
-        m_model.buffer.Write(_stream);
-        _StreamUncompressedArray(m_model.meshes, _stream);
-        _StreamUncompressedArray(m_model.meshGroups, _stream);
-        _StreamUncompressedArray(m_model.nodes, _stream);
-        _StreamUncompressedArray(m_model.scenes, _stream);
-        _StreamUncompressedArray(m_model.skeletonJoints, _stream);
-        _StreamUncompressedArray(m_model.skeletons, _stream);
-        _StreamUncompressedArray(m_model.animations, _stream);
-        _StreamUncompressedArray(m_model.animationChannels, _stream);
-        _StreamUncompressedArray(m_model.phongMaterials, _stream);
-        _StreamUncompressedArray(m_model.pbrMaterials, _stream);
+    namespace {
+        // maps the header zstd level onto a compressor, other levels are written as is, just like Unserializer reads them
+        template <typename Chain>
+        void _PushCompressor(Chain& _chain, uint8_t _bZstdLevel) {
+            namespace bio = boost::iostreams;
+            if (_bZstdLevel == 9)
+                _chain.push(bio::zstd_compressor(bio::zstd_params(bio::zstd::best_compression)));
+            else if (_bZstdLevel == 1)
+                _chain.push(bio::zstd_compressor(bio::zstd_params(bio::zstd::default_compression)));
+            else if (_bZstdLevel == 255)
+                _chain.push(bio::zstd_compressor(bio::zstd_params(bio::zstd::best_speed)));
+        }
     }
 
 
-    void Serializer::_StreamCompressed() {
+    void Serializer::_StreamUncompressed(std::ostream& _stream, uint32_t _uBufferSize, const BufferWriter* _pfnWriteBuffer) {
+        {
+            StructureStatsScope scope(m_pStats, StructureIdentifier_Buffer, _stream);
+            if (_pfnWriteBuffer) {
+                const StructureIdentifier bStructure = StructureIdentifier_Buffer;
+                _stream.write(reinterpret_cast<const char*>(&bStructure), sizeof(StructureIdentifier));
+                _stream.write(reinterpret_cast<const char*>(&_uBufferSize), sizeof(uint32_t));
+                (*_pfnWriteBuffer)(_stream);
+            }
+            else m_model.buffer.Write(_stream);
+        }
+        _StreamUncompressedArray(m_model.meshes, StructureIdentifier_Mesh, _stream);
+        _StreamUncompressedArray(m_model.meshGroups, StructureIdentifier_MeshGroup, _stream);
+        _StreamUncompressedArray(m_model.nodes, StructureIdentifier_Node, _stream);
+        _StreamUncompressedArray(m_model.scenes, StructureIdentifier_Scene, _stream);
+        _StreamUncompressedArray(m_model.skeletonJoints, StructureIdentifier_SkeletonJoint, _stream);
+        _StreamUncompressedArray(m_model.skeletons, StructureIdentifier_Skeleton, _stream);
+        _StreamUncompressedArray(m_model.animations, StructureIdentifier_Animation, _stream);
+        _StreamUncompressedArray(m_model.animationChannels, StructureIdentifier_AnimationChannel, _stream);
+        _StreamUncompressedArray(m_model.phongMaterials, StructureIdentifier_MaterialPhong, _stream);
+        _StreamUncompressedArray(m_model.pbrMaterials, StructureIdentifier_MaterialPbr, _stream);
+    }
+
+
+    void Serializer::_StreamCompressed(std::ostream& _stream) {
         namespace bio = boost::iostreams;
 
         std::stringstream origin;
-        _StreamUncompressed(origin);
+        _StreamUncompressed(origin, 0, nullptr);
 
         bio::filtering_streambuf<bio::input> out;
+        _PushCompressor(out, m_model.header.bZstdLevel);
+        out.push(origin);
 
-        if (m_model.header.bZstdLevel == 9)
-            out.push(bio::zstd_compressor(bio::zstd_params(bio::zstd::best_compression)));
-        else if (m_model.header.bZstdLevel == 1)
-            out.push(bio::zstd_compressor(bio::zstd_params(bio::zstd::default_compression)));
-        else if (m_model.header.bZstdLevel == 255)
-            out.push(bio::zstd_compressor(bio::zstd_params(bio::zstd::best_speed)));
+        // writes to _stream happen inside of the compression loop and are subtracted afterwards
+        const double fIoSeconds = m_pStats ? m_pStats->arrPhases[StatisticsPhase_Io].fSeconds : 0.0;
+        StatsTimer timer(GetPhaseStats(m_pStats, StatisticsPhase_Compression));
+        bio::copy(out, _stream);
+        if (m_pStats)
+            m_pStats->arrPhases[StatisticsPhase_Compression].fSeconds -= m_pStats->arrPhases[StatisticsPhase_Io].fSeconds - fIoSeconds;
+    }
 
-        out.push(origin);
-        bio::copy(out, m_stream);
+
+    void Serializer::_StreamCompressed(std::ostream& _stream, uint32_t _uBufferSize, const BufferWriter& _fnWriteBuffer) {
+        namespace bio = boost::iostreams;
+
+        // the compressor does not report stream positions, with statistics a timed stream buffer in front of it provides
+        // them and measures compression including the writes to _stream, which are subtracted afterwards
+        bio::filtering_ostream compressed;
+        _PushCompressor(compressed, m_model.header.bZstdLevel);
+        compressed.push(_stream);
+
+        if (!m_pStats) {
+            _StreamUncompressed(compressed, _uBufferSize, &_fnWriteBuffer);
+            compressed.reset();
+            return;
+        }
+
+        const double fIoSeconds = m_pStats->arrPhases[StatisticsPhase_Io].fSeconds;
+        {
+            TimedStreamBuffer timedBuffer(compressed.rdbuf(), &m_pStats->arrPhases[StatisticsPhase_Compression], nullptr);
+            std::ostream stream(&timedBuffer);
+            _StreamUncompressed(stream, _uBufferSize, &_fnWriteBuffer);
+            stream.flush();
+            if (stream.bad())
+                _stream.setstate(std::ios_base::badbit);
+        }
+        {
+            StatsTimer timer(&m_pStats->arrPhases[StatisticsPhase_Compression]);
+            compressed.reset();
+        }
+        m_pStats->arrPhases[StatisticsPhase_Compression].fSeconds -= m_pStats->arrPhases[StatisticsPhase_Io].fSeconds - fIoSeconds;
+    }
+
+
+    void Serializer::_Serialize(uint32_t _uBufferSize, const BufferWriter* _pfnWriteBuffer) {
+        auto fnStream = [&](std::ostream& _stream) {
+            if (!m_model.header.bZstdLevel)
+                _StreamUncompressed(_stream, _uBufferSize, _pfnWriteBuffer);
+            else if (_pfnWriteBuffer)
+                _StreamCompressed(_stream, _uBufferSize, *_pfnWriteBuffer);
+            else _StreamCompressed(_stream);
+        };
+
+        if (!m_pStats) {
+            m_model.header.Write(m_stream);
+            fnStream(m_stream);
+            return;
+        }
+
+        // with statistics all writes go through a timed stream buffer, which separates I/O from serialization
+        std::ostream stream(nullptr);
+        {
+            TimedStreamBuffer timedBuffer(m_stream.rdbuf(), &m_pStats->arrPhases[StatisticsPhase_Io], &m_pStats->uBytesOut);
+            stream.rdbuf(&timedBuffer);
+
+            {
+                StatsTimer timer(&m_pStats->arrPhases[StatisticsPhase_Header]);
+                m_model.header.Write(stream);
+            }
+
+            fnStream(stream);
+
+            stream.flush();
+            stream.rdbuf(nullptr);
+        }
+
+        if (stream.bad())
+            m_stream.setstate(std::ios_base::badbit);
+
+        for (size_t i = 0; i < DAS2_STATISTICS_STRUCTURE_COUNT; i++)
+            m_pStats->uBytesIn += m_pStats->arrStructures[i].uBytes;
     }
 
 
     void Serializer::Serialize() {
-        m_model.header.Write(m_stream);
-        if (m_model.header.bZstdLevel)
-            _StreamCompressed();
-        else _StreamUncompressed(m_stream);
+        {
+            StatsTimer timer(GetPhaseStats(m_pStats, StatisticsPhase_Total));
+            _Serialize(0, nullptr);
+        }
+
+        if (m_pStats)
+            m_pStats->Publish();
+    }
+
+
+    void Serializer::Serialize(uint32_t _uBufferSize, const BufferWriter& _fnWriteBuffer) {
+        {
+            StatsTimer timer(GetPhaseStats(m_pStats, StatisticsPhase_Total));
+            _Serialize(_uBufferSize, &_fnWriteBuffer);
+        }
+
+        if (m_pStats)
+            m_pStats->Publish();
     }
 }
@@ -0,0 +1,214 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: SkeletonPalette.cpp - implementation of skinning matrix palette computation for skeletons
+// author: Karl-Mihkel Ott
+
+#include <sstream>
+#include <unordered_map>
+#include <das2/Exceptions.h>
+#include <das2/SkeletonPalette.h>
+
+#define PALETTE_INSTANCE_GRAIN 16
+
+namespace das2 {
+
+    SkeletonLayout::SkeletonLayout(const Model& _model, uint32_t _uSkeletonIndex) {
+        if (_uSkeletonIndex >= _model.skeletons.size()) {
+            std::stringstream ss;
+            ss << "das2::SkeletonLayout: invalid skeleton index " << _uSkeletonIndex;
+            throw HierarchyException(ss.str());
+        }
+
+        const Skeleton& skeleton = _model.skeletons[_uSkeletonIndex];
+        m_jointIds.assign(skeleton.joints.begin(), skeleton.joints.end());
+
+        std::unordered_map<uint32_t, uint32_t> localIndices;
+        localIndices.reserve(m_jointIds.size());
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_jointIds.size()); i++) {
+            if (m_jointIds[i] >= _model.skeletonJoints.size()) {
+                std::stringstream ss;
+                ss << "das2::SkeletonLayout: invalid joint id " << m_jointIds[i] << " in skeleton " << _uSkeletonIndex;
+                throw HierarchyException(ss.str());
+            }
+            localIndices[m_jointIds[i]] = i;
+        }
+
+        // resolve parents from children lists
+        std::vector<uint32_t> parents(m_jointIds.size(), static_cast<uint32_t>(-1));
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_jointIds.size()); i++) {
+            const SkeletonJoint& joint = _model.skeletonJoints[m_jointIds[i]];
+            for (auto it = joint.children.begin(); it != joint.children.end(); it++) {
+                auto localIt = localIndices.find(*it);
+                if (localIt == localIndices.end())
+                    continue;
+
+                if (parents[localIt->second] != static_cast<uint32_t>(-1)) {
+                    std::stringstream ss;
+                    ss << "das2::SkeletonLayout: joint " << *it << " has multiple parents in skeleton " << _uSkeletonIndex;
+                    throw HierarchyException(ss.str());
+                }
+                parents[localIt->second] = i;
+            }
+        }
+
+        // breadth first order starting from the root joints
+        std::vector<uint32_t> slots(m_jointIds.size(), static_cast<uint32_t>(-1));
+        m_order.reserve(m_jointIds.size());
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_jointIds.size()); i++) {
+            if (parents[i] == static_cast<uint32_t>(-1)) {
+                slots[i] = static_cast<uint32_t>(m_order.size());
+                m_order.push_back(i);
+            }
+        }
+
+        for (size_t uSlot = 0; uSlot < m_order.size(); uSlot++) {
+            const SkeletonJoint& joint = _model.skeletonJoints[m_jointIds[m_order[uSlot]]];
+            for (auto it = joint.children.begin(); it != joint.children.end(); it++) {
+                auto localIt = localIndices.find(*it);
+                if (localIt == localIndices.end() || slots[localIt->second] != static_cast<uint32_t>(-1))
+                    continue;
+
+                slots[localIt->second] = static_cast<uint32_t>(m_order.size());
+                m_order.push_back(localIt->second);
+            }
+        }
+
+        // joints that were not reached form a cycle
+        if (m_order.size() != m_jointIds.size()) {
+            std::stringstream ss;
+            ss << "das2::SkeletonLayout: skeleton " << _uSkeletonIndex << " contains a joint cycle";
+            throw HierarchyException(ss.str());
+        }
+
+        m_parentSlots.resize(m_order.size());
+        for (size_t uSlot = 0; uSlot < m_order.size(); uSlot++) {
+            const uint32_t uParent = parents[m_order[uSlot]];
+            m_parentSlots[uSlot] = uParent == static_cast<uint32_t>(-1) ? uParent : slots[uParent];
+        }
+
+        m_inverseBindMatrices.resize(m_jointIds.size());
+        m_restPose.resize(m_jointIds.size());
+        for (size_t i = 0; i < m_jointIds.size(); i++) {
+            const SkeletonJoint& joint = _model.skeletonJoints[m_jointIds[i]];
+            m_inverseBindMatrices[i] = ToMatrix3x4(joint.mInverseBindPos);
+            m_restPose[i] = LocalPose{ joint.qRotation, joint.vTranslation, joint.fScale };
+        }
+    }
+
+
+    namespace {
+
+        // Evaluates L::uWidth instances at once, each lane corresponds to one instance.
+        // _pWorld: scratch space of GetJointCount() * 12 * L::uWidth floats
+        template <typename L>
+        void _ComputeInstanceLanes(const SkeletonLayout& _layout, const LocalPose* _pPoses, const Matrix3x4* _pRootTransforms,
+                                   Matrix3x4* _pPalettes, float* _pWorld)
+        {
+            using V = typename L::Type;
+            const size_t uJointCount = _layout.GetJointCount();
+            const auto& order = _layout.GetEvaluationOrder();
+            const auto& parentSlots = _layout.GetParentSlots();
+            const auto& inverseBindMatrices = _layout.GetInverseBindMatrices();
+
+            alignas(16) float arrLanes[12][L::uWidth];
+
+            for (size_t uSlot = 0; uSlot < uJointCount; uSlot++) {
+                const uint32_t uJoint = order[uSlot];
+
+                // transpose poses of all lanes
+                for (size_t uLane = 0; uLane < L::uWidth; uLane++) {
+                    const LocalPose& pose = _pPoses[uLane * uJointCount + uJoint];
+                    arrLanes[0][uLane] = pose.qRotation.x;
+                    arrLanes[1][uLane] = pose.qRotation.y;
+                    arrLanes[2][uLane] = pose.qRotation.z;
+                    arrLanes[3][uLane] = pose.qRotation.w;
+                    arrLanes[4][uLane] = pose.vTranslation.first;
+                    arrLanes[5][uLane] = pose.vTranslation.second;
+                    arrLanes[6][uLane] = pose.vTranslation.third;
+                    arrLanes[7][uLane] = pose.fScale;
+                }
+
+                V rotation[4], translation[3];
+                for (int i = 0; i < 4; i++)
+                    rotation[i] = L::Load(arrLanes[i]);
+                for (int i = 0; i < 3; i++)
+                    translation[i] = L::Load(arrLanes[4 + i]);
+
+                V world[12];
+                ComposeTransformLanes<L>(rotation, translation, L::Load(arrLanes[7]), world);
+
+                if (parentSlots[uSlot] != static_cast<uint32_t>(-1)) {
+                    V parent[12];
+                    const float* pParent = _pWorld + parentSlots[uSlot] * 12 * L::uWidth;
+                    for (int i = 0; i < 12; i++)
+                        parent[i] = L::Load(pParent + i * L::uWidth);
+                    MultiplyLanes<L>(parent, world, world);
+                }
+                else if (_pRootTransforms) {
+                    V root[12];
+                    for (size_t uLane = 0; uLane < L::uWidth; uLane++) {
+                        for (int i = 0; i < 12; i++)
+                            arrLanes[i][uLane] = _pRootTransforms[uLane].m[i / 4][i % 4];
+                    }
+                    for (int i = 0; i < 12; i++)
+                        root[i] = L::Load(arrLanes[i]);
+                    MultiplyLanes<L>(root, world, world);
+                }
+
+                float* pWorld = _pWorld + uSlot * 12 * L::uWidth;
+                for (int i = 0; i < 12; i++)
+                    L::Store(pWorld + i * L::uWidth, world[i]);
+
+                // palette = world * inverse bind, the inverse bind matrix is shared by all lanes
+                V inverseBind[12], palette[12];
+                for (int i = 0; i < 12; i++)
+                    inverseBind[i] = L::Set(inverseBindMatrices[uJoint].m[i / 4][i % 4]);
+                MultiplyLanes<L>(world, inverseBind, palette);
+
+                for (int i = 0; i < 12; i++)
+                    L::Store(arrLanes[i], palette[i]);
+                for (size_t uLane = 0; uLane < L::uWidth; uLane++) {
+                    Matrix3x4& out = _pPalettes[uLane * uJointCount + uJoint];
+                    for (int i = 0; i < 12; i++)
+                        out.m[i / 4][i % 4] = arrLanes[i][uLane];
+                }
+            }
+        }
+
+
+        void _ComputeInstanceRange(const SkeletonLayout& _layout, const LocalPose* _pPoses, size_t _uBegin, size_t _uEnd,
+                                   Matrix3x4* _pPalettes, const Matrix3x4* _pRootTransforms)
+        {
+            const size_t uJointCount = _layout.GetJointCount();
+            std::vector<float> scratch(uJointCount * 12 * simd::Wide::uWidth);
+
+            size_t i = _uBegin;
+            for (; i + simd::Wide::uWidth <= _uEnd; i += simd::Wide::uWidth) {
+                _ComputeInstanceLanes<simd::Wide>(_layout, _pPoses + i * uJointCount, _pRootTransforms ? _pRootTransforms + i : nullptr,
+                                                  _pPalettes + i * uJointCount, scratch.data());
+            }
+
+            for (; i < _uEnd; i++) {
+                _ComputeInstanceLanes<simd::Scalar>(_layout, _pPoses + i * uJointCount, _pRootTransforms ? _pRootTransforms + i : nullptr,
+                                                    _pPalettes + i * uJointCount, scratch.data());
+            }
+        }
+    }
+
+
+    void ComputeJointPalettes(const SkeletonLayout& _layout, const LocalPose* _pPoses, size_t _uInstanceCount, Matrix3x4* _pPalettes,
+                              const Matrix3x4* _pRootTransforms, ThreadPool* _pThreadPool)
+    {
+        if (!_layout.GetJointCount() || !_uInstanceCount)
+            return;
+
+        if (_pThreadPool && _uInstanceCount > PALETTE_INSTANCE_GRAIN) {
+            _pThreadPool->ParallelFor(0, _uInstanceCount, PALETTE_INSTANCE_GRAIN, [&](size_t _uFirst, size_t _uLast) {
+                _ComputeInstanceRange(_layout, _pPoses, _uFirst, _uLast, _pPalettes, _pRootTransforms);
+            });
+        }
+        else {
+            _ComputeInstanceRange(_layout, _pPoses, 0, _uInstanceCount, _pPalettes, _pRootTransforms);
+        }
+    }
+}
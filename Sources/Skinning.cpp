@@ -0,0 +1,165 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: Skinning.cpp - implementation of CPU linear blend skinning kernel
+// author: Karl-Mihkel Ott
+
+#include <sstream>
+#include <das2/Exceptions.h>
+#include <das2/Skinning.h>
+
+// vertices per parallel task
+#define SKINNING_GRAIN 4096
+
+namespace das2 {
+
+    namespace {
+        // element offsets of consecutive vertices in interleaved streams
+        alignas(32) const uint32_t g_arrStride3[8] = { 0, 3, 6, 9, 12, 15, 18, 21 };
+        alignas(32) const uint32_t g_arrStride4[8] = { 0, 4, 8, 12, 16, 20, 24, 28 };
+
+        template <typename L>
+        inline void _SkinLanes(const SkinnedMeshView& _view, const float* _pPalette, size_t _uJointCount, size_t _uVertex,
+                               float* _pOutPositions, float* _pOutNormals)
+        {
+            using V = typename L::Type;
+            constexpr size_t uWidth = L::uWidth;
+            alignas(32) uint32_t arrOffsets[uWidth];
+
+            // blend joint matrices of each lane
+            V blended[12];
+            for (int i = 0; i < 12; i++)
+                blended[i] = L::Set(0.f);
+
+            for (uint32_t uSet = 0; uSet < _view.uJointSetCount; uSet++) {
+                const uint32_t* pJoints = _view.arrJointIndices[uSet] + _uVertex * DAS2_JOINTS_PER_SET;
+                const float* pWeights = _view.arrJointWeights[uSet] + _uVertex * DAS2_JOINTS_PER_SET;
+
+                for (uint32_t uInfluence = 0; uInfluence < DAS2_JOINTS_PER_SET; uInfluence++) {
+                    for (size_t i = 0; i < uWidth; i++) {
+                        const uint32_t uJoint = pJoints[i * DAS2_JOINTS_PER_SET + uInfluence];
+                        if (uJoint >= _uJointCount) {
+                            std::stringstream ss;
+                            ss << "das2::SkinVertices: vertex " << _uVertex + i << " references joint " << uJoint << " outside of the palette";
+                            throw BufferRangeException(ss.str());
+                        }
+                        arrOffsets[i] = uJoint * 12;
+                    }
+
+                    const V weight = L::Gather(pWeights + uInfluence, g_arrStride4);
+                    for (int i = 0; i < 12; i++)
+                        blended[i] = L::MulAdd(weight, L::Gather(_pPalette + i, arrOffsets), blended[i]);
+                }
+            }
+
+            alignas(32) float arrOut[3][uWidth];
+            const float* pPositions = _view.pPositions + _uVertex * 3;
+            const V x = L::Gather(pPositions, g_arrStride3);
+            const V y = L::Gather(pPositions + 1, g_arrStride3);
+            const V z = L::Gather(pPositions + 2, g_arrStride3);
+            for (int r = 0; r < 3; r++) {
+                const V out = L::MulAdd(blended[r * 4], x, L::MulAdd(blended[r * 4 + 1], y, L::MulAdd(blended[r * 4 + 2], z, blended[r * 4 + 3])));
+                L::Store(arrOut[r], out);
+            }
+
+            float* pOutPositions = _pOutPositions + _uVertex * 3;
+            for (size_t i = 0; i < uWidth; i++) {
+                pOutPositions[i * 3] = arrOut[0][i];
+                pOutPositions[i * 3 + 1] = arrOut[1][i];
+                pOutPositions[i * 3 + 2] = arrOut[2][i];
+            }
+
+            if (!_view.pNormals || !_pOutNormals)
+                return;
+
+            // das2 scales are uniform, thus the upper 3x3 part transforms normals up to their length
+            const float* pNormals = _view.pNormals + _uVertex * 3;
+            const V nx = L::Gather(pNormals, g_arrStride3);
+            const V ny = L::Gather(pNormals + 1, g_arrStride3);
+            const V nz = L::Gather(pNormals + 2, g_arrStride3);
+
+            V normal[3];
+            V fLengthSq = L::Set(0.f);
+            for (int r = 0; r < 3; r++) {
+                normal[r] = L::MulAdd(blended[r * 4], nx, L::MulAdd(blended[r * 4 + 1], ny, L::Mul(blended[r * 4 + 2], nz)));
+                fLengthSq = L::MulAdd(normal[r], normal[r], fLengthSq);
+            }
+
+            // zero length normals stay zero instead of turning into NaNs
+            const V fInvLength = L::Div(L::Set(1.f), L::Sqrt(L::Max(fLengthSq, L::Set(1e-30f))));
+            for (int r = 0; r < 3; r++)
+                L::Store(arrOut[r], L::Mul(normal[r], fInvLength));
+
+            float* pOutNormals = _pOutNormals + _uVertex * 3;
+            for (size_t i = 0; i < uWidth; i++) {
+                pOutNormals[i * 3] = arrOut[0][i];
+                pOutNormals[i * 3 + 1] = arrOut[1][i];
+                pOutNormals[i * 3 + 2] = arrOut[2][i];
+            }
+        }
+
+
+        void _SkinRange(const SkinnedMeshView& _view, const float* _pPalette, size_t _uJointCount, size_t _uBegin, size_t _uEnd,
+                        float* _pOutPositions, float* _pOutNormals)
+        {
+            size_t i = _uBegin;
+            for (; i + simd::Widest::uWidth <= _uEnd; i += simd::Widest::uWidth)
+                _SkinLanes<simd::Widest>(_view, _pPalette, _uJointCount, i, _pOutPositions, _pOutNormals);
+            for (; i < _uEnd; i++)
+                _SkinLanes<simd::Scalar>(_view, _pPalette, _uJointCount, i, _pOutPositions, _pOutNormals);
+        }
+
+
+        template <typename T>
+        inline const T* _GetStream(const Model& _model, uint32_t _uOffset, size_t _uCount, const char* _szName) {
+            if (static_cast<size_t>(_uOffset) + _uCount * sizeof(T) > _model.buffer.Size()) {
+                std::stringstream ss;
+                ss << "das2::MakeSkinnedMeshView: " << _szName << " stream at offset " << _uOffset << " exceeds the buffer size";
+                throw BufferRangeException(ss.str());
+            }
+
+            return _model.buffer.Get<T>(_uOffset);
+        }
+    }
+
+
+    SkinnedMeshView MakeSkinnedMeshView(const Model& _model, const Mesh& _mesh, size_t _uVertexCount, uint32_t _uJointSetCount, bool _bNormals) {
+        if (_uJointSetCount > DAS2_MAX_JOINT_SETS) {
+            std::stringstream ss;
+            ss << "das2::MakeSkinnedMeshView: at most " << DAS2_MAX_JOINT_SETS << " joint sets are supported, " << _uJointSetCount << " requested";
+            throw BufferRangeException(ss.str());
+        }
+
+        SkinnedMeshView view;
+        view.uVertexCount = _uVertexCount;
+        view.uJointSetCount = _uJointSetCount;
+        view.pPositions = _GetStream<float>(_model, _mesh.uPositionVertexBufferOffset, _uVertexCount * 3, "position");
+        if (_bNormals)
+            view.pNormals = _GetStream<float>(_model, _mesh.uVertexNormalBufferOffset, _uVertexCount * 3, "vertex normal");
+
+        for (uint32_t i = 0; i < _uJointSetCount; i++) {
+            view.arrJointIndices[i] = _GetStream<uint32_t>(_model, _mesh.arrSkeletalJointIndexBufferOffsets[i], _uVertexCount * DAS2_JOINTS_PER_SET,
+                                                           "joint index");
+            view.arrJointWeights[i] = _GetStream<float>(_model, _mesh.arrSkeletalJointWeightBufferOffsets[i], _uVertexCount * DAS2_JOINTS_PER_SET,
+                                                        "joint weight");
+        }
+
+        return view;
+    }
+
+
+    void SkinVertices(const SkinnedMeshView& _view, const Matrix3x4* _pPalette, size_t _uJointCount, float* _pOutPositions,
+                      float* _pOutNormals, ThreadPool* _pThreadPool)
+    {
+        static_assert(sizeof(Matrix3x4) == 12 * sizeof(float), "Matrix3x4 must consist of 12 tightly packed floats");
+        const float* pPalette = reinterpret_cast<const float*>(_pPalette);
+
+        if (_pThreadPool && _view.uVertexCount > SKINNING_GRAIN) {
+            _pThreadPool->ParallelFor(0, _view.uVertexCount, SKINNING_GRAIN, [&](size_t _uBegin, size_t _uEnd) {
+                _SkinRange(_view, pPalette, _uJointCount, _uBegin, _uEnd, _pOutPositions, _pOutNormals);
+            });
+        }
+        else {
+            _SkinRange(_view, pPalette, _uJointCount, 0, _view.uVertexCount, _pOutPositions, _pOutNormals);
+        }
+    }
+}
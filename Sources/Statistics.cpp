@@ -0,0 +1,269 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: Statistics.cpp - implementation of optional load and save statistics instrumentation
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <cstring>
+#include <das2/Statistics.h>
+
+namespace das2 {
+
+    namespace {
+        const char* g_arrPhaseNames[StatisticsPhase_Count] = {
+            "total", "header", "io", "compression", "structures", "buffer",
+            "triangulation", "normal_generation", "welding", "layout", "materials"
+        };
+
+        const char* g_arrStructureNames[DAS2_STATISTICS_STRUCTURE_COUNT] = {
+            "unknown", "buffer", "mesh", "morph_target", "mesh_group", "node", "scene",
+            "skeleton_joint", "skeleton", "animation", "animation_channel", "material_phong", "material_pbr"
+        };
+
+
+        inline double _Elapsed(std::chrono::steady_clock::time_point _start) {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+        }
+    }
+
+
+    void IoStats::Reset() {
+        std::fill(std::begin(arrPhases), std::end(arrPhases), PhaseStats());
+        std::fill(std::begin(arrStructures), std::end(arrStructures), StructureStats());
+        uBytesIn = 0;
+        uBytesOut = 0;
+    }
+
+
+    void IoStats::Export(const char* _szPrefix, const MetricSink& _fnSink) const {
+        const std::string sPrefix = _szPrefix;
+
+        // phases and structures that were never entered are skipped
+        for (size_t i = 0; i < StatisticsPhase_Count; i++) {
+            if (!arrPhases[i].uCount)
+                continue;
+            _fnSink(sPrefix + ".phase." + g_arrPhaseNames[i] + ".seconds", arrPhases[i].fSeconds);
+            _fnSink(sPrefix + ".phase." + g_arrPhaseNames[i] + ".count", static_cast<double>(arrPhases[i].uCount));
+        }
+
+        for (size_t i = 0; i < DAS2_STATISTICS_STRUCTURE_COUNT; i++) {
+            if (!arrStructures[i].uCount)
+                continue;
+            const std::string sName = sPrefix + ".structure." + g_arrStructureNames[i];
+            _fnSink(sName + ".count", static_cast<double>(arrStructures[i].uCount));
+            _fnSink(sName + ".bytes", static_cast<double>(arrStructures[i].uBytes));
+            _fnSink(sName + ".seconds", arrStructures[i].fSeconds);
+        }
+
+        _fnSink(sPrefix + ".bytes_in", static_cast<double>(uBytesIn));
+        _fnSink(sPrefix + ".bytes_out", static_cast<double>(uBytesOut));
+    }
+
+
+    void LoadStats::Reset() {
+        IoStats::Reset();
+        uAllocationCount = 0;
+        uAllocatedBytes = 0;
+        bAllocationsCounted = false;
+    }
+
+
+    void LoadStats::Export(const MetricSink& _fnSink) const {
+        IoStats::Export("das2.load", _fnSink);
+        if (!bAllocationsCounted)
+            return;
+
+        _fnSink("das2.load.allocations", static_cast<double>(uAllocationCount));
+        _fnSink("das2.load.allocated_bytes", static_cast<double>(uAllocatedBytes));
+    }
+
+
+    void SaveStats::Export(const MetricSink& _fnSink) const {
+        IoStats::Export("das2.save", _fnSink);
+    }
+
+
+    void StructureStatsScope::_Begin(std::istream& _stream) {
+        m_pInput = &_stream;
+        m_uStart = static_cast<std::streamoff>(_stream.tellg());
+        m_start = std::chrono::steady_clock::now();
+    }
+
+
+    void StructureStatsScope::_Begin(std::ostream& _stream) {
+        m_pOutput = &_stream;
+        m_uStart = static_cast<std::streamoff>(_stream.tellp());
+        m_start = std::chrono::steady_clock::now();
+    }
+
+
+    void StructureStatsScope::_End() {
+        if (static_cast<size_t>(m_bIdentifier) >= DAS2_STATISTICS_STRUCTURE_COUNT)
+            return;
+
+        const double fSeconds = _Elapsed(m_start);
+        const std::streamoff uEnd = m_pInput ? static_cast<std::streamoff>(m_pInput->tellg()) : static_cast<std::streamoff>(m_pOutput->tellp());
+
+        StructureStats& structure = m_pStats->arrStructures[m_bIdentifier];
+        structure.uCount++;
+        structure.fSeconds += fSeconds;
+        if (m_uStart >= 0 && uEnd >= m_uStart)
+            structure.uBytes += static_cast<uint64_t>(uEnd - m_uStart);
+
+        m_pStats->arrPhases[m_bIdentifier == StructureIdentifier_Buffer ? StatisticsPhase_Buffer : StatisticsPhase_Structures].fSeconds += fSeconds;
+    }
+
+
+    TimedStreamBuffer::TimedStreamBuffer(std::streambuf* _pTarget, PhaseStats* _pPhase, uint64_t* _pBytes, size_t _uBufferSize) :
+        m_pTarget(_pTarget),
+        m_pPhase(_pPhase),
+        m_pBytes(_pBytes),
+        m_buffer(_uBufferSize)
+    {
+        setg(m_buffer.data(), m_buffer.data(), m_buffer.data());
+        setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+    }
+
+
+    TimedStreamBuffer::~TimedStreamBuffer() {
+        _Flush();
+    }
+
+
+    bool TimedStreamBuffer::_Flush() {
+        const std::streamsize uPending = pptr() - pbase();
+        if (!uPending)
+            return true;
+
+        StatsTimer timer(m_pPhase);
+        const std::streamsize uWritten = m_pTarget->sputn(pbase(), uPending);
+        m_uPosition += static_cast<uint64_t>(std::max<std::streamsize>(uWritten, 0));
+        if (m_pBytes)
+            *m_pBytes += static_cast<uint64_t>(std::max<std::streamsize>(uWritten, 0));
+
+        setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+        return uWritten == uPending;
+    }
+
+
+    TimedStreamBuffer::int_type TimedStreamBuffer::underflow() {
+        if (gptr() < egptr())
+            return traits_type::to_int_type(*gptr());
+
+        m_uPosition += static_cast<uint64_t>(egptr() - eback());
+        std::streamsize uRead = 0;
+        {
+            StatsTimer timer(m_pPhase);
+            uRead = m_pTarget->sgetn(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+        }
+
+        if (m_pBytes)
+            *m_pBytes += static_cast<uint64_t>(std::max<std::streamsize>(uRead, 0));
+        setg(m_buffer.data(), m_buffer.data(), m_buffer.data() + std::max<std::streamsize>(uRead, 0));
+        return uRead > 0 ? traits_type::to_int_type(*gptr()) : traits_type::eof();
+    }
+
+
+    std::streamsize TimedStreamBuffer::xsgetn(char* _pData, std::streamsize _uCount) {
+        // large reads, such as the buffer blob, bypass the intermediate buffer
+        const std::streamsize uBuffered = std::min<std::streamsize>(egptr() - gptr(), _uCount);
+        if (uBuffered > 0) {
+            std::memcpy(_pData, gptr(), static_cast<size_t>(uBuffered));
+            gbump(static_cast<int>(uBuffered));
+        }
+        if (uBuffered == _uCount)
+            return uBuffered;
+
+        if (_uCount - uBuffered < static_cast<std::streamsize>(m_buffer.size()))
+            return uBuffered + std::streambuf::xsgetn(_pData + uBuffered, _uCount - uBuffered);
+
+        m_uPosition += static_cast<uint64_t>(egptr() - eback());
+        setg(m_buffer.data(), m_buffer.data(), m_buffer.data());
+
+        std::streamsize uRead = 0;
+        {
+            StatsTimer timer(m_pPhase);
+            uRead = m_pTarget->sgetn(_pData + uBuffered, _uCount - uBuffered);
+        }
+
+        m_uPosition += static_cast<uint64_t>(std::max<std::streamsize>(uRead, 0));
+        if (m_pBytes)
+            *m_pBytes += static_cast<uint64_t>(std::max<std::streamsize>(uRead, 0));
+        return uBuffered + std::max<std::streamsize>(uRead, 0);
+    }
+
+
+    TimedStreamBuffer::int_type TimedStreamBuffer::overflow(int_type _ch) {
+        if (!_Flush())
+            return traits_type::eof();
+
+        if (!traits_type::eq_int_type(_ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(_ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(_ch);
+    }
+
+
+    std::streamsize TimedStreamBuffer::xsputn(const char* _pData, std::streamsize _uCount) {
+        if (_uCount < static_cast<std::streamsize>(m_buffer.size()))
+            return std::streambuf::xsputn(_pData, _uCount);
+
+        if (!_Flush())
+            return 0;
+
+        std::streamsize uWritten = 0;
+        {
+            StatsTimer timer(m_pPhase);
+            uWritten = m_pTarget->sputn(_pData, _uCount);
+        }
+
+        m_uPosition += static_cast<uint64_t>(std::max<std::streamsize>(uWritten, 0));
+        if (m_pBytes)
+            *m_pBytes += static_cast<uint64_t>(std::max<std::streamsize>(uWritten, 0));
+        return uWritten;
+    }
+
+
+    int TimedStreamBuffer::sync() {
+        if (!_Flush())
+            return -1;
+
+        StatsTimer timer(m_pPhase);
+        return m_pTarget->pubsync();
+    }
+
+
+    TimedStreamBuffer::pos_type TimedStreamBuffer::seekoff(off_type _iOffset, std::ios_base::seekdir _eDir, std::ios_base::openmode _eMode) {
+        if (_eDir != std::ios_base::cur)
+            return pos_type(off_type(-1));
+
+        if (!(_eMode & std::ios_base::in)) {
+            if (_iOffset != 0)
+                return pos_type(off_type(-1));
+            return pos_type(static_cast<off_type>(m_uPosition + static_cast<uint64_t>(pptr() - pbase())));
+        }
+
+        const off_type iCurrent = static_cast<off_type>(m_uPosition + static_cast<uint64_t>(gptr() - eback()));
+        if (_iOffset == 0)
+            return pos_type(iCurrent);
+        if (iCurrent + _iOffset < 0)
+            return pos_type(off_type(-1));
+
+        // seeks within the get area only move it, all others are forwarded to the target, which is at the end of the get area
+        if (_iOffset > 0 && _iOffset <= egptr() - gptr()) {
+            gbump(static_cast<int>(_iOffset));
+            return pos_type(iCurrent + _iOffset);
+        }
+
+        {
+            StatsTimer timer(m_pPhase);
+            if (m_pTarget->pubseekoff(_iOffset - (egptr() - gptr()), std::ios_base::cur, std::ios_base::in) == pos_type(off_type(-1)))
+                return pos_type(off_type(-1));
+        }
+
+        m_uPosition = static_cast<uint64_t>(iCurrent + _iOffset);
+        setg(m_buffer.data(), m_buffer.data(), m_buffer.data());
+        return pos_type(iCurrent + _iOffset);
+    }
+}
@@ -0,0 +1,140 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: ThreadPool.cpp - implementation of a simple worker thread pool used by parallel das2 algorithms
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <das2/ThreadPool.h>
+
+namespace das2 {
+
+    ThreadPool::ThreadPool(uint32_t _uThreadCount) {
+        if (!_uThreadCount)
+            _uThreadCount = std::max(1u, std::thread::hardware_concurrency());
+
+        m_workers.reserve(_uThreadCount);
+        for (uint32_t i = 0; i < _uThreadCount; i++)
+            m_workers.emplace_back(&ThreadPool::_WorkerLoop, this);
+    }
+
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_bStop = true;
+        }
+        m_cvTask.notify_all();
+
+        for (auto it = m_workers.begin(); it != m_workers.end(); it++)
+            it->join();
+    }
+
+
+    void ThreadPool::_WorkerLoop() {
+        while (true) {
+            std::function<void()> fnTask;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cvTask.wait(lock, [this]() { return m_bStop || !m_tasks.empty(); });
+                if (m_tasks.empty())
+                    return;
+
+                fnTask = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+
+            fnTask();
+        }
+    }
+
+
+    std::future<void> ThreadPool::Submit(std::function<void()> _fnTask) {
+        auto pTask = std::make_shared<std::packaged_task<void()>>(std::move(_fnTask));
+        std::future<void> future = pTask->get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.emplace_back([pTask]() { (*pTask)(); });
+        }
+        m_cvTask.notify_one();
+        return future;
+    }
+
+
+    void ThreadPool::ParallelFor(size_t _uBegin, size_t _uEnd, size_t _uGrain, const std::function<void(size_t, size_t)>& _fnBody) {
+        if (_uEnd <= _uBegin)
+            return;
+
+        if (!_uGrain)
+            _uGrain = 1;
+
+        const size_t uChunkCount = (_uEnd - _uBegin + _uGrain - 1) / _uGrain;
+        if (uChunkCount == 1) {
+            _fnBody(_uBegin, _uEnd);
+            return;
+        }
+
+        struct _SharedState {
+            std::atomic<size_t> uNextChunk{0};
+            std::mutex mutex;
+            std::condition_variable cvDone;
+            std::exception_ptr pException;
+            size_t uRunningHelpers = 0;
+            bool bClosed = false;       // set once the caller has drained the range, late helpers return immediately
+        };
+
+        auto pState = std::make_shared<_SharedState>();
+        auto fnDrain = [=, &_fnBody]() {
+            size_t uChunk;
+            while ((uChunk = pState->uNextChunk.fetch_add(1)) < uChunkCount) {
+                const size_t uFirst = _uBegin + uChunk * _uGrain;
+                const size_t uLast = std::min(_uEnd, uFirst + _uGrain);
+                try {
+                    _fnBody(uFirst, uLast);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(pState->mutex);
+                    if (!pState->pException)
+                        pState->pException = std::current_exception();
+                }
+            }
+        };
+
+        auto fnHelper = [=]() {
+            {
+                std::lock_guard<std::mutex> lock(pState->mutex);
+                if (pState->bClosed)
+                    return;
+                pState->uRunningHelpers++;
+            }
+
+            fnDrain();
+
+            std::lock_guard<std::mutex> lock(pState->mutex);
+            if (!--pState->uRunningHelpers)
+                pState->cvDone.notify_all();
+        };
+
+        // Helpers, which are still queued once the caller has claimed every chunk, only touch the shared state and
+        // return without calling _fnBody. Helpers, which did start, are waited for, thus _fnBody and everything else on
+        // the caller's stack is not used after this call returns.
+        const size_t uHelperCount = std::min<size_t>(m_workers.size(), uChunkCount - 1);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (size_t i = 0; i < uHelperCount; i++)
+                m_tasks.emplace_back(fnHelper);
+        }
+        m_cvTask.notify_all();
+
+        fnDrain();
+
+        std::unique_lock<std::mutex> lock(pState->mutex);
+        pState->bClosed = true;
+        pState->cvDone.wait(lock, [&]() { return !pState->uRunningHelpers; });
+
+        if (pState->pException)
+            std::rethrow_exception(pState->pException);
+    }
+}
@@ -6,6 +6,7 @@
 #include <sstream>
 
 #include <das2/Exceptions.h>
+#include <das2/MemoryResource.h>
 #include <das2/Unserializer.h>
 
 #include <boost/iostreams/filtering_streambuf.hpp>
@@ -14,11 +15,13 @@
 
 namespace das2 {
 
-    Unserializer::Unserializer(std::istream& _stream) :
-        m_stream(_stream) {}
+    Unserializer::Unserializer(std::istream& _stream, std::pmr::memory_resource* _pResource, LoadStats* _pStats) :
+        m_stream(_stream),
+        m_model(_pResource),
+        m_pStats(_pStats) {}
 
 
-    void Unserializer::_ReadCompressed() {
+    void Unserializer::_ReadCompressed(std::istream& _stream) {
         namespace bio = boost::iostreams;
 
         bio::filtering_streambuf<bio::input> in;
@@ -29,9 +32,16 @@ namespace das2 {
         else
             in.push(bio::zstd_decompressor(bio::zstd::best_speed));
 
-        in.push(m_stream);
         std::stringstream ss;
-        bio::copy(in, ss);
+        {
+            // I/O of the source stream happens inside of the decompression loop and is subtracted afterwards
+            const double fIoSeconds = m_pStats ? m_pStats->arrPhases[StatisticsPhase_Io].fSeconds : 0.0;
+            StatsTimer timer(GetPhaseStats(m_pStats, StatisticsPhase_Compression));
+            in.push(_stream);
+            bio::copy(in, ss);
+            if (m_pStats)
+                m_pStats->arrPhases[StatisticsPhase_Compression].fSeconds -= m_pStats->arrPhases[StatisticsPhase_Io].fSeconds - fIoSeconds;
+        }
 
         _ReadUncompressed(ss);
     }
@@ -42,6 +52,7 @@ namespace das2 {
         bool bBufferRead = false;
         while (!_stream.eof() && _stream.peek() != -1) {
             StructureIdentifier bIdentifier = static_cast<StructureIdentifier>(_stream.peek());
+            StructureStatsScope scope(m_pStats, bIdentifier, _stream);
             switch (bIdentifier) {
                 case StructureIdentifier_Buffer:
                     if (bBufferRead)
@@ -109,13 +120,50 @@ namespace das2 {
     }
 
 
-    void Unserializer::Unserialize() {
-        // read header
-        m_model.header.Read(m_stream);
+    void Unserializer::_Unserialize() {
+        if (!m_pStats) {
+            m_model.header.Read(m_stream);
+            if (m_model.header.bZstdLevel != 0)
+                _ReadCompressed(m_stream);
+            else _ReadUncompressed(m_stream);
+            return;
+        }
+
+        // with statistics all reads go through a timed stream buffer, which separates I/O from parsing
+        TimedStreamBuffer timedBuffer(m_stream.rdbuf(), &m_pStats->arrPhases[StatisticsPhase_Io], &m_pStats->uBytesIn);
+        std::istream stream(&timedBuffer);
+
+        {
+            StatsTimer timer(&m_pStats->arrPhases[StatisticsPhase_Header]);
+            m_model.header.Read(stream);
+        }
 
-        // check if zlib compression is used
         if (m_model.header.bZstdLevel != 0)
-            _ReadCompressed();
-        else _ReadUncompressed(m_stream);
+            _ReadCompressed(stream);
+        else _ReadUncompressed(stream);
+
+        for (size_t i = 0; i < DAS2_STATISTICS_STRUCTURE_COUNT; i++)
+            m_pStats->uBytesOut += m_pStats->arrStructures[i].uBytes;
+    }
+
+
+    void Unserializer::Unserialize() {
+        CountingMemoryResource* pCounting = m_pStats ? dynamic_cast<CountingMemoryResource*>(m_model.GetMemoryResource()) : nullptr;
+        const uint64_t uAllocationCount = pCounting ? pCounting->GetAllocationCount() : 0;
+        const uint64_t uAllocatedBytes = pCounting ? pCounting->GetAllocatedBytes() : 0;
+
+        {
+            StatsTimer timer(GetPhaseStats(m_pStats, StatisticsPhase_Total));
+            _Unserialize();
+        }
+
+        if (pCounting) {
+            m_pStats->uAllocationCount += pCounting->GetAllocationCount() - uAllocationCount;
+            m_pStats->uAllocatedBytes += pCounting->GetAllocatedBytes() - uAllocatedBytes;
+            m_pStats->bAllocationsCounted = true;
+        }
+
+        if (m_pStats)
+            m_pStats->Publish();
     }
-}
\ No newline at end of file
+}
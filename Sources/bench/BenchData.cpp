@@ -0,0 +1,96 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: BenchData.cpp - implementation of deterministic benchmark inputs
+// author: Karl-Mihkel Ott
+
+#include <cstdio>
+#include <das2/bench/Benchmark.h>
+
+namespace das2 {
+    namespace bench {
+
+        std::string GenerateObjText(size_t _uTargetSize, uint32_t _uGroupCount) {
+            std::string sText;
+            sText.reserve(_uTargetSize + 4096);
+
+            // a fixed linear congruential generator keeps the input identical across platforms and runs
+            uint32_t uState = 0x9e3779b9u;
+            auto fnRandom = [&uState]() {
+                uState = uState * 1664525u + 1013904223u;
+                return static_cast<float>(uState >> 8) / static_cast<float>(1u << 24);
+            };
+
+            // every group is a jittered grid, even groups carry normals and odd groups are smoothed by the converter
+            const size_t uGroupSize = _uTargetSize / (_uGroupCount ? _uGroupCount : 1) + 1;
+            uint64_t uVertexCount = 0;
+            uint64_t uNormalCount = 0;
+            char szLine[256];
+            for (uint32_t uGroup = 0; sText.size() < _uTargetSize; uGroup++) {
+                const bool bNormals = uGroup % 2 == 0;
+                std::snprintf(szLine, sizeof(szLine), "g group%u\nusemtl material%u\ns %d\n", uGroup, uGroup % 8, bNormals ? 0 : 1);
+                sText += szLine;
+
+                // roughly 150 bytes of text per grid vertex
+                uint32_t uSide = 2;
+                while (static_cast<size_t>(uSide + 1) * (uSide + 1) * 150 < uGroupSize)
+                    uSide++;
+
+                const uint64_t uFirst = uVertexCount + 1;
+                const uint64_t uFirstNormal = uNormalCount + 1;
+                for (uint32_t y = 0; y < uSide; y++) {
+                    for (uint32_t x = 0; x < uSide; x++) {
+                        std::snprintf(szLine, sizeof(szLine), "v %.6f %.6f %.6f\nvt %.6f %.6f\n", static_cast<float>(x) + fnRandom() * 0.1f,
+                                      static_cast<float>(y) + fnRandom() * 0.1f, fnRandom(), static_cast<float>(x) / uSide, static_cast<float>(y) / uSide);
+                        sText += szLine;
+                        if (bNormals) {
+                            std::snprintf(szLine, sizeof(szLine), "vn %.6f %.6f 1.000000\n", fnRandom() * 0.1f, fnRandom() * 0.1f);
+                            sText += szLine;
+                        }
+                    }
+                }
+                uVertexCount += static_cast<uint64_t>(uSide) * uSide;
+                if (bNormals)
+                    uNormalCount += static_cast<uint64_t>(uSide) * uSide;
+
+                // quads, with every eighth cell split into two triangles
+                for (uint32_t y = 0; y + 1 < uSide; y++) {
+                    for (uint32_t x = 0; x + 1 < uSide; x++) {
+                        const uint64_t arrCorners[4] = {
+                            uFirst + y * uSide + x, uFirst + y * uSide + x + 1,
+                            uFirst + (y + 1) * uSide + x + 1, uFirst + (y + 1) * uSide + x
+                        };
+
+                        auto fnCorner = [&](uint64_t _uIndex) {
+                            if (bNormals)
+                                std::snprintf(szLine, sizeof(szLine), " %llu/%llu/%llu", static_cast<unsigned long long>(_uIndex),
+                                              static_cast<unsigned long long>(_uIndex),
+                                              static_cast<unsigned long long>(_uIndex - uFirst + uFirstNormal));
+                            else std::snprintf(szLine, sizeof(szLine), " %llu/%llu", static_cast<unsigned long long>(_uIndex),
+                                               static_cast<unsigned long long>(_uIndex));
+                            sText += szLine;
+                        };
+
+                        if ((x + y) % 8 == 0) {
+                            sText += 'f';
+                            fnCorner(arrCorners[0]);
+                            fnCorner(arrCorners[1]);
+                            fnCorner(arrCorners[2]);
+                            sText += "\nf";
+                            fnCorner(arrCorners[0]);
+                            fnCorner(arrCorners[2]);
+                            fnCorner(arrCorners[3]);
+                        }
+                        else {
+                            sText += 'f';
+                            for (size_t i = 0; i < 4; i++)
+                                fnCorner(arrCorners[i]);
+                        }
+                        sText += '\n';
+                    }
+                }
+            }
+
+            return sText;
+        }
+    }
+}
@@ -0,0 +1,316 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: Benchmark.cpp - implementation of the das2 benchmark harness
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <new>
+
+#if defined(_WIN32)
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+#include <das2/bench/Benchmark.h>
+
+namespace das2 {
+    namespace bench {
+        namespace {
+            std::atomic<uint64_t> g_uAllocationCount(0);
+            std::atomic<uint64_t> g_uAllocatedBytes(0);
+
+
+            void* _Allocate(std::size_t _uSize) {
+                g_uAllocationCount.fetch_add(1, std::memory_order_relaxed);
+                g_uAllocatedBytes.fetch_add(_uSize, std::memory_order_relaxed);
+                return std::malloc(_uSize ? _uSize : 1);
+            }
+
+
+            void* _AllocateAligned(std::size_t _uSize, std::size_t _uAlignment) {
+                g_uAllocationCount.fetch_add(1, std::memory_order_relaxed);
+                g_uAllocatedBytes.fetch_add(_uSize, std::memory_order_relaxed);
+#if defined(_WIN32)
+                return _aligned_malloc(_uSize ? _uSize : 1, _uAlignment);
+#else
+                void* pMemory = nullptr;
+                if (posix_memalign(&pMemory, std::max(_uAlignment, sizeof(void*)), _uSize ? _uSize : 1))
+                    return nullptr;
+                return pMemory;
+#endif
+            }
+
+
+            void _FreeAligned(void* _pMemory) {
+#if defined(_WIN32)
+                _aligned_free(_pMemory);
+#else
+                std::free(_pMemory);
+#endif
+            }
+
+
+            void _WriteJsonString(std::ostream& _stream, const std::string& _str) {
+                _stream << '"';
+                for (auto it = _str.begin(); it != _str.end(); it++) {
+                    if (*it == '"' || *it == '\\')
+                        _stream << '\\';
+                    _stream << *it;
+                }
+                _stream << '"';
+            }
+        }
+
+
+        uint64_t GetAllocationCount() {
+            return g_uAllocationCount.load(std::memory_order_relaxed);
+        }
+
+
+        uint64_t GetAllocatedBytes() {
+            return g_uAllocatedBytes.load(std::memory_order_relaxed);
+        }
+
+
+        bool ResetPeakRss() {
+#if defined(__linux__)
+            // writing 5 resets VmHWM to the current resident set size, supported since Linux 4.0
+            std::ofstream stream("/proc/self/clear_refs");
+            return static_cast<bool>(stream << '5' << std::flush);
+#else
+            return false;
+#endif
+        }
+
+
+        uint64_t GetPeakRss() {
+#if defined(__linux__)
+            // ru_maxrss cannot be reset, VmHWM follows ResetPeakRss()
+            std::ifstream status("/proc/self/status");
+            std::string sLine;
+            while (std::getline(status, sLine)) {
+                if (sLine.compare(0, 6, "VmHWM:"))
+                    continue;
+                return std::strtoull(sLine.c_str() + 6, nullptr, 10) * 1024;
+            }
+#endif
+#if defined(_WIN32)
+            PROCESS_MEMORY_COUNTERS counters = {};
+            if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+                return static_cast<uint64_t>(counters.PeakWorkingSetSize);
+            return 0;
+#else
+            struct rusage usage = {};
+            if (getrusage(RUSAGE_SELF, &usage))
+                return 0;
+    #if defined(__APPLE__)
+            return static_cast<uint64_t>(usage.ru_maxrss);
+    #else
+            return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+    #endif
+#endif
+        }
+
+
+        void BenchmarkContext::Measure(uint64_t _uBytes, uint64_t _uItems, const std::function<void()>& _fnBody) {
+            using Clock = std::chrono::steady_clock;
+            _fnBody();
+
+            const uint64_t uAllocations = GetAllocationCount();
+            const uint64_t uAllocatedBytes = GetAllocatedBytes();
+            const Clock::time_point start = Clock::now();
+
+            uint64_t uIterations = 0;
+            double fSeconds = 0.0;
+            do {
+                _fnBody();
+                uIterations++;
+                fSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+            } while (fSeconds < m_settings.fMinTime || uIterations < m_settings.uMinIterations);
+
+            m_result.uIterations = uIterations;
+            m_result.fSeconds = fSeconds;
+            m_result.uBytes = _uBytes;
+            m_result.uItems = _uItems;
+            m_result.fAllocations = static_cast<double>(GetAllocationCount() - uAllocations) / static_cast<double>(uIterations);
+            m_result.fAllocatedBytes = static_cast<double>(GetAllocatedBytes() - uAllocatedBytes) / static_cast<double>(uIterations);
+        }
+
+
+        void BenchmarkRegistry::Add(const std::string& _sName, BenchmarkFunction _fnBenchmark) {
+            m_benchmarks.emplace_back(_sName, std::move(_fnBenchmark));
+        }
+
+
+        std::vector<BenchmarkResult> BenchmarkRegistry::Run(const BenchmarkSettings& _settings, const std::string& _sFilter, std::ostream& _log) const {
+            std::vector<BenchmarkResult> results;
+            for (auto it = m_benchmarks.begin(); it != m_benchmarks.end(); it++) {
+                if (it->first.find(_sFilter) == std::string::npos)
+                    continue;
+
+                _log << "Running " << it->first << "..." << std::endl;
+                BenchmarkResult result;
+                result.sName = it->first;
+                BenchmarkContext context(_settings, result);
+                ResetPeakRss();
+                it->second(context);
+                result.uPeakRss = GetPeakRss();
+                results.push_back(std::move(result));
+            }
+
+            return results;
+        }
+
+
+        void WriteTable(std::ostream& _stream, const std::vector<BenchmarkResult>& _results) {
+            _stream << std::left << std::setw(44) << "Benchmark" << std::right << std::setw(12) << "Iterations" << std::setw(14) << "ms/iter"
+                    << std::setw(12) << "MB/s" << std::setw(14) << "items/s" << std::setw(14) << "allocs/iter" << std::setw(14) << "peak RSS MB" << '\n';
+
+            for (auto it = _results.begin(); it != _results.end(); it++) {
+                _stream << std::left << std::setw(44) << it->sName << std::right << std::setw(12) << it->uIterations
+                        << std::fixed << std::setprecision(3) << std::setw(14) << it->GetSecondsPerIteration() * 1e3
+                        << std::setprecision(1) << std::setw(12) << it->GetMegabytesPerSecond()
+                        << std::setprecision(0) << std::setw(14) << it->GetItemsPerSecond()
+                        << std::setprecision(1) << std::setw(14) << it->fAllocations
+                        << std::setw(14) << static_cast<double>(it->uPeakRss) / 1e6 << '\n';
+            }
+            _stream << std::defaultfloat;
+        }
+
+
+        void WriteJson(std::ostream& _stream, const BenchmarkSettings& _settings, const std::vector<BenchmarkResult>& _results) {
+            _stream << "{\n  \"scale\": " << _settings.uScale << ",\n  \"min_time\": " << _settings.fMinTime
+                    << ",\n  \"threads\": " << _settings.uThreadCount << ",\n  \"benchmarks\": [";
+
+            _stream << std::setprecision(9);
+            for (auto it = _results.begin(); it != _results.end(); it++) {
+                _stream << (it == _results.begin() ? "\n" : ",\n") << "    { \"name\": ";
+                _WriteJsonString(_stream, it->sName);
+                _stream << ", \"iterations\": " << it->uIterations
+                        << ", \"seconds_per_iteration\": " << it->GetSecondsPerIteration()
+                        << ", \"bytes_per_iteration\": " << it->uBytes
+                        << ", \"items_per_iteration\": " << it->uItems
+                        << ", \"mb_per_second\": " << it->GetMegabytesPerSecond()
+                        << ", \"items_per_second\": " << it->GetItemsPerSecond()
+                        << ", \"allocations_per_iteration\": " << it->fAllocations
+                        << ", \"allocated_bytes_per_iteration\": " << it->fAllocatedBytes
+                        << ", \"peak_rss_bytes\": " << it->uPeakRss << " }";
+            }
+            _stream << "\n  ]\n}\n";
+        }
+
+
+        MemoryStreamBuffer::MemoryStreamBuffer(const char* _pData, size_t _uSize) {
+            char* pData = const_cast<char*>(_pData);
+            setg(pData, pData, pData + _uSize);
+        }
+
+
+        MemoryStreamBuffer::pos_type MemoryStreamBuffer::seekoff(off_type _iOffset, std::ios_base::seekdir _dir, std::ios_base::openmode _mode) {
+            if (!(_mode & std::ios_base::in))
+                return pos_type(off_type(-1));
+
+            off_type iBase = 0;
+            if (_dir == std::ios_base::cur)
+                iBase = gptr() - eback();
+            else if (_dir == std::ios_base::end)
+                iBase = egptr() - eback();
+
+            const off_type iPosition = iBase + _iOffset;
+            if (iPosition < 0 || iPosition > egptr() - eback())
+                return pos_type(off_type(-1));
+
+            setg(eback(), eback() + iPosition, egptr());
+            return pos_type(iPosition);
+        }
+
+
+        MemoryStreamBuffer::pos_type MemoryStreamBuffer::seekpos(pos_type _uPosition, std::ios_base::openmode _mode) {
+            return seekoff(off_type(_uPosition), std::ios_base::beg, _mode);
+        }
+    }
+}
+
+
+// global allocation functions are replaced to count heap allocations of everything the benchmarks run
+void* operator new(std::size_t _uSize) {
+    void* pMemory = das2::bench::_Allocate(_uSize);
+    if (!pMemory)
+        throw std::bad_alloc();
+    return pMemory;
+}
+
+
+void* operator new[](std::size_t _uSize) {
+    return operator new(_uSize);
+}
+
+
+void* operator new(std::size_t _uSize, const std::nothrow_t&) noexcept {
+    return das2::bench::_Allocate(_uSize);
+}
+
+
+void* operator new[](std::size_t _uSize, const std::nothrow_t&) noexcept {
+    return das2::bench::_Allocate(_uSize);
+}
+
+
+void* operator new(std::size_t _uSize, std::align_val_t _alignment) {
+    void* pMemory = das2::bench::_AllocateAligned(_uSize, static_cast<std::size_t>(_alignment));
+    if (!pMemory)
+        throw std::bad_alloc();
+    return pMemory;
+}
+
+
+void* operator new[](std::size_t _uSize, std::align_val_t _alignment) {
+    return operator new(_uSize, _alignment);
+}
+
+
+void operator delete(void* _pMemory) noexcept {
+    std::free(_pMemory);
+}
+
+
+void operator delete[](void* _pMemory) noexcept {
+    std::free(_pMemory);
+}
+
+
+void operator delete(void* _pMemory, std::size_t) noexcept {
+    std::free(_pMemory);
+}
+
+
+void operator delete[](void* _pMemory, std::size_t) noexcept {
+    std::free(_pMemory);
+}
+
+
+void operator delete(void* _pMemory, std::align_val_t) noexcept {
+    das2::bench::_FreeAligned(_pMemory);
+}
+
+
+void operator delete[](void* _pMemory, std::align_val_t) noexcept {
+    das2::bench::_FreeAligned(_pMemory);
+}
+
+
+void operator delete(void* _pMemory, std::size_t, std::align_val_t) noexcept {
+    das2::bench::_FreeAligned(_pMemory);
+}
+
+
+void operator delete[](void* _pMemory, std::size_t, std::align_val_t) noexcept {
+    das2::bench::_FreeAligned(_pMemory);
+}
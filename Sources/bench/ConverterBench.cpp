@@ -0,0 +1,153 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: ConverterBench.cpp - benchmarks of Wavefront OBJ to das2 conversion stages
+// author: Karl-Mihkel Ott
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <das2/ThreadPool.h>
+#include <das2/bench/Benchmark.h>
+#include <das2/converters/obj/DasConverter.h>
+#include <das2/converters/obj/NormalGenerator.h>
+#include <das2/converters/obj/StreamingConverter.h>
+#include <das2/converters/obj/Triangulator.h>
+#include <das2/converters/obj/Unserializer.h>
+#include <das2/converters/obj/VertexWelder.h>
+
+#define BENCH_CONVERTER_OBJ_SIZE (16 << 20)
+#define BENCH_CONVERTER_GROUP_COUNT 64
+#define BENCH_STREAMING_BUDGET (64 << 20)
+
+namespace das2 {
+    namespace bench {
+
+        namespace {
+            volatile uint64_t g_uSink = 0;
+
+            // discards everything written to it, keeps output costs out of conversion benchmarks
+            class _NullStreamBuffer : public std::streambuf {
+                protected:
+                    int_type overflow(int_type _ch) override {
+                        return traits_type::not_eof(_ch);
+                    }
+
+                    std::streamsize xsputn(const char*, std::streamsize _uCount) override {
+                        return _uCount;
+                    }
+            };
+
+
+            obj::Object _ParseObject(const std::string& _sText) {
+                MemoryStreamBuffer buffer(_sText.data(), _sText.size());
+                std::istream stream(&buffer);
+                obj::Unserializer unserializer(stream);
+                return unserializer.Get();
+            }
+
+
+            uint64_t _CountCorners(const obj::Object& _obj) {
+                uint64_t uCorners = 0;
+                for (auto it = _obj.groups.begin(); it != _obj.groups.end(); it++)
+                    uCorners += it->elements.corners.size();
+                return uCorners;
+            }
+
+
+            uint64_t _CountTriangles(const std::vector<std::vector<obj::Triangle>>& _triangles) {
+                uint64_t uTriangles = 0;
+                for (auto it = _triangles.begin(); it != _triangles.end(); it++)
+                    uTriangles += it->size();
+                return uTriangles;
+            }
+        }
+
+
+        void RegisterConverterBenchmarks(BenchmarkRegistry& _registry) {
+            // stage benchmarks report corners or triangles per second, whole conversions report obj text throughput
+            _registry.Add("DasConverter/Triangulate", [](BenchmarkContext& _context) {
+                const obj::Object obj = _ParseObject(GenerateObjText(BENCH_CONVERTER_OBJ_SIZE * _context.GetSettings().uScale, BENCH_CONVERTER_GROUP_COUNT));
+                std::vector<std::vector<obj::Triangle>> triangles;
+                _context.Measure(0, _CountCorners(obj), [&obj, &triangles]() {
+                    obj::TriangulateGroups(obj, triangles);
+                });
+            });
+
+            _registry.Add("DasConverter/GenerateNormals", [](BenchmarkContext& _context) {
+                const obj::Object obj = _ParseObject(GenerateObjText(BENCH_CONVERTER_OBJ_SIZE * _context.GetSettings().uScale, BENCH_CONVERTER_GROUP_COUNT));
+                std::vector<std::vector<obj::Triangle>> triangles;
+                obj::TriangulateGroups(obj, triangles);
+
+                std::vector<TRS::Vector3<float>> normals;
+                _context.Measure(0, _CountTriangles(triangles), [&obj, &triangles, &normals]() {
+                    for (auto it = triangles.begin(); it != triangles.end(); it++)
+                        obj::GenerateNormals(obj.vertices, *it, obj::NormalGeneratorSettings(), normals);
+                });
+            });
+
+            _registry.Add("DasConverter/Weld", [](BenchmarkContext& _context) {
+                const obj::Object obj = _ParseObject(GenerateObjText(BENCH_CONVERTER_OBJ_SIZE * _context.GetSettings().uScale, BENCH_CONVERTER_GROUP_COUNT));
+                std::vector<std::vector<obj::Triangle>> triangles;
+                obj::TriangulateGroups(obj, triangles);
+
+                _context.Measure(0, _CountTriangles(triangles) * 3, [&obj, &triangles]() {
+                    const auto& positions = obj.vertices.geometricVertices;
+                    const auto& uvs = obj.vertices.textureVertices;
+                    const auto& normals = obj.vertices.vertexNormals;
+
+                    uint64_t uVertices = 0;
+                    for (auto groupIt = triangles.begin(); groupIt != triangles.end(); groupIt++) {
+                        obj::VertexWelder welder(groupIt->size() * 3, true);
+                        for (auto it = groupIt->begin(); it != groupIt->end(); it++) {
+                            for (auto vIt = it->begin(); vIt != it->end(); vIt++) {
+                                obj::UnifiedVertex vertex;
+                                vertex.positionVertex = TRS::Vector3<float>(positions[vIt->x][0], positions[vIt->x][1], positions[vIt->x][2]);
+                                if (vIt->y != static_cast<uint32_t>(-1))
+                                    vertex.textureVertex = TRS::Vector2<float>(uvs[vIt->y][0], uvs[vIt->y][1]);
+                                if (vIt->z != static_cast<uint32_t>(-1))
+                                    vertex.normalVertex = normals[vIt->z];
+                                welder.Weld(vertex);
+                            }
+                        }
+                        uVertices += welder.GetVertexCount();
+                    }
+                    g_uSink = uVertices;
+                });
+            });
+
+            _registry.Add("DasConverter/Convert", [](BenchmarkContext& _context) {
+                const std::string sText = GenerateObjText(BENCH_CONVERTER_OBJ_SIZE * _context.GetSettings().uScale, BENCH_CONVERTER_GROUP_COUNT);
+                const obj::Object obj = _ParseObject(sText);
+                _context.Measure(sText.size(), _CountCorners(obj), [&obj]() {
+                    g_uSink = obj::DasConverter(obj).GetModel().buffer.Size();
+                });
+            });
+
+            _registry.Add("DasConverter/ConvertParallel", [](BenchmarkContext& _context) {
+                const std::string sText = GenerateObjText(BENCH_CONVERTER_OBJ_SIZE * _context.GetSettings().uScale, BENCH_CONVERTER_GROUP_COUNT);
+                const obj::Object obj = _ParseObject(sText);
+                ThreadPool pool(_context.GetSettings().uThreadCount);
+                _context.Measure(sText.size(), _CountCorners(obj), [&obj, &pool]() {
+                    g_uSink = obj::DasConverter(obj, "", "", 0, &pool).GetModel().buffer.Size();
+                });
+            });
+
+            _registry.Add("StreamingConverter/Convert", [](BenchmarkContext& _context) {
+                const std::string sText = GenerateObjText(BENCH_CONVERTER_OBJ_SIZE * _context.GetSettings().uScale, BENCH_CONVERTER_GROUP_COUNT);
+                ThreadPool pool(_context.GetSettings().uThreadCount);
+                obj::StreamingConverterSettings settings;
+                settings.uMemoryBudget = BENCH_STREAMING_BUDGET;
+
+                _context.Measure(sText.size(), 0, [&sText, &pool, &settings]() {
+                    MemoryStreamBuffer inputBuffer(sText.data(), sText.size());
+                    std::istream input(&inputBuffer);
+                    _NullStreamBuffer outputBuffer;
+                    std::ostream output(&outputBuffer);
+                    obj::StreamingConverter(input, output, settings, &pool).Convert();
+                });
+            });
+        }
+    }
+}
@@ -0,0 +1,96 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: Main.cpp - entry point of the das2 benchmark suite
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <das2/bench/Benchmark.h>
+
+namespace {
+    void _PrintUsage() {
+        std::cout << "Usage: das2_bench [options]\n"
+                  << "  --filter <text>     run only benchmarks whose name contains <text>\n"
+                  << "  --min-time <sec>    minimum measured time per benchmark (default 0.5)\n"
+                  << "  --scale <n>         input size multiplier (default 1)\n"
+                  << "  --threads <n>       worker threads for parallel benchmarks (default: hardware concurrency)\n"
+                  << "  --json <file>       write machine-readable results to <file>, '-' for stdout\n"
+                  << "  --list              list benchmarks and exit\n";
+    }
+}
+
+
+int main(int argc, char* argv[]) {
+    das2::bench::BenchmarkSettings settings;
+    std::string sFilter;
+    std::string sJsonPath;
+    bool bList = false;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            const bool bHasValue = i + 1 < argc;
+            if (!std::strcmp(argv[i], "--filter") && bHasValue)
+                sFilter = argv[++i];
+            else if (!std::strcmp(argv[i], "--min-time") && bHasValue)
+                settings.fMinTime = std::stod(argv[++i]);
+            else if (!std::strcmp(argv[i], "--scale") && bHasValue)
+                settings.uScale = static_cast<uint32_t>(std::max(1, std::stoi(argv[++i])));
+            else if (!std::strcmp(argv[i], "--threads") && bHasValue)
+                settings.uThreadCount = static_cast<uint32_t>(std::max(0, std::stoi(argv[++i])));
+            else if (!std::strcmp(argv[i], "--json") && bHasValue)
+                sJsonPath = argv[++i];
+            else if (!std::strcmp(argv[i], "--list"))
+                bList = true;
+            else {
+                _PrintUsage();
+                return std::strcmp(argv[i], "--help") ? 1 : 0;
+            }
+        }
+    }
+    catch (const std::invalid_argument&) {
+        _PrintUsage();
+        return 1;
+    }
+    catch (const std::out_of_range&) {
+        _PrintUsage();
+        return 1;
+    }
+
+    das2::bench::BenchmarkRegistry registry;
+    das2::bench::RegisterSerializationBenchmarks(registry);
+    das2::bench::RegisterStringBenchmarks(registry);
+#ifdef DAS2_BENCH_WAVEFRONT_OBJ
+    das2::bench::RegisterObjBenchmarks(registry);
+    das2::bench::RegisterConverterBenchmarks(registry);
+#endif
+
+    if (bList) {
+        for (auto it = registry.GetBenchmarks().begin(); it != registry.GetBenchmarks().end(); it++)
+            std::cout << it->first << '\n';
+        return 0;
+    }
+
+    // progress goes to stderr, so that "--json -" produces clean output
+    const std::vector<das2::bench::BenchmarkResult> results = registry.Run(settings, sFilter, std::cerr);
+    if (sJsonPath == "-") {
+        das2::bench::WriteJson(std::cout, settings, results);
+        return 0;
+    }
+
+    das2::bench::WriteTable(std::cout, results);
+    if (!sJsonPath.empty()) {
+        std::ofstream stream(sJsonPath);
+        if (!stream) {
+            std::cerr << "Cannot open '" << sJsonPath << "' for writing\n";
+            return 1;
+        }
+        das2::bench::WriteJson(stream, settings, results);
+    }
+
+    return 0;
+}
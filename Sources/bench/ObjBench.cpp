@@ -0,0 +1,78 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: ObjBench.cpp - benchmarks of Wavefront OBJ tokenizing and parsing
+// author: Karl-Mihkel Ott
+
+#include <istream>
+#include <memory>
+#include <string>
+
+#include <das2/ThreadPool.h>
+#include <das2/bench/Benchmark.h>
+#include <das2/converters/obj/Tokenizer.h>
+#include <das2/converters/obj/Unserializer.h>
+
+#define BENCH_OBJ_SIZE (32 << 20)
+#define BENCH_OBJ_GROUP_COUNT 64
+#define BENCH_OBJ_STREAM_BLOCK_SIZE (4 << 20)
+
+namespace das2 {
+    namespace bench {
+
+        namespace {
+            volatile uint64_t g_uSink = 0;
+        }
+
+
+        void RegisterObjBenchmarks(BenchmarkRegistry& _registry) {
+            _registry.Add("Obj/Tokenize", [](BenchmarkContext& _context) {
+                const std::string sText = GenerateObjText(BENCH_OBJ_SIZE * _context.GetSettings().uScale, BENCH_OBJ_GROUP_COUNT);
+                _context.Measure(sText.size(), 0, [&sText]() {
+                    obj::Tokenizer tokenizer(sText.data(), sText.data() + sText.size());
+                    uint64_t uTokens = 0;
+                    while (tokenizer.NextLine()) {
+                        for (std::string_view sToken = tokenizer.NextToken(); !sToken.empty(); sToken = tokenizer.NextToken())
+                            uTokens++;
+                    }
+                    g_uSink = uTokens;
+                });
+            });
+
+            _registry.Add("Obj/Parse", [](BenchmarkContext& _context) {
+                const std::string sText = GenerateObjText(BENCH_OBJ_SIZE * _context.GetSettings().uScale, BENCH_OBJ_GROUP_COUNT);
+                _context.Measure(sText.size(), 0, [&sText]() {
+                    MemoryStreamBuffer buffer(sText.data(), sText.size());
+                    std::istream stream(&buffer);
+                    obj::Unserializer unserializer(stream);
+                    g_uSink = unserializer.Get().groups.size();
+                });
+            });
+
+            _registry.Add("Obj/ParseParallel", [](BenchmarkContext& _context) {
+                const std::string sText = GenerateObjText(BENCH_OBJ_SIZE * _context.GetSettings().uScale, BENCH_OBJ_GROUP_COUNT);
+                ThreadPool pool(_context.GetSettings().uThreadCount);
+                _context.Measure(sText.size(), 0, [&sText, &pool]() {
+                    MemoryStreamBuffer buffer(sText.data(), sText.size());
+                    std::istream stream(&buffer);
+                    obj::Unserializer unserializer(stream, &pool);
+                    g_uSink = unserializer.Get().groups.size();
+                });
+            });
+
+            _registry.Add("Obj/ParseStreaming", [](BenchmarkContext& _context) {
+                const std::string sText = GenerateObjText(BENCH_OBJ_SIZE * _context.GetSettings().uScale, BENCH_OBJ_GROUP_COUNT);
+                ThreadPool pool(_context.GetSettings().uThreadCount);
+                _context.Measure(sText.size(), 0, [&sText, &pool]() {
+                    MemoryStreamBuffer buffer(sText.data(), sText.size());
+                    std::istream stream(&buffer);
+                    obj::StreamingUnserializer unserializer(stream, BENCH_OBJ_STREAM_BLOCK_SIZE, &pool);
+                    obj::StreamedBlock block;
+                    uint64_t uGroups = 0;
+                    while (unserializer.Next(block))
+                        uGroups += block.groups.size();
+                    g_uSink = uGroups;
+                });
+            });
+        }
+    }
+}
@@ -0,0 +1,118 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: SerializationBench.cpp - benchmarks of das2 serialization and unserialization
+// author: Karl-Mihkel Ott
+
+#include <cmath>
+#include <sstream>
+#include <string>
+
+#include <das2/DasStructures.h>
+#include <das2/Serializer.h>
+#include <das2/Unserializer.h>
+#include <das2/bench/Benchmark.h>
+
+#define BENCH_MODEL_BUFFER_SIZE (16 << 20)
+#define BENCH_MODEL_MESH_COUNT 1024
+
+namespace das2 {
+    namespace bench {
+
+        namespace {
+            // one mesh group and node per mesh, vertex data is a smooth surface, so that compression levels behave realistically
+            Model _CreateModel(uint32_t _uBufferSize, uint32_t _uMeshCount) {
+                Model model;
+                model.header.Initialize();
+                model.header.szAuthorName = "das2_bench";
+                model.buffer.Initialize();
+
+                const uint32_t uMeshSize = _uBufferSize / _uMeshCount;
+                const uint32_t uVertexCount = uMeshSize / (2 * sizeof(TRS::Vector3<float>) + 3 * sizeof(uint32_t));
+                std::vector<TRS::Vector3<float>> positions(uVertexCount);
+                std::vector<uint32_t> indices(uVertexCount * 3);
+
+                model.scenes.emplace_back();
+                model.scenes.back().Initialize();
+                for (uint32_t i = 0; i < _uMeshCount; i++) {
+                    for (uint32_t j = 0; j < uVertexCount; j++) {
+                        const float fPhase = static_cast<float>(i) + static_cast<float>(j) * 0.01f;
+                        positions[j] = TRS::Vector3<float>(std::sin(fPhase), std::cos(fPhase), static_cast<float>(j % 64));
+                        indices[j * 3] = j;
+                        indices[j * 3 + 1] = (j + 1) % uVertexCount;
+                        indices[j * 3 + 2] = (j + 2) % uVertexCount;
+                    }
+
+                    model.meshes.emplace_back();
+                    Mesh& mesh = model.meshes.back();
+                    mesh.Initialize();
+                    mesh.arrUVBufferOffsets.fill(0);
+                    mesh.arrSkeletalJointIndexBufferOffsets.fill(0);
+                    mesh.arrSkeletalJointWeightBufferOffsets.fill(0);
+                    mesh.uPositionVertexBufferOffset = model.buffer.PushRange(positions.data(), positions.size());
+                    mesh.uVertexNormalBufferOffset = model.buffer.PushRange(positions.data(), positions.size());
+                    mesh.uIndexBufferOffset = model.buffer.PushRange(indices.data(), indices.size());
+                    mesh.uDrawCount = static_cast<uint32_t>(indices.size());
+
+                    const std::string sName = "mesh_" + std::to_string(i);
+                    model.meshGroups.emplace_back();
+                    model.meshGroups.back().Initialize();
+                    model.meshGroups.back().szName = sName;
+                    model.meshGroups.back().meshes.push_back(i);
+                    model.nodes.emplace_back();
+                    model.nodes.back().Initialize();
+                    model.nodes.back().szName = sName;
+                    model.nodes.back().uMeshGroupId = i;
+                    model.scenes.back().rootNodes.push_back(i);
+                }
+
+                return model;
+            }
+
+
+            void _RegisterLevel(BenchmarkRegistry& _registry, uint8_t _bLevel) {
+                const std::string sSuffix = "/zstd" + std::to_string(_bLevel);
+
+                _registry.Add("Serializer/Serialize" + sSuffix, [_bLevel](BenchmarkContext& _context) {
+                    Model model = _CreateModel(BENCH_MODEL_BUFFER_SIZE * _context.GetSettings().uScale, BENCH_MODEL_MESH_COUNT);
+
+                    // the uncompressed stream size is reported, so that levels are comparable
+                    std::stringstream reference;
+                    Serializer(reference, model).Serialize();
+                    model.header.bZstdLevel = _bLevel;
+
+                    _context.Measure(reference.str().size(), model.meshes.size(), [&model]() {
+                        std::stringstream stream;
+                        Serializer(stream, model).Serialize();
+                    });
+                });
+
+                _registry.Add("Unserializer/Unserialize" + sSuffix, [_bLevel](BenchmarkContext& _context) {
+                    Model model = _CreateModel(BENCH_MODEL_BUFFER_SIZE * _context.GetSettings().uScale, BENCH_MODEL_MESH_COUNT);
+
+                    std::stringstream reference;
+                    Serializer(reference, model).Serialize();
+                    const uint64_t uUncompressedSize = reference.str().size();
+
+                    model.header.bZstdLevel = _bLevel;
+                    std::stringstream serialized;
+                    Serializer(serialized, model).Serialize();
+                    const std::string sData = serialized.str();
+
+                    _context.Measure(uUncompressedSize, model.meshes.size(), [&sData]() {
+                        MemoryStreamBuffer buffer(sData.data(), sData.size());
+                        std::istream stream(&buffer);
+                        Unserializer unserializer(stream);
+                        unserializer.Unserialize();
+                    });
+                });
+            }
+        }
+
+
+        void RegisterSerializationBenchmarks(BenchmarkRegistry& _registry) {
+            const uint8_t arrLevels[] = { 0, 255, 1, 9 };
+            for (uint8_t bLevel : arrLevels)
+                _RegisterLevel(_registry, bLevel);
+        }
+    }
+}
@@ -0,0 +1,83 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: StringBench.cpp - benchmarks of BinString construction and hashing
+// author: Karl-Mihkel Ott
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <das2/DasStructures.h>
+#include <das2/bench/Benchmark.h>
+
+#define BENCH_STRING_COUNT 16384
+
+namespace das2 {
+    namespace bench {
+
+        namespace {
+            // node and material like names between 8 and 64 characters
+            std::vector<std::string> _CreateNames(size_t _uCount) {
+                std::vector<std::string> names;
+                names.reserve(_uCount);
+                for (size_t i = 0; i < _uCount; i++) {
+                    std::string sName = "Armature|Bone_" + std::to_string(i);
+                    sName.resize(8 + (i * 7) % 57, static_cast<char>('a' + i % 26));
+                    names.push_back(std::move(sName));
+                }
+                return names;
+            }
+
+
+            uint64_t _TotalLength(const std::vector<std::string>& _names) {
+                uint64_t uLength = 0;
+                for (auto it = _names.begin(); it != _names.end(); it++)
+                    uLength += it->size();
+                return uLength;
+            }
+
+
+            // keeps results observable, so that the measured work is not optimized away
+            volatile uint64_t g_uSink = 0;
+        }
+
+
+        void RegisterStringBenchmarks(BenchmarkRegistry& _registry) {
+            _registry.Add("BinString/Construct", [](BenchmarkContext& _context) {
+                const std::vector<std::string> names = _CreateNames(BENCH_STRING_COUNT * _context.GetSettings().uScale);
+                _context.Measure(_TotalLength(names), names.size(), [&names]() {
+                    uint64_t uSum = 0;
+                    for (auto it = names.begin(); it != names.end(); it++)
+                        uSum += BinString(*it).Hash();
+                    g_uSink = uSum;
+                });
+            });
+
+            _registry.Add("BinString/Copy", [](BenchmarkContext& _context) {
+                const std::vector<std::string> names = _CreateNames(BENCH_STRING_COUNT * _context.GetSettings().uScale);
+                const std::vector<BinString> strings(names.begin(), names.end());
+                _context.Measure(_TotalLength(names), strings.size(), [&strings]() {
+                    uint64_t uSum = 0;
+                    for (auto it = strings.begin(); it != strings.end(); it++)
+                        uSum += BinString(*it).Length();
+                    g_uSink = uSum;
+                });
+            });
+
+            _registry.Add("BinString/MapLookup", [](BenchmarkContext& _context) {
+                const std::vector<std::string> names = _CreateNames(BENCH_STRING_COUNT * _context.GetSettings().uScale);
+                const std::vector<BinString> strings(names.begin(), names.end());
+                std::unordered_map<BinString, uint32_t> map;
+                for (size_t i = 0; i < strings.size(); i++)
+                    map.emplace(strings[i], static_cast<uint32_t>(i));
+
+                _context.Measure(_TotalLength(names), strings.size(), [&strings, &map]() {
+                    uint64_t uSum = 0;
+                    for (auto it = strings.begin(); it != strings.end(); it++)
+                        uSum += map.find(*it)->second;
+                    g_uSink = uSum;
+                });
+            });
+        }
+    }
+}
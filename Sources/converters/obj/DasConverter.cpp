@@ -3,216 +3,287 @@
 // file: DasConverter.h - implementation file for obj file convertion class
 // author: Karl-Mihkel Ott
 
-#include <queue>
-#include <unordered_set>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <das2/converters/obj/DasConverter.h>
 #include <das2/Exceptions.h>
+#include <das2/MemoryResource.h>
 
 #define PI 3.14159f
 
 namespace das2 {
     namespace obj {
 
-        DasConverter::DasConverter(const Object& _obj, const BinString& _szAuthorName, const BinString& _szComment, uint8_t _bZLibLevel) :
-            IConverter(_szAuthorName, _szComment, _bZLibLevel),
-            m_obj(_obj)
+        DasConverter::DasConverter(const Object& _obj, const BinString& _szAuthorName, const BinString& _szComment, uint8_t _bZLibLevel,
+                                   ThreadPool* _pThreadPool, LoadStats* _pStats, std::pmr::memory_resource* _pResource) :
+            IConverter(_szAuthorName, _szComment, _bZLibLevel, _pResource),
+            m_obj(_obj),
+            m_pThreadPool(_pThreadPool),
+            m_pStats(_pStats)
         {
             _CreateModel();
         }
 
 
-        void DasConverter::_TriangulizeFace(const std::vector<TRS::Point3D<uint32_t>>& _face) {
-            std::deque<TRS::Point3D<uint32_t>> qFaces;
-            // add vertices to queue
-            for (auto it = _face.begin(); it != _face.end(); it++)
-                qFaces.push_back(*it);
-
-            // initially pick 3 vertices 1, 2, 3
-            // remove vertex 2 from the set and recursively perform the same algorithm until the amount of vertices divides by 3
-            size_t uRemainingVertices = _face.size();
-            while (!qFaces.empty()) {
-                m_triangulizedFaces.emplace_back();
-                m_triangulizedFaces.back()[0] = qFaces.front();
-                qFaces.pop_front();
-                m_triangulizedFaces.back()[1] = qFaces.front();
-                qFaces.pop_back();
-                m_triangulizedFaces.back()[2] = qFaces.front();
-                qFaces.pop_back();
-                
-                if (!qFaces.empty()) {
-                    qFaces.push_front(m_triangulizedFaces.back()[2]);
-                    qFaces.push_back(m_triangulizedFaces.back()[0]);
-                }
-            }
+        DasConverter::DasConverter(Object&& _obj, const BinString& _szAuthorName, const BinString& _szComment, uint8_t _bZLibLevel,
+                                   ThreadPool* _pThreadPool, LoadStats* _pStats, std::pmr::memory_resource* _pResource) :
+            IConverter(_szAuthorName, _szComment, _bZLibLevel, _pResource),
+            m_obj(std::move(_obj)),
+            m_pThreadPool(_pThreadPool),
+            m_pStats(_pStats)
+        {
+            _CreateModel();
         }
 
 
-        void DasConverter::_SmoothenNormals(size_t _uTriangulizationOffset) {
-            // key: vertex position index
-            // value vector: all normal ids
-            std::unordered_map<uint32_t, std::vector<uint32_t>> matchingVertexMap;
-            for (auto faceIt = m_triangulizedFaces.begin() + _uTriangulizationOffset; faceIt != m_triangulizedFaces.end(); faceIt++) {
-                for (auto vIt = faceIt->begin(); vIt != faceIt->end(); vIt++) {
-                    matchingVertexMap[vIt->x].push_back(vIt->z);
-                }
+        std::pair<MaterialType, uint32_t> AppendMaterial(Model& _model, const BinString& _szName, const Material& _material) {
+            if (_material.bPbr) {
+                MaterialPbr pbr;
+                pbr.Initialize();
+                pbr.szName = _szName;
+                pbr.vAlbedoFactor = TRS::Vector4<float>(_material.vKd.first, _material.vKd.second, _material.vKd.third, _material.fD);
+                pbr.vEmissiveFactor = TRS::Vector4<float>(_material.vEmissive.first, _material.vEmissive.second, _material.vEmissive.third, 1.f);
+                pbr.fRoughness = _material.fPr;
+                pbr.fMetallic = _material.fPm;
+                pbr.szAlbedoMapUri = _material.szMapKdUri;
+                pbr.szEmissionMapUri = _material.szEmissionMapUri;
+                pbr.szRoughnessMapUri = _material.szMapPrUri;
+                pbr.szMetallicMapUri = _material.szMapPmUri;
+
+                _model.pbrMaterials.push_back(std::move(pbr));
+                return std::make_pair(MaterialType_Pbr, static_cast<uint32_t>(_model.pbrMaterials.size() - 1));
             }
 
-            // substitude normals
-            for (auto mapIt = matchingVertexMap.begin(); mapIt != matchingVertexMap.end(); mapIt++) {
-                TRS::Vector3<float> meanNormal;
-                for (auto matchIt = mapIt->second.begin(); matchIt != mapIt->second.end(); matchIt++) {
-                    if (*matchIt != static_cast<uint32_t>(-1))
-                        meanNormal += m_obj.vertices.vertexNormals[*matchIt];
-                    else {
-                        throw das2::ConvertionLogicException("Wavefront obj: Cannot use smooth shading for faces that have no normals");
-                    }
-                }
-                meanNormal.Normalise();
-
-                for (auto matchIt = mapIt->second.begin(); matchIt != mapIt->second.end(); matchIt++) {
-                    m_obj.vertices.vertexNormals[*matchIt] = meanNormal;
-                }
-            }
+            MaterialPhong phong;
+            phong.Initialize();
+            phong.szName = _szName;
+            phong.vDiffuse = TRS::Vector4<float>(_material.vKd.first, _material.vKd.second, _material.vKd.third, _material.fD);
+            phong.vSpecular = TRS::Vector4<float>(_material.vKs.first, _material.vKs.second, _material.vKs.third, 1.f);
+            phong.vEmission = TRS::Vector4<float>(_material.vEmissive.first, _material.vEmissive.second, _material.vEmissive.third, 1.f);
+            phong.szDiffuseMapUri = _material.szMapKdUri;
+            phong.szSpecularMapUri = _material.szMapKsUri;
+            phong.szEmissionMapUri = _material.szEmissionMapUri;
+
+            _model.phongMaterials.push_back(std::move(phong));
+            return std::make_pair(MaterialType_Phong, static_cast<uint32_t>(_model.phongMaterials.size() - 1));
         }
 
 
-        void DasConverter::_GenerateVertexNormals(const std::pair<size_t, size_t>& _draw) {
-            m_reindexedNormals.reserve(m_reindexedNormals.size() + _draw.second * 3);
-
-            for (size_t i = _draw.first; i < _draw.second; i++) {
-                TRS::Vector3<float> v1= {
-                    m_obj.vertices.geometricVertices[m_triangulizedFaces[i][0].x][0],
-                    m_obj.vertices.geometricVertices[m_triangulizedFaces[i][0].x][1],
-                    m_obj.vertices.geometricVertices[m_triangulizedFaces[i][0].x][2],
-                };
-
-                TRS::Vector3<float> v2 = {
-                    m_obj.vertices.geometricVertices[m_triangulizedFaces[i][1].x][0],
-                    m_obj.vertices.geometricVertices[m_triangulizedFaces[i][1].x][1],
-                    m_obj.vertices.geometricVertices[m_triangulizedFaces[i][1].x][2],
-                };
-
-                TRS::Vector3<float> v3 = {
-                    m_obj.vertices.geometricVertices[m_triangulizedFaces[i][2].x][0],
-                    m_obj.vertices.geometricVertices[m_triangulizedFaces[i][2].x][1],
-                    m_obj.vertices.geometricVertices[m_triangulizedFaces[i][2].x][2],
-                };
-
-                auto normal = TRS::Vector3<float>::Cross(v2 - v1, v3 - v1);
-                normal.Normalise();
-                m_reindexedNormals.emplace_back(normal);
-                m_reindexedNormals.emplace_back(normal);
-                m_reindexedNormals.emplace_back(normal);
+        TRS::Vector3<float> DasConverter::_ComputeFaceNormal(const Triangle& _triangle) const {
+            TRS::Vector3<float> arrVertices[3];
+            for (size_t i = 0; i < 3; i++) {
+                const auto& position = m_obj.vertices.geometricVertices[_triangle[i].x];
+                arrVertices[i] = TRS::Vector3<float>(position[0], position[1], position[2]);
             }
+
+            auto normal = TRS::Vector3<float>::Cross(arrVertices[1] - arrVertices[0], arrVertices[2] - arrVertices[0]);
+            normal.Normalise();
+            return normal;
         }
 
 
-        void DasConverter::_OmitIndices(const std::pair<size_t, size_t>& _draw) {
-            for (size_t i = _draw.first; i < _draw.second; i++) {
-                for (auto vIt = m_triangulizedFaces[i].begin(); vIt != m_triangulizedFaces[i].end(); vIt++) {
-                    if (vIt->x != -1) {
-                        TRS::Vector3<float> v = {
-                            m_obj.vertices.geometricVertices[vIt->x][0],
-                            m_obj.vertices.geometricVertices[vIt->x][1],
-                            m_obj.vertices.geometricVertices[vIt->x][2],
-                        };
-                        m_reindexedVertexPositions.emplace_back(v);
+        void DasConverter::_WeldGroup(const std::vector<Triangle>& _triangles, const std::vector<TRS::Vector3<float>>& _generatedNormals,
+                                      VertexWelder& _welder)
+        {
+            const auto& positions = m_obj.vertices.geometricVertices;
+            const auto& uvs = m_obj.vertices.textureVertices;
+            const auto& normals = m_obj.vertices.vertexNormals;
+
+            for (auto triangleIt = _triangles.begin(); triangleIt != _triangles.end(); triangleIt++) {
+                const Triangle& triangle = *triangleIt;
+
+                for (auto vIt = triangle.begin(); vIt != triangle.end(); vIt++) {
+                    if (vIt->x >= positions.size() || (vIt->y != static_cast<uint32_t>(-1) && vIt->y >= uvs.size()) ||
+                        (vIt->z != static_cast<uint32_t>(-1) && vIt->z >= normals.size()))
+                    {
+                        throw ConvertionException("Wavefront obj: Face references a vertex attribute out of range");
                     }
+                }
 
-                    if (vIt->y != -1) {
-                        TRS::Vector2<float> v = {
-                            m_obj.vertices.textureVertices[vIt->y][0],
-                            m_obj.vertices.textureVertices[vIt->y][1],
-                        };
-
-                        m_reindexedUVPositions.emplace_back(v);
-                    }
+                // corners without source normals use generated smooth normals if available, flat normals of their triangle otherwise
+                TRS::Vector3<float> flatNormal;
+                if (_generatedNormals.empty() && (triangle[0].z == static_cast<uint32_t>(-1) || triangle[1].z == static_cast<uint32_t>(-1) ||
+                    triangle[2].z == static_cast<uint32_t>(-1)))
+                {
+                    flatNormal = _ComputeFaceNormal(triangle);
+                }
 
-                    if (vIt->z != -1)
-                        m_reindexedNormals.emplace_back(m_obj.vertices.vertexNormals[vIt->z]);
+                const size_t uTriangle = static_cast<size_t>(triangleIt - _triangles.begin());
+                for (auto vIt = triangle.begin(); vIt != triangle.end(); vIt++) {
+                    UnifiedVertex vertex;
+                    vertex.positionVertex = TRS::Vector3<float>(positions[vIt->x][0], positions[vIt->x][1], positions[vIt->x][2]);
+                    // corners without texture coordinates in a group, which has them elsewhere, get a zero uv
+                    if (vIt->y != static_cast<uint32_t>(-1))
+                        vertex.textureVertex = TRS::Vector2<float>(uvs[vIt->y][0], uvs[vIt->y][1]);
+                    else vertex.textureVertex = TRS::Vector2<float>(0.f, 0.f);
+                    if (vIt->z != static_cast<uint32_t>(-1))
+                        vertex.normalVertex = normals[vIt->z];
+                    else if (!_generatedNormals.empty())
+                        vertex.normalVertex = _generatedNormals[uTriangle * 3 + static_cast<size_t>(vIt - triangle.begin())];
+                    else vertex.normalVertex = flatNormal;
+                    _welder.Weld(vertex);
                 }
             }
         }
 
 
-        void DasConverter::_Convert() {
-            // first: triangulizationOffset
-            // second: draw count
-            std::vector<std::pair<size_t, size_t>> twoAttrGroups;
-
-            // for each group
-            for (auto groupIt = m_obj.groups.begin(); groupIt != m_obj.groups.end(); groupIt++) {
-                // for each face try to triangulize it
-                size_t uTriangulizationOffset = m_triangulizedFaces.size();
-                for (auto faceIt = groupIt->elements.faces.begin(); faceIt != groupIt->elements.faces.end(); faceIt++) {
-                    _TriangulizeFace(*faceIt);
+        std::unique_ptr<VertexWelder> DasConverter::_ConvertGroup(const Group& _group, Triangulator& _triangulator, std::vector<Triangle>& _triangles,
+                                                                  PhaseStats* _pPhases)
+        {
+            _triangles.clear();
+            {
+                StatsTimer timer(_pPhases ? &_pPhases[StatisticsPhase_Triangulation] : nullptr);
+                _triangulator.Triangulate(m_obj.vertices, _group.elements, _triangles);
+            }
+            if (_triangles.empty())
+                return nullptr;
+
+            auto fnHasUV = [](const TRS::Point3D<uint32_t>& _corner) { return _corner.y != static_cast<uint32_t>(-1); };
+            const bool bUVs = std::any_of(_group.elements.corners.begin(), _group.elements.corners.end(), fnHasUV);
+
+            // smoothing groups without (complete) source normals get generated smooth normals
+            std::vector<TRS::Vector3<float>> generatedNormals;
+            if (_group.bSmoothing) {
+                auto fnMissingNormal = [](const TRS::Point3D<uint32_t>& _corner) { return _corner.z == static_cast<uint32_t>(-1); };
+                if (std::any_of(_group.elements.corners.begin(), _group.elements.corners.end(), fnMissingNormal)) {
+                    StatsTimer timer(_pPhases ? &_pPhases[StatisticsPhase_NormalGeneration] : nullptr);
+                    GenerateNormals(m_obj.vertices, _triangles, NormalGeneratorSettings(), generatedNormals, m_pThreadPool);
                 }
+            }
 
-                auto& firstVertex = groupIt->elements.faces.front().front();
-                // check if smooth shading is enabled 
-                if (firstVertex.z == -1 && groupIt->bSmoothing) {
-                    _SmoothenNormals(uTriangulizationOffset);
-                }
+            StatsTimer timer(_pPhases ? &_pPhases[StatisticsPhase_Welding] : nullptr);
+            auto pWelder = std::make_unique<VertexWelder>(_triangles.size() * 3, bUVs);
+            _WeldGroup(_triangles, generatedNormals, *pWelder);
+            return pWelder;
+        }
 
-                // check if there are only position vertices
-                // if so then attempt to reindex them
-                if (firstVertex.x != -1 && firstVertex.y == -1) {
-                    twoAttrGroups.emplace_back(std::make_pair(uTriangulizationOffset, m_triangulizedFaces.size() - uTriangulizationOffset));
-                }
-                else if (firstVertex.x != -1) {
-                    m_model.meshes.emplace_back();
-                    m_model.meshes.back().Initialize();
-                    m_model.meshes.back().uDrawCount = static_cast<uint32_t>((m_triangulizedFaces.size() - uTriangulizationOffset) * 3);
-                    m_model.meshes.back().uPositionVertexBufferOffset = static_cast<uint32_t>(m_reindexedVertexPositions.size() * sizeof(TRS::Vector3<float>));
-                    
-                    for (auto uvIt = m_model.meshes.back().arrUVBufferOffsets.begin(); uvIt != m_model.meshes.back().arrUVBufferOffsets.end(); uvIt++)
-                        *uvIt = static_cast<uint32_t>(m_reindexedUVPositions.size() * sizeof(TRS::Vector2<float>));
-                    
-                    m_model.meshes.back().uVertexNormalBufferOffset = static_cast<uint32_t>(m_reindexedNormals.size() * sizeof(TRS::Vector3<float>));
-                    _OmitIndices(std::make_pair(uTriangulizationOffset, m_triangulizedFaces.size() - uTriangulizationOffset));
+
+        void DasConverter::_LayoutMeshes(const std::vector<std::unique_ptr<VertexWelder>>& _welders) {
+            // exclusive prefix sum of per group stream sizes, every group occupies one contiguous block of the buffer
+            uint64_t uSize = 0;
+            for (size_t i = 0; i < _welders.size(); i++) {
+                Mesh& mesh = m_model.meshes[i];
+                if (!_welders[i])
+                    continue;
+
+                const VertexWelder& welder = *_welders[i];
+                mesh.uDrawCount = static_cast<uint32_t>(welder.GetIndices().size());
+                mesh.uPositionVertexBufferOffset = static_cast<uint32_t>(uSize);
+                uSize += welder.GetPositions().size() * sizeof(TRS::Vector3<float>);
+                if (welder.HasUVs()) {
+                    mesh.arrUVBufferOffsets[0] = static_cast<uint32_t>(uSize);
+                    uSize += welder.GetUVs().size() * sizeof(TRS::Vector2<float>);
                 }
+                mesh.uVertexNormalBufferOffset = static_cast<uint32_t>(uSize);
+                uSize += welder.GetNormals().size() * sizeof(TRS::Vector3<float>);
+                mesh.uIndexBufferOffset = static_cast<uint32_t>(uSize);
+                uSize += welder.GetIndices().size() * sizeof(uint32_t);
+
+                if (uSize + m_model.buffer.Size() > UINT32_MAX)
+                    throw ConvertionException("Wavefront obj: Converted vertex data exceeds the 4 GiB buffer limit");
             }
 
-            // for each two attribute group
-            for (auto groupIt = twoAttrGroups.begin(); groupIt != twoAttrGroups.end(); groupIt++) {
-                auto& firstVertex = m_triangulizedFaces[groupIt->first].front();
+            const uint32_t uBase = m_model.buffer.Extend(static_cast<uint32_t>(uSize));
+
+            auto fnCopy = [&](size_t _uBegin, size_t _uEnd) {
+                for (size_t i = _uBegin; i < _uEnd; i++) {
+                    if (!_welders[i])
+                        continue;
+
+                    Mesh& mesh = m_model.meshes[i];
+                    const VertexWelder& welder = *_welders[i];
+                    mesh.uPositionVertexBufferOffset += uBase;
+                    mesh.uVertexNormalBufferOffset += uBase;
+                    mesh.uIndexBufferOffset += uBase;
+
+                    std::memcpy(m_model.buffer.Get(mesh.uPositionVertexBufferOffset), welder.GetPositions().data(),
+                                welder.GetPositions().size() * sizeof(TRS::Vector3<float>));
+                    if (welder.HasUVs()) {
+                        mesh.arrUVBufferOffsets[0] += uBase;
+                        std::memcpy(m_model.buffer.Get(mesh.arrUVBufferOffsets[0]), welder.GetUVs().data(),
+                                    welder.GetUVs().size() * sizeof(TRS::Vector2<float>));
+                    }
+                    std::memcpy(m_model.buffer.Get(mesh.uVertexNormalBufferOffset), welder.GetNormals().data(),
+                                welder.GetNormals().size() * sizeof(TRS::Vector3<float>));
+                    std::memcpy(m_model.buffer.Get(mesh.uIndexBufferOffset), welder.GetIndices().data(),
+                                welder.GetIndices().size() * sizeof(uint32_t));
+                }
+            };
 
-                m_model.meshes.emplace_back();
-                m_model.meshes.back().uPositionVertexBufferOffset = static_cast<uint32_t>(m_reindexedVertexPositions.size());
-                m_model.meshes.back().uPositionVertexBufferOffset = static_cast<uint32_t>(m_reindexedNormals.size());
-                m_model.meshes.back().uDrawCount = static_cast<uint32_t>(groupIt->second);
+            if (m_pThreadPool && _welders.size() > 1)
+                m_pThreadPool->ParallelFor(0, _welders.size(), 1, fnCopy);
+            else fnCopy(0, _welders.size());
+        }
 
-                // vertex normals are missing
-                if (firstVertex.z == -1) {
-                    _GenerateVertexNormals(*groupIt);
-                }
 
-                _OmitIndices(*groupIt);
+        void DasConverter::_AssignMaterials() {
+            // materials are added in order of first use, unused library entries are not converted
+            std::unordered_map<BinString, std::pair<MaterialType, uint32_t>> converted;
+
+            for (size_t i = 0; i < m_obj.groups.size(); i++) {
+                const BinString& szName = m_obj.groups[i].szMaterialName;
+                auto matIt = m_obj.materials.find(szName);
+                if (matIt == m_obj.materials.end())
+                    continue;
+
+                auto convIt = converted.find(szName);
+                if (convIt == converted.end())
+                    convIt = converted.emplace(szName, AppendMaterial(m_model, szName, matIt->second)).first;
+
+                m_model.meshes[i].bMaterialType = convIt->second.first;
+                m_model.meshes[i].uMaterialId = convIt->second.second;
             }
+        }
 
-            // set vertex offsets correctly
-            m_model.buffer.Initialize();
-            uint32_t uVertexBufferOffset = m_model.buffer.PushRange(m_reindexedVertexPositions.begin(), m_reindexedVertexPositions.end());
-            uint32_t uUVBufferOffset = m_model.buffer.PushRange(m_reindexedUVPositions.begin(), m_reindexedUVPositions.end());
-            uint32_t uVertexNormalBufferOffset = m_model.buffer.PushRange(m_reindexedNormals.begin(), m_reindexedNormals.end());
-            uint32_t uIndexBufferOffset = m_model.buffer.PushRange(m_indices.begin(), m_indices.end());
 
+        void DasConverter::_Convert() {
+            m_model.buffer.Initialize();
+            m_model.meshes.resize(m_obj.groups.size());
             for (auto it = m_model.meshes.begin(); it != m_model.meshes.end(); it++) {
-                it->uPositionVertexBufferOffset += uVertexBufferOffset;
+                it->Initialize();
+                it->arrUVBufferOffsets.fill(0);
+                it->arrSkeletalJointIndexBufferOffsets.fill(0);
+                it->arrSkeletalJointWeightBufferOffsets.fill(0);
+            }
 
-                if (m_obj.vertices.textureVertices.size()) {
-                    for (size_t i = 0; i < it->arrUVBufferOffsets.size(); i++) {
-                        it->arrUVBufferOffsets[i] += uUVBufferOffset;
+            // each group is converted into a single indexed mesh, groups are independent and converted in parallel
+            // per group phases are timed into worker local statistics, which are summed once the range is done
+            std::vector<std::unique_ptr<VertexWelder>> welders(m_obj.groups.size());
+            std::mutex statsMutex;
+            auto fnConvert = [&](size_t _uBegin, size_t _uEnd) {
+                Triangulator triangulator;
+                std::vector<Triangle> triangles;
+                PhaseStats arrPhases[StatisticsPhase_Count];
+                for (size_t i = _uBegin; i < _uEnd; i++)
+                    welders[i] = _ConvertGroup(m_obj.groups[i], triangulator, triangles, m_pStats ? arrPhases : nullptr);
+
+                if (m_pStats) {
+                    std::scoped_lock lock(statsMutex);
+                    for (size_t i = 0; i < StatisticsPhase_Count; i++) {
+                        m_pStats->arrPhases[i].fSeconds += arrPhases[i].fSeconds;
+                        m_pStats->arrPhases[i].uCount += arrPhases[i].uCount;
                     }
                 }
+            };
 
-                if (m_obj.vertices.vertexNormals.size()) {
-                    it->uVertexNormalBufferOffset += uVertexNormalBufferOffset;
-                }
+            if (m_pThreadPool && m_obj.groups.size() > 1)
+                m_pThreadPool->ParallelFor(0, m_obj.groups.size(), 1, fnConvert);
+            else fnConvert(0, m_obj.groups.size());
+
+            {
+                StatsTimer timer(GetPhaseStats(m_pStats, StatisticsPhase_Layout));
+                _LayoutMeshes(welders);
             }
+
+            StatsTimer timer(GetPhaseStats(m_pStats, StatisticsPhase_Materials));
+            _AssignMaterials();
         }
 
-        void DasConverter::_CreateModel() {
+
+        void DasConverter::_BuildModel() {
             m_model.meshGroups.resize(m_obj.groups.size());
             m_model.nodes.resize(m_obj.groups.size());
 
@@ -236,7 +307,7 @@ namespace das2 {
             m_model.nodes.resize(m_model.meshGroups.size());
             for (size_t i = 0; i < m_model.nodes.size(); i++) {
                 m_model.nodes[i].Initialize();
-                m_model.nodes.back().uMeshGroupId = static_cast<uint32_t>(i);
+                m_model.nodes[i].uMeshGroupId = static_cast<uint32_t>(i);
             }
 
             m_model.scenes.emplace_back();
@@ -246,5 +317,28 @@ namespace das2 {
             for (size_t i = 0; i < m_model.nodes.size(); i++)
                 m_model.scenes.back().rootNodes.push_back(static_cast<uint32_t>(i));
         }
+
+
+        void DasConverter::_CreateModel() {
+            CountingMemoryResource* pCounting = m_pStats ? dynamic_cast<CountingMemoryResource*>(m_model.GetMemoryResource()) : nullptr;
+            const uint64_t uAllocationCount = pCounting ? pCounting->GetAllocationCount() : 0;
+            const uint64_t uAllocatedBytes = pCounting ? pCounting->GetAllocatedBytes() : 0;
+
+            {
+                StatsTimer timer(GetPhaseStats(m_pStats, StatisticsPhase_Total));
+                _BuildModel();
+            }
+
+            if (!m_pStats)
+                return;
+
+            if (pCounting) {
+                m_pStats->uAllocationCount += pCounting->GetAllocationCount() - uAllocationCount;
+                m_pStats->uAllocatedBytes += pCounting->GetAllocatedBytes() - uAllocatedBytes;
+                m_pStats->bAllocationsCounted = true;
+            }
+            m_pStats->uBytesOut += m_model.buffer.Size();
+            m_pStats->Publish();
+        }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,91 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: MaterialLibraryCache.cpp - implementation of process-wide Wavefront MTL library cache
+// author: Karl-Mihkel Ott
+
+#include <fstream>
+#include <das2/converters/obj/MaterialLibraryCache.h>
+#include <das2/converters/obj/Unserializer.h>
+
+namespace das2 {
+    namespace obj {
+
+        MaterialLibraryCache& MaterialLibraryCache::GetInstance() {
+            static MaterialLibraryCache instance;
+            return instance;
+        }
+
+
+        std::shared_ptr<const MaterialLibrary> MaterialLibraryCache::Load(const std::filesystem::path& _path) {
+            const std::filesystem::path canonicalPath = std::filesystem::canonical(_path);
+            const std::filesystem::file_time_type modificationTime = std::filesystem::last_write_time(canonicalPath);
+            const std::string sKey = canonicalPath.string();
+
+            std::promise<std::shared_ptr<const MaterialLibrary>> promise;
+            std::shared_future<std::shared_ptr<const MaterialLibrary>> library;
+            uint64_t uGeneration = 0;
+            bool bOwner = false;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto it = m_entries.find(sKey);
+                if (it != m_entries.end() && it->second.modificationTime == modificationTime) {
+                    library = it->second.library;
+                }
+                else {
+                    library = promise.get_future().share();
+                    uGeneration = ++m_uGeneration;
+                    m_entries[sKey] = _Entry{ modificationTime, library, uGeneration };
+                    bOwner = true;
+                }
+            }
+
+            // the first requester parses the library outside of the lock, others wait on its future
+            if (bOwner) {
+                try {
+                    std::ifstream stream(canonicalPath, std::ios_base::binary);
+                    if (!stream)
+                        throw std::filesystem::filesystem_error("Cannot open material library", canonicalPath, std::make_error_code(std::errc::io_error));
+
+                    UnserializerMtl unserializer(stream);
+                    promise.set_value(std::make_shared<const MaterialLibrary>(std::move(unserializer.Get())));
+                }
+                catch (...) {
+                    promise.set_exception(std::current_exception());
+
+                    // failures are not cached, the next request tries again
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    auto it = m_entries.find(sKey);
+                    if (it != m_entries.end() && it->second.uGeneration == uGeneration)
+                        m_entries.erase(it);
+                }
+            }
+
+            return library.get();
+        }
+
+
+        void MaterialLibraryCache::Clear() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_entries.clear();
+        }
+
+
+        std::vector<std::string> LoadMaterialLibraries(Object& _obj, const std::filesystem::path& _baseDirectory) {
+            std::vector<std::string> missing;
+            for (auto it = _obj.materialLibraries.begin(); it != _obj.materialLibraries.end(); it++) {
+                const std::filesystem::path path = _baseDirectory / it->CString();
+                std::error_code error;
+                if (!std::filesystem::exists(path, error)) {
+                    missing.push_back(path.string());
+                    continue;
+                }
+
+                std::shared_ptr<const MaterialLibrary> pLibrary = MaterialLibraryCache::GetInstance().Load(path);
+                for (auto matIt = pLibrary->begin(); matIt != pLibrary->end(); matIt++)
+                    _obj.materials.insert(*matIt);
+            }
+
+            return missing;
+        }
+    }
+}
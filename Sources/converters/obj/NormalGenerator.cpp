@@ -0,0 +1,137 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: NormalGenerator.cpp - implementation of smooth vertex normal generation for obj conversion
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <cmath>
+#include <das2/Exceptions.h>
+#include <das2/converters/obj/NormalGenerator.h>
+
+// triangles or sorted corners per parallel task
+#define NORMAL_GENERATOR_GRAIN 8192
+
+namespace das2 {
+    namespace obj {
+
+        namespace {
+            inline TRS::Vector3<float> _Position(const Vertices& _vertices, uint32_t _uIndex) {
+                const auto& position = _vertices.geometricVertices[_uIndex];
+                return TRS::Vector3<float>(position[0], position[1], position[2]);
+            }
+
+            inline TRS::Vector3<float> _Normalized(const TRS::Vector3<float>& _vec) {
+                const float fLength = std::sqrt(TRS::Vector3<float>::Dot(_vec, _vec));
+                return fLength > 0.f ? _vec * (1.f / fLength) : _vec;
+            }
+
+            inline float _Angle(const TRS::Vector3<float>& _a, const TRS::Vector3<float>& _b) {
+                const float fLength = std::sqrt(TRS::Vector3<float>::Dot(_a, _a) * TRS::Vector3<float>::Dot(_b, _b));
+                if (fLength <= 0.f)
+                    return 0.f;
+                return std::acos(std::max(-1.f, std::min(1.f, TRS::Vector3<float>::Dot(_a, _b) / fLength)));
+            }
+
+
+            void _ParallelFor(ThreadPool* _pThreadPool, size_t _uCount, const std::function<void(size_t, size_t)>& _fnBody) {
+                if (_pThreadPool && _uCount > NORMAL_GENERATOR_GRAIN)
+                    _pThreadPool->ParallelFor(0, _uCount, NORMAL_GENERATOR_GRAIN, _fnBody);
+                else _fnBody(0, _uCount);
+            }
+        }
+
+
+        void GenerateNormals(const Vertices& _vertices, const std::vector<Triangle>& _triangles, const NormalGeneratorSettings& _settings,
+                             std::vector<TRS::Vector3<float>>& _outNormals, ThreadPool* _pThreadPool)
+        {
+            const size_t uCornerCount = _triangles.size() * 3;
+            const size_t uPositionCount = _vertices.geometricVertices.size();
+
+            // weighted face normal of each corner and unit face normals for crease tests
+            std::vector<TRS::Vector3<float>> weighted(uCornerCount);
+            std::vector<TRS::Vector3<float>> faceNormals(_triangles.size());
+            std::vector<uint64_t> keys(uCornerCount);
+
+            _ParallelFor(_pThreadPool, _triangles.size(), [&](size_t _uBegin, size_t _uEnd) {
+                for (size_t i = _uBegin; i < _uEnd; i++) {
+                    const Triangle& triangle = _triangles[i];
+                    if (triangle[0].x >= uPositionCount || triangle[1].x >= uPositionCount || triangle[2].x >= uPositionCount)
+                        throw ConvertionException("Wavefront obj: Face references a vertex position out of range");
+
+                    const TRS::Vector3<float> arrPositions[3] = {
+                        _Position(_vertices, triangle[0].x),
+                        _Position(_vertices, triangle[1].x),
+                        _Position(_vertices, triangle[2].x)
+                    };
+
+                    // the cross product length is twice the triangle area
+                    const TRS::Vector3<float> cross = TRS::Vector3<float>::Cross(arrPositions[1] - arrPositions[0], arrPositions[2] - arrPositions[0]);
+                    faceNormals[i] = _Normalized(cross);
+                    const TRS::Vector3<float> faceNormal = _settings.bAreaWeighted ? cross : faceNormals[i];
+
+                    for (size_t j = 0; j < 3; j++) {
+                        float fWeight = 1.f;
+                        if (_settings.bAngleWeighted) {
+                            const TRS::Vector3<float>& corner = arrPositions[j];
+                            fWeight = _Angle(arrPositions[(j + 1) % 3] - corner, arrPositions[(j + 2) % 3] - corner);
+                        }
+
+                        weighted[i * 3 + j] = faceNormal * fWeight;
+                        keys[i * 3 + j] = (static_cast<uint64_t>(triangle[j].x) << 32) | static_cast<uint64_t>(i * 3 + j);
+                    }
+                }
+            });
+
+            // corners sharing a position become adjacent
+            std::sort(keys.begin(), keys.end());
+
+            _outNormals.resize(uCornerCount);
+            const bool bCrease = _settings.fCreaseAngle < 3.14159265f;
+            const float fCosCrease = std::cos(_settings.fCreaseAngle);
+
+            _ParallelFor(_pThreadPool, uCornerCount, [&](size_t _uBegin, size_t _uEnd) {
+                // process every run of equal positions that starts inside [_uBegin, _uEnd)
+                size_t uRun = _uBegin;
+                while (uRun > 0 && uRun < uCornerCount && (keys[uRun - 1] >> 32) == (keys[uRun] >> 32))
+                    uRun++;
+
+                while (uRun < _uEnd) {
+                    const uint64_t uPosition = keys[uRun] >> 32;
+                    size_t uRunEnd = uRun + 1;
+                    while (uRunEnd < uCornerCount && (keys[uRunEnd] >> 32) == uPosition)
+                        uRunEnd++;
+
+                    if (!bCrease) {
+                        TRS::Vector3<float> sum;
+                        for (size_t i = uRun; i < uRunEnd; i++)
+                            sum += weighted[keys[i] & 0xffffffffu];
+                        sum = _Normalized(sum);
+
+                        for (size_t i = uRun; i < uRunEnd; i++) {
+                            const uint32_t uCorner = static_cast<uint32_t>(keys[i] & 0xffffffffu);
+                            _outNormals[uCorner] = TRS::Vector3<float>::Dot(sum, sum) > 0.f ? sum : faceNormals[uCorner / 3];
+                        }
+                    }
+                    else {
+                        for (size_t i = uRun; i < uRunEnd; i++) {
+                            const uint32_t uCorner = static_cast<uint32_t>(keys[i] & 0xffffffffu);
+                            const TRS::Vector3<float>& faceNormal = faceNormals[uCorner / 3];
+
+                            TRS::Vector3<float> sum;
+                            for (size_t j = uRun; j < uRunEnd; j++) {
+                                const uint32_t uOther = static_cast<uint32_t>(keys[j] & 0xffffffffu);
+                                if (uOther == uCorner || TRS::Vector3<float>::Dot(faceNormal, faceNormals[uOther / 3]) >= fCosCrease)
+                                    sum += weighted[uOther];
+                            }
+
+                            sum = _Normalized(sum);
+                            _outNormals[uCorner] = TRS::Vector3<float>::Dot(sum, sum) > 0.f ? sum : faceNormal;
+                        }
+                    }
+
+                    uRun = uRunEnd;
+                }
+            });
+        }
+    }
+}
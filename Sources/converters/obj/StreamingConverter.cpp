@@ -0,0 +1,416 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: StreamingConverter.cpp - implementation of out-of-core Wavefront OBJ to das2 converter
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+
+#include <das2/Exceptions.h>
+#include <das2/Serializer.h>
+#include <das2/converters/obj/DasConverter.h>
+#include <das2/converters/obj/MaterialLibraryCache.h>
+#include <das2/converters/obj/StreamingConverter.h>
+#include <das2/converters/obj/Unserializer.h>
+
+// the memory budget is split between the input block and the face batch, parsed blocks take roughly four times their text size
+#define OBJ_STREAM_BLOCK_FRACTION 16
+#define OBJ_STREAM_MIN_BLOCK_SIZE (1 << 16)
+// estimated peak memory per batched face corner: corners, gathered attributes, triangles, welder streams and the mesh buffer
+#define OBJ_STREAM_BYTES_PER_CORNER 256
+#define OBJ_STREAM_MIN_BATCH_CORNERS 4096
+// gaps of at most that many elements between referenced vertices are read instead of seeked over
+#define OBJ_STREAM_GATHER_GAP 64
+#define OBJ_STREAM_COPY_SIZE (1 << 20)
+
+namespace das2 {
+    namespace obj {
+
+        namespace {
+
+            // append-only temporary file with random access reads, removed on destruction
+            class _SpillFile {
+                private:
+                    std::filesystem::path m_path;
+                    std::fstream m_file;
+                    uint64_t m_uSize = 0;
+
+                private:
+                    [[noreturn]] void _Fail(const char* _szMessage) const {
+                        throw std::filesystem::filesystem_error(_szMessage, m_path, std::make_error_code(std::errc::io_error));
+                    }
+
+                public:
+                    _SpillFile(const std::filesystem::path& _directory, const char* _szTag) {
+                        std::random_device device;
+                        do {
+                            std::stringstream ss;
+                            ss << "das2-" << std::hex << std::setfill('0') << std::setw(8) << device() << std::setw(8) << device() << '-' << _szTag << ".tmp";
+                            m_path = _directory / ss.str();
+                        } while (std::filesystem::exists(m_path));
+
+                        m_file.open(m_path, std::ios_base::in | std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+                        if (!m_file)
+                            _Fail("Cannot create temporary file");
+                    }
+
+                    _SpillFile(const _SpillFile&) = delete;
+                    _SpillFile& operator=(const _SpillFile&) = delete;
+
+                    ~_SpillFile() {
+                        m_file.close();
+                        std::error_code error;
+                        std::filesystem::remove(m_path, error);
+                    }
+
+                    inline uint64_t Size() const {
+                        return m_uSize;
+                    }
+
+                    void Append(const void* _pData, size_t _uSize) {
+                        if (!_uSize)
+                            return;
+
+                        m_file.seekp(static_cast<std::streamoff>(m_uSize));
+                        m_file.write(static_cast<const char*>(_pData), static_cast<std::streamsize>(_uSize));
+                        if (!m_file)
+                            _Fail("Cannot write temporary file");
+                        m_uSize += _uSize;
+                    }
+
+                    void Read(uint64_t _uOffset, void* _pData, size_t _uSize) {
+                        m_file.seekg(static_cast<std::streamoff>(_uOffset));
+                        m_file.read(static_cast<char*>(_pData), static_cast<std::streamsize>(_uSize));
+                        if (!m_file)
+                            _Fail("Cannot read temporary file");
+                    }
+
+                    void CopyTo(std::ostream& _stream) {
+                        std::vector<char> block(static_cast<size_t>(std::min<uint64_t>(m_uSize, OBJ_STREAM_COPY_SIZE)));
+                        for (uint64_t uOffset = 0; uOffset < m_uSize; uOffset += block.size()) {
+                            const size_t uSize = static_cast<size_t>(std::min<uint64_t>(block.size(), m_uSize - uOffset));
+                            Read(uOffset, block.data(), uSize);
+                            _stream.write(block.data(), static_cast<std::streamsize>(uSize));
+                        }
+                    }
+            };
+
+
+            // reads elements _indices (sorted and unique) of the array of T stored in _file into _out
+            // nearby indices are read with a single contiguous read
+            template <typename T>
+            void _Gather(_SpillFile& _file, const std::vector<uint32_t>& _indices, std::vector<T>& _out) {
+                _out.resize(_indices.size());
+                std::vector<T> span;
+
+                size_t i = 0;
+                while (i < _indices.size()) {
+                    size_t j = i;
+                    while (j + 1 < _indices.size() && _indices[j + 1] - _indices[j] <= OBJ_STREAM_GATHER_GAP &&
+                           _indices[j + 1] - _indices[i] < OBJ_STREAM_COPY_SIZE / sizeof(T))
+                    {
+                        j++;
+                    }
+
+                    const uint32_t uFirst = _indices[i];
+                    span.resize(_indices[j] - uFirst + 1);
+                    _file.Read(static_cast<uint64_t>(uFirst) * sizeof(T), span.data(), span.size() * sizeof(T));
+                    for (size_t k = i; k <= j; k++)
+                        _out[k] = span[_indices[k] - uFirst];
+                    i = j + 1;
+                }
+            }
+
+
+            // sorts and deduplicates _indices, throws if any of them is not below _uCount
+            void _MakeUnique(std::vector<uint32_t>& _indices, uint64_t _uCount) {
+                std::sort(_indices.begin(), _indices.end());
+                _indices.erase(std::unique(_indices.begin(), _indices.end()), _indices.end());
+                if (!_indices.empty() && _indices.back() >= _uCount)
+                    throw ConvertionException("Wavefront obj: Face references a vertex attribute out of range");
+            }
+
+
+            inline uint32_t _Remap(const std::vector<uint32_t>& _indices, uint32_t _uIndex) {
+                return static_cast<uint32_t>(std::lower_bound(_indices.begin(), _indices.end(), _uIndex) - _indices.begin());
+            }
+        }
+
+
+        struct StreamingConverter::_State {
+            _SpillFile positions;
+            _SpillFile textures;
+            _SpillFile normals;
+            _SpillFile buffer;
+
+            size_t uBatchCorners = 0;
+            std::vector<Group> batch;               // pending faces, one entry per output mesh
+            std::vector<uint32_t> batchGroups;      // mesh group index of each batch entry
+            size_t uPendingCorners = 0;
+
+            Model model;
+            std::vector<BinString> meshMaterials;   // material name of each mesh
+            std::vector<BinString> materialLibraries;
+
+            _State(const std::filesystem::path& _directory) :
+                positions(_directory, "v"),
+                textures(_directory, "vt"),
+                normals(_directory, "vn"),
+                buffer(_directory, "buffer") {}
+        };
+
+
+        StreamingConverter::StreamingConverter(std::istream& _input, std::ostream& _output, const StreamingConverterSettings& _settings,
+                                               ThreadPool* _pThreadPool) :
+            m_input(_input),
+            m_output(_output),
+            m_settings(_settings),
+            m_pThreadPool(_pThreadPool)
+        {
+        }
+
+
+        StreamingConverter::~StreamingConverter() = default;
+
+
+        void StreamingConverter::_SpillVertices(const Vertices& _vertices) {
+            m_pState->positions.Append(_vertices.geometricVertices.data(), _vertices.geometricVertices.size() * sizeof(TRS::Vector4<float>));
+            m_pState->textures.Append(_vertices.textureVertices.data(), _vertices.textureVertices.size() * sizeof(TRS::Vector3<float>));
+            m_pState->normals.Append(_vertices.vertexNormals.data(), _vertices.vertexNormals.size() * sizeof(TRS::Vector3<float>));
+        }
+
+
+        void StreamingConverter::_Enqueue(Group&& _group, bool _bContinues) {
+            _State& state = *m_pState;
+
+            // new obj groups get their own mesh group and node
+            if (!_bContinues) {
+                std::string sConcatName;
+                for (auto it = _group.groupNames.begin(); it != _group.groupNames.end(); it++) {
+                    if (it != _group.groupNames.begin())
+                        sConcatName += '_';
+                    sConcatName += it->CString();
+                }
+
+                state.model.meshGroups.emplace_back();
+                state.model.meshGroups.back().Initialize();
+                state.model.meshGroups.back().szName = sConcatName;
+                state.model.nodes.emplace_back();
+                state.model.nodes.back().Initialize();
+                state.model.nodes.back().szName = sConcatName;
+                state.model.nodes.back().uMeshGroupId = static_cast<uint32_t>(state.model.meshGroups.size() - 1);
+            }
+
+            const uint32_t uMeshGroup = static_cast<uint32_t>(state.model.meshGroups.size() - 1);
+            size_t uFace = 0;
+            while (uFace < _group.elements.GetFaceCount()) {
+                // take as many faces as fit into the batch, but at least one if the batch is empty
+                const size_t uRoom = state.uBatchCorners > state.uPendingCorners ? state.uBatchCorners - state.uPendingCorners : 0;
+                const uint32_t uFirstCorner = _group.elements.faceOffsets[uFace];
+                size_t uLastFace = uFace;
+                while (uLastFace < _group.elements.GetFaceCount() && _group.elements.faceOffsets[uLastFace + 1] - uFirstCorner <= uRoom)
+                    uLastFace++;
+                if (uLastFace == uFace && !state.uPendingCorners)
+                    uLastFace++;
+
+                if (uLastFace == uFace) {
+                    _Flush();
+                    continue;
+                }
+
+                // faces continuing the last batch entry are merged into it
+                if (state.batch.empty() || state.batchGroups.back() != uMeshGroup) {
+                    state.batch.emplace_back();
+                    state.batch.back().szMaterialName = _group.szMaterialName;
+                    state.batch.back().bSmoothing = _group.bSmoothing;
+                    state.batchGroups.push_back(uMeshGroup);
+                }
+
+                Elements& elements = state.batch.back().elements;
+                const uint32_t uLastCorner = _group.elements.faceOffsets[uLastFace];
+                const uint32_t uBase = static_cast<uint32_t>(elements.corners.size()) - uFirstCorner;
+                elements.corners.insert(elements.corners.end(), _group.elements.corners.begin() + uFirstCorner,
+                                        _group.elements.corners.begin() + uLastCorner);
+                for (size_t i = uFace + 1; i <= uLastFace; i++)
+                    elements.faceOffsets.push_back(uBase + _group.elements.faceOffsets[i]);
+
+                state.uPendingCorners += uLastCorner - uFirstCorner;
+                uFace = uLastFace;
+            }
+        }
+
+
+        void StreamingConverter::_Flush() {
+            _State& state = *m_pState;
+            if (state.batch.empty())
+                return;
+
+            // gather referenced vertices from the spill files and remap corners to batch-local indices
+            std::vector<uint32_t> arrReferenced[3];
+            for (size_t i = 0; i < 3; i++)
+                arrReferenced[i].reserve(state.uPendingCorners);
+
+            for (auto groupIt = state.batch.begin(); groupIt != state.batch.end(); groupIt++) {
+                for (auto it = groupIt->elements.corners.begin(); it != groupIt->elements.corners.end(); it++) {
+                    arrReferenced[0].push_back(it->x);
+                    if (it->y != static_cast<uint32_t>(-1))
+                        arrReferenced[1].push_back(it->y);
+                    if (it->z != static_cast<uint32_t>(-1))
+                        arrReferenced[2].push_back(it->z);
+                }
+            }
+
+            _MakeUnique(arrReferenced[0], state.positions.Size() / sizeof(TRS::Vector4<float>));
+            _MakeUnique(arrReferenced[1], state.textures.Size() / sizeof(TRS::Vector3<float>));
+            _MakeUnique(arrReferenced[2], state.normals.Size() / sizeof(TRS::Vector3<float>));
+
+            Object obj;
+            _Gather(state.positions, arrReferenced[0], obj.vertices.geometricVertices);
+            _Gather(state.textures, arrReferenced[1], obj.vertices.textureVertices);
+            _Gather(state.normals, arrReferenced[2], obj.vertices.vertexNormals);
+
+            auto fnRemap = [&](size_t _uBegin, size_t _uEnd) {
+                for (size_t i = _uBegin; i < _uEnd; i++) {
+                    for (auto it = state.batch[i].elements.corners.begin(); it != state.batch[i].elements.corners.end(); it++) {
+                        it->x = _Remap(arrReferenced[0], it->x);
+                        if (it->y != static_cast<uint32_t>(-1))
+                            it->y = _Remap(arrReferenced[1], it->y);
+                        if (it->z != static_cast<uint32_t>(-1))
+                            it->z = _Remap(arrReferenced[2], it->z);
+                    }
+                }
+            };
+
+            if (m_pThreadPool && state.batch.size() > 1)
+                m_pThreadPool->ParallelFor(0, state.batch.size(), 1, fnRemap);
+            else fnRemap(0, state.batch.size());
+
+            for (size_t i = 0; i < 3; i++)
+                std::vector<uint32_t>().swap(arrReferenced[i]);
+
+            std::vector<BinString> materials;
+            materials.reserve(state.batch.size());
+            for (auto it = state.batch.begin(); it != state.batch.end(); it++)
+                materials.push_back(it->szMaterialName);
+
+            obj.groups = std::move(state.batch);
+            Model batchModel = DasConverter(std::move(obj), "", "", 0, m_pThreadPool).GetModel();
+
+            // append converted vertex data to the buffer spill and rebase mesh offsets
+            const uint64_t uBase = state.buffer.Size();
+            if (uBase + batchModel.buffer.Size() > UINT32_MAX)
+                throw ConvertionException("Wavefront obj: Converted vertex data exceeds the 4 GiB buffer limit");
+            state.buffer.Append(batchModel.buffer.Get(), batchModel.buffer.Size());
+
+            for (size_t i = 0; i < batchModel.meshes.size(); i++) {
+                Mesh& mesh = batchModel.meshes[i];
+                if (!mesh.uDrawCount)
+                    continue;
+
+                mesh.uPositionVertexBufferOffset += static_cast<uint32_t>(uBase);
+                mesh.uVertexNormalBufferOffset += static_cast<uint32_t>(uBase);
+                mesh.uIndexBufferOffset += static_cast<uint32_t>(uBase);
+                // uv offset 0 means that the mesh has no texture coordinates, positions always precede them in the buffer
+                if (mesh.arrUVBufferOffsets[0])
+                    mesh.arrUVBufferOffsets[0] += static_cast<uint32_t>(uBase);
+
+                state.model.meshGroups[state.batchGroups[i]].meshes.push_back(static_cast<uint32_t>(state.model.meshes.size()));
+                state.model.meshes.push_back(std::move(mesh));
+                state.meshMaterials.push_back(std::move(materials[i]));
+            }
+
+            state.batch.clear();
+            state.batchGroups.clear();
+            state.uPendingCorners = 0;
+        }
+
+
+        void StreamingConverter::_AssignMaterials() {
+            if (m_settings.materialDirectory.empty())
+                return;
+
+            Object libraries;
+            libraries.materialLibraries = m_pState->materialLibraries;
+            m_missingLibraries = LoadMaterialLibraries(libraries, m_settings.materialDirectory);
+
+            // materials are added in order of first use, unused library entries are not converted
+            std::unordered_map<BinString, std::pair<MaterialType, uint32_t>> converted;
+            for (size_t i = 0; i < m_pState->meshMaterials.size(); i++) {
+                const BinString& szName = m_pState->meshMaterials[i];
+                auto matIt = libraries.materials.find(szName);
+                if (matIt == libraries.materials.end())
+                    continue;
+
+                auto convIt = converted.find(szName);
+                if (convIt == converted.end())
+                    convIt = converted.emplace(szName, AppendMaterial(m_pState->model, szName, matIt->second)).first;
+
+                m_pState->model.meshes[i].bMaterialType = convIt->second.first;
+                m_pState->model.meshes[i].uMaterialId = convIt->second.second;
+            }
+        }
+
+
+        void StreamingConverter::_Write() {
+            // the buffer is copied from the spill file instead of being held in model.buffer
+            Serializer serializer(m_output, m_pState->model);
+            serializer.Serialize(static_cast<uint32_t>(m_pState->buffer.Size()), [this](std::ostream& _stream) {
+                m_pState->buffer.CopyTo(_stream);
+            });
+            m_output.flush();
+        }
+
+
+        void StreamingConverter::Convert() {
+            const std::filesystem::path tempDirectory = m_settings.tempDirectory.empty() ? std::filesystem::temp_directory_path() : m_settings.tempDirectory;
+            m_pState = std::make_unique<_State>(tempDirectory);
+            m_missingLibraries.clear();
+
+            // temporary files are removed as soon as the conversion finishes or fails
+            try {
+                _State& state = *m_pState;
+                state.uBatchCorners = std::max<size_t>(m_settings.uMemoryBudget / 2 / OBJ_STREAM_BYTES_PER_CORNER, OBJ_STREAM_MIN_BATCH_CORNERS);
+                state.model.header.Initialize();
+                state.model.header.szAuthorName = m_settings.szAuthorName;
+                state.model.header.szComment = m_settings.szComment;
+                state.model.header.bZstdLevel = m_settings.bZstdLevel;
+
+                // complete groups are batched until the batch reaches the budget, large groups are split across batches
+                const size_t uBlockSize = std::max<size_t>(m_settings.uMemoryBudget / OBJ_STREAM_BLOCK_FRACTION, OBJ_STREAM_MIN_BLOCK_SIZE);
+                StreamingUnserializer unserializer(m_input, uBlockSize, m_pThreadPool);
+                StreamedBlock block;
+                while (unserializer.Next(block)) {
+                    _SpillVertices(block.vertices);
+                    block.vertices = Vertices();
+                    state.materialLibraries.insert(state.materialLibraries.end(), block.materialLibraries.begin(), block.materialLibraries.end());
+
+                    for (size_t i = 0; i < block.groups.size(); i++)
+                        _Enqueue(std::move(block.groups[i]), i == 0 && block.bContinuesGroup);
+                }
+                _Flush();
+
+                _AssignMaterials();
+
+                state.model.scenes.emplace_back();
+                state.model.scenes.back().Initialize();
+                state.model.scenes.back().rootNodes.reserve(state.model.nodes.size());
+                for (size_t i = 0; i < state.model.nodes.size(); i++)
+                    state.model.scenes.back().rootNodes.push_back(static_cast<uint32_t>(i));
+
+                _Write();
+            }
+            catch (...) {
+                m_pState.reset();
+                throw;
+            }
+            m_pState.reset();
+        }
+    }
+}
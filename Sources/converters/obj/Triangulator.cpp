@@ -0,0 +1,192 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: Triangulator.cpp - implementation of polygon triangulation for obj conversion
+// author: Karl-Mihkel Ott
+
+#include <cmath>
+#include <das2/Exceptions.h>
+#include <das2/converters/obj/Triangulator.h>
+
+namespace das2 {
+    namespace obj {
+
+        namespace {
+            inline TRS::Vector3<float> _Position(const Vertices& _vertices, const TRS::Point3D<uint32_t>& _corner) {
+                const auto& position = _vertices.geometricVertices[_corner.x];
+                return TRS::Vector3<float>(position[0], position[1], position[2]);
+            }
+
+            // twice the signed area of triangle abc in the projection plane
+            inline float _Cross(const float* _pA, const float* _pB, const float* _pC) {
+                return (_pB[0] - _pA[0]) * (_pC[1] - _pA[1]) - (_pB[1] - _pA[1]) * (_pC[0] - _pA[0]);
+            }
+        }
+
+
+        bool Triangulator::_IsReflex(uint32_t _uCorner) const {
+            const float* pA = &m_projected[m_prev[_uCorner] * 2];
+            const float* pB = &m_projected[_uCorner * 2];
+            const float* pC = &m_projected[m_next[_uCorner] * 2];
+
+            // collinear corners are treated as reflex, they are clipped only if no proper ear remains
+            return _Cross(pA, pB, pC) <= 0.f;
+        }
+
+
+        bool Triangulator::_IsEar(uint32_t _uCorner, uint32_t _uRemaining) const {
+            if (m_reflex[_uCorner])
+                return false;
+
+            const uint32_t uPrev = m_prev[_uCorner];
+            const uint32_t uNext = m_next[_uCorner];
+            const float* pA = &m_projected[uPrev * 2];
+            const float* pB = &m_projected[_uCorner * 2];
+            const float* pC = &m_projected[uNext * 2];
+
+            // only reflex corners can lie inside of a convex corner's triangle
+            uint32_t uTested = m_next[uNext];
+            for (uint32_t i = 3; i < _uRemaining; i++, uTested = m_next[uTested]) {
+                if (!m_reflex[uTested])
+                    continue;
+
+                const float* pP = &m_projected[uTested * 2];
+                if (_Cross(pA, pB, pP) >= 0.f && _Cross(pB, pC, pP) >= 0.f && _Cross(pC, pA, pP) >= 0.f)
+                    return false;
+            }
+
+            return true;
+        }
+
+
+        void Triangulator::_ClipEars(const TRS::Point3D<uint32_t>* _pCorners, uint32_t _uCornerCount, std::vector<Triangle>& _out) {
+            m_prev.resize(_uCornerCount);
+            m_next.resize(_uCornerCount);
+            m_reflex.resize(_uCornerCount);
+
+            for (uint32_t i = 0; i < _uCornerCount; i++) {
+                m_prev[i] = i == 0 ? _uCornerCount - 1 : i - 1;
+                m_next[i] = i + 1 == _uCornerCount ? 0 : i + 1;
+            }
+
+            for (uint32_t i = 0; i < _uCornerCount; i++)
+                m_reflex[i] = _IsReflex(i) ? 1 : 0;
+
+            uint32_t uRemaining = _uCornerCount;
+            uint32_t uCorner = 0;
+            uint32_t uSkipped = 0;
+            while (uRemaining > 3) {
+                // a full loop without ears means the polygon is degenerate or self-intersecting, clip the current corner anyway
+                if (_IsEar(uCorner, uRemaining) || uSkipped >= uRemaining) {
+                    const uint32_t uPrev = m_prev[uCorner];
+                    const uint32_t uNext = m_next[uCorner];
+                    _out.push_back(Triangle{ _pCorners[uPrev], _pCorners[uCorner], _pCorners[uNext] });
+
+                    m_next[uPrev] = uNext;
+                    m_prev[uNext] = uPrev;
+                    uRemaining--;
+
+                    m_reflex[uPrev] = _IsReflex(uPrev) ? 1 : 0;
+                    m_reflex[uNext] = _IsReflex(uNext) ? 1 : 0;
+                    uCorner = uNext;
+                    uSkipped = 0;
+                }
+                else {
+                    uCorner = m_next[uCorner];
+                    uSkipped++;
+                }
+            }
+
+            _out.push_back(Triangle{ _pCorners[m_prev[uCorner]], _pCorners[uCorner], _pCorners[m_next[uCorner]] });
+        }
+
+
+        void Triangulator::Triangulate(const Vertices& _vertices, const TRS::Point3D<uint32_t>* _pCorners, uint32_t _uCornerCount,
+                                       std::vector<Triangle>& _out)
+        {
+            if (_uCornerCount < 3)
+                return;
+
+            if (_uCornerCount == 3) {
+                _out.push_back(Triangle{ _pCorners[0], _pCorners[1], _pCorners[2] });
+                return;
+            }
+
+            for (uint32_t i = 0; i < _uCornerCount; i++) {
+                if (_pCorners[i].x >= _vertices.geometricVertices.size())
+                    throw ConvertionException("Wavefront obj: Face references a vertex position out of range");
+            }
+
+            if (_uCornerCount == 4) {
+                // split along the 0-2 diagonal unless it lies outside of a concave quad, which flips one of the halves
+                const TRS::Vector3<float> p0 = _Position(_vertices, _pCorners[0]);
+                const TRS::Vector3<float> p1 = _Position(_vertices, _pCorners[1]);
+                const TRS::Vector3<float> p2 = _Position(_vertices, _pCorners[2]);
+                const TRS::Vector3<float> p3 = _Position(_vertices, _pCorners[3]);
+                const auto n1 = TRS::Vector3<float>::Cross(p1 - p0, p2 - p0);
+                const auto n2 = TRS::Vector3<float>::Cross(p2 - p0, p3 - p0);
+
+                if (TRS::Vector3<float>::Dot(n1, n2) >= 0.f) {
+                    _out.push_back(Triangle{ _pCorners[0], _pCorners[1], _pCorners[2] });
+                    _out.push_back(Triangle{ _pCorners[0], _pCorners[2], _pCorners[3] });
+                }
+                else {
+                    _out.push_back(Triangle{ _pCorners[1], _pCorners[2], _pCorners[3] });
+                    _out.push_back(Triangle{ _pCorners[1], _pCorners[3], _pCorners[0] });
+                }
+                return;
+            }
+
+            // Newell normal of the polygon
+            TRS::Vector3<float> normal;
+            for (uint32_t i = 0; i < _uCornerCount; i++) {
+                const TRS::Vector3<float> current = _Position(_vertices, _pCorners[i]);
+                const TRS::Vector3<float> next = _Position(_vertices, _pCorners[i + 1 == _uCornerCount ? 0 : i + 1]);
+                normal.first += (current.second - next.second) * (current.third + next.third);
+                normal.second += (current.third - next.third) * (current.first + next.first);
+                normal.third += (current.first - next.first) * (current.second + next.second);
+            }
+
+            // drop the dominant axis, the remaining axes are picked in cyclic order and flipped so that the polygon is counter-clockwise
+            const float arrAbs[3] = { std::fabs(normal.first), std::fabs(normal.second), std::fabs(normal.third) };
+            const uint32_t uDrop = arrAbs[0] > arrAbs[1] ? (arrAbs[0] > arrAbs[2] ? 0 : 2) : (arrAbs[1] > arrAbs[2] ? 1 : 2);
+            const uint32_t uAxisU = (uDrop + 1) % 3;
+            const uint32_t uAxisV = (uDrop + 2) % 3;
+            const float fSign = normal[uDrop] < 0.f ? -1.f : 1.f;
+
+            m_projected.resize(_uCornerCount * 2);
+            for (uint32_t i = 0; i < _uCornerCount; i++) {
+                const TRS::Vector3<float> position = _Position(_vertices, _pCorners[i]);
+                m_projected[i * 2] = position[uAxisU] * fSign;
+                m_projected[i * 2 + 1] = position[uAxisV];
+            }
+
+            _ClipEars(_pCorners, _uCornerCount, _out);
+        }
+
+
+        void Triangulator::Triangulate(const Vertices& _vertices, const Elements& _elements, std::vector<Triangle>& _out) {
+            // every polygon with n corners yields n - 2 triangles
+            _out.reserve(_out.size() + _elements.corners.size() - 2 * _elements.GetFaceCount());
+
+            for (size_t i = 0; i < _elements.GetFaceCount(); i++)
+                Triangulate(_vertices, _elements.GetFace(i), _elements.GetCornerCount(i), _out);
+        }
+
+
+        void TriangulateGroups(const Object& _obj, std::vector<std::vector<Triangle>>& _out, ThreadPool* _pThreadPool) {
+            _out.resize(_obj.groups.size());
+
+            auto fnTriangulate = [&](size_t _uBegin, size_t _uEnd) {
+                Triangulator triangulator;
+                for (size_t i = _uBegin; i < _uEnd; i++) {
+                    _out[i].clear();
+                    triangulator.Triangulate(_obj.vertices, _obj.groups[i].elements, _out[i]);
+                }
+            };
+
+            if (_pThreadPool && _obj.groups.size() > 1)
+                _pThreadPool->ParallelFor(0, _obj.groups.size(), 1, fnTriangulate);
+            else fnTriangulate(0, _obj.groups.size());
+        }
+    }
+}
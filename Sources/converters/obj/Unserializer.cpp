@@ -3,304 +3,800 @@
 // file: Unserializer.cpp - implementation file for Wavefront OBJ unserializer class
 // author: Karl-Mihkel Ott
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
 #include <string>
-#include <iostream>
+#include <string_view>
+#include <das2/converters/obj/Tokenizer.h>
 #include <das2/converters/obj/Unserializer.h>
 
+// chunks smaller than that are not worth the scheduling overhead
+#define OBJ_MIN_CHUNK_SIZE (1 << 20)
+#define OBJ_CHUNKS_PER_THREAD 4
+
 namespace das2 {
     namespace obj {
 
-        const char* _KeywordTokenToString(KeywordToken _token) {
-            const char* arrLookup[] = { 
-                "v", "vt", "vn", "vp", "cstype", "deg",
-                "bmat", "step", "p", "l", "f", 
-                "curv", "curv2", "surf", "parm", "trim", 
-                "hole", "scrv", "sp", "end", "con", "g", 
-                "s", "mg", "o", "bevel", "c_interp",
-                "d_interp", "lod", "usemtl", "mtllib", "shadow_obj",
-                "trace_obj", "ctech", "stech"
+        namespace {
+            using ObjKeywordTable = KeywordTable<KeywordToken, 36>;
+
+            constexpr ObjKeywordTable::Entry g_arrObjKeywords[] = {
+                { "#", KeywordToken::Comment },
+                { "v", KeywordToken::GeometryVertex },
+                { "vt", KeywordToken::TextureVertex },
+                { "vn", KeywordToken::VertexNormal },
+                { "vp", KeywordToken::ParameterSpaceVertex },
+                { "cstype", KeywordToken::CSType },
+                { "deg", KeywordToken::Degree },
+                { "bmat", KeywordToken::BasisMatrix },
+                { "step", KeywordToken::StepSize },
+                { "p", KeywordToken::Point },
+                { "l", KeywordToken::Line },
+                { "f", KeywordToken::Face },
+                { "curv", KeywordToken::Curve },
+                { "curv2", KeywordToken::Curve2D },
+                { "surf", KeywordToken::Surface },
+                { "parm", KeywordToken::ParameterValues },
+                { "trim", KeywordToken::OuterTrimmingLoop },
+                { "hole", KeywordToken::InnerTrimmingLoop },
+                { "scrv", KeywordToken::SpecialCurve },
+                { "sp", KeywordToken::SpecialPoint },
+                { "end", KeywordToken::EndStatement },
+                { "con", KeywordToken::Connect },
+                { "g", KeywordToken::GroupName },
+                { "s", KeywordToken::SmoothingGroup },
+                { "mg", KeywordToken::MergingGroup },
+                { "o", KeywordToken::ObjectName },
+                { "bevel", KeywordToken::BevelInterpolation },
+                { "c_interp", KeywordToken::ColorInterpolation },
+                { "d_interp", KeywordToken::DissolveInterpolation },
+                { "lod", KeywordToken::LevelOfDetail },
+                { "usemtl", KeywordToken::MaterialName },
+                { "mtllib", KeywordToken::MaterialLibrary },
+                { "shadow_obj", KeywordToken::ShadowCasting },
+                { "trace_obj", KeywordToken::RayTracing },
+                { "ctech", KeywordToken::CurveApprox },
+                { "stech", KeywordToken::SurfaceApprox }
             };
 
-            return arrLookup[static_cast<size_t>(_token)];
-        }
+            constexpr ObjKeywordTable g_objKeywords(g_arrObjKeywords);
+
+            using MtlKeywordTable = KeywordTable<MTLToken, 24>;
+
+            constexpr MtlKeywordTable::Entry g_arrMtlKeywords[] = {
+                { "newmtl", MTLToken::NewMaterial },
+                { "Ka", MTLToken::Phong_Ambient },
+                { "Kd", MTLToken::Phong_Diffuse },
+                { "Ks", MTLToken::Phong_Specular },
+                { "Ns", MTLToken::Phong_SpecularExp },
+                { "d", MTLToken::Transparency },
+                { "map_Ka", MTLToken::Phong_AmbientMapUri },
+                { "map_Kd", MTLToken::Phong_DiffuseMapUri },
+                { "map_Ks", MTLToken::Phong_SpecularMapUri },
+                { "map_Ns", MTLToken::Phong_SpecularExpUri },
+                { "map_d", MTLToken::TransparencyMapUri },
+                { "Pr", MTLToken::PBR_Roughness },
+                { "Pm", MTLToken::PBR_Metallic },
+                { "Ps", MTLToken::PBR_Sheen },
+                { "Pc", MTLToken::PBR_ClearcoatThickness },
+                { "Pcr", MTLToken::PBR_ClearcoatRoughness },
+                { "Ke", MTLToken::PBR_Emissive },
+                { "aniso", MTLToken::PBR_Anisotropy },
+                { "anisor", MTLToken::PBR_AnisotropyRotation },
+                { "map_Pr", MTLToken::PBR_RoughnessMapUri },
+                { "map_Pm", MTLToken::PBR_MetallicMapUri },
+                { "map_Ps", MTLToken::PBR_SheenMapUri },
+                { "map_Ke", MTLToken::PBR_EmissionMapUri },
+                { "norm", MTLToken::PBR_NormalMapUri }
+            };
 
+            constexpr MtlKeywordTable g_mtlKeywords(g_arrMtlKeywords);
 
-        const char* _MTLTokenToString(MTLToken _token) {
-            const char* arrLookup[] = {
-                "Ka", "Kd", "Ks", "Ns", "d", "map_Ka",
-                "map_Kd", "map_Ks", "map_Ns", "map_d", "Pr",
-                "Pm", "Ps", "Pc", "Pcr", "Ke",
-                "aniso", "anisor", "map_Pr", "map_Pm", "map_Ps",
-                "map_Ke", "norm"
-            };
 
-            return arrLookup[static_cast<size_t>(_token)];
-        }
+            // removes and returns the first whitespace separated word of _sLine
+            std::string_view _NextWord(std::string_view& _sLine) {
+                size_t uBegin = 0;
+                while (uBegin < _sLine.size() && (_sLine[uBegin] == ' ' || _sLine[uBegin] == '\t'))
+                    uBegin++;
 
+                size_t uEnd = uBegin;
+                while (uEnd < _sLine.size() && _sLine[uEnd] != ' ' && _sLine[uEnd] != '\t')
+                    uEnd++;
 
-        std::ostream& operator<<(std::ostream& _stream, std::variant<std::monostate, KeywordToken, BinString>& _val) {
-            switch (_val.index()) {
-                case TokenIndex_Keyword:
-                    _stream << _KeywordTokenToString(std::get<TokenIndex_Keyword>(_val));
-                    break;
+                const std::string_view sWord = _sLine.substr(uBegin, uEnd - uBegin);
+                _sLine.remove_prefix(uEnd);
+                return sWord;
+            }
 
-                case TokenIndex_String:
-                    _stream << std::get<TokenIndex_String>(_val).CString();
-                    break;
 
-                default:
-                    break;  
+            // reads the whole stream with a single bulk copy if its size is known, tokens are views into the returned buffer
+            std::string _ReadStream(std::istream& _stream) {
+                std::string sBuffer;
+                const std::istream::pos_type uStart = _stream.tellg();
+                if (uStart != std::istream::pos_type(-1) && _stream.seekg(0, std::ios::end)) {
+                    const std::istream::pos_type uEnd = _stream.tellg();
+                    _stream.seekg(uStart);
+                    sBuffer.resize(static_cast<size_t>(uEnd - uStart));
+                    _stream.read(sBuffer.data(), static_cast<std::streamsize>(sBuffer.size()));
+                    sBuffer.resize(static_cast<size_t>(_stream.gcount()));
+                }
+                else {
+                    _stream.clear();
+                    std::stringstream ss;
+                    ss << _stream.rdbuf();
+                    sBuffer = std::move(ss).str();
+                }
+
+                return sBuffer;
             }
 
-            return _stream;
-        }
 
+            // state changes and faces of a chunk in the order they appear in the file
+            enum class _EventType : uint8_t {
+                Face,               // uIndex: first chunk-local face, uCount: number of consecutive faces
+                Group,              // uIndex: first name in chunk strings, uCount: number of names
+                Smoothing,          // uIndex: 1 if smoothing is enabled
+                Material,           // uIndex: material name in chunk strings
+                MaterialLibrary     // uIndex: first library in chunk strings, uCount: number of libraries
+            };
 
-        std::ostream& operator<<(std::ostream& _stream, std::variant<std::monostate, MTLToken, BinString>& _val) {
-            switch (_val.index()) {
-                case TokenIndex_Keyword:
-                    _stream << _MTLTokenToString(std::get<TokenIndex_Keyword>(_val));
-                    break;
+            struct _Event {
+                _EventType eType;
+                uint32_t uIndex;
+                uint32_t uCount;
+            };
 
-                case TokenIndex_String:
-                    _stream << std::get<TokenIndex_String>(_val).CString();
-                    break;
+            // relative (negative) vertex reference, which can only be resolved once preceding chunks are known
+            struct _Fixup {
+                size_t uCorner;             // chunk-local corner index
+                uint32_t uComponent;        // 0: position, 1: texture, 2: normal
+                int64_t iLocalIndex;        // index relative to the first vertex of the chunk, can be negative
+                uint32_t uLine;             // chunk-local line number
+            };
 
-                default:
-                    break;
-            }
+            struct _ParseError {
+                bool bSet = false;
+                bool bUnexpectedEOF = false;
+                uint32_t uLine = 0;         // chunk-local line number
+                std::string sMessage;
+            };
 
-            return _stream;
-        }
+            struct _Chunk {
+                const char* pBegin = nullptr;
+                const char* pEnd = nullptr;
+
+                Vertices vertices;
+                Elements elements;
+                std::vector<_Event> events;
+                std::vector<BinString> strings;
+                std::vector<_Fixup> fixups;
+                uint32_t uLineCount = 0;
+                _ParseError error;
+            };
 
 
-        Unserializer::Unserializer(std::istream& _stream) :
-            cvar::IPlainTextUnserializer<Object>(_stream) 
-        {
-            _ParseObj();
-        }
+            // thrown internally to abort parsing of a chunk
+            struct _ChunkAbort {};
 
+            class _ChunkParser {
+                private:
+                    _Chunk& m_chunk;
+                    Tokenizer m_tokenizer;
 
-        std::optional<KeywordToken> Unserializer::_TokenizeKeyword(const BinString& _str) {
-            if (m_cObjKeywords.find(_str) != m_cObjKeywords.end())
-                return m_cObjKeywords.find(_str)->second;
+                private:
+                    [[noreturn]] void _Fail(const std::string& _sMessage, bool _bUnexpectedEOF = false) {
+                        m_chunk.error.bSet = true;
+                        m_chunk.error.bUnexpectedEOF = _bUnexpectedEOF;
+                        m_chunk.error.uLine = m_tokenizer.GetLine();
+                        m_chunk.error.sMessage = _sMessage;
+                        throw _ChunkAbort{};
+                    }
 
-            return std::nullopt;
-        }
+                    template <typename T>
+                    void _ReadVector(std::vector<T>& _dst, size_t _uMin, size_t _uMax) {
+                        T vec;
+                        size_t i = 0;
+                        for (std::string_view sToken = m_tokenizer.NextToken(); !sToken.empty(); sToken = m_tokenizer.NextToken()) {
+                            if (i == _uMax)
+                                _Fail("Wavefront obj: Unexpected token '" + std::string(sToken) + "'");
+                            if (!ParseFloat(sToken, vec[i++]))
+                                _Fail("Wavefront obj: Invalid number '" + std::string(sToken) + "'");
+                        }
+
+                        if (i < _uMin)
+                            _Fail("Wavefront obj: Expected at least " + std::to_string(_uMin) + " values");
+                        _dst.push_back(vec);
+                    }
 
+                    void _ReadFace() {
+                        auto& corners = m_chunk.elements.corners;
+                        const size_t uFirstCorner = corners.size();
+
+                        const int64_t arrLocalCounts[3] = {
+                            static_cast<int64_t>(m_chunk.vertices.geometricVertices.size()),
+                            static_cast<int64_t>(m_chunk.vertices.textureVertices.size()),
+                            static_cast<int64_t>(m_chunk.vertices.vertexNormals.size())
+                        };
+
+                        for (std::string_view sToken = m_tokenizer.NextToken(); !sToken.empty(); sToken = m_tokenizer.NextToken()) {
+                            // v, v/vt, v//vn or v/vt/vn
+                            uint32_t arrIndices[3] = { static_cast<uint32_t>(-1), static_cast<uint32_t>(-1), static_cast<uint32_t>(-1) };
+                            std::string_view sRest = sToken;
+
+                            for (uint32_t uComponent = 0; uComponent < 3; uComponent++) {
+                                const size_t uSlash = sRest.find('/');
+                                const std::string_view sIndex = sRest.substr(0, uSlash);
+
+                                if (!sIndex.empty()) {
+                                    int64_t iIndex = 0;
+                                    // UINT32_MAX (-1 after conversion to zero based) marks an absent attribute
+                                    if (!ParseInt(sIndex, iIndex) || iIndex == 0 || iIndex > static_cast<int64_t>(UINT32_MAX) ||
+                                        iIndex < -static_cast<int64_t>(UINT32_MAX))
+                                    {
+                                        _Fail("Wavefront obj: Invalid vertex index '" + std::string(sToken) + "'");
+                                    }
+
+                                    if (iIndex > 0) {
+                                        arrIndices[uComponent] = static_cast<uint32_t>(iIndex - 1);
+                                    }
+                                    else {
+                                        m_chunk.fixups.push_back(_Fixup{ corners.size(), uComponent, arrLocalCounts[uComponent] + iIndex,
+                                                                         m_tokenizer.GetLine() });
+                                    }
+                                }
+                                else if (uComponent == 0) {
+                                    _Fail("Wavefront obj: Face vertex '" + std::string(sToken) + "' has no position index");
+                                }
+
+                                if (uSlash == std::string_view::npos)
+                                    break;
+                                sRest.remove_prefix(uSlash + 1);
+                            }
+
+                            corners.emplace_back(arrIndices[0], arrIndices[1], arrIndices[2]);
+                        }
+
+                        // at least three vertices are needed for a face
+                        if (corners.size() - uFirstCorner < 3)
+                            _Fail("Wavefront obj: At least 3 vertices are needed to construct a face");
+
+                        // consecutive faces are merged into a single event
+                        const uint32_t uFace = static_cast<uint32_t>(m_chunk.elements.GetFaceCount());
+                        m_chunk.elements.faceOffsets.push_back(static_cast<uint32_t>(corners.size()));
+                        if (!m_chunk.events.empty() && m_chunk.events.back().eType == _EventType::Face)
+                            m_chunk.events.back().uCount++;
+                        else m_chunk.events.push_back(_Event{ _EventType::Face, uFace, 1 });
+                    }
 
-        bool Unserializer::_NextToken() {
-            m_token.token = std::monostate{};
-            m_token.uLine = m_uLineCounter;
+                    void _ReadNames(_EventType _eType) {
+                        const uint32_t uFirst = static_cast<uint32_t>(m_chunk.strings.size());
+                        for (std::string_view sToken = m_tokenizer.NextToken(); !sToken.empty(); sToken = m_tokenizer.NextToken())
+                            m_chunk.strings.emplace_back(std::string(sToken).c_str());
 
-            if (m_stream.peek() == -1)
-                return false;
+                        const uint32_t uCount = static_cast<uint32_t>(m_chunk.strings.size()) - uFirst;
+                        m_chunk.events.push_back(_Event{ _eType, uFirst, uCount });
+                    }
 
-            // skip whitespaces
-            while (m_stream.peek() != -1 && _Contains(m_stream.peek(), " \t\n\r", 4)) {
-                if (static_cast<char>(m_stream.peek()) == '\n')
-                    m_uLineCounter++;
-                static_cast<void>(m_stream.get());
-            }
+                    // material names may contain spaces, the same way as newmtl statements in .mtl files
+                    void _ReadMaterialName() {
+                        const std::string_view sName = m_tokenizer.Remainder();
+                        if (sName.empty())
+                            _Fail("Wavefront obj: Expected a name", m_tokenizer.IsLastLine());
 
-            if (m_stream.peek() == -1)
-                return false;
+                        m_chunk.events.push_back(_Event{ _EventType::Material, static_cast<uint32_t>(m_chunk.strings.size()), 1 });
+                        m_chunk.strings.emplace_back(std::string(sName).c_str());
+                    }
 
-            // try to extract a word
-            std::string sWord;
-            while (m_stream.peek() != -1 && !_Contains(m_stream.peek(), " \t\n\r", 4)) {
-                sWord += static_cast<char>(m_stream.get());
-            }
+                    void _ReadSmoothing() {
+                        const std::string_view sToken = m_tokenizer.NextToken();
+                        if (sToken.empty())
+                            _Fail("Wavefront obj: Expected a smoothing group", m_tokenizer.IsLastLine());
 
-            if (_TryValueTokenization(_TokenizeKeyword(sWord)) || _TryValueTokenization<BinString>(sWord)) {
-                return true;
-            }
+                        int32_t iGroup = 0;
+                        if (sToken != "off" && !ParseInt(sToken, iGroup))
+                            _Fail("Wavefront obj: Invalid smoothing group '" + std::string(sToken) + "'");
 
-            std::stringstream ss;
-            ss << "Wavefront obj: Unexpected symbol '" << static_cast<char>(m_stream.peek()) << "'at line " << m_uLineCounter;
-            throw cvar::SyntaxErrorException(ss.str());
-            return false;
-        }
+                        m_chunk.events.push_back(_Event{ _EventType::Smoothing, iGroup > 0 ? 1u : 0u, 0 });
+                    }
 
+                    void _ParseLine() {
+                        const std::string_view sKeyword = m_tokenizer.NextToken();
+                        if (sKeyword.empty() || sKeyword[0] == '#')
+                            return;
 
-        void Unserializer::_SkipLine() {
-            while (m_stream.peek() != -1 && m_stream.peek() != '\n') {
-                static_cast<void>(m_stream.get());
-            }
+                        const KeywordToken* pKeyword = g_objKeywords.Find(sKeyword);
+                        if (!pKeyword)
+                            _Fail("Wavefront obj: Unexpected token '" + std::string(sKeyword) + "'");
 
-            m_bTokenRead = _NextToken();
-        }
+                        switch (*pKeyword) {
+                            case KeywordToken::GeometryVertex:
+                                _ReadVector(m_chunk.vertices.geometricVertices, 3, 4);
+                                break;
 
+                            case KeywordToken::TextureVertex:
+                                _ReadVector(m_chunk.vertices.textureVertices, 1, 3);
+                                break;
 
-        void Unserializer::_SkipToNextKeyword() {
-            while ((m_bTokenRead = _NextToken())) {
-                if (m_token.token.index() == TokenIndex_Keyword)
-                    break;
-            }
-        }
+                            case KeywordToken::VertexNormal:
+                                _ReadVector(m_chunk.vertices.vertexNormals, 3, 3);
+                                break;
 
+                            case KeywordToken::Face:
+                                _ReadFace();
+                                break;
 
-        void Unserializer::_ReadFace() {
-            size_t i = 0;
-            while ((m_bTokenRead = _NextToken())) {
-                if (m_token.token.index() != TokenIndex_String)
-                    break;
+                            case KeywordToken::GroupName:
+                            case KeywordToken::ObjectName:
+                                _ReadNames(_EventType::Group);
+                                break;
+
+                            case KeywordToken::SmoothingGroup:
+                                _ReadSmoothing();
+                                break;
+
+                            case KeywordToken::MaterialName:
+                                _ReadMaterialName();
+                                break;
+
+                            case KeywordToken::MaterialLibrary:
+                                _ReadNames(_EventType::MaterialLibrary);
+                                break;
 
-                m_root.groups.back().elements.faces.back().emplace_back(-1, -1, -1);
-                auto& face = m_root.groups.back().elements.faces.back().back();
-                
-                std::string stdStrFace = std::get<BinString>(m_token.token).CString();
-                size_t delims[2] = { static_cast<size_t>(-1), static_cast<size_t>(-1) };
-
-                delims[0] = stdStrFace.find('/', 0);
-
-                if (delims[0] != std::string::npos)
-                    delims[1] = stdStrFace.find('/', delims[0]+1);
-                
-                // extract indices
-                if (delims[0] != std::string::npos) {
-                    face.x = std::stoi(stdStrFace.substr(0, delims[0]))-1;
-                    if (delims[1] != std::string::npos) {
-                        if (delims[1] - delims[0] > 1)
-                            face.y = std::stoi(stdStrFace.substr(delims[0]+1, delims[1] - delims[0] - 1))-1;
-                        if (stdStrFace.size() - delims[1] > 1)
-                            face.z = std::stoi(stdStrFace.substr(delims[1]+1))-1;
+                            default:
+                                break;
+                        }
                     }
-                    else if (stdStrFace.size() - delims[0] > 1) {
-                        face.y = std::stoi(stdStrFace.substr(delims[0]+1))-1;
+
+                public:
+                    _ChunkParser(_Chunk& _chunk) :
+                        m_chunk(_chunk),
+                        m_tokenizer(_chunk.pBegin, _chunk.pEnd) {}
+
+                    void Parse() {
+                        try {
+                            while (m_tokenizer.NextLine())
+                                _ParseLine();
+                        }
+                        catch (const _ChunkAbort&) {}
+
+                        m_chunk.uLineCount = m_tokenizer.GetLine();
+                    }
+            };
+
+
+            // splits [_pBegin, _pEnd) into roughly _uCount chunks, which all end with a newline or the end of the input
+            std::vector<_Chunk> _SplitChunks(const char* _pBegin, const char* _pEnd, size_t _uCount) {
+                std::vector<_Chunk> chunks;
+                const size_t uSize = static_cast<size_t>(_pEnd - _pBegin);
+                const size_t uChunkSize = uSize / std::max<size_t>(_uCount, 1) + 1;
+
+                const char* pChunk = _pBegin;
+                while (pChunk < _pEnd) {
+                    const char* pSplit = pChunk + std::min(uChunkSize, static_cast<size_t>(_pEnd - pChunk));
+                    if (pSplit < _pEnd) {
+                        const char* pNewline = static_cast<const char*>(std::memchr(pSplit, '\n', static_cast<size_t>(_pEnd - pSplit)));
+                        pSplit = pNewline ? pNewline + 1 : _pEnd;
                     }
-                } else {
-                    face.x = std::stoi(stdStrFace)-1;
+
+                    chunks.emplace_back();
+                    chunks.back().pBegin = pChunk;
+                    chunks.back().pEnd = pSplit;
+                    pChunk = pSplit;
                 }
 
-                i++;
+                return chunks;
             }
 
-            // at least three vertices are needed for a face
-            if (i < 3) {
-                std::stringstream ss;
-                ss << "Wavefront obj: At least 3 vertices are needed to construct a face at line " << m_token.uLine;
-                throw cvar::SyntaxErrorException(ss.str());
+
+            // parses _chunks on _pThreadPool if given and more than one chunk exists
+            void _ParseChunks(std::vector<_Chunk>& _chunks, ThreadPool* _pThreadPool) {
+                if (_pThreadPool && _chunks.size() > 1) {
+                    _pThreadPool->ParallelFor(0, _chunks.size(), 1, [&_chunks](size_t _uFirst, size_t _uLast) {
+                        for (size_t i = _uFirst; i < _uLast; i++)
+                            _ChunkParser(_chunks[i]).Parse();
+                    });
+                }
+                else {
+                    for (auto it = _chunks.begin(); it != _chunks.end(); it++)
+                        _ChunkParser(*it).Parse();
+                }
             }
-        }
 
 
-        void Unserializer::_ReadSmoothing() {
-            m_bTokenRead = _NextToken();
+            size_t _GetChunkCount(size_t _uSize, ThreadPool* _pThreadPool) {
+                if (!_pThreadPool)
+                    return 1;
+                return std::min(_uSize / OBJ_MIN_CHUNK_SIZE + 1, static_cast<size_t>(_pThreadPool->GetThreadCount() + 1) * OBJ_CHUNKS_PER_THREAD);
+            }
+
 
-            if (!m_bTokenRead) 
-                throw cvar::UnexpectedEOFException("No more tokens to validate Wavefront obj syntax");
-            
-            if (m_token.token.index() != TokenIndex_String) {
-                std::stringstream ss;
-                ss << "Wavefront obj: Invalid identifier '" << m_token.token << "' at line " << m_token.uLine;
-                throw cvar::SyntaxErrorException(ss.str());
+            // reports the first error in file order with its global line number
+            void _ThrowFirstError(const std::vector<_Chunk>& _chunks, uint32_t _uLineOffset) {
+                for (auto it = _chunks.begin(); it != _chunks.end(); it++) {
+                    if (it->error.bSet) {
+                        std::stringstream ss;
+                        ss << it->error.sMessage << " at line " << _uLineOffset + it->error.uLine;
+                        if (it->error.bUnexpectedEOF)
+                            throw cvar::UnexpectedEOFException(ss.str());
+                        throw cvar::SyntaxErrorException(ss.str());
+                    }
+                    _uLineOffset += it->uLineCount;
+                }
             }
 
-            if (std::get<TokenIndex_String>(m_token.token) != "off" && std::stoi(std::get<TokenIndex_String>(m_token.token).CString()) > 0)
-                m_root.groups.back().bSmoothing = true;
 
-            m_bTokenRead = _NextToken();
+            // Merges parsed chunks in file order into vertex and group arrays.
+            // Relative indices are resolved against the global vertex counts, which also include vertices that were merged
+            // into earlier (already consumed) destinations when streaming.
+            class _ChunkMerger {
+                private:
+                    std::array<uint64_t, 3> m_arrCounts = {};
+                    uint32_t m_uLineOffset = 0;
+
+                public:
+                    Vertices* pVertices = nullptr;
+                    std::vector<Group>* pGroups = nullptr;
+                    std::vector<BinString>* pMaterialLibraries = nullptr;
+                    bool bSealed = false;               // true if the faces of pGroups->back() were already consumed
+
+                public:
+                    inline uint32_t GetLineOffset() const {
+                        return m_uLineOffset;
+                    }
+
+                    inline const std::array<uint64_t, 3>& GetCounts() const {
+                        return m_arrCounts;
+                    }
+
+                    void Merge(_Chunk& _chunk) {
+                        for (auto fixIt = _chunk.fixups.begin(); fixIt != _chunk.fixups.end(); fixIt++) {
+                            const int64_t iIndex = static_cast<int64_t>(m_arrCounts[fixIt->uComponent]) + fixIt->iLocalIndex;
+                            if (iIndex < 0) {
+                                std::stringstream ss;
+                                ss << "Wavefront obj: Relative vertex index points before the first vertex at line " << m_uLineOffset + fixIt->uLine;
+                                throw cvar::SyntaxErrorException(ss.str());
+                            }
+                            if (iIndex >= static_cast<int64_t>(UINT32_MAX)) {
+                                std::stringstream ss;
+                                ss << "Wavefront obj: Invalid vertex index at line " << m_uLineOffset + fixIt->uLine;
+                                throw cvar::SyntaxErrorException(ss.str());
+                            }
+
+                            auto& corner = _chunk.elements.corners[fixIt->uCorner];
+                            uint32_t* arrComponents[3] = { &corner.x, &corner.y, &corner.z };
+                            *arrComponents[fixIt->uComponent] = static_cast<uint32_t>(iIndex);
+                        }
+
+                        auto fnAppend = [](auto& _dst, auto& _src) {
+                            _dst.insert(_dst.end(), _src.begin(), _src.end());
+                        };
+                        fnAppend(pVertices->geometricVertices, _chunk.vertices.geometricVertices);
+                        fnAppend(pVertices->textureVertices, _chunk.vertices.textureVertices);
+                        fnAppend(pVertices->vertexNormals, _chunk.vertices.vertexNormals);
+                        m_arrCounts[0] += _chunk.vertices.geometricVertices.size();
+                        m_arrCounts[1] += _chunk.vertices.textureVertices.size();
+                        m_arrCounts[2] += _chunk.vertices.vertexNormals.size();
+
+                        // replay state changes, a new group is started only if the current one already has faces
+                        for (auto evIt = _chunk.events.begin(); evIt != _chunk.events.end(); evIt++) {
+                            if (evIt->eType != _EventType::Face && evIt->eType != _EventType::MaterialLibrary &&
+                                (bSealed || !pGroups->back().elements.Empty()))
+                            {
+                                pGroups->emplace_back();
+                                bSealed = false;
+                            }
+
+                            Group& group = pGroups->back();
+                            switch (evIt->eType) {
+                                case _EventType::Face:
+                                {
+                                    const uint32_t uFirstCorner = _chunk.elements.faceOffsets[evIt->uIndex];
+                                    const uint32_t uLastCorner = _chunk.elements.faceOffsets[evIt->uIndex + evIt->uCount];
+                                    const uint32_t uBase = static_cast<uint32_t>(group.elements.corners.size()) - uFirstCorner;
+
+                                    group.elements.corners.insert(group.elements.corners.end(), _chunk.elements.corners.begin() + uFirstCorner,
+                                                                  _chunk.elements.corners.begin() + uLastCorner);
+                                    for (uint32_t i = 1; i <= evIt->uCount; i++)
+                                        group.elements.faceOffsets.push_back(uBase + _chunk.elements.faceOffsets[evIt->uIndex + i]);
+                                    break;
+                                }
+
+                                case _EventType::Group:
+                                    for (uint32_t i = 0; i < evIt->uCount; i++)
+                                        group.groupNames.push_back(std::move(_chunk.strings[evIt->uIndex + i]));
+                                    break;
+
+                                case _EventType::Smoothing:
+                                    if (evIt->uIndex)
+                                        group.bSmoothing = true;
+                                    break;
+
+                                case _EventType::Material:
+                                    group.szMaterialName = std::move(_chunk.strings[evIt->uIndex]);
+                                    break;
+
+                                case _EventType::MaterialLibrary:
+                                    for (uint32_t i = 0; i < evIt->uCount; i++)
+                                        pMaterialLibraries->push_back(std::move(_chunk.strings[evIt->uIndex + i]));
+                                    break;
+                            }
+                        }
+
+                        m_uLineOffset += _chunk.uLineCount;
+
+                        // release chunk memory early, large inputs would otherwise keep two copies of all data alive
+                        _chunk = _Chunk();
+                    }
+            };
         }
 
 
-        void Unserializer::_ReadGroup() {
-            while ((m_bTokenRead = _NextToken()) && m_token.token.index() == TokenIndex_String)
-                m_root.groups.back().groupNames.push_back(std::get<TokenIndex_String>(m_token.token));
+        Unserializer::Unserializer(std::istream& _stream, ThreadPool* _pThreadPool) :
+            cvar::IPlainTextUnserializer<Object>(_stream),
+            m_pThreadPool(_pThreadPool)
+        {
+            _ParseObj();
         }
 
 
-        void Unserializer::_ReadMaterialName() {
-            uint32_t uPrevLine = m_token.uLine;
-            if (!(m_bTokenRead = _NextToken())) {
-                std::stringstream ss;
-                ss << "Wavefront obj: Unexpected end of file at line " << uPrevLine;
-                throw cvar::UnexpectedEOFException(ss.str());
+        void Unserializer::_ParseObj() {
+            const std::string sBuffer = _ReadStream(m_stream);
+            std::vector<_Chunk> chunks = _SplitChunks(sBuffer.data(), sBuffer.data() + sBuffer.size(), _GetChunkCount(sBuffer.size(), m_pThreadPool));
+            _ParseChunks(chunks, m_pThreadPool);
+            _ThrowFirstError(chunks, 0);
+
+            size_t uVertexCount = 0, uTextureCount = 0, uNormalCount = 0;
+            for (auto it = chunks.begin(); it != chunks.end(); it++) {
+                uVertexCount += it->vertices.geometricVertices.size();
+                uTextureCount += it->vertices.textureVertices.size();
+                uNormalCount += it->vertices.vertexNormals.size();
             }
+            m_root.vertices.geometricVertices.reserve(uVertexCount);
+            m_root.vertices.textureVertices.reserve(uTextureCount);
+            m_root.vertices.vertexNormals.reserve(uNormalCount);
+            m_root.groups.emplace_back();
+
+            _ChunkMerger merger;
+            merger.pVertices = &m_root.vertices;
+            merger.pGroups = &m_root.groups;
+            merger.pMaterialLibraries = &m_root.materialLibraries;
+            for (auto it = chunks.begin(); it != chunks.end(); it++)
+                merger.Merge(*it);
+        }
 
-            if (m_token.token.index() != TokenIndex_String) {
-                std::stringstream ss;
-                ss << "Wavefront obj: Unexpected token '" << m_token.token << "' at line " << m_token.uLine;
-                throw cvar::UnexpectedEOFException(ss.str());
-            }
 
-            m_root.groups.back().szMaterialName = std::get<TokenIndex_String>(m_token.token);
+        struct StreamingUnserializer::_State {
+            _ChunkMerger merger;
+            Group openGroup;                // state and faces of the group the previous block ended with
+            bool bOpenGroupSealed = false;
+        };
 
-            m_bTokenRead = _NextToken();
+
+        StreamingUnserializer::StreamingUnserializer(std::istream& _stream, size_t _uBlockSize, ThreadPool* _pThreadPool) :
+            m_stream(_stream),
+            m_uBlockSize(std::max<size_t>(_uBlockSize, 1)),
+            m_pThreadPool(_pThreadPool),
+            m_pState(std::make_unique<_State>())
+        {
         }
 
 
-        void Unserializer::_ReadMaterialLibrary() {
-            while ((m_bTokenRead = _NextToken())) {
-                if (m_token.token.index() != TokenIndex_String) {
+        StreamingUnserializer::~StreamingUnserializer() = default;
+
+
+        bool StreamingUnserializer::Next(StreamedBlock& _block) {
+            _block.vertices = Vertices();
+            _block.groups.clear();
+            _block.materialLibraries.clear();
+            _block.bContinuesGroup = false;
+
+            // read until the block holds at least one complete line, the unterminated tail is kept for the next block
+            size_t uEnd = 0;
+            while (true) {
+                const size_t uSize = m_sBuffer.size();
+                if (m_stream && m_sBuffer.size() < m_uBlockSize) {
+                    m_sBuffer.resize(m_uBlockSize);
+                    m_stream.read(m_sBuffer.data() + uSize, static_cast<std::streamsize>(m_uBlockSize - uSize));
+                    m_sBuffer.resize(uSize + static_cast<size_t>(m_stream.gcount()));
+                }
+
+                if (!m_stream) {
+                    uEnd = m_sBuffer.size();
+                    break;
+                }
+
+                const size_t uNewline = m_sBuffer.rfind('\n');
+                if (uNewline != std::string::npos) {
+                    uEnd = uNewline + 1;
                     break;
                 }
 
-                m_root.materials.emplace(std::get<TokenIndex_String>(m_token.token), Material{});
+                // a single line is longer than the block size
+                const size_t uGrowth = m_sBuffer.size();
+                m_sBuffer.resize(uGrowth * 2);
+                m_stream.read(m_sBuffer.data() + uGrowth, static_cast<std::streamsize>(uGrowth));
+                m_sBuffer.resize(uGrowth + static_cast<size_t>(m_stream.gcount()));
             }
+
+            if (!uEnd)
+                return false;
+            const bool bLast = !m_stream && uEnd == m_sBuffer.size();
+
+            std::vector<_Chunk> chunks = _SplitChunks(m_sBuffer.data(), m_sBuffer.data() + uEnd, _GetChunkCount(uEnd, m_pThreadPool));
+            _ParseChunks(chunks, m_pThreadPool);
+            _ThrowFirstError(chunks, m_pState->merger.GetLineOffset());
+
+            const std::array<uint64_t, 3>& arrCounts = m_pState->merger.GetCounts();
+            _block.uFirstPosition = arrCounts[0];
+            _block.uFirstTexture = arrCounts[1];
+            _block.uFirstNormal = arrCounts[2];
+
+            _block.groups.push_back(std::move(m_pState->openGroup));
+            _block.bContinuesGroup = m_pState->bOpenGroupSealed;
+            m_pState->merger.pVertices = &_block.vertices;
+            m_pState->merger.pGroups = &_block.groups;
+            m_pState->merger.pMaterialLibraries = &_block.materialLibraries;
+            m_pState->merger.bSealed = m_pState->bOpenGroupSealed;
+            for (auto it = chunks.begin(); it != chunks.end(); it++)
+                m_pState->merger.Merge(*it);
+
+            // the group the block ends with may continue in the next block, its faces are handed out now and its state is kept
+            Group& lastGroup = _block.groups.back();
+            if (bLast) {
+                m_pState->openGroup = Group();
+                m_pState->bOpenGroupSealed = false;
+            }
+            else if (lastGroup.elements.Empty()) {
+                m_pState->openGroup = std::move(lastGroup);
+                m_pState->bOpenGroupSealed = m_pState->merger.bSealed;
+                _block.groups.pop_back();
+            }
+            else {
+                m_pState->openGroup = Group();
+                m_pState->openGroup.szMaterialName = lastGroup.szMaterialName;
+                m_pState->openGroup.groupNames = lastGroup.groupNames;
+                m_pState->openGroup.bSmoothing = lastGroup.bSmoothing;
+                m_pState->bOpenGroupSealed = true;
+            }
+
+            // groups without faces are not reported
+            if (_block.bContinuesGroup && (_block.groups.empty() || _block.groups.front().elements.Empty()))
+                _block.bContinuesGroup = false;
+            _block.groups.erase(std::remove_if(_block.groups.begin(), _block.groups.end(), [](const Group& _group) { return _group.elements.Empty(); }),
+                                _block.groups.end());
+
+            m_sBuffer.erase(0, uEnd);
+            return true;
         }
 
 
-        void Unserializer::_ParseObj() {
-            m_bTokenRead = _NextToken();
-            m_root.groups.emplace_back();
+        UnserializerMtl::UnserializerMtl(std::istream& _stream) :
+            cvar::IPlainTextUnserializer<MaterialLibrary>(_stream)
+        {
+            _ParseMtl();
+        }
 
-            while (m_bTokenRead) {
-                if (m_token.token.index() != TokenIndex_Keyword) {
-                    std::stringstream ss;
-                    ss << "Wavefront obj: Unexpected token '" << m_token.token << "' at line " << m_token.uLine;
-                    throw cvar::SyntaxErrorException(ss.str());
+
+        void UnserializerMtl::_ParseMtl() {
+            const std::string sBuffer = _ReadStream(m_stream);
+            Tokenizer tokenizer(sBuffer.data(), sBuffer.data() + sBuffer.size());
+            Material* pMaterial = nullptr;
+
+            auto fnFail = [&tokenizer](const std::string& _sMessage) {
+                std::stringstream ss;
+                ss << "Wavefront mtl: " << _sMessage << " at line " << tokenizer.GetLine();
+                throw cvar::SyntaxErrorException(ss.str());
+            };
+
+            auto fnReadFloat = [&]() {
+                float fValue = 0.f;
+                const std::string_view sToken = tokenizer.NextToken();
+                if (sToken.empty())
+                    fnFail("Expected a value");
+                if (!ParseFloat(sToken, fValue))
+                    fnFail("Invalid number '" + std::string(sToken) + "'");
+                return fValue;
+            };
+
+            // "r [g b]", a single value is used for all components, spectral and xyz colors are not supported
+            auto fnReadColor = [&]() {
+                const std::string_view sFirst = tokenizer.NextToken();
+                if (sFirst == "spectral" || sFirst == "xyz")
+                    fnFail("Unsupported color statement '" + std::string(sFirst) + "'");
+
+                TRS::Vector3<float> vColor;
+                if (sFirst.empty() || !ParseFloat(sFirst, vColor.first))
+                    fnFail("Invalid color value '" + std::string(sFirst) + "'");
+
+                const std::string_view sSecond = tokenizer.NextToken();
+                if (sSecond.empty()) {
+                    vColor.second = vColor.third = vColor.first;
+                    return vColor;
+                }
+
+                if (!ParseFloat(sSecond, vColor.second) || !ParseFloat(tokenizer.NextToken(), vColor.third))
+                    fnFail("Invalid color value");
+                return vColor;
+            };
+
+            // texture map options precede the file name, which may contain spaces
+            auto fnReadMap = [&]() {
+                std::string_view sLine = tokenizer.Remainder();
+                while (!sLine.empty() && sLine[0] == '-') {
+                    const std::string_view sOption = _NextWord(sLine);
+
+                    // options take one argument, except for -mm (two) and -o, -s, -t (one to three numbers)
+                    uint32_t uMaxArguments = 1;
+                    if (sOption == "-o" || sOption == "-s" || sOption == "-t")
+                        uMaxArguments = 3;
+                    else if (sOption == "-mm")
+                        uMaxArguments = 2;
+
+                    static_cast<void>(_NextWord(sLine));
+                    for (uint32_t i = 1; i < uMaxArguments; i++) {
+                        std::string_view sPeek = sLine;
+                        float fArgument = 0.f;
+                        if (!ParseFloat(_NextWord(sPeek), fArgument))
+                            break;
+                        sLine = sPeek;
+                    }
+
+                    while (!sLine.empty() && (sLine[0] == ' ' || sLine[0] == '\t'))
+                        sLine.remove_prefix(1);
+                }
+
+                if (sLine.empty())
+                    fnFail("Expected a texture map file name");
+                return BinString(std::string(sLine).c_str());
+            };
+
+            while (tokenizer.NextLine()) {
+                const std::string_view sKeyword = tokenizer.NextToken();
+                if (sKeyword.empty() || sKeyword[0] == '#')
+                    continue;
+
+                const MTLToken* pToken = g_mtlKeywords.Find(sKeyword);
+                if (!pToken)
+                    continue;
+
+                if (*pToken == MTLToken::NewMaterial) {
+                    const std::string_view sName = tokenizer.Remainder();
+                    if (sName.empty())
+                        fnFail("Expected a material name");
+                    pMaterial = &m_root[BinString(std::string(sName).c_str())];
+                    continue;
                 }
 
-                KeywordToken kwToken = std::get<KeywordToken>(m_token.token);
-                switch (kwToken) {
-                    case KeywordToken::Comment:
-                        _SkipLine();
-                        break;
-
-                    case KeywordToken::GeometryVertex:
-                        m_root.vertices.geometricVertices.push_back(_ReadVector<TRS::Vector4<float>>(3, 4));
-                        break;
-
-                    case KeywordToken::TextureVertex:
-                        m_root.vertices.textureVertices.push_back(_ReadVector<TRS::Vector3<float>>(1, 3));
-                        break;
-
-                    case KeywordToken::VertexNormal:
-                        m_root.vertices.vertexNormals.push_back(_ReadVector<TRS::Vector3<float>>(3, 3));
-                        break;
-
-                    case KeywordToken::Face:
-                        m_root.groups.back().elements.faces.emplace_back();
-                        _ReadFace();
-                        break;
-
-                    case KeywordToken::GroupName:
-                    case KeywordToken::ObjectName:
-                        if (m_root.groups.size() && !m_root.groups.back().elements.faces.empty())
-                            m_root.groups.emplace_back();
-                        _ReadGroup();
-                        break;
-
-                    case KeywordToken::SmoothingGroup:
-                        if (m_root.groups.size() && !m_root.groups.back().elements.faces.empty())
-                            m_root.groups.emplace_back();
-                        _ReadSmoothing();                        
-                        break;
-
-                    case KeywordToken::MaterialName:
-                        if (m_root.groups.size() && !m_root.groups.back().elements.faces.empty())
-                            m_root.groups.emplace_back();
-                        _ReadMaterialName();
-                        break;
-
-                    case KeywordToken::MaterialLibrary:
-                        _ReadMaterialLibrary();
-                        break;
-
-                    default:
-                        _SkipToNextKeyword();
-                        break;
+                if (!pMaterial)
+                    fnFail("Statement '" + std::string(sKeyword) + "' before newmtl");
+
+                switch (*pToken) {
+                    case MTLToken::Phong_Ambient:           pMaterial->vKa = fnReadColor(); break;
+                    case MTLToken::Phong_Diffuse:           pMaterial->vKd = fnReadColor(); break;
+                    case MTLToken::Phong_Specular:          pMaterial->vKs = fnReadColor(); break;
+                    case MTLToken::Phong_SpecularExp:       pMaterial->fNs = fnReadFloat(); break;
+                    case MTLToken::Transparency:            pMaterial->fD = fnReadFloat(); break;
+                    case MTLToken::Phong_AmbientMapUri:     pMaterial->szMapKaUri = fnReadMap(); break;
+                    case MTLToken::Phong_DiffuseMapUri:     pMaterial->szMapKdUri = fnReadMap(); break;
+                    case MTLToken::Phong_SpecularMapUri:    pMaterial->szMapKsUri = fnReadMap(); break;
+                    case MTLToken::Phong_SpecularExpUri:    pMaterial->szMapNsUri = fnReadMap(); break;
+                    case MTLToken::TransparencyMapUri:      pMaterial->szMapDUri = fnReadMap(); break;
+                    case MTLToken::PBR_Emissive:            pMaterial->vEmissive = fnReadColor(); break;
+                    case MTLToken::PBR_EmissionMapUri:      pMaterial->szEmissionMapUri = fnReadMap(); break;
+                    case MTLToken::PBR_Roughness:           pMaterial->fPr = fnReadFloat(); pMaterial->bPbr = true; break;
+                    case MTLToken::PBR_Metallic:            pMaterial->fPm = fnReadFloat(); pMaterial->bPbr = true; break;
+                    case MTLToken::PBR_Sheen:               pMaterial->fSheen = fnReadFloat(); pMaterial->bPbr = true; break;
+                    case MTLToken::PBR_ClearcoatThickness:  pMaterial->fPc = fnReadFloat(); pMaterial->bPbr = true; break;
+                    case MTLToken::PBR_ClearcoatRoughness:  pMaterial->fPcr = fnReadFloat(); pMaterial->bPbr = true; break;
+                    case MTLToken::PBR_Anisotropy:          pMaterial->fAnisotropy = fnReadFloat(); pMaterial->bPbr = true; break;
+                    case MTLToken::PBR_AnisotropyRotation:  pMaterial->fAnisor = fnReadFloat(); pMaterial->bPbr = true; break;
+                    case MTLToken::PBR_RoughnessMapUri:     pMaterial->szMapPrUri = fnReadMap(); pMaterial->bPbr = true; break;
+                    case MTLToken::PBR_MetallicMapUri:      pMaterial->szMapPmUri = fnReadMap(); pMaterial->bPbr = true; break;
+                    case MTLToken::PBR_SheenMapUri:         pMaterial->szMapSheenUri = fnReadMap(); pMaterial->bPbr = true; break;
+                    case MTLToken::PBR_NormalMapUri:        pMaterial->szNormalMapUri = fnReadMap(); pMaterial->bPbr = true; break;
+                    default: break;
                 }
             }
         }
@@ -0,0 +1,130 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: VertexWelder.cpp - implementation of unified vertex deduplication for obj conversion
+// author: Karl-Mihkel Ott
+
+#include <cstring>
+#include <das2/converters/obj/VertexWelder.h>
+
+#define EMPTY_SLOT static_cast<uint32_t>(-1)
+
+namespace das2 {
+    namespace obj {
+
+        namespace {
+            // bit pattern of a float with -0.0 folded into 0.0
+            inline uint32_t _FloatBits(float _fValue) {
+                uint32_t uBits = 0;
+                if (_fValue != 0.f)
+                    std::memcpy(&uBits, &_fValue, sizeof(float));
+                return uBits;
+            }
+
+            inline uint64_t _Mix(uint64_t _uHash, uint32_t _uBits) {
+                _uHash ^= _uBits;
+                _uHash *= 0x100000001b3ull;
+                return _uHash;
+            }
+        }
+
+
+        VertexWelder::VertexWelder(size_t _uCornerCount, bool _bUVs) :
+            m_bUVs(_bUVs)
+        {
+            m_positions.reserve(_uCornerCount);
+            m_normals.reserve(_uCornerCount);
+            m_indices.reserve(_uCornerCount);
+            m_hashes.reserve(_uCornerCount);
+            if (m_bUVs)
+                m_uvs.reserve(_uCornerCount);
+
+            // keep the load factor at or below 0.5, so that the table never grows when every corner is unique
+            size_t uCapacity = 16;
+            while (uCapacity < _uCornerCount * 2)
+                uCapacity <<= 1;
+            _Rehash(uCapacity);
+        }
+
+
+        uint64_t VertexWelder::_Hash(const UnifiedVertex& _vertex) {
+            uint64_t uHash = 0xcbf29ce484222325ull;
+            uHash = _Mix(uHash, _FloatBits(_vertex.positionVertex.first));
+            uHash = _Mix(uHash, _FloatBits(_vertex.positionVertex.second));
+            uHash = _Mix(uHash, _FloatBits(_vertex.positionVertex.third));
+            uHash = _Mix(uHash, _FloatBits(_vertex.textureVertex.first));
+            uHash = _Mix(uHash, _FloatBits(_vertex.textureVertex.second));
+            uHash = _Mix(uHash, _FloatBits(_vertex.normalVertex.first));
+            uHash = _Mix(uHash, _FloatBits(_vertex.normalVertex.second));
+            uHash = _Mix(uHash, _FloatBits(_vertex.normalVertex.third));
+            return uHash ^ (uHash >> 29);
+        }
+
+
+        bool VertexWelder::_Equals(uint32_t _uIndex, const UnifiedVertex& _vertex) const {
+            const TRS::Vector3<float>& position = m_positions[_uIndex];
+            const TRS::Vector3<float>& normal = m_normals[_uIndex];
+            if (_FloatBits(position.first) != _FloatBits(_vertex.positionVertex.first) ||
+                _FloatBits(position.second) != _FloatBits(_vertex.positionVertex.second) ||
+                _FloatBits(position.third) != _FloatBits(_vertex.positionVertex.third) ||
+                _FloatBits(normal.first) != _FloatBits(_vertex.normalVertex.first) ||
+                _FloatBits(normal.second) != _FloatBits(_vertex.normalVertex.second) ||
+                _FloatBits(normal.third) != _FloatBits(_vertex.normalVertex.third))
+            {
+                return false;
+            }
+
+            if (m_bUVs) {
+                const TRS::Vector2<float>& uv = m_uvs[_uIndex];
+                return _FloatBits(uv.first) == _FloatBits(_vertex.textureVertex.first) &&
+                       _FloatBits(uv.second) == _FloatBits(_vertex.textureVertex.second);
+            }
+
+            return true;
+        }
+
+
+        void VertexWelder::_Rehash(size_t _uCapacity) {
+            m_table.assign(_uCapacity, EMPTY_SLOT);
+            m_uMask = static_cast<uint32_t>(_uCapacity - 1);
+
+            for (uint32_t i = 0; i < static_cast<uint32_t>(m_hashes.size()); i++) {
+                uint32_t uSlot = static_cast<uint32_t>(m_hashes[i]) & m_uMask;
+                while (m_table[uSlot] != EMPTY_SLOT)
+                    uSlot = (uSlot + 1) & m_uMask;
+                m_table[uSlot] = i;
+            }
+        }
+
+
+        uint32_t VertexWelder::Weld(const UnifiedVertex& _vertex) {
+            UnifiedVertex vertex = _vertex;
+            if (!m_bUVs)
+                vertex.textureVertex = TRS::Vector2<float>();
+
+            const uint64_t uHash = _Hash(vertex);
+            uint32_t uSlot = static_cast<uint32_t>(uHash) & m_uMask;
+            while (m_table[uSlot] != EMPTY_SLOT) {
+                const uint32_t uIndex = m_table[uSlot];
+                if (m_hashes[uIndex] == uHash && _Equals(uIndex, vertex)) {
+                    m_indices.push_back(uIndex);
+                    return uIndex;
+                }
+                uSlot = (uSlot + 1) & m_uMask;
+            }
+
+            const uint32_t uIndex = static_cast<uint32_t>(m_positions.size());
+            m_table[uSlot] = uIndex;
+            m_hashes.push_back(uHash);
+            m_positions.push_back(vertex.positionVertex);
+            m_normals.push_back(vertex.normalVertex);
+            if (m_bUVs)
+                m_uvs.push_back(vertex.textureVertex);
+            m_indices.push_back(uIndex);
+
+            if (m_positions.size() * 2 > m_table.size())
+                _Rehash(m_table.size() * 2);
+
+            return uIndex;
+        }
+    }
+}
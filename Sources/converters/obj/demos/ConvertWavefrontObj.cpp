@@ -3,9 +3,11 @@
 // file: ConvertWavefrontObj.cpp - implementation of demo program to convert wavefront obj files into das2 files
 // author: Karl-Mihkel Ott
 
+#include <filesystem>
 #include <iostream>
 #include <fstream>
 #include <das2/Exceptions.h>
+#include <das2/converters/obj/MaterialLibraryCache.h>
 #include <das2/converters/obj/demos/ConvertWavefrontObj.h>
 
 namespace das2 {
@@ -29,6 +31,11 @@ namespace das2 {
             das2::obj::Object obj = m_pUnserializer->Get();
             m_fileInputStream.close();
 
+            const std::vector<std::string> missingLibraries =
+                das2::obj::LoadMaterialLibraries(obj, std::filesystem::path(_szInputFileName).parent_path());
+            for (auto it = missingLibraries.begin(); it != missingLibraries.end(); it++)
+                std::cerr << "Material library '" << *it << "' not found\n";
+
             try {
                 m_pDasConverter = new das2::obj::DasConverter(obj, "", "", _bZlibCompression);
             }
@@ -64,11 +64,13 @@ namespace das2 {
                 std::cout << "bSmoothing: " << (it->bSmoothing ? "true\n" : "false\n");
                 std::cout << "elements:\n";
 
-                for (auto it2 = it->elements.faces.begin(); it2 != it->elements.faces.end(); it2++) {
+                for (size_t i = 0; i < it->elements.GetFaceCount(); i++) {
                     std::cout << "f ";
-                    for (auto it3 = it2->begin(); it3 != it2->end(); it3++) {
-                        std::cout << it3->x << '/' << it3->y << '/' << it3->z;
-                        if (std::next(it3) == it2->end())
+                    const TRS::Point3D<uint32_t>* pFace = it->elements.GetFace(i);
+                    const uint32_t uCornerCount = it->elements.GetCornerCount(i);
+                    for (uint32_t j = 0; j < uCornerCount; j++) {
+                        std::cout << pFace[j].x << '/' << pFace[j].y << '/' << pFace[j].z;
+                        if (j + 1 == uCornerCount)
                             std::cout << '\n';
                         else std::cout << ' ';
                     }
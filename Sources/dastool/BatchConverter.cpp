@@ -0,0 +1,396 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: BatchConverter.cpp - implementation of dastool parallel batch conversion of Wavefront OBJ files
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include <das2/Exceptions.h>
+#include <das2/Instancing.h>
+#include <das2/MemoryReport.h>
+#include <das2/Serializer.h>
+#include <das2/ThreadPool.h>
+#include <das2/converters/obj/DasConverter.h>
+#include <das2/converters/obj/MaterialLibraryCache.h>
+#include <das2/converters/obj/StreamingConverter.h>
+#include <das2/converters/obj/Unserializer.h>
+#include <das2/dastool/BatchConverter.h>
+#include <das2/dastool/Common.h>
+
+namespace fs = std::filesystem;
+
+namespace das2 {
+    namespace dastool {
+
+        namespace {
+            void _PrintUsage() {
+                std::cout << "Usage: dastool convert <input>... [options]\n"
+                          << "Inputs are obj files, directories searched recursively for obj files or glob patterns ('*', '?', '**').\n"
+                          << "  -o, --output <dir>      output directory, directory inputs keep their relative layout (default: next to inputs)\n"
+                          << "  -j, --jobs <n>          files converted concurrently, 0 uses hardware concurrency (default 0)\n"
+                          << "  --memory-limit <MiB>    approximate memory limit of a single conversion, larger files are streamed (default 1024)\n"
+                          << "  --zstd <level>          das2 compression level (0, 1, 9 or 255)\n"
+                          << "  --incremental           skip files whose output is newer than the input\n"
+                          << "  --instance              replace duplicated geometry with transformed instances (in-memory conversions only)\n"
+                          << "  -v, --verbose           log every converted file\n";
+            }
+
+
+            // compares paths regardless of how they were spelled on the command line, e.g. "./a.obj" and "a.obj"
+            fs::path _NormalizePath(const fs::path& _path) {
+                std::error_code error;
+                fs::path absolute = fs::absolute(_path, error);
+                return (error ? _path : absolute).lexically_normal();
+            }
+        }
+
+
+        BatchConverter::BatchConverter(const BatchConverterSettings& _settings) :
+            m_settings(_settings) {}
+
+
+        void BatchConverter::_AddFile(const fs::path& _file, const fs::path& _root) {
+            BatchEntry entry;
+            entry.inputPath = _file;
+
+            if (m_settings.outputDirectory.empty())
+                entry.outputPath = _file;
+            else entry.outputPath = m_settings.outputDirectory / _file.lexically_relative(_root);
+            entry.outputPath.replace_extension(DASTOOL_OUTPUT_EXTENSION);
+
+            std::error_code error;
+            entry.uInputSize = fs::file_size(_file, error);
+            m_entries.push_back(std::move(entry));
+        }
+
+
+        void BatchConverter::_AddMissing(const std::string& _sInput) {
+            BatchEntry entry;
+            entry.inputPath = _sInput;
+            entry.eStatus = BatchStatus_Failed;
+            entry.sMessage = "No such file, directory or matching files";
+            m_entries.push_back(std::move(entry));
+        }
+
+
+        void BatchConverter::AddInput(const std::string& _sInput) {
+            std::vector<InputFile> files;
+            if (!ExpandInput(_sInput, ".obj", files)) {
+                _AddMissing(_sInput);
+                return;
+            }
+
+            for (const InputFile& file : files)
+                _AddFile(file.path, file.root);
+        }
+
+
+        void BatchConverter::_Convert(BatchEntry& _entry) const {
+            const fs::path parentDirectory = _entry.inputPath.parent_path();
+            fs::path tempPath = _entry.outputPath;
+            tempPath += ".tmp";
+
+            if (!_entry.outputPath.parent_path().empty())
+                fs::create_directories(_entry.outputPath.parent_path());
+
+            {
+                std::ifstream input(_entry.inputPath, std::ios_base::binary);
+                if (!input)
+                    throw std::runtime_error("Cannot open '" + _entry.inputPath.string() + "' for reading");
+
+                std::ofstream output(tempPath, std::ios_base::binary | std::ios_base::trunc);
+                if (!output)
+                    throw std::runtime_error("Cannot open '" + tempPath.string() + "' for writing");
+
+                _entry.bStreamed = _entry.uInputSize > m_settings.uMemoryLimit / DASTOOL_IN_MEMORY_FACTOR;
+                if (_entry.bStreamed) {
+                    obj::StreamingConverterSettings settings;
+                    settings.uMemoryBudget = m_settings.uMemoryLimit;
+                    settings.materialDirectory = parentDirectory.empty() ? fs::path(".") : parentDirectory;
+                    settings.bZstdLevel = m_settings.bZstdLevel;
+
+                    obj::StreamingConverter converter(input, output, settings);
+                    converter.Convert();
+                    _entry.missingLibraries = converter.GetMissingMaterialLibraries();
+                }
+                else {
+                    obj::Unserializer unserializer(input);
+                    obj::Object object = std::move(unserializer.Get());
+                    input.close();
+
+                    _entry.missingLibraries = obj::LoadMaterialLibraries(object, parentDirectory);
+                    obj::DasConverter converter(std::move(object), "", "", m_settings.bZstdLevel);
+                    Model model = converter.GetModel();
+                    if (m_settings.bInstancing)
+                        InstanceDuplicateGeometry(model);
+                    Serializer(output, model).Serialize();
+                }
+
+                output.close();
+                if (!output)
+                    throw std::runtime_error("Failed to write '" + tempPath.string() + "'");
+            }
+
+            fs::rename(tempPath, _entry.outputPath);
+            _entry.uOutputSize = fs::file_size(_entry.outputPath);
+        }
+
+
+        void BatchConverter::_Run(BatchEntry& _entry) const {
+            if (m_settings.bIncremental) {
+                std::error_code error;
+                const auto outputTime = fs::last_write_time(_entry.outputPath, error);
+                if (!error && outputTime >= fs::last_write_time(_entry.inputPath, error) && !error) {
+                    _entry.eStatus = BatchStatus_Skipped;
+                    return;
+                }
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            try {
+                _Convert(_entry);
+                _entry.eStatus = BatchStatus_Converted;
+            }
+            catch (const cvar::SyntaxErrorException& e) {
+                _entry.sMessage = std::string("[SyntaxErrorException] ") + e.what();
+            }
+            catch (const cvar::UnexpectedEOFException& e) {
+                _entry.sMessage = std::string("[UnexpectedEOFException] ") + e.what();
+            }
+            catch (const ConvertionException& e) {
+                _entry.sMessage = std::string("[ConvertionException] ") + e.what();
+            }
+            catch (const SerializerException& e) {
+                _entry.sMessage = std::string("[SerializerException] ") + e.what();
+            }
+            catch (const std::bad_alloc&) {
+                _entry.sMessage = "[bad_alloc] Out of memory, lower --memory-limit or --jobs";
+            }
+            catch (const std::exception& e) {
+                _entry.sMessage = std::string("[exception] ") + e.what();
+            }
+            _entry.fSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if (_entry.eStatus != BatchStatus_Converted) {
+                _entry.eStatus = BatchStatus_Failed;
+                fs::path tempPath = _entry.outputPath;
+                tempPath += ".tmp";
+                std::error_code error;
+                fs::remove(tempPath, error);
+            }
+        }
+
+
+        void BatchConverter::_RejectOutputCollisions(std::ostream& _log) {
+            std::vector<std::pair<fs::path, size_t>> outputs;
+            outputs.reserve(m_entries.size());
+            for (size_t i = 0; i < m_entries.size(); i++) {
+                if (m_entries[i].eStatus == BatchStatus_Pending)
+                    outputs.emplace_back(_NormalizePath(m_entries[i].outputPath), i);
+            }
+            std::sort(outputs.begin(), outputs.end());
+
+            // every input of a collision fails, since which one would be kept depends on the order of the jobs
+            for (size_t uFirst = 0; uFirst < outputs.size();) {
+                size_t uLast = uFirst + 1;
+                while (uLast < outputs.size() && outputs[uLast].first == outputs[uFirst].first)
+                    uLast++;
+
+                for (size_t i = uFirst; uLast - uFirst > 1 && i < uLast; i++) {
+                    BatchEntry& entry = m_entries[outputs[i].second];
+                    const BatchEntry& other = m_entries[outputs[i == uFirst ? uFirst + 1 : uFirst].second];
+                    entry.eStatus = BatchStatus_Failed;
+                    entry.sMessage = "Output '" + entry.outputPath.string() + "' would also be written by '" + other.inputPath.string() + "'";
+                    _log << entry.inputPath.string() << ": " << entry.sMessage << '\n';
+                }
+                uFirst = uLast;
+            }
+        }
+
+
+        void BatchConverter::Run(std::ostream& _log) {
+            // duplicates from overlapping inputs are converted once with the output path of the first input
+            std::stable_sort(m_entries.begin(), m_entries.end(), [](const BatchEntry& _a, const BatchEntry& _b) {
+                return _NormalizePath(_a.inputPath) < _NormalizePath(_b.inputPath);
+            });
+            m_entries.erase(std::unique(m_entries.begin(), m_entries.end(), [](const BatchEntry& _a, const BatchEntry& _b) {
+                return _NormalizePath(_a.inputPath) == _NormalizePath(_b.inputPath);
+            }), m_entries.end());
+            _RejectOutputCollisions(_log);
+
+            // largest files first, so that a single large file does not end up as the tail of the batch
+            std::vector<size_t> order;
+            order.reserve(m_entries.size());
+            for (size_t i = 0; i < m_entries.size(); i++) {
+                if (m_entries[i].eStatus == BatchStatus_Pending)
+                    order.push_back(i);
+            }
+            std::stable_sort(order.begin(), order.end(), [this](size_t _a, size_t _b) {
+                return m_entries[_a].uInputSize > m_entries[_b].uInputSize;
+            });
+
+            std::mutex logMutex;
+            std::atomic<size_t> uDone{0};
+            auto fnConvert = [&](size_t _uBegin, size_t _uEnd) {
+                for (size_t i = _uBegin; i < _uEnd; i++) {
+                    BatchEntry& entry = m_entries[order[i]];
+                    _Run(entry);
+                    const size_t uIndex = ++uDone;
+
+                    if (entry.eStatus == BatchStatus_Failed || m_settings.bVerbose) {
+                        std::scoped_lock lock(logMutex);
+                        _log << '[' << uIndex << '/' << order.size() << "] " << entry.inputPath.string();
+                        if (entry.eStatus == BatchStatus_Failed)
+                            _log << ": " << entry.sMessage;
+                        else if (entry.eStatus == BatchStatus_Skipped)
+                            _log << ": up to date";
+                        else _log << " -> " << entry.outputPath.string() << (entry.bStreamed ? " (streamed)" : "");
+                        _log << '\n';
+
+                        for (const std::string& sLibrary : entry.missingLibraries)
+                            _log << "    material library '" << sLibrary << "' not found\n";
+                    }
+                }
+            };
+
+            const auto start = std::chrono::steady_clock::now();
+
+            // the calling thread is one of the jobs
+            uint32_t uJobCount = m_settings.uJobCount ? m_settings.uJobCount : std::max(1u, std::thread::hardware_concurrency());
+            uJobCount = static_cast<uint32_t>(std::min<size_t>(uJobCount, std::max<size_t>(order.size(), 1)));
+            if (uJobCount > 1) {
+                ThreadPool pool(uJobCount - 1);
+                pool.ParallelFor(0, order.size(), 1, fnConvert);
+            }
+            else fnConvert(0, order.size());
+
+            m_fSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+
+        size_t BatchConverter::GetFailureCount() const {
+            return static_cast<size_t>(std::count_if(m_entries.begin(), m_entries.end(), [](const BatchEntry& _entry) {
+                return _entry.eStatus == BatchStatus_Failed;
+            }));
+        }
+
+
+        void BatchConverter::PrintReport(std::ostream& _stream) const {
+            size_t uConverted = 0, uSkipped = 0, uStreamed = 0;
+            uint64_t uInputBytes = 0, uOutputBytes = 0;
+            for (const BatchEntry& entry : m_entries) {
+                if (entry.eStatus == BatchStatus_Skipped)
+                    uSkipped++;
+                if (entry.eStatus != BatchStatus_Converted)
+                    continue;
+
+                uConverted++;
+                uStreamed += entry.bStreamed;
+                uInputBytes += entry.uInputSize;
+                uOutputBytes += entry.uOutputSize;
+            }
+
+            const size_t uFailed = GetFailureCount();
+            const double fSeconds = std::max(m_fSeconds, 1e-9);
+            char szLine[256] = {};
+
+            std::snprintf(szLine, sizeof(szLine), "Converted %zu of %zu files (%zu skipped, %zu failed) in %.2f s\n",
+                          uConverted, m_entries.size(), uSkipped, uFailed, m_fSeconds);
+            _stream << szLine;
+            std::snprintf(szLine, sizeof(szLine), "Input %s, output %s, %s/s, %.1f files/s\n", FormatBytes(uInputBytes).c_str(),
+                          FormatBytes(uOutputBytes).c_str(), FormatBytes(static_cast<uint64_t>(static_cast<double>(uInputBytes) / fSeconds)).c_str(),
+                          static_cast<double>(uConverted) / fSeconds);
+            _stream << szLine;
+            if (uStreamed)
+                _stream << "Streamed " << uStreamed << " files exceeding the in-memory limit\n";
+
+            if (!uFailed)
+                return;
+
+            _stream << "Failures:\n";
+            for (const BatchEntry& entry : m_entries) {
+                if (entry.eStatus == BatchStatus_Failed)
+                    _stream << "  " << entry.inputPath.string() << ": " << entry.sMessage << '\n';
+            }
+        }
+
+
+        int RunConvertCommand(int _argc, char* _argv[]) {
+            BatchConverterSettings settings;
+            std::vector<std::string> inputs;
+
+            uint64_t uValue = 0;
+            auto fnInvalid = [&](int _iOption) {
+                std::cerr << "Invalid value '" << _argv[_iOption + 1] << "' for " << _argv[_iOption] << '\n';
+                _PrintUsage();
+                return 1;
+            };
+
+            for (int i = 1; i < _argc; i++) {
+                const bool bHasValue = i + 1 < _argc;
+                if (!std::strcmp(_argv[i], "--help") || !std::strcmp(_argv[i], "-h")) {
+                    _PrintUsage();
+                    return 0;
+                }
+                else if ((!std::strcmp(_argv[i], "-o") || !std::strcmp(_argv[i], "--output")) && bHasValue)
+                    settings.outputDirectory = _argv[++i];
+                else if ((!std::strcmp(_argv[i], "-j") || !std::strcmp(_argv[i], "--jobs")) && bHasValue) {
+                    if (!ParseUnsigned(_argv[i + 1], UINT32_MAX, uValue))
+                        return fnInvalid(i);
+                    settings.uJobCount = static_cast<uint32_t>(uValue);
+                    i++;
+                }
+                else if (!std::strcmp(_argv[i], "--memory-limit") && bHasValue) {
+                    if (!ParseUnsigned(_argv[i + 1], SIZE_MAX >> 20, uValue))
+                        return fnInvalid(i);
+                    settings.uMemoryLimit = static_cast<size_t>(uValue) << 20;
+                    i++;
+                }
+                else if (!std::strcmp(_argv[i], "--zstd") && bHasValue) {
+                    // Serializer and Unserializer only map these levels onto zstd parameters
+                    if (!ParseUnsigned(_argv[i + 1], UINT8_MAX, uValue) || (uValue != 0 && uValue != 1 && uValue != 9 && uValue != 255))
+                        return fnInvalid(i);
+                    settings.bZstdLevel = static_cast<uint8_t>(uValue);
+                    i++;
+                }
+                else if (!std::strcmp(_argv[i], "--incremental"))
+                    settings.bIncremental = true;
+                else if (!std::strcmp(_argv[i], "--instance"))
+                    settings.bInstancing = true;
+                else if (!std::strcmp(_argv[i], "-v") || !std::strcmp(_argv[i], "--verbose"))
+                    settings.bVerbose = true;
+                else if (_argv[i][0] == '-') {
+                    std::cerr << "Unknown option '" << _argv[i] << "'\n";
+                    _PrintUsage();
+                    return 1;
+                }
+                else inputs.push_back(_argv[i]);
+            }
+
+            if (inputs.empty()) {
+                _PrintUsage();
+                return 1;
+            }
+
+            BatchConverter converter(settings);
+            for (const std::string& sInput : inputs)
+                converter.AddInput(sInput);
+
+            converter.Run(std::cerr);
+            converter.PrintReport(std::cout);
+            return converter.GetFailureCount() ? 2 : 0;
+        }
+    }
+}
@@ -0,0 +1,155 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: Common.cpp - implementation of helpers shared by dastool commands
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <system_error>
+
+#include <das2/dastool/Common.h>
+
+namespace fs = std::filesystem;
+
+namespace das2 {
+    namespace dastool {
+
+        namespace {
+            bool _HasWildcard(const std::string& _sComponent) {
+                return _sComponent.find_first_of("*?") != std::string::npos;
+            }
+
+
+            // matches a single path component, '*' matches any number of characters and '?' exactly one
+            bool _MatchComponent(const char* _szPattern, const char* _szName) {
+                const char* szStar = nullptr;
+                const char* szResume = nullptr;
+                while (*_szName) {
+                    if (*_szPattern == '?' || *_szPattern == *_szName) {
+                        _szPattern++;
+                        _szName++;
+                    }
+                    else if (*_szPattern == '*') {
+                        szStar = _szPattern++;
+                        szResume = _szName;
+                    }
+                    else if (szStar) {
+                        _szPattern = szStar + 1;
+                        _szName = ++szResume;
+                    }
+                    else return false;
+                }
+
+                while (*_szPattern == '*')
+                    _szPattern++;
+                return !*_szPattern;
+            }
+
+
+            // matches path components, a "**" pattern component matches any number of path components
+            bool _MatchPath(const std::vector<std::string>& _pattern, size_t _uPattern, const std::vector<std::string>& _path, size_t _uPath) {
+                if (_uPattern == _pattern.size())
+                    return _uPath == _path.size();
+
+                if (_pattern[_uPattern] == "**") {
+                    for (size_t i = _uPath; i <= _path.size(); i++) {
+                        if (_MatchPath(_pattern, _uPattern + 1, _path, i))
+                            return true;
+                    }
+                    return false;
+                }
+
+                return _uPath < _path.size() && _MatchComponent(_pattern[_uPattern].c_str(), _path[_uPath].c_str()) &&
+                       _MatchPath(_pattern, _uPattern + 1, _path, _uPath + 1);
+            }
+
+
+            bool _HasExtension(const fs::path& _path, const char* _szExtension) {
+                std::string sExtension = _path.extension().string();
+                std::string sExpected = _szExtension;
+                auto fnLower = [](unsigned char c) { return static_cast<char>(std::tolower(c)); };
+                std::transform(sExtension.begin(), sExtension.end(), sExtension.begin(), fnLower);
+                std::transform(sExpected.begin(), sExpected.end(), sExpected.begin(), fnLower);
+                return sExtension == sExpected;
+            }
+        }
+
+
+        bool ExpandInput(const std::string& _sInput, const char* _szExtension, std::vector<InputFile>& _files) {
+            const size_t uPrevious = _files.size();
+            const fs::path input(_sInput);
+            std::error_code error;
+
+            // glob patterns are split into a base directory without wildcards and the remaining components
+            fs::path base;
+            std::vector<std::string> pattern;
+            for (const fs::path& component : input) {
+                if (pattern.empty() && !_HasWildcard(component.string()))
+                    base /= component;
+                else pattern.push_back(component.string());
+            }
+
+            if (!pattern.empty()) {
+                if (base.empty())
+                    base = ".";
+
+                const bool bRecursive = std::find(pattern.begin(), pattern.end(), "**") != pattern.end();
+                fs::recursive_directory_iterator it(base, fs::directory_options::skip_permission_denied, error);
+                for (; !error && it != fs::recursive_directory_iterator(); it.increment(error)) {
+                    if (!bRecursive && static_cast<size_t>(it.depth()) + 1 >= pattern.size())
+                        it.disable_recursion_pending();
+                    if (!it->is_regular_file(error))
+                        continue;
+
+                    std::vector<std::string> path;
+                    for (const fs::path& component : it->path().lexically_relative(base))
+                        path.push_back(component.string());
+                    if (_MatchPath(pattern, 0, path, 0))
+                        _files.push_back({ it->path(), base });
+                }
+            }
+            else if (fs::is_directory(input, error)) {
+                fs::recursive_directory_iterator it(input, fs::directory_options::skip_permission_denied, error);
+                for (; !error && it != fs::recursive_directory_iterator(); it.increment(error)) {
+                    if (it->is_regular_file(error) && _HasExtension(it->path(), _szExtension))
+                        _files.push_back({ it->path(), input });
+                }
+            }
+            else if (fs::is_regular_file(input, error)) {
+                _files.push_back({ input, input.parent_path() });
+            }
+
+            // directory iteration order is unspecified, sorting keeps reports comparable between runs
+            std::sort(_files.begin() + uPrevious, _files.end(), [](const InputFile& _a, const InputFile& _b) {
+                return _a.path < _b.path;
+            });
+            return _files.size() != uPrevious;
+        }
+
+
+        bool ParseUnsigned(const char* _szValue, uint64_t _uMax, uint64_t& _uValue) {
+            // std::stoull accepts leading whitespace, signs and trailing garbage, all of which are rejected here
+            if (!std::isdigit(static_cast<unsigned char>(*_szValue)))
+                return false;
+
+            size_t uLength = 0;
+            unsigned long long uValue = 0;
+            try {
+                uValue = std::stoull(_szValue, &uLength);
+            }
+            catch (const std::invalid_argument&) {
+                return false;
+            }
+            catch (const std::out_of_range&) {
+                return false;
+            }
+
+            if (_szValue[uLength] || uValue > _uMax)
+                return false;
+
+            _uValue = static_cast<uint64_t>(uValue);
+            return true;
+        }
+    }
+}
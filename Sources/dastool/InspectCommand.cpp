@@ -0,0 +1,257 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: InspectCommand.cpp - implementation of dastool das2 file inspection command
+// author: Karl-Mihkel Ott
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <das2/Exceptions.h>
+#include <das2/Inspector.h>
+#include <das2/MemoryReport.h>
+#include <das2/ThreadPool.h>
+#include <das2/dastool/Common.h>
+#include <das2/dastool/InspectCommand.h>
+
+namespace das2 {
+    namespace dastool {
+
+        namespace {
+            struct _Column {
+                StructureIdentifier bIdentifier;
+                const char* szName;
+            };
+
+            // top level records, morph targets are part of mesh records
+            const _Column g_arrColumns[] = {
+                { StructureIdentifier_Mesh, "meshes" },
+                { StructureIdentifier_MeshGroup, "mesh_groups" },
+                { StructureIdentifier_Node, "nodes" },
+                { StructureIdentifier_Scene, "scenes" },
+                { StructureIdentifier_SkeletonJoint, "joints" },
+                { StructureIdentifier_Skeleton, "skeletons" },
+                { StructureIdentifier_Animation, "animations" },
+                { StructureIdentifier_AnimationChannel, "channels" },
+                { StructureIdentifier_MaterialPhong, "phong_materials" },
+                { StructureIdentifier_MaterialPbr, "pbr_materials" }
+            };
+
+
+            struct _Result {
+                InputFile file;
+                ModelSummary summary;
+                std::string sError;
+            };
+
+
+            void _PrintUsage() {
+                std::cout << "Usage: dastool inspect <input>... [options]\n"
+                          << "Inputs are das2 files, directories searched recursively for " DASTOOL_INSPECT_EXTENSION " files or glob patterns ('*', '?', '**').\n"
+                          << "Only headers and structure records are read, buffers are skipped.\n"
+                          << "  --deep                  decompress compressed files to count structures and compute compression ratios\n"
+                          << "  --csv                   print one comma separated line per file\n"
+                          << "  -j, --jobs <n>          files inspected concurrently, 0 uses hardware concurrency (default 1)\n";
+            }
+
+
+            void _Inspect(_Result& _result, bool _bDeep) {
+                std::ifstream stream(_result.file.path, std::ios_base::binary);
+                if (!stream) {
+                    _result.sError = "Cannot open file for reading";
+                    return;
+                }
+
+                try {
+                    _result.summary = InspectModel(stream, _bDeep);
+                }
+                catch (const MagicValueException& e) {
+                    _result.sError = std::string("[MagicValueException] ") + e.what();
+                }
+                catch (const SerializerException& e) {
+                    _result.sError = std::string("[SerializerException] ") + e.what();
+                }
+                catch (const std::exception& e) {
+                    _result.sError = std::string("[exception] ") + e.what();
+                }
+            }
+
+
+            void _PrintCsvHeader() {
+                std::cout << "file,size,uncompressed_size,ratio,zstd_level,vertices,buffer_size";
+                for (const _Column& column : g_arrColumns)
+                    std::cout << ',' << column.szName;
+                std::cout << ",error\n";
+            }
+
+
+            void _PrintCsv(const _Result& _result) {
+                const ModelSummary& summary = _result.summary;
+                std::cout << '"' << _result.file.path.string() << "\"," << summary.uFileSize << ',';
+                if (summary.bStructuresScanned)
+                    std::cout << summary.uUncompressedSize << ',' << summary.GetCompressionRatio();
+                else std::cout << ',';
+                std::cout << ',' << static_cast<int>(summary.header.bZstdLevel) << ',' << summary.header.uVerticesCount << ',';
+                if (summary.bStructuresScanned)
+                    std::cout << summary.uBufferSize;
+
+                for (const _Column& column : g_arrColumns) {
+                    std::cout << ',';
+                    if (summary.bStructuresScanned)
+                        std::cout << summary.arrStructures[column.bIdentifier].uCount;
+                }
+                std::cout << ",\"" << _result.sError << "\"\n";
+            }
+
+
+            void _PrintText(const _Result& _result) {
+                std::cout << _result.file.path.string() << ": ";
+                if (!_result.sError.empty()) {
+                    std::cout << _result.sError << '\n';
+                    return;
+                }
+
+                const ModelSummary& summary = _result.summary;
+                std::cout << FormatBytes(summary.uFileSize);
+                if (summary.header.bZstdLevel) {
+                    std::cout << ", zstd " << static_cast<int>(summary.header.bZstdLevel);
+                    if (summary.bStructuresScanned) {
+                        char szRatio[32] = {};
+                        std::snprintf(szRatio, sizeof(szRatio), "%.2f", summary.GetCompressionRatio());
+                        std::cout << ", uncompressed " << FormatBytes(summary.uUncompressedSize) << ", ratio " << szRatio;
+                    }
+                }
+                std::cout << ", " << summary.header.uVerticesCount << " vertices";
+
+                if (!summary.bStructuresScanned) {
+                    // only the header is known without decompression
+                    std::cout << ", " << summary.header.uMeshCount << " meshes, " << summary.header.uAnimationCount << " animations (header)\n";
+                    return;
+                }
+
+                std::cout << ", buffer " << FormatBytes(summary.uBufferSize);
+                for (const _Column& column : g_arrColumns) {
+                    const StructureStats& structure = summary.arrStructures[column.bIdentifier];
+                    if (structure.uCount)
+                        std::cout << ", " << structure.uCount << ' ' << column.szName;
+                }
+                std::cout << '\n';
+            }
+        }
+
+
+        int RunInspectCommand(int _argc, char* _argv[]) {
+            std::vector<std::string> inputs;
+            bool bDeep = false;
+            bool bCsv = false;
+            uint32_t uJobCount = 1;
+
+            for (int i = 1; i < _argc; i++) {
+                if (!std::strcmp(_argv[i], "--help") || !std::strcmp(_argv[i], "-h")) {
+                    _PrintUsage();
+                    return 0;
+                }
+                else if (!std::strcmp(_argv[i], "--deep"))
+                    bDeep = true;
+                else if (!std::strcmp(_argv[i], "--csv"))
+                    bCsv = true;
+                else if ((!std::strcmp(_argv[i], "-j") || !std::strcmp(_argv[i], "--jobs")) && i + 1 < _argc) {
+                    uint64_t uValue = 0;
+                    if (!ParseUnsigned(_argv[i + 1], UINT32_MAX, uValue)) {
+                        std::cerr << "Invalid value '" << _argv[i + 1] << "' for " << _argv[i] << '\n';
+                        _PrintUsage();
+                        return 1;
+                    }
+                    uJobCount = static_cast<uint32_t>(uValue);
+                    i++;
+                }
+                else if (_argv[i][0] == '-') {
+                    std::cerr << "Unknown option '" << _argv[i] << "'\n";
+                    _PrintUsage();
+                    return 1;
+                }
+                else inputs.push_back(_argv[i]);
+            }
+
+            if (inputs.empty()) {
+                _PrintUsage();
+                return 1;
+            }
+
+            std::vector<_Result> results;
+            for (const std::string& sInput : inputs) {
+                std::vector<InputFile> files;
+                if (!ExpandInput(sInput, DASTOOL_INSPECT_EXTENSION, files)) {
+                    results.emplace_back();
+                    results.back().file.path = sInput;
+                    results.back().sError = "No such file, directory or matching files";
+                    continue;
+                }
+
+                for (InputFile& file : files) {
+                    results.emplace_back();
+                    results.back().file = std::move(file);
+                }
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            auto fnInspect = [&](size_t _uBegin, size_t _uEnd) {
+                for (size_t i = _uBegin; i < _uEnd; i++) {
+                    if (results[i].sError.empty())
+                        _Inspect(results[i], bDeep);
+                }
+            };
+
+            // the calling thread is one of the jobs
+            if (!uJobCount)
+                uJobCount = std::max(1u, std::thread::hardware_concurrency());
+            if (uJobCount > 1 && results.size() > 1) {
+                ThreadPool pool(uJobCount - 1);
+                pool.ParallelFor(0, results.size(), 64, fnInspect);
+            }
+            else fnInspect(0, results.size());
+            const double fSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if (bCsv)
+                _PrintCsvHeader();
+
+            size_t uFailed = 0;
+            uint64_t uTotalSize = 0, uCompressedSize = 0, uUncompressedSize = 0;
+            for (const _Result& result : results) {
+                if (bCsv)
+                    _PrintCsv(result);
+                else _PrintText(result);
+
+                if (!result.sError.empty()) {
+                    uFailed++;
+                    continue;
+                }
+
+                uTotalSize += result.summary.uFileSize;
+                if (result.summary.header.bZstdLevel && result.summary.bStructuresScanned) {
+                    uCompressedSize += result.summary.uFileSize;
+                    uUncompressedSize += result.summary.uUncompressedSize;
+                }
+            }
+
+            // totals go to stderr, so that csv output stays machine readable
+            char szLine[256] = {};
+            std::snprintf(szLine, sizeof(szLine), "Inspected %zu files (%zu failed, %s) in %.3f s, %.0f files/s\n", results.size(), uFailed,
+                          FormatBytes(uTotalSize).c_str(), fSeconds, static_cast<double>(results.size()) / std::max(fSeconds, 1e-9));
+            std::cerr << szLine;
+            if (uCompressedSize) {
+                std::snprintf(szLine, sizeof(szLine), "Compressed files: %s, %s uncompressed, ratio %.2f\n", FormatBytes(uCompressedSize).c_str(),
+                              FormatBytes(uUncompressedSize).c_str(), static_cast<double>(uUncompressedSize) / static_cast<double>(uCompressedSize));
+                std::cerr << szLine;
+            }
+
+            return uFailed ? 2 : 0;
+        }
+    }
+}
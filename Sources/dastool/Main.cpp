@@ -0,0 +1,59 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: Main.cpp - dastool entry point and command dispatch
+// author: Karl-Mihkel Ott
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <das2/dastool/InspectCommand.h>
+#ifdef DASTOOL_WAVEFRONT_OBJ
+    #include <das2/dastool/BatchConverter.h>
+#endif
+
+namespace {
+    struct _Command {
+        const char* szName;
+        int (*pfnRun)(int _argc, char* _argv[]);
+        const char* szDescription;
+    };
+
+    const _Command g_arrCommands[] = {
+#ifdef DASTOOL_WAVEFRONT_OBJ
+        { "convert", das2::dastool::RunConvertCommand, "convert Wavefront obj files, directories or glob patterns into das2 files" },
+#endif
+        { "inspect", das2::dastool::RunInspectCommand, "print header fields, structure counts and compression ratios of das2 files" },
+        { nullptr, nullptr, nullptr }
+    };
+
+
+    void _PrintUsage() {
+        std::cout << "Usage: dastool <command> [arguments]\n"
+                  << "Commands:\n";
+        for (const _Command* pCommand = g_arrCommands; pCommand->szName; pCommand++) {
+            std::string sName = pCommand->szName;
+            sName.resize(12, ' ');
+            std::cout << "  " << sName << pCommand->szDescription << '\n';
+        }
+        std::cout << "Run 'dastool <command> --help' for the options of a command.\n";
+    }
+}
+
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || !std::strcmp(argv[1], "--help") || !std::strcmp(argv[1], "-h")) {
+        _PrintUsage();
+        return argc < 2 ? 1 : 0;
+    }
+
+    // commands receive their own name as argv[0]
+    for (const _Command* pCommand = g_arrCommands; pCommand->szName; pCommand++) {
+        if (!std::strcmp(argv[1], pCommand->szName))
+            return pCommand->pfnRun(argc - 1, argv + 1);
+    }
+
+    std::cerr << "Unknown command '" << argv[1] << "'\n";
+    _PrintUsage();
+    return 1;
+}
@@ -12,7 +12,7 @@
 namespace das2 {
 
     DasDump::DasDump(const std::string& _sFileName) {
-        std::ifstream stream(_sFileName);
+        std::ifstream stream(_sFileName, std::ios_base::binary);
         
         try {
             Unserializer unserializer(stream);
@@ -32,13 +32,14 @@ namespace das2 {
 
     void DasDump::PrintInfo() {
         std::cout << "---- das2::Header ----\n";
-        std::cout << "Author name: \"" << m_model.header.szAuthorName.CString() << "\"\n";
-        std::cout << "Comment: \"" << m_model.header.szComment.CString() << "\"\n";
+        // empty strings have no data, streaming a null pointer would put std::cout into a failed state
+        std::cout << "Author name: \"" << (m_model.header.szAuthorName.CString() ? m_model.header.szAuthorName.CString() : "") << "\"\n";
+        std::cout << "Comment: \"" << (m_model.header.szComment.CString() ? m_model.header.szComment.CString() : "") << "\"\n";
         std::cout << "Vertices count: " << m_model.header.uVerticesCount << '\n';
         std::cout << "Mesh count: " << m_model.header.uMeshCount << '\n';
         std::cout << "Animation count: " << m_model.header.uAnimationCount << '\n';
         std::cout << "Default scene index: " << m_model.header.uDefaultSceneIndex << '\n';
-        std::cout << "zstd compression mode: " << (int)m_model.header.bZlibLevel << '\n';
+        std::cout << "zstd compression mode: " << (int)m_model.header.bZstdLevel << '\n';
 
         std::cout << "---- das2::Buffer ----\n";
         std::cout << "Buffer length: " << m_model.buffer.Size() << '\n';
@@ -0,0 +1,128 @@
+// das2: Improved DENG asset manager library
+// licence: Apache, see LICENCE file
+// file: GenerateModel.cpp - demo program to generate synthetic das2 and obj files of arbitrary size
+// author: Karl-Mihkel Ott
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <das2/Exceptions.h>
+#include <das2/ModelGenerator.h>
+#include <das2/ThreadPool.h>
+
+namespace {
+    struct _CountOption {
+        const char* szName;
+        uint32_t das2::ModelGeneratorSettings::* pField;
+        const char* szDescription;
+    };
+
+    const _CountOption g_arrCountOptions[] = {
+        { "--meshes", &das2::ModelGeneratorSettings::uMeshCount, "number of meshes" },
+        { "--vertices", &das2::ModelGeneratorSettings::uVerticesPerMesh, "vertices per mesh, rounded up to a square grid" },
+        { "--uv-sets", &das2::ModelGeneratorSettings::uUVSetCount, "uv sets per mesh, at most 8" },
+        { "--lods", &das2::ModelGeneratorSettings::uLodCount, "additional levels of detail per mesh" },
+        { "--morph-targets", &das2::ModelGeneratorSettings::uMorphTargetCount, "morph targets per mesh" },
+        { "--nodes", &das2::ModelGeneratorSettings::uNodeCount, "number of nodes, at least the number of meshes" },
+        { "--node-branching", &das2::ModelGeneratorSettings::uNodeBranching, "children per node, 1 is a chain, 0 attaches all to the root" },
+        { "--skeletons", &das2::ModelGeneratorSettings::uSkeletonCount, "number of skeletons" },
+        { "--joints", &das2::ModelGeneratorSettings::uJointCount, "joints per skeleton" },
+        { "--joint-branching", &das2::ModelGeneratorSettings::uJointBranching, "children per joint" },
+        { "--animations", &das2::ModelGeneratorSettings::uAnimationCount, "number of animations" },
+        { "--keyframes", &das2::ModelGeneratorSettings::uKeyframeCount, "keyframes per animation channel" },
+        { "--animated-nodes", &das2::ModelGeneratorSettings::uAnimatedNodeCount, "nodes with translation and morph weight channels" },
+        { "--materials", &das2::ModelGeneratorSettings::uMaterialCount, "number of phong materials" }
+    };
+
+
+    void _PrintUsage() {
+        std::cout << "Usage: ./GenerateModel <output-file> [options]\n"
+                  << "Files ending with .obj are written as Wavefront obj, all other files as das2.\n"
+                  << "  --seed <n>              random seed (default 1)\n";
+        for (const _CountOption& option : g_arrCountOptions) {
+            std::string sName = std::string(option.szName) + " <n>";
+            sName.resize(24, ' ');
+            std::cout << "  " << sName << option.szDescription << '\n';
+        }
+        std::cout << "  --no-normals            omit vertex normals\n"
+                  << "  --zstd <level>          das2 compression level (0, 1, 9 or 255)\n"
+                  << "  --threads <n>           worker threads, 0 uses hardware concurrency (default 1)\n";
+    }
+
+
+    bool _EndsWith(const std::string& _sText, const std::string& _sSuffix) {
+        return _sText.size() >= _sSuffix.size() && _sText.compare(_sText.size() - _sSuffix.size(), _sSuffix.size(), _sSuffix) == 0;
+    }
+}
+
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || !std::strcmp(argv[1], "--help")) {
+        _PrintUsage();
+        return 0;
+    }
+
+    const std::string sOutput = argv[1];
+    das2::ModelGeneratorSettings settings;
+    uint32_t uThreadCount = 1;
+
+    for (int i = 2; i < argc; i++) {
+        const bool bHasValue = i + 1 < argc;
+        bool bMatched = false;
+        for (const _CountOption& option : g_arrCountOptions) {
+            if (!std::strcmp(argv[i], option.szName) && bHasValue) {
+                settings.*option.pField = static_cast<uint32_t>(std::stoul(argv[++i]));
+                bMatched = true;
+                break;
+            }
+        }
+
+        if (bMatched)
+            continue;
+        else if (!std::strcmp(argv[i], "--seed") && bHasValue)
+            settings.uSeed = std::stoull(argv[++i]);
+        else if (!std::strcmp(argv[i], "--no-normals"))
+            settings.bNormals = false;
+        else if (!std::strcmp(argv[i], "--zstd") && bHasValue)
+            settings.bZstdLevel = static_cast<uint8_t>(std::stoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--threads") && bHasValue)
+            uThreadCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+        else {
+            std::cerr << "Unknown option '" << argv[i] << "'\n";
+            _PrintUsage();
+            return 1;
+        }
+    }
+
+    std::ofstream stream(sOutput, std::ios_base::binary);
+    if (!stream) {
+        std::cerr << "Cannot open '" << sOutput << "' for writing\n";
+        return 1;
+    }
+
+    // a single thread generates in place, without the overhead of a pool
+    std::unique_ptr<das2::ThreadPool> pThreadPool;
+    if (uThreadCount != 1)
+        pThreadPool = std::make_unique<das2::ThreadPool>(uThreadCount);
+
+    try {
+        das2::ModelGenerator generator(settings, pThreadPool.get());
+        if (_EndsWith(sOutput, ".obj"))
+            generator.WriteObj(stream);
+        else generator.Write(stream);
+    }
+    catch (const das2::BufferRangeException& e) {
+        std::cerr << "[BufferRangeException] " << e.what() << '\n';
+        return 2;
+    }
+
+    if (!stream) {
+        std::cerr << "Failed to write '" << sOutput << "'\n";
+        return 3;
+    }
+
+    return 0;
+}